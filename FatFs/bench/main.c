@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * FatFs benchmark.
+ *
+ * runs each test once with no card latency, showing the cost of like-posix and FatFs alone,
+ * and once with timings that roughly model a class 10 SD card in SDIO 4 bit mode.
+ *
+ * - sequential write and read throughput, for several transfer sizes
+ * - random 4kB read and write throughput, within one file
+ * - open()/close() latency versus directory depth
+ *
+ * alongside each result are the disk commands and sectors it took, from diskio_file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sdfs.h"
+#include "diskio_file.h"
+
+#define SEQ_FILE            "/bench/seq.bin"
+#define RAND_FILE           "/bench/rand.bin"
+#define RAND_FILE_SIZE      (1024 * 1024)
+#define RAND_TRANSFER       4096
+#define RAND_COUNT          256
+#define MAX_DEPTH           8
+#define OPEN_COUNT          200
+
+typedef struct {
+    const char* name;
+    diskio_file_latency_t latency;
+    uint32_t seq_size;          ///< bytes in the sequential test file
+} profile_t;
+
+static const profile_t profiles[] = {
+    {"none", {0, 0, 0, 0}, 16 * 1024 * 1024},
+    // ~250us to start a read, ~20MB/s; ~500us to start a write, ~10MB/s
+    {"sdcard", {250, 25, 500, 50}, 2 * 1024 * 1024},
+};
+
+static const uint32_t transfer_sizes[] = {512, 4096, 32768};
+
+static uint8_t buffer[32768];
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+/**
+ * minlibc printf has no precision support, rates are printed in whole kB/s.
+ */
+static void report(const char* test, uint32_t transfer, uint32_t bytes, uint64_t us)
+{
+    diskio_file_stats_t stats;
+    diskio_file_get_stats(&stats);
+    printf("  %s %d bytes: %d kB/s, %d commands, %d sectors\n", test, (int)transfer,
+            (int)(us ? ((uint64_t)bytes * 1000000 / 1024) / us : 0),
+            (int)(stats.reads + stats.writes), (int)(stats.sectors_read + stats.sectors_written));
+}
+
+static void bench_sequential(const profile_t* profile)
+{
+    uint32_t t, done;
+    uint64_t start;
+    int fd;
+
+    for(t = 0; t < sizeof(transfer_sizes)/sizeof(transfer_sizes[0]); t++)
+    {
+        fd = open(SEQ_FILE, O_WRONLY|O_CREAT|O_TRUNC, 0);
+        if(fd == -1)
+        {
+            printf("failed to open %s\n", SEQ_FILE);
+            return;
+        }
+        diskio_file_reset_stats();
+        start = now_us();
+        for(done = 0; done < profile->seq_size; done += transfer_sizes[t])
+            write(fd, buffer, transfer_sizes[t]);
+        close(fd);
+        report("seq write", transfer_sizes[t], profile->seq_size, now_us() - start);
+
+        fd = open(SEQ_FILE, O_RDONLY, 0);
+        diskio_file_reset_stats();
+        start = now_us();
+        for(done = 0; done < profile->seq_size; done += transfer_sizes[t])
+            read(fd, buffer, transfer_sizes[t]);
+        close(fd);
+        report("seq read", transfer_sizes[t], profile->seq_size, now_us() - start);
+    }
+}
+
+static void bench_random(void)
+{
+    uint32_t i;
+    uint64_t start;
+    int fd;
+
+    fd = open(RAND_FILE, O_RDWR|O_CREAT|O_TRUNC, 0);
+    if(fd == -1)
+    {
+        printf("failed to open %s\n", RAND_FILE);
+        return;
+    }
+    for(i = 0; i < RAND_FILE_SIZE; i += sizeof(buffer))
+        write(fd, buffer, sizeof(buffer));
+
+    srand(1);
+    diskio_file_reset_stats();
+    start = now_us();
+    for(i = 0; i < RAND_COUNT; i++)
+    {
+        lseek(fd, (rand() % (RAND_FILE_SIZE / RAND_TRANSFER)) * RAND_TRANSFER, SEEK_SET);
+        read(fd, buffer, RAND_TRANSFER);
+    }
+    report("rand read", RAND_TRANSFER, RAND_COUNT * RAND_TRANSFER, now_us() - start);
+
+    diskio_file_reset_stats();
+    start = now_us();
+    for(i = 0; i < RAND_COUNT; i++)
+    {
+        lseek(fd, (rand() % (RAND_FILE_SIZE / RAND_TRANSFER)) * RAND_TRANSFER, SEEK_SET);
+        write(fd, buffer, RAND_TRANSFER);
+    }
+    close(fd);
+    report("rand write", RAND_TRANSFER, RAND_COUNT * RAND_TRANSFER, now_us() - start);
+}
+
+static void bench_open(void)
+{
+    char path[16 + (MAX_DEPTH * 4)];
+    diskio_file_stats_t stats;
+    int depth, i, fd;
+    uint64_t start;
+
+    strcpy(path, "/bench");
+    for(depth = 0; depth <= MAX_DEPTH; depth++)
+    {
+        if(depth)
+        {
+            sprintf(path + strlen(path), "/d%d", depth);
+            mkdir(path, 0);
+        }
+        strcat(path, "/f");
+        fd = open(path, O_WRONLY|O_CREAT, 0);
+        close(fd);
+
+        diskio_file_reset_stats();
+        start = now_us();
+        for(i = 0; i < OPEN_COUNT; i++)
+        {
+            fd = open(path, O_RDONLY, 0);
+            close(fd);
+        }
+        diskio_file_get_stats(&stats);
+        printf("  open depth %d: %d us, %d sectors read per open\n", depth,
+                (int)((now_us() - start) / OPEN_COUNT), (int)(stats.sectors_read / OPEN_COUNT));
+
+        path[strlen(path) - 2] = '\0';
+    }
+}
+
+int main(void)
+{
+    uint32_t p;
+
+    memset(buffer, 0x5a, sizeof(buffer));
+    sdfs_init();
+    while(!sdfs_ready())
+        vTaskDelay(10);
+    mkdir("/bench", 0);
+
+    for(p = 0; p < sizeof(profiles)/sizeof(profiles[0]); p++)
+    {
+        printf("latency profile '%s': read %uus + %uus/sector, write %uus + %uus/sector\n",
+                profiles[p].name,
+                (unsigned)profiles[p].latency.read_access_us, (unsigned)profiles[p].latency.read_sector_us,
+                (unsigned)profiles[p].latency.write_access_us, (unsigned)profiles[p].latency.write_sector_us);
+        diskio_file_set_latency(&profiles[p].latency);
+        bench_sequential(&profiles[p]);
+        bench_random();
+        bench_open();
+    }
+
+    unlink(SEQ_FILE);
+    unlink(RAND_FILE);
+    exit(0);
+    return 0;
+}
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup sdfs
+ *
+ * Disk IO interface for host builds, links up a FAT image file with FatFs by ChaN.
+ *
+ * the image file FATFS_IMAGE_FILE is mapped into memory, and created FATFS_IMAGE_SECTORS
+ * sectors long if it does not exist. it can be prepared or inspected on the host with
+ * mkfs.vfat and mtools.
+ *
+ * SD card timings may be modelled by setting a delay per command and per sector,
+ * so that code on the like-posix file path can be profiled as it would run on a card.
+ *
+ * the host open() and close() are routed to like-posix (see libc_host.c), so the
+ * image is opened with raw system calls.
+ *
+ * @file
+ * @{
+ */
+
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "diskio.h"
+#include "diskio_file.h"
+#include "cutensils.h"
+
+#define IMAGE_SECTOR_SIZE       512
+
+static logger_t diskiolog;
+static DSTATUS Status = STA_NOINIT;
+static uint8_t* image = NULL;
+static uint32_t image_sectors;
+static diskio_file_latency_t image_latency = {
+    .read_access_us = FATFS_IMAGE_READ_ACCESS_US,
+    .read_sector_us = FATFS_IMAGE_READ_SECTOR_US,
+    .write_access_us = FATFS_IMAGE_WRITE_ACCESS_US,
+    .write_sector_us = FATFS_IMAGE_WRITE_SECTOR_US,
+};
+static diskio_file_stats_t image_stats;
+
+/**
+ * waits for the given time without giving up the processor, as a polled card driver would.
+ * the deadline is absolute, so signals used by the FreeRTOS port do not stretch it.
+ */
+static void image_delay(uint32_t us)
+{
+    struct timespec deadline;
+
+    if(!us)
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += us / 1000000;
+    deadline.tv_nsec += (us % 1000000) * 1000;
+    if(deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);
+}
+
+/**
+ * maps the image file, creating it if need be.
+ *
+ * @retval  true on success.
+ */
+static bool image_map(void)
+{
+    struct stat st;
+    int fd;
+
+    fd = syscall(SYS_openat, AT_FDCWD, FATFS_IMAGE_FILE, O_RDWR|O_CREAT, 0644);
+    if(fd == -1)
+    {
+        log_error(&diskiolog, "failed to open %s", FATFS_IMAGE_FILE);
+        return false;
+    }
+
+    if(syscall(SYS_fstat, fd, &st) == -1 ||
+       (st.st_size < IMAGE_SECTOR_SIZE && syscall(SYS_ftruncate, fd, (off_t)FATFS_IMAGE_SECTORS * IMAGE_SECTOR_SIZE) == -1) ||
+       syscall(SYS_fstat, fd, &st) == -1)
+    {
+        log_error(&diskiolog, "failed to size %s", FATFS_IMAGE_FILE);
+        syscall(SYS_close, fd);
+        return false;
+    }
+
+    image_sectors = st.st_size / IMAGE_SECTOR_SIZE;
+    image = mmap(NULL, (size_t)image_sectors * IMAGE_SECTOR_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping holds its own reference to the file
+    syscall(SYS_close, fd);
+
+    if(image == MAP_FAILED)
+    {
+        log_error(&diskiolog, "failed to map %s", FATFS_IMAGE_FILE);
+        image = NULL;
+        return false;
+    }
+
+    log_info(&diskiolog, "image %s, %u sectors", FATFS_IMAGE_FILE, (unsigned int)image_sectors);
+    return true;
+}
+
+DSTATUS disk_initialize(BYTE drv)
+{
+    log_init(&diskiolog, "diskio");
+
+    if(drv)
+        return STA_NOINIT|STA_NODISK;
+
+    if(image || image_map())
+        Status = 0;
+    else
+        Status = STA_NOINIT|STA_NODISK;
+
+    return Status;
+}
+
+DSTATUS disk_status(BYTE drv)
+{
+    if(drv)
+        return STA_NOINIT|STA_NODISK;
+    return Status;
+}
+
+DRESULT disk_read(BYTE drv, BYTE *buff, DWORD sector, UINT count)
+{
+    if(drv || !count)
+        return RES_PARERR;
+
+    if(Status & (STA_NODISK | STA_NOINIT))
+        return RES_NOTRDY;
+
+    if(sector + count > image_sectors)
+        return RES_PARERR;
+
+    image_delay(image_latency.read_access_us + (count * image_latency.read_sector_us));
+    memcpy(buff, image + ((size_t)sector * IMAGE_SECTOR_SIZE), count * IMAGE_SECTOR_SIZE);
+
+    image_stats.reads++;
+    image_stats.sectors_read += count;
+
+    return RES_OK;
+}
+
+#if _FS_READONLY == 0
+DRESULT disk_write(BYTE drv, const BYTE *buff, DWORD sector, UINT count)
+{
+    if(drv || !count)
+        return RES_PARERR;
+
+    if(Status & (STA_NODISK | STA_NOINIT))
+        return RES_NOTRDY;
+
+    if(sector + count > image_sectors)
+        return RES_PARERR;
+
+    image_delay(image_latency.write_access_us + (count * image_latency.write_sector_us));
+    memcpy(image + ((size_t)sector * IMAGE_SECTOR_SIZE), buff, count * IMAGE_SECTOR_SIZE);
+
+    image_stats.writes++;
+    image_stats.sectors_written += count;
+
+    return RES_OK;
+}
+#endif // _FS_READONLY
+
+#ifdef _USE_IOCTL // _USE_IOCTL != 0
+
+DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void *buff)
+{
+    DRESULT res = RES_OK;
+
+    if(drv)
+        return RES_PARERR;
+
+    if(Status & (STA_NODISK | STA_NOINIT))
+        return RES_NOTRDY;
+
+    switch(ctrl)
+    {
+        case CTRL_SYNC:
+            if(msync(image, (size_t)image_sectors * IMAGE_SECTOR_SIZE, MS_ASYNC) == -1)
+                res = RES_ERROR;
+        break;
+        case GET_SECTOR_COUNT:
+            *(DWORD*)buff = image_sectors;
+        break;
+        case GET_SECTOR_SIZE:
+            *(DWORD*)buff = IMAGE_SECTOR_SIZE;
+        break;
+        case GET_BLOCK_SIZE:
+            *(DWORD*)buff = 1;
+        break;
+        default:
+            res = RES_PARERR;
+        break;
+    }
+
+    return res;
+}
+#endif // _USE_IOCTL != 0
+
+/**
+ * the FAT file time, from the system time.
+ */
+DWORD get_fattime(void)
+{
+    DWORD ftime = 0;
+    time_t t;
+    time(&t);
+    struct tm* lt = localtime(&t);
+    ftime = ((lt->tm_year - 80) << 25) |
+    ((lt->tm_mon + 1) << 21) |
+    ((lt->tm_mday) << 16) |
+    ((lt->tm_hour) << 11) |
+    ((lt->tm_min) << 5) |
+    (lt->tm_sec/2);
+    return ftime;
+}
+
+/**
+ * sets the simulated card timings, takes effect from the next read or write.
+ */
+void diskio_file_set_latency(const diskio_file_latency_t* latency)
+{
+    image_latency = *latency;
+}
+
+/**
+ * gets the simulated card timings in use.
+ */
+void diskio_file_get_latency(diskio_file_latency_t* latency)
+{
+    *latency = image_latency;
+}
+
+/**
+ * copies the command and sector counts, since startup or the last diskio_file_reset_stats().
+ */
+void diskio_file_get_stats(diskio_file_stats_t* stats)
+{
+    *stats = image_stats;
+}
+
+/**
+ * zeroes the command and sector counts.
+ */
+void diskio_file_reset_stats(void)
+{
+    memset(&image_stats, 0, sizeof(image_stats));
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup sdfs
+ *
+ * @file diskio_file.h
+ * @{
+ */
+
+#ifndef DISKIO_FILE_H_
+#define DISKIO_FILE_H_
+
+#include <stdint.h>
+
+/**
+ * path of the FAT image file on the host, relative to the working directory.
+ */
+#ifndef FATFS_IMAGE_FILE
+#define FATFS_IMAGE_FILE                "fatfs.img"
+#endif
+
+/**
+ * size in 512 byte sectors that a new image file is created with. an existing image keeps its size.
+ */
+#ifndef FATFS_IMAGE_SECTORS
+#define FATFS_IMAGE_SECTORS             131072
+#endif
+
+/**
+ * simulated card timings, in us. 0 disables the delay.
+ * each read or write command costs its access time once, plus the sector time per sector.
+ */
+#ifndef FATFS_IMAGE_READ_ACCESS_US
+#define FATFS_IMAGE_READ_ACCESS_US      0
+#endif
+#ifndef FATFS_IMAGE_READ_SECTOR_US
+#define FATFS_IMAGE_READ_SECTOR_US      0
+#endif
+#ifndef FATFS_IMAGE_WRITE_ACCESS_US
+#define FATFS_IMAGE_WRITE_ACCESS_US     0
+#endif
+#ifndef FATFS_IMAGE_WRITE_SECTOR_US
+#define FATFS_IMAGE_WRITE_SECTOR_US     0
+#endif
+
+typedef struct {
+    uint32_t read_access_us;        ///< delay per read command
+    uint32_t read_sector_us;        ///< delay per sector read
+    uint32_t write_access_us;       ///< delay per write command
+    uint32_t write_sector_us;       ///< delay per sector written
+} diskio_file_latency_t;
+
+typedef struct {
+    uint32_t reads;                 ///< number of read commands
+    uint32_t writes;                ///< number of write commands
+    uint32_t sectors_read;
+    uint32_t sectors_written;
+} diskio_file_stats_t;
+
+void diskio_file_set_latency(const diskio_file_latency_t* latency);
+void diskio_file_get_latency(diskio_file_latency_t* latency);
+void diskio_file_get_stats(diskio_file_stats_t* stats);
+void diskio_file_reset_stats(void);
+
+#endif /* DISKIO_FILE_H_ */
+
+/**
+ * @}
+ */
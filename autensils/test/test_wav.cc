@@ -2,6 +2,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <limits.h>
+#include <unistd.h>
 #include "gtest/gtest.h"
 #include "wav.h"
 
@@ -88,3 +89,47 @@ TEST(test_wav, wav_file_init_stream_params)
     ASSERT_TRUE(init);
     ASSERT_NE(ret, -1);
 }
+
+TEST(test_wav, wav_file_mix_to_buffer_channel)
+{
+	uint16_t wavreadlength = 256;
+	uint16_t samples = 300;
+	uint16_t channels = 2;
+	int16_t expected[samples * channels];
+	int16_t buffer[samples * channels];
+	uint8_t data[samples * 2 + 1];
+	uint32_t mixed;
+	int length;
+
+	wav_file_processing_t wp;
+	wav_file_t f;
+
+	memset(&wp, 0, sizeof(wav_file_processing_t));
+	memset(expected, 0, sizeof(expected));
+	memset(buffer, 0, sizeof(buffer));
+
+	// mix straight from the file
+	ASSERT_NE(wav_file_open(&f, "test.wav"), -1);
+	ASSERT_TRUE(wav_file_init_stream_params(&f, &wp, 2, wavreadlength));
+	wav_file_buffer_setup(&wp, &expected[1], samples, channels);
+	ASSERT_EQ(wav_file_read_mix_to_buffer_channel(&f, &wp), samples);
+	wav_file_close(&f);
+
+	// mix the same data from memory, in two uneven parts, with a partial sample on the end
+	ASSERT_NE(wav_file_open(&f, "test.wav"), -1);
+	length = read(f.fdes, data, sizeof(data));
+	ASSERT_EQ(length, (int)sizeof(data));
+	wav_file_buffer_setup(&wp, &buffer[1], samples, channels);
+	mixed = wav_file_mix_to_buffer_channel(&f, &wp, data, 101 * 2, 0);
+	ASSERT_EQ(mixed, 101u);
+	mixed += wav_file_mix_to_buffer_channel(&f, &wp, data + mixed * 2, sizeof(data) - mixed * 2, mixed);
+	ASSERT_EQ(mixed, samples);
+	wav_file_close(&f);
+
+	ASSERT_EQ(memcmp(expected, buffer, sizeof(buffer)), 0);
+
+	// stops at the end of the stream buffer
+	ASSERT_EQ(wav_file_mix_to_buffer_channel(&f, &wp, data, sizeof(data), samples - 10), 10u);
+
+	wav_file_deinit_stream_params(&wp);
+}
@@ -203,6 +203,85 @@ void wav_file_buffer_setup(wav_file_processing_t* wavproc, void* buffer, uint32_
 	wavproc->buffer_length_samples = buffer_length_samples;
 }
 
+/**
+ * mix all channels of whole wave file samples held in memory, down into one stream buffer channel.
+ *
+ * this is the mixing stage of wav_file_read_mix_to_buffer_channel(), for callers that fetch
+ * the wave data themselves (from a prefetch buffer for example).
+ * a trailing partial sample in data is ignored.
+ *
+ * @param file is the open wave file the data came from.
+ * @param wavproc is an initialized wav_file_processing_t structure.
+ * 			initialize with wav_file_init_stream_params() and wav_file_buffer_setup().
+ * @param data is the wave file data to mix, it must begin on a sample boundary.
+ * @param length is the length of data in bytes.
+ * @param offset is the sample in the stream buffer to start writing at.
+ * @retval the number of samples written to the stream buffer, stops at the end of the buffer.
+ */
+uint32_t wav_file_mix_to_buffer_channel(wav_file_t* file, wav_file_processing_t* wavproc, const void* data, uint32_t length, uint32_t offset)
+{
+	uint32_t wordcount = length / wavproc->wav_word_size_bytes;
+	uint32_t samplecount = offset;
+	const void* scratch = data;
+	void* buffer = ((uint8_t*)wavproc->buffer) + (offset * wavproc->buffer_channels * wavproc->buffer_word_size_bytes);
+	uint32_t word;
+	uint16_t i;
+	int32_t sum;
+
+	// drop a trailing partial sample
+	wordcount -= wordcount % file->header.fmt_num_channels;
+
+	// one loop per sample in wave file
+	for(word = 0; word < wordcount && samplecount < wavproc->buffer_length_samples; word += file->header.fmt_num_channels, samplecount++)
+	{
+		sum = 0;
+		// one loop per channel in the sample
+		switch(wavproc->wav_word_size_bytes)
+		{
+			case sizeof(uint8_t):
+				for(i = 0; i < file->header.fmt_num_channels; i++)
+				{
+					sum += (*(const uint8_t*)scratch)-128; // 8bit wave is unsigned
+					scratch = ((const uint8_t*)scratch) + wavproc->wav_word_size_bytes;
+				}
+				sum *= 256; // normalize to 16bits
+			break;
+			case sizeof(int16_t):
+				for(i = 0; i < file->header.fmt_num_channels; i++)
+				{
+					sum += *(const int16_t*)scratch;
+					scratch = ((const uint8_t*)scratch) + wavproc->wav_word_size_bytes;
+				}
+			break;
+			case sizeof(int32_t):
+				for(i = 0; i < file->header.fmt_num_channels; i++)
+				{
+					sum += (*(const int32_t*)scratch)/65536; // avoid overflow, divide every cycle, normalize to 16bits
+					scratch = ((const uint8_t*)scratch) + wavproc->wav_word_size_bytes;
+				}
+			break;
+
+		}
+
+		switch(wavproc->buffer_word_size_bytes)
+		{
+			case sizeof(int8_t):
+				*(int8_t*)buffer = sum / file->header.fmt_num_channels;
+			break;
+			case sizeof(int16_t):
+				*(int16_t*)buffer = sum / file->header.fmt_num_channels;
+			break;
+			case sizeof(int32_t):
+				*(int32_t*)buffer = sum / file->header.fmt_num_channels;
+			break;
+		}
+
+		buffer = ((uint8_t*)buffer) + (wavproc->buffer_channels * wavproc->buffer_word_size_bytes);
+	}
+
+	return samplecount - offset;
+}
+
 /**
  * read all channels from N wave file, mixing signal down into one stream buffer channel.
  *
@@ -216,72 +295,27 @@ void wav_file_buffer_setup(wav_file_processing_t* wavproc, void* buffer, uint32_
  * @param file is the open wave file
  * @param wavproc is an initialized wav_file_processing_t structure.
  * 			initialize with wav_file_init_stream_params() and wav_file_buffer_setup().
- * @param multiply is a number to multiply samples by before after summing. it can be used to amplify the output data.
  */
 uint32_t wav_file_read_mix_to_buffer_channel(wav_file_t* file, wav_file_processing_t* wavproc)
 {
-	uint32_t wordsread = wavproc->workarea_length_samples;
+	uint32_t length = wavproc->wav_read_length_bytes;
 	uint32_t samplecount = 0;
-	void* scratch;
-	void* buffer = wavproc->buffer;
-	uint32_t word;
-	uint16_t i;
-	int32_t sum;
+	int bytesread = length;
+	uint32_t remaining;
 
-	// one loop per 256 samples
-	while(wordsread == wavproc->workarea_length_samples && samplecount < wavproc->buffer_length_samples)
+	// one loop per workarea full of samples
+	while((uint32_t)bytesread == length && samplecount < wavproc->buffer_length_samples)
 	{
-		wordsread = read(file->fdes, wavproc->workarea, wavproc->wav_read_length_bytes);
-		wordsread /= wavproc->wav_word_size_bytes;
-		scratch = wavproc->workarea;
+		// read no more than the buffer has room for
+		remaining = (wavproc->buffer_length_samples - samplecount) * file->header.fmt_num_channels * wavproc->wav_word_size_bytes;
+		if(remaining < length)
+			length = remaining;
 
-		// one loop per sample in wave file
-		for(word = 0; word < wordsread; word += file->header.fmt_num_channels, samplecount++)
-		{
-			sum = 0;
-			// one loop per channel in the sample
-			switch(wavproc->wav_word_size_bytes)
-			{
-				case sizeof(uint8_t):
-					for(i = 0; i < file->header.fmt_num_channels; i++)
-					{
-						sum += (*(uint8_t*)scratch)-128; // 8bit wave is unsigned
-						scratch = ((uint8_t*)scratch) + wavproc->wav_word_size_bytes;
-					}
-					sum *= 256; // normalize to 16bits
-				break;
-				case sizeof(int16_t):
-					for(i = 0; i < file->header.fmt_num_channels; i++)
-					{
-						sum += *(int16_t*)scratch;
-						scratch = ((uint8_t*)scratch) + wavproc->wav_word_size_bytes;
-					}
-				break;
-				case sizeof(int32_t):
-					for(i = 0; i < file->header.fmt_num_channels; i++)
-					{
-						sum += (*(int32_t*)scratch)/65536; // avoid overflow, divide every cycle, normalize to 16bits
-						scratch = ((uint8_t*)scratch) + wavproc->wav_word_size_bytes;
-					}
-				break;
-
-			}
-
-			switch(wavproc->buffer_word_size_bytes)
-			{
-				case sizeof(int8_t):
-					*(int8_t*)buffer = sum / file->header.fmt_num_channels;
-				break;
-				case sizeof(int16_t):
-					*(int16_t*)buffer = sum / file->header.fmt_num_channels;
-				break;
-				case sizeof(int32_t):
-					*(int32_t*)buffer = sum / file->header.fmt_num_channels;
-				break;
-			}
-
-			buffer = ((uint8_t*)buffer) + (wavproc->buffer_channels * wavproc->buffer_word_size_bytes);
-		}
+		bytesread = read(file->fdes, wavproc->workarea, length);
+		if(bytesread < 1)
+			break;
+
+		samplecount += wav_file_mix_to_buffer_channel(file, wavproc, wavproc->workarea, bytesread, samplecount);
 	}
 
 	return samplecount;
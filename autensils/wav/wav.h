@@ -165,6 +165,7 @@ void wav_file_buffer_setup(wav_file_processing_t* wavproc, void* buffer, uint32_
 void wav_file_deinit_stream_params(wav_file_processing_t* wavproc);
 void wav_file_close(wav_file_t* file);
 uint32_t wav_file_read_mix_to_buffer_channel(wav_file_t* file, wav_file_processing_t* wavproc);
+uint32_t wav_file_mix_to_buffer_channel(wav_file_t* file, wav_file_processing_t* wavproc, const void* data, uint32_t length, uint32_t offset);
 uint16_t wav_file_get_channels(wav_file_t* file);
 uint32_t wav_file_get_data_length(wav_file_t* file);
 uint32_t wav_file_get_samplerate(wav_file_t* file);
@@ -30,14 +30,21 @@
  *
  */
 
+#include <string.h>
+#include <unistd.h>
 #include "wavstream.h"
 
 
 static void wavstream_service_callback_mixdown(unsigned_stream_type_t* buffer, uint16_t length, uint8_t channels, stream_connection_t* wavstream);
+static void wavstream_prefetch_task(wavstream_t* wavstream);
 
 /**
  * streams a wave file out of the specified stream device.
  *
+ * the file is read ahead into a ring buffer of WAVSTREAM_PREFETCH_LENGTH bytes by a reader task,
+ * so the stream callback only ever copies from RAM and a slow SD card access does not
+ * starve the stream.
+ *
  * **NOTE**
  * - this module will only work with a stream that supports signed data (i2s_stream is an example)
  * - supports 8b unsigned PCM, 16bit signed PCM, 32bit signed PCM (extensible format not validated)
@@ -65,37 +72,148 @@ void wavstream_init(wavstream_t* wavstream, stream_connection_t* conn, stream_t*
 
 	init_wavstream_mutex();
 
+	wavstream->prefetching = false;
+	wavstream->eof = false;
+	memset(&wavstream->stats, 0, sizeof(wavstream_stats_t));
+	wavstream->stats.prefetch_length = WAVSTREAM_PREFETCH_LENGTH;
+	wavstream->prefetch = ringbuf_create(WAVSTREAM_PREFETCH_LENGTH);
+	assert_true(wavstream->prefetch);
+	wavstream->reading = xSemaphoreCreateMutex();
+	assert_true(wavstream->reading);
+	wavstream->fill = xSemaphoreCreateBinary();
+	assert_true(wavstream->fill);
+
+	if(xTaskCreate((TaskFunction_t)wavstream_prefetch_task,
+					name,
+					configMINIMAL_STACK_SIZE + WAVSTREAM_PREFETCH_TASK_STACK,
+					wavstream,
+					tskIDLE_PRIORITY + WAVSTREAM_PREFETCH_TASK_PRIORITY,
+					NULL) != pdPASS)
+		log_error(&wavstream->log, "failed to create reader task");
+
     wavstream_set_level(conn, wavstream->fsa);
 }
 
+/**
+ * reads the wave file into the prefetch ring buffer until it is full or the file is exhausted.
+ *
+ * only whole wave samples are put into the ring buffer, so the stream callback
+ * always takes data out on a sample boundary.
+ * must be called with the reading mutex held.
+ */
+static void wavstream_prefetch(wavstream_t* wavstream)
+{
+	uint32_t samplesize = wav_file_get_channels(&wavstream->file) * wav_file_get_wordsize_bytes(&wavstream->file);
+	TickType_t start;
+	uint32_t elapsed;
+	int length;
+
+	while(wavstream->prefetching && !wavstream->eof &&
+			ringbuf_space(wavstream->prefetch) >= wavstream->chunk)
+	{
+		start = xTaskGetTickCount();
+		length = read(wavstream->file.fdes, wavstream->readbuf, wavstream->chunk);
+		elapsed = (xTaskGetTickCount() - start) * portTICK_RATE_MS;
+		if(elapsed > wavstream->stats.slowest_read)
+			wavstream->stats.slowest_read = elapsed;
+
+		if(length < (int)wavstream->chunk)
+		{
+			if(length > 0)
+				ringbuf_put(wavstream->prefetch, wavstream->readbuf, length - (length % samplesize));
+			// set only after the last data is in, the stream callback stops on eof and an empty ring buffer
+			wavstream->eof = true;
+		}
+		else
+			ringbuf_put(wavstream->prefetch, wavstream->readbuf, length);
+	}
+}
+
+/**
+ * keeps the prefetch ring buffer topped up while a file is playing.
+ * woken by the stream callback each time it has taken data out.
+ */
+static void wavstream_prefetch_task(wavstream_t* wavstream)
+{
+	while(1)
+	{
+		xSemaphoreTake(wavstream->fill, portMAX_DELAY);
+
+		if(xSemaphoreTake(wavstream->reading, portMAX_DELAY) == pdTRUE)
+		{
+			wavstream_prefetch(wavstream);
+			xSemaphoreGive(wavstream->reading);
+		}
+	}
+}
+
 /**
  * stream callback function.
  *
  * operates on one stream channel only.
+ * takes data from the prefetch ring buffer only, never from the file. when the ring buffer
+ * runs dry before the end of the file, the rest of the buffer is filled with silence and
+ * an underrun is counted.
  */
 void wavstream_service_callback_mixdown(unsigned_stream_type_t* buffer, uint16_t length, uint8_t channels, stream_connection_t* conn)
 {
 	uint32_t samplesread = 0;
+	uint32_t samplesize;
+	uint32_t count;
+	uint32_t used;
 	uint16_t i;
+	bool finished = false;
     wavstream_t* wavstream = (wavstream_t*)conn->ctx;
 
-	if(wavstream_take_mutex() && conn->enabled)
+	if(wavstream_take_mutex())
 	{
-		// wave file part
-		wav_file_buffer_setup(&wavstream->wavproc, buffer, length, channels);
+		if(conn->enabled)
+		{
+			samplesize = wav_file_get_channels(&wavstream->file) * wav_file_get_wordsize_bytes(&wavstream->file);
 
-		samplesread = wav_file_read_mix_to_buffer_channel(&wavstream->file, &wavstream->wavproc);
+			// the ring buffer drains at the end of the file, that does not count
+			used = ringbuf_used(wavstream->prefetch);
+			if(!wavstream->eof && used < wavstream->stats.low_watermark)
+				wavstream->stats.low_watermark = used;
 
-		// scale to user defined level
-		for(i = 0; i < length; i++)
-		{
-			*buffer = *((signed_stream_type_t*)buffer) * wavstream->level / wavstream->fsa;
-			buffer += channels;
+			// wave file part
+			wav_file_buffer_setup(&wavstream->wavproc, buffer, length, channels);
+
+			while(samplesread < length)
+			{
+				count = (length - samplesread) * samplesize;
+				if(count > wavstream->wavproc.wav_read_length_bytes)
+					count = wavstream->wavproc.wav_read_length_bytes;
+				count = ringbuf_get(wavstream->prefetch, wavstream->wavproc.workarea, count);
+				if(!count)
+					break;
+				samplesread += wav_file_mix_to_buffer_channel(&wavstream->file, &wavstream->wavproc,
+																wavstream->wavproc.workarea, count, samplesread);
+			}
+
+			xSemaphoreGive(wavstream->fill);
+
+			if(samplesread < length)
+			{
+				finished = wavstream->eof && ringbuf_used(wavstream->prefetch) == 0;
+				if(!finished)
+					wavstream->stats.underruns++;
+				// pad with silence
+				for(i = samplesread; i < length; i++)
+					buffer[i * channels] = 0;
+			}
+
+			// scale to user defined level
+			for(i = 0; i < length; i++)
+			{
+				*buffer = *((signed_stream_type_t*)buffer) * wavstream->level / wavstream->fsa;
+				buffer += channels;
+			}
 		}
 		wavstream_give_mutex();
 	}
 
-    if(samplesread < length)
+    if(finished)
     	wavstream_enable(conn, NULL);
 }
 
@@ -117,6 +235,15 @@ void wavstream_set_level(stream_connection_t* conn, signed_stream_type_t level)
         log_warning(&wavstream->log, "level %dmV out of range, range is 0 to %dmV", level, wavstream->fsa);
 }
 
+/**
+ * copies the prefetch statistics of the current or last playback into stats.
+ */
+void wavstream_get_stats(stream_connection_t* conn, wavstream_stats_t* stats)
+{
+    wavstream_t* wavstream = (wavstream_t*)conn->ctx;
+    *stats = wavstream->stats;
+}
+
 /**
  * @retval  returns the signal generator level in mV.
  */
@@ -166,6 +293,19 @@ void wavstream_enable(stream_connection_t* conn, const char* file)
 														sizeof(signed_stream_type_t), WAV_FILE_WORK_AREA_LENGTH);
 					if(enable)
 					{
+						// fill the prefetch ring buffer before the stream starts taking data
+						wavstream->chunk = WAVSTREAM_PREFETCH_CHUNK - (WAVSTREAM_PREFETCH_CHUNK %
+											(wav_file_get_channels(&wavstream->file) * wav_file_get_wordsize_bytes(&wavstream->file)));
+						ringbuf_reset(wavstream->prefetch);
+						wavstream->eof = false;
+						wavstream->stats.low_watermark = WAVSTREAM_PREFETCH_LENGTH;
+						wavstream->stats.underruns = 0;
+						wavstream->stats.slowest_read = 0;
+						wavstream->prefetching = true;
+						xSemaphoreTake(wavstream->reading, portMAX_DELAY);
+						wavstream_prefetch(wavstream);
+						xSemaphoreGive(wavstream->reading);
+
 						// set the stream samplerate to match the file
 						wavstream->restore_samplerate = wavstream->getsamplerate();
 						if(wavstream->restore_samplerate != wavstream->file.header.fmt_sample_rate)
@@ -185,7 +325,11 @@ void wavstream_enable(stream_connection_t* conn, const char* file)
 		else if(conn->enabled)
 		{
 			stream_connection_enable(conn, false);
+			// wait for any read in progress before closing the file
+			wavstream->prefetching = false;
+			xSemaphoreTake(wavstream->reading, portMAX_DELAY);
 			wav_file_close(&wavstream->file);
+			xSemaphoreGive(wavstream->reading);
 			if(wavstream->restore_samplerate != wavstream->getsamplerate())
 				wavstream->setsamplerate(wavstream->restore_samplerate);
 			wav_file_deinit_stream_params(&wavstream->wavproc);
@@ -53,6 +53,41 @@
 #pragma message "building wavstream with thread safety 'off', WAVSTREAM_USE_MUTEX=0"
 #endif
 
+#include "ringbuf.h"
+
+/**
+ * size in bytes of the PCM prefetch ring buffer, filled from the file by the reader task.
+ * at 44.1kHz 16bit stereo, 16kB holds about 90ms of audio.
+ */
+#ifndef WAVSTREAM_PREFETCH_LENGTH
+#define WAVSTREAM_PREFETCH_LENGTH       16384
+#endif
+
+/**
+ * size in bytes of each file read made by the reader task.
+ */
+#ifndef WAVSTREAM_PREFETCH_CHUNK
+#define WAVSTREAM_PREFETCH_CHUNK        512
+#endif
+
+#ifndef WAVSTREAM_PREFETCH_TASK_PRIORITY
+#define WAVSTREAM_PREFETCH_TASK_PRIORITY    2
+#endif
+
+#ifndef WAVSTREAM_PREFETCH_TASK_STACK
+#define WAVSTREAM_PREFETCH_TASK_STACK       128
+#endif
+
+/**
+ * prefetch statistics, reset every time playback starts.
+ */
+typedef struct {
+    uint32_t prefetch_length;   ///< size of the prefetch ring buffer in bytes
+    uint32_t low_watermark;     ///< the fewest bytes buffered when the stream asked for data
+    uint32_t underruns;         ///< number of stream buffers that ran out of data before the end of the file
+    uint32_t slowest_read;      ///< the longest single file read made by the reader task, in ms
+} wavstream_stats_t;
+
 
 typedef struct {
     logger_t log;
@@ -66,6 +101,14 @@ typedef struct {
 #if WAVSTREAM_USE_MUTEX
     SemaphoreHandle_t busy;
 #endif
+    ringbuf_t* prefetch;                ///< PCM data read ahead of the stream
+    SemaphoreHandle_t reading;          ///< held by the reader task while it uses the file
+    SemaphoreHandle_t fill;             ///< given to wake the reader task
+    volatile bool prefetching;          ///< true while the reader task should keep the ring buffer topped up
+    volatile bool eof;                  ///< set by the reader task once the whole file is in the ring buffer
+    uint32_t chunk;                     ///< file read size, a whole number of wave samples
+    uint8_t readbuf[WAVSTREAM_PREFETCH_CHUNK];
+    wavstream_stats_t stats;
 } wavstream_t;
 
 #if WAVSTREAM_USE_MUTEX
@@ -89,6 +132,7 @@ void wavstream_enable(stream_connection_t* conn, const char* file);
 bool wavstream_enabled(stream_connection_t* conn);
 void wavstream_set_level(stream_connection_t* conn, signed_stream_type_t level);
 signed_stream_type_t wavstream_get_level(stream_connection_t* conn);
+void wavstream_get_stats(stream_connection_t* conn, wavstream_stats_t* stats);
 
 #endif /* WAVSTREAM_H_ */
 
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+
+
+/**
+ * configuration for the like-posix project, shared by the host benches, see build-env/collect.mk.
+ * a project may supply its own copy, or override the settings wrapped in #ifndef with -D in its Makefile.
+ */
+
+#ifndef LIKEPOSIX_CONFIG_H_
+#define LIKEPOSIX_CONFIG_H_
+
+/**
+ * fudge factor for the file table, presently can be any value higher than STDIN_FILENO...
+ */
+#define FILE_TABLE_OFFSET		10
+/**
+ * the maximum number of open files/devices, sockets included
+ */
+#ifndef FILE_TABLE_LENGTH
+#define FILE_TABLE_LENGTH 		64
+#endif
+/**
+ * the maximum number of installed devices, maximum of 255
+ */
+#define DEVICE_TABLE_LENGTH 	10
+/**
+ * location where devices get installed to
+ */
+#define DEVICE_INTERFACE_DIRECTORY 	"/dev/"
+/**
+ * this is a hack that adds an ofset in seconds onto the time returned by time/gettimeofday.
+ * corrects time set by NTP for your timezone. 12 hours for NZT
+ */
+#define TIMEZONE_OFFSET (12 * 60 * 60)
+/**
+ * enable integration of lwip sockets in likeposix
+ */
+#ifndef ENABLE_LIKEPOSIX_SOCKETS
+#define ENABLE_LIKEPOSIX_SOCKETS    0
+#endif
+/**
+ * count file table and file lock contention, see file_table_lock_stats()
+ */
+#ifndef LIKEPOSIX_LOCK_STATS
+#define LIKEPOSIX_LOCK_STATS        0
+#endif
+
+#endif /* LIKEPOSIX_CONFIG_H_ */
@@ -59,6 +59,15 @@ include $(BUILD_ENV_DIR)/jsmn.mk
 include $(BUILD_ENV_DIR)/autensils.mk
 include $(BUILD_ENV_DIR)/pthreads.mk
 
+## host builds use the native toolchain, FAMILY is set by the board
+ifeq ($(FAMILY), HOST)
+CC=gcc
+OBJCOPY=objcopy
+SIZE=size
+OBJDUMP=objdump
+NM = nm
+endif
+
 ## definitions
 CFLAGS += -D CLEVER_DEFAULT_INTERRUPT_HANDLER=$(CLEVER_DEFAULT_INTERRUPT_HANDLER)
 CFLAGS += -D PROJECT_VERSION='"$(PROJECT_VERSION)"'
@@ -77,6 +86,11 @@ endif
 CFLAGS += -O$(OPT)
 CFLAGS += -std=gnu99
 CFLAGS += -I ./
+# configuration shared by the host benches, after the project directory so that a
+# project may still supply its own FreeRTOSConfig.h, likeposix_config.h or lwipopts.h
+ifeq ($(FAMILY), HOST)
+CFLAGS += -I $(BUILD_ENV_DIR)/bench_common
+endif
 CFLAGS += -ffunction-sections
 CFLAGS += -fdata-sections
 CFLAGS += -fno-builtin
@@ -99,6 +113,15 @@ ASFLAGS += -Wa,-adhlns=$(addprefix $(OUTDIR)/, $(notdir $(addsuffix .lst, $(base
 #ASFLAGS += $(patsubst %,-I%,$(EXTRAINCDIRS))
 
 ## Linker options
+ifeq ($(FAMILY), HOST)
+LINKER_FLAGS += -pthread
+LINKER_FLAGS += -Xlinker -o$(OUTPUT_PREFIX).elf
+LINKER_FLAGS += -Xlinker -Map=$(OUTPUT_PREFIX).map
+LINKER_FLAGS += -Xlinker -gc-sections
+
+## add any libraries here
+LIBS += -lm -lrt
+else
 # to allow for C++, remove -nostartfiles
 ifndef __cplusplus
 LINKER_FLAGS += -nostartfiles
@@ -112,6 +135,7 @@ LINKER_FLAGS += -Xlinker -gc-sections
 
 ## add any libraries here
 LIBS += -lm -lc -lnosys
+endif
 
 
 ####################################################################
@@ -123,7 +147,12 @@ ALLSRCBASE = $(notdir $(basename $(SOURCE))) $(notdir $(basename $(ASOURCE)))
 # List of all objects files.
 OBJS = $(addprefix $(OUTDIR)/, $(addsuffix .o, $(ALLSRCBASE)))
 
+ifeq ($(FAMILY), HOST)
+# a host build runs the elf file directly
+all: begin gccversion $(OUTPUT_PREFIX).elf size proj_version end
+else
 all: begin gccversion buildlinkerscript $(OUTPUT_PREFIX).bin log size proj_version end
+endif
 	
 # binary file
 $(OUTPUT_PREFIX).bin : $(OUTPUT_PREFIX).elf Makefile
@@ -156,6 +185,7 @@ $(OUTDIR)/startup.o : $(STARTUP_SOURCE) Makefile
 clean :
 	-rm -f $(OBJS)
 	-rm -f $(OUTDIR)/startup.o
+	-rm -f $(ROMFS_IMAGE)
 	-rm -f $(OUTPUT_PREFIX).elf
 	-rm -f $(OUTPUT_PREFIX).bin
 	-rm -f $(OUTPUT_PREFIX).map
@@ -5,7 +5,14 @@ ifeq ($(filter $(USE_DRIVER_FAT_FILESYSTEM),$(USE_DRIVER_FAT_FILESYSTEM_VALUES))
 $(error USE_DRIVER_FAT_FILESYSTEM is not set. set to one of: $(USE_DRIVER_FAT_FILESYSTEM))
 endif
 
+USE_FATFS_IMAGE_FILE_VALUES = 0 1
+
+ifeq ($(filter $(USE_FATFS_IMAGE_FILE),$(USE_FATFS_IMAGE_FILE_VALUES)), )
+$(error USE_FATFS_IMAGE_FILE is not set. set to one of: $(USE_FATFS_IMAGE_FILE_VALUES))
+endif
+
 CFLAGS += -DUSE_DRIVER_FAT_FILESYSTEM=$(USE_DRIVER_FAT_FILESYSTEM)
+CFLAGS += -DUSE_FATFS_IMAGE_FILE=$(USE_FATFS_IMAGE_FILE)
 
 ## FAT Filesystem
 ifeq ($(USE_DRIVER_FAT_FILESYSTEM), 1)
@@ -13,7 +20,15 @@ SOURCE += $(FATFS_DIR)/core/option/syscall.c
 SOURCE += $(FATFS_DIR)/core/option/ccsbcs.c
 SOURCE += $(FATFS_DIR)/core/ff.c
 
+ifeq ($(USE_FATFS_IMAGE_FILE), 1)
+ifneq ($(FAMILY), HOST)
+$(error USE_FATFS_IMAGE_FILE is only supported by the host device)
+endif
+SOURCE += $(FATFS_DIR)/diskio_file.c
+CFLAGS += -I$(FATFS_DIR)
+else
 SOURCE += $(FATFS_DIR)/diskio_stm32.c
+endif
 
 CFLAGS += -I$(FATFS_DIR)/core
 
@@ -30,8 +30,13 @@ SOURCE += $(FREERTOSDIR)/portable/GCC/ARM_CM4F/port.c
 CFLAGS += -I$(FREERTOSDIR)/portable/GCC/ARM_CM4F
 SOURCE += $(FREERTOSDIR)/../heap_ccram.c
 else
+ifeq ($(FAMILY), HOST)
+SOURCE += $(FREERTOSDIR)/portable/GCC/POSIX/port.c
+CFLAGS += -I$(FREERTOSDIR)/portable/GCC/POSIX
+else
 $(error the FAMILY specified '$(FAMILY)' is invalid, it is meant to be set in board.mk)
 endif
 endif
+endif
 
 endif
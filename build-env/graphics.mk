@@ -5,7 +5,14 @@ ifeq ($(filter $(USE_GRAPHICS),$(USE_GRAPHICS_VALUES)), )
 $(error USE_GRAPHICS is not set. set to one of: $(USE_GRAPHICS_VALUES))
 endif
 
+USE_GRAPHIC_GLYPH_CACHE_VALUES = 0 1
+
+ifeq ($(filter $(USE_GRAPHIC_GLYPH_CACHE),$(USE_GRAPHIC_GLYPH_CACHE_VALUES)), )
+$(error USE_GRAPHIC_GLYPH_CACHE is not set. set to one of: $(USE_GRAPHIC_GLYPH_CACHE_VALUES))
+endif
+
 CFLAGS += -DUSE_GRAPHICS=$(USE_GRAPHICS)
+CFLAGS += -DUSE_GRAPHIC_GLYPH_CACHE=$(USE_GRAPHIC_GLYPH_CACHE)
 
 ifeq ($(USE_GRAPHICS), 1)
 
@@ -19,6 +26,10 @@ SOURCE += $(GRAPHICSDIR)/text.c
 SOURCE += $(GRAPHICSDIR)/image.c
 SOURCE += $(GRAPHICSDIR)/shape.c
 
+ifeq ($(USE_GRAPHIC_GLYPH_CACHE), 1)
+SOURCE += $(GRAPHICSDIR)/glyph_cache.c
+endif
+
 SOURCE += $(GRAPHICSDIR)/images/images.c
 
 SOURCE += $(GRAPHICSDIR)/fonts/Ubuntu_16.c
@@ -8,7 +8,14 @@ ifeq ($(filter $(USE_LIKEPOSIX),$(USE_LIKEPOSIX_VALUES)), )
 $(error USE_LIKEPOSIX is not set. set to one of: $(USE_LIKEPOSIX))
 endif
 
+USE_ROMFS_VALUES = 0 1
+
+ifeq ($(filter $(USE_ROMFS),$(USE_ROMFS_VALUES)), )
+$(error USE_ROMFS is not set. set to one of: $(USE_ROMFS_VALUES))
+endif
+
 CFLAGS += -DUSE_LIKEPOSIX=$(USE_LIKEPOSIX)
+CFLAGS += -DUSE_ROMFS=$(USE_ROMFS)
 
 ifeq ($(USE_LIKEPOSIX), 1) 
 
@@ -26,8 +33,26 @@ endif
 
 # override minimal syscalls with full implementation
 SYSCALLS = $(LIKEPOSIX_DIR)/syscalls.c
+SYSCALLS += $(LIKEPOSIX_DIR)/ringbuf.c
+# newlib allocator hooks, on the host malloc is provided by device/HOST/libc_host.c
+ifneq ($(FAMILY), HOST)
 SYSCALLS += $(LIKEPOSIX_DIR)/stdlib_impl.c
+endif
 CFLAGS += -I$(LIKEPOSIX_DIR)
+
+## read only file system image, generated from ROMFS_SOURCE_DIR
+ifeq ($(USE_ROMFS), 1)
+ROMFS_IMAGE = $(OUTDIR)/romfs_image.c
+SYSCALLS += $(LIKEPOSIX_DIR)/romfs.c
+SYSCALLS += $(ROMFS_IMAGE)
+
+$(ROMFS_IMAGE) : $(shell find $(ROMFS_SOURCE_DIR) -type f) $(BUILD_ENV_DIR)/tools/mkromfs.py
+	python $(BUILD_ENV_DIR)/tools/mkromfs.py $(ROMFS_SOURCE_DIR) $(ROMFS_IMAGE) $(ROMFS_MOUNT_POINT)
+endif
+else
+ifeq ($(USE_ROMFS), 1)
+$(error to use the read only file system, USE_LIKEPOSIX must be set to 1)
+endif
 endif
 
 
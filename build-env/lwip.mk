@@ -1,11 +1,17 @@
 
 USE_DRIVER_LWIP_NET_VALUES = 0 1
+USE_ETH_ZERO_COPY_VALUES = 0 1
 
 ifeq ($(filter $(USE_DRIVER_LWIP_NET),$(USE_DRIVER_LWIP_NET_VALUES)), )
 $(error USE_DRIVER_LWIP_NET is not set. set to one of: $(USE_DRIVER_LWIP_NET_VALUES))
 endif
 
+ifeq ($(filter $(USE_ETH_ZERO_COPY),$(USE_ETH_ZERO_COPY_VALUES)), )
+$(error USE_ETH_ZERO_COPY is not set. set to one of: $(USE_ETH_ZERO_COPY_VALUES))
+endif
+
 CFLAGS += -DUSE_DRIVER_LWIP_NET=$(USE_DRIVER_LWIP_NET)
+CFLAGS += -DUSE_ETH_ZERO_COPY=$(USE_ETH_ZERO_COPY)
 CFLAGS += -I$(LWIP_DIR)/src/include
 CFLAGS += -I$(LWIP_DIR)/src/include/ipv4
 CFLAGS += -I$(LWIP_DIR)/src/include/netif
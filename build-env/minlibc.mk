@@ -26,6 +26,8 @@ SOURCE += $(MINLIBCDIR)/stdlib.c
 SOURCE += $(MINLIBCDIR)/unistd.c
 ifeq ($(USE_LIKEPOSIX), 1)
 SOURCE += $(MINLIBCDIR)/termios.c
+SOURCE += $(MINLIBCDIR)/poll.c
+SOURCE += $(MINLIBCDIR)/sendfile.c
 endif
 ifeq ($(USE_DRIVER_FAT_FILESYSTEM), 1)
 SOURCE += $(MINLIBCDIR)/dirent.c
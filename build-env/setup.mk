@@ -81,6 +81,9 @@ USE_CONFPARSE ?= 0
 USE_LOGGER ?= 0
 USE_UDP_LOGGER ?= 0
 USE_LOGGER_TIMESTAMP ?= 1
+# set to 1 to have log records written out by a background logger task
+# depends on USE_FREERTOS set to 1
+USE_ASYNC_LOGGER ?= 0
 
 ## to use pthreads, freertos is required.
 # set to 1 to enable
@@ -90,6 +93,12 @@ PTHREAD_THREADS_MAX ?= 32
 ## to use many of the facilities, posix style IO is required.
 # set to 1 to enable
 USE_LIKEPOSIX ?= 0
+# set to 1 to link a read only file system image into flash, laid over the FAT file system.
+# the image is generated at build time from ROMFS_SOURCE_DIR, see like-posix/romfs.h
+# depends on USE_LIKEPOSIX set to 1
+USE_ROMFS ?= 0
+ROMFS_SOURCE_DIR ?= $(LIKEPOSIX_DIR)/base_fs
+ROMFS_MOUNT_POINT ?=
 
 ## socket utilities from the nutensils project
 # set to 1 to enable, set to 0 to disable
@@ -117,6 +126,8 @@ USE_GRAPHICS ?= 0
 USE_GRAPHIC_WIDGET_TOUCH_KEY ?= 0
 USE_GRAPHIC_WIDGET_PANEL_METER ?= 0
 USE_GRAPHIC_WIDGET_STATUSBAR ?= 0
+# set to 1 to draw text from a cache of pre-rendered glyphs
+USE_GRAPHIC_GLYPH_CACHE ?= 0
 
 ## wave file module from the autensils module
 # set to 1 to enable, set to 0 to disable
@@ -142,16 +153,24 @@ USE_DRIVER_TOUCH_PANEL ?= 0
 # Networking. PHY selection is set in board.mk
 USE_DRIVER_UIP_NET ?= 0
 USE_DRIVER_LWIP_NET ?= 0
+# STM32 MAC only, hand frames between LwIP and the ethernet DMA without copying them
+USE_ETH_ZERO_COPY ?= 0
 # FAT Filesystem and SD Card driver selection go together
 USE_DRIVER_SDCARD_SPI ?= 0
 USE_DRIVER_SDCARD ?= 0
 USE_DRIVER_FAT_FILESYSTEM ?= 0
 # SDIO mode, polled or thread aware
 USE_THREAD_AWARE_SDCARD_DRIVER ?= 0
+# host builds only, back the filesystem with a FAT image file rather than the RAM disk, see FatFs/diskio_file.h
+USE_FATFS_IMAGE_FILE ?= 0
 # Enable steam drivers
 USE_DRIVER_ADC_STREAM ?= 0
 USE_DRIVER_DAC_STREAM ?= 0
 USE_DRIVER_I2S_STREAM ?= 0
+# host builds only, runs stream connections from a simulated DMA, see stream/sim/sim_stream.c
+USE_DRIVER_SIM_STREAM ?= 0
+# record the processing time of each stream connection, requires USE_DRIVER_SYSTEM_TIMER
+USE_STREAM_STATS ?= 0
 # PWM driver
 USE_DRIVER_PWM ?= 0
 # 1 wire drivers
@@ -17,9 +17,11 @@ SYSTEMDIR = $(DEVICE_SUPPORT_DIR)/system
 CFLAGS += -I$(SYSTEMDIR)
 CFLAGS += -DDEBUG_PRINTF_EXCEPTIONS=$(DEBUG_PRINTF_EXCEPTIONS)
 
+ifneq ($(FAMILY), HOST)
 SOURCE += $(SYSTEMDIR)/system.c
-SOURCE += $(SYSTEMDIR)/asserts.c
 SOURCE += $(SYSTEMDIR)/hardware_exception.c
+endif
+SOURCE += $(SYSTEMDIR)/asserts.c
 SOURCE += $(SYSTEMDIR)/services.c
 ifeq ($(USE_FREERTOS), 1)
 SOURCE += $(SYSTEMDIR)/stackoverflow.c
@@ -36,7 +38,11 @@ CFLAGS += -I$(DRIVERSDIR)
 ## System Clock timer
 CFLAGS += -DUSE_DRIVER_SYSTEM_TIMER=$(USE_DRIVER_SYSTEM_TIMER)
 ifeq ($(USE_DRIVER_SYSTEM_TIMER), 1)
+ifeq ($(FAMILY), HOST)
+SOURCE += $(CHIPSUPPORTDIR)/systime_host.c
+else
 SOURCE += $(DRIVERSDIR)/system_timer/systime.c
+endif
 CFLAGS += -I$(DRIVERSDIR)/system_timer
 endif
 
@@ -56,6 +62,10 @@ $(error to use the LCD driver, USE_FREERTOS must be set to 1)
 endif
 
 CFLAGS += -I$(DRIVERSDIR)/lcd
+ifeq ($(FAMILY), HOST)
+# the host has a framebuffer display, without a touch panel or backlight
+SOURCE += $(CHIPSUPPORTDIR)/lcd_host.c
+else
 SOURCE += $(DRIVERSDIR)/lcd/lcd.c
 SOURCE += $(DRIVERSDIR)/touch_panel/tsc2046.c
 SOURCE += $(DRIVERSDIR)/touch_panel/touch_panel.c
@@ -64,6 +74,7 @@ CFLAGS += -I $(DRIVERSDIR)/lcd
 SOURCE += $(DRIVERSDIR)/lcd_backlight/lcd_backlight.c
 CFLAGS += -I $(DRIVERSDIR)/lcd_backlight
 endif
+endif
 
 ## 1 wire
 CFLAGS += -DUSE_DRIVER_1WIRE=$(USE_DRIVER_1WIRE)
@@ -99,7 +110,11 @@ ifneq ($(USE_DRIVER_SYSTEM_TIMER), 1)
 $(error to use the SDIO driver, USE_DRIVER_SYSTEM_TIMER must be set to 1)
 endif
 
+ifeq ($(FAMILY), HOST)
+SOURCE += $(CHIPSUPPORTDIR)/sdcard_host.c
+else
 SOURCE += $(DRIVERSDIR)/sdcard/sdcard.c
+endif
 SOURCE += $(DRIVERSDIR)/sdcard/sdfs.c
 CFLAGS += -I$(DRIVERSDIR)/sdcard
 endif
@@ -122,6 +137,12 @@ SOURCE += $(DRIVERSDIR)/net_lwip/netconf.c
 SOURCE += $(DRIVERSDIR)/net_lwip/netif/ethernetif.c
 SOURCE += $(DRIVERSDIR)/net_lwip/arch/sys_arch.c
 
+ifeq ($(FAMILY), HOST)
+# there is no PHY on the host, ethernetif.c loops frames back to the interface
+CFLAGS += -I$(DRIVERSDIR)/ethernet
+CFLAGS += -DCHECKSUM_BY_HARDWARE=0
+endif
+
 endif
 
 ## Ethernet PHY, ENC28J60
@@ -152,10 +173,23 @@ else
 ifeq ($(USE_DRIVER_ADC_STREAM),1)
 SOURCE += $(DRIVERSDIR)/stream/stream_common.c
 CFLAGS += -I$(DRIVERSDIR)/stream
+else
+ifeq ($(USE_DRIVER_SIM_STREAM),1)
+SOURCE += $(DRIVERSDIR)/stream/stream_common.c
+CFLAGS += -I$(DRIVERSDIR)/stream
+endif
 endif
 endif
 endif
 
+## stream processing time statistics
+CFLAGS += -DUSE_STREAM_STATS=$(USE_STREAM_STATS)
+ifeq ($(USE_STREAM_STATS), 1)
+ifneq ($(USE_DRIVER_SYSTEM_TIMER), 1)
+$(error to use USE_STREAM_STATS, USE_DRIVER_SYSTEM_TIMER must be set to 1)
+endif
+endif
+
 ## ADC streaming driver
 CFLAGS += -DUSE_DRIVER_ADC_STREAM=$(USE_DRIVER_ADC_STREAM)
 ifeq ($(USE_DRIVER_ADC_STREAM), 1)
@@ -185,6 +219,16 @@ SOURCE += $(DRIVERSDIR)/stream/i2s/i2s_stream.c
 CFLAGS += -I$(DRIVERSDIR)/stream/i2s
 endif
 
+## simulated streaming driver
+CFLAGS += -DUSE_DRIVER_SIM_STREAM=$(USE_DRIVER_SIM_STREAM)
+ifeq ($(USE_DRIVER_SIM_STREAM), 1)
+ifneq ($(FAMILY), HOST)
+$(error USE_DRIVER_SIM_STREAM is only supported by the host device)
+endif
+SOURCE += $(DRIVERSDIR)/stream/sim/sim_stream.c
+CFLAGS += -I$(DRIVERSDIR)/stream/sim
+endif
+
 ## PWM driver
 CFLAGS += -DUSE_DRIVER_PWM=$(USE_DRIVER_PWM)
 ifeq ($(USE_DRIVER_PWM), 1)
@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+#
+# generates a read only file system image, as C source, from a directory.
+#
+# mkromfs.py <source directory> <output .c file> [mount point]
+#
+# every regular file under the source directory becomes a const array, which the
+# linker places in flash. the directory table lists the files by their full path,
+# sorted in strcmp() order so that romfs_find() can binary search it.
+# files and directories whose names start with '.' are skipped.
+#
+# see like-posix/romfs.h
+
+from sys import argv, exit
+import os
+
+if len(argv) < 3:
+    print('usage: mkromfs.py <source directory> <output .c file> [mount point]')
+    exit(1)
+
+source = argv[1]
+output = argv[2]
+mount = argv[3].rstrip('/') if len(argv) > 3 else ''
+
+files = []
+for root, dirs, names in os.walk(source):
+    dirs[:] = [d for d in dirs if not d.startswith('.')]
+    for name in names:
+        if name.startswith('.'):
+            continue
+        path = os.path.join(root, name)
+        rel = os.path.relpath(path, source).replace(os.sep, '/')
+        files.append(((mount + '/' + rel).encode('utf-8'), path))
+
+if not files:
+    print('error: no files found in %s' % source)
+    exit(1)
+
+# strcmp() order is byte order
+files.sort(key=lambda f: f[0])
+
+
+def c_string(b):
+    out = ''
+    for c in bytearray(b):
+        if c == 0x22 or c == 0x5c:
+            out += '\\' + chr(c)
+        elif 0x20 <= c < 0x7f:
+            out += chr(c)
+        else:
+            out += '\\%03o' % c
+    return '"' + out + '"'
+
+
+lines = []
+lines.append('/* generated by mkromfs.py from %s, do not edit */' % source)
+lines.append('')
+lines.append('#include "romfs.h"')
+lines.append('')
+
+sizes = []
+for i, (name, path) in enumerate(files):
+    data = bytearray(open(path, 'rb').read())
+    sizes.append(len(data))
+    lines.append('/* %s, %d bytes */' % (name.decode('utf-8'), len(data)))
+    lines.append('static const uint8_t romfs_data_%d[] __attribute__((aligned(4))) = {' % i)
+    # a terminating 0, not counted in the file size
+    data.append(0)
+    for j in range(0, len(data), 16):
+        lines.append('    ' + ', '.join('0x%02x' % c for c in data[j:j + 16]) + ',')
+    lines.append('};')
+    lines.append('')
+
+lines.append('static const romfs_entry_t romfs_entries[] = {')
+for i, (name, path) in enumerate(files):
+    lines.append('    {%s, romfs_data_%d, %d},' % (c_string(name), i, sizes[i]))
+lines.append('};')
+lines.append('')
+lines.append('const romfs_t romfs_image = {')
+lines.append('    romfs_entries,')
+lines.append('    sizeof(romfs_entries) / sizeof(romfs_entries[0]),')
+lines.append('};')
+lines.append('')
+
+out = open(output, 'w')
+out.write('\n'.join(lines))
+out.close()
+
+print('romfs: %d files, %d bytes, from %s' % (len(files), sum(sizes), source))
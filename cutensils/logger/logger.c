@@ -57,6 +57,22 @@
 #include "sock_utils.h"
 #endif
 
+#if USE_ASYNC_LOGGER
+#if !USE_FREERTOS
+#error "USE_ASYNC_LOGGER requires USE_FREERTOS"
+#endif
+#if LOG_QUEUE_LENGTH & (LOG_QUEUE_LENGTH - 1)
+#error "LOG_QUEUE_LENGTH must be a power of 2"
+#endif
+#if LOG_DRAIN_BUFFER_SIZE < (LOG_RECORD_SIZE + LOG_TIMESTAMP_BUFFER_SIZE)
+#error "LOG_DRAIN_BUFFER_SIZE must hold at least one timestamped record"
+#endif
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#endif
+
 static log_level_t _log_level = LOG_SYSLOG;
 static bool _log_coloured = true;
 static bool _log_timestamp = true;
@@ -71,15 +87,45 @@ static struct sockaddr udp_handlers[MAX_LOG_HANDLERS];
 #define is_udp_handler(i)       0
 #endif
 
+#if USE_ASYNC_LOGGER
+/**
+ * a slot in the log queue.
+ * seq is the queue position the slot is free for (seq == pos), or holds a record for (seq == pos + 1).
+ */
+typedef struct {
+    volatile uint32_t seq;
+    int length;
+#if USE_LOGGER_TIMESTAMP
+    bool timestamp;
+    struct timeval tv;
+#endif
+    char data[LOG_RECORD_SIZE];
+} log_record_t;
+
+/**
+ * bounded lock free multi producer, single consumer queue.
+ * any task may claim a slot by advancing head, only the logger task advances tail.
+ */
+typedef struct {
+    log_record_t records[LOG_QUEUE_LENGTH];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped;
+    SemaphoreHandle_t wake;
+} log_queue_t;
+
+static log_queue_t log_queue;
+/**
+ * records are gathered here by the logger task, and written out in one go.
+ */
+static char drain_buf[LOG_DRAIN_BUFFER_SIZE];
+static void logger_task(void* pvParameters);
+#else
 /**
  * the log buffer is static, not stacked, in order to eliminate blowing task stack sizes out.
  */
 static char log_buf[LOG_BUFFER_SIZE];
-#if USE_LOGGER_TIMESTAMP
-static char ts_buf[LOG_TIMESTAMP_BUFFER_SIZE];
 #endif
-struct tm* ts_lt;
-struct timeval ts_tv;
 
 /**
  * logger that may be used by any module
@@ -106,7 +152,7 @@ static const char* colourstart[] = {
 
 static const char colourstop[] = "\x1b[0m";
 
-static const char* tabs = "\t\t\t\t\t";
+static const char tabs[] = "\t\t\t\t\t";
 #define PAD_TO          (char)((sizeof(tabs)-2)*TAB_WIDTH)
 
 /**
@@ -123,6 +169,22 @@ void logger_init()
     }
 
     log_init(&_syslog, "root logger");
+
+#if USE_ASYNC_LOGGER
+    for(uint32_t i = 0; i < LOG_QUEUE_LENGTH; i++)
+        log_queue.records[i].seq = i;
+    log_queue.head = 0;
+    log_queue.tail = 0;
+    log_queue.dropped = 0;
+    log_queue.wake = xSemaphoreCreateBinary();
+
+    xTaskCreate(logger_task,
+                "logger",
+                configMINIMAL_STACK_SIZE + LOGGER_TASK_STACK,
+                NULL,
+                tskIDLE_PRIORITY + LOGGER_TASK_PRIORITY,
+                NULL);
+#endif
 }
 
 /**
@@ -247,89 +309,266 @@ void log_coloured(bool c)
 }
 
 /**
- * log record writer...
+ * @retval returns the number of log records dropped because the log queue was full.
+ *         always 0 unless USE_ASYNC_LOGGER is set.
  */
-static inline void write_log_record(logger_t* logger, log_level_t level, char* message, va_list va_args)
+unsigned int log_dropped()
 {
-    int length;
-#if USE_LOGGER_TIMESTAMP
-    int tslength = 0;
-    char* end;
+#if USE_ASYNC_LOGGER
+    return log_queue.dropped;
+#else
+    return 0;
 #endif
-	if(level < _log_level)
-		return;
-#if USE_MUTEX
-	if(_logger_write_mutex == NULL)
-		return;
+}
+
+static inline int append_log_text(char* buf, int length, int size, const char* text, int n)
+{
+    if(n > size - length)
+        n = size - length;
+    memcpy(buf + length, text, n);
+    return length + n;
+}
+
+#if USE_LOGGER_TIMESTAMP
+/**
+ * formats a timestamp into buf, which must be at least LOG_TIMESTAMP_BUFFER_SIZE bytes.
+ *
+ * @retval returns the length of the timestamp.
+ */
+static int format_timestamp(char* buf, struct timeval* tv)
+{
+    struct tm brokentime;
+    int length = strftime(buf, LOG_TIMESTAMP_BUFFER_SIZE, "%Y-%m-%d %H:%M:%S", localtime_r(&tv->tv_sec, &brokentime));
+    int n = snprintf(buf + length, LOG_TIMESTAMP_BUFFER_SIZE - length, ".%03d\t", (int)(tv->tv_usec/1000));
+    return n > 0 && n < LOG_TIMESTAMP_BUFFER_SIZE - length ? length + n : length;
+}
 #endif
 
-	logger = logger != NULL ? logger : &_syslog;
+/**
+ * formats a log record, less the timestamp, into buf.
+ * the message is truncated if it does not fit, the line is always terminated.
+ * the result is not null terminated.
+ *
+ * @retval returns the length of the record.
+ */
+static int format_log_record(char* buf, int size, logger_t* logger, log_level_t level, char* message, va_list va_args)
+{
+    int length = 0;
+    int n;
 
-	take_mutex(_logger_write_mutex);
+    // keep space for the line ending
+    size -= (_log_coloured ? sizeof(colourstop)-1 : 0) + 1;
 
-    length = vsprintf(log_buf, message, va_args);
+    length = append_log_text(buf, length, size, logger->name, strlen(logger->name));
+    if(logger->pad > 0)
+        length = append_log_text(buf, length, size, tabs, logger->pad);
+    length = append_log_text(buf, length, size, levelstr[level], strlen(levelstr[level]));
+    if(_log_coloured)
+        length = append_log_text(buf, length, size, colourstart[level], strlen(colourstart[level]));
 
-#if USE_LOGGER_TIMESTAMP
-    if(_log_timestamp)
+    if(length < size)
     {
-        if(gettimeofday(&ts_tv, NULL) == 0)
-        {
-            ts_lt = localtime(&ts_tv.tv_sec);
-            tslength = strftime(ts_buf, sizeof(ts_buf), "%Y-%m-%d %H:%M:%S", ts_lt);
-            end = ts_buf + tslength;
-            tslength += sprintf(end, ".%03d\t", ts_tv.tv_usec/1000);
-        }
+        n = vsnprintf(buf + length, size - length, message, va_args);
+        if(n > 0)
+            length += n < size - length ? n : size - length - 1;
     }
-#endif
 
+    if(_log_coloured)
+    {
+        memcpy(buf + length, colourstop, sizeof(colourstop)-1);
+        length += sizeof(colourstop)-1;
+    }
+    buf[length++] = '\n';
+
+    return length;
+}
+
+/**
+ * writes buf to every log handler.
+ */
+static void write_log_handlers(const char* buf, int length)
+{
 	for(int i = 0; i < MAX_LOG_HANDLERS; i++)
 	{
 		if(handlers[i] != -1)
 		{
 		    if(!is_udp_handler(i))
-		    {
-#if USE_LOGGER_TIMESTAMP
-            if(_log_timestamp)
-                write(handlers[i], ts_buf, tslength);
-#endif
-                write(handlers[i], logger->name, strlen(logger->name));
-                if(logger->pad > 0)
-                    write(handlers[i], tabs, logger->pad);
-                write(handlers[i], levelstr[level], strlen(levelstr[level]));
-                if(_log_coloured)
-                    write(handlers[i], colourstart[level], strlen(colourstart[level]));
-                write(handlers[i], log_buf, length);
-                if(_log_coloured)
-                    write(handlers[i], colourstop, sizeof(colourstop)-1);
-                write(handlers[i], "\n", 1);
-
-                if(isatty(handlers[i]) == 0)
-                    fsync(handlers[i]);
-		    }
+                write(handlers[i], buf, length);
 #if USE_UDP_LOGGER
 		    else
-		    {
-#if USE_LOGGER_TIMESTAMP
-                if(_log_timestamp)
-                    sendto(handlers[i], ts_buf, tslength, 0, &udp_handlers[i], sizeof(struct sockaddr));
-#endif
-		        sendto(handlers[i], logger->name, strlen(logger->name), 0, &udp_handlers[i], sizeof(struct sockaddr));
-                if(logger->pad > 0)
-                    sendto(handlers[i], tabs, logger->pad, 0, &udp_handlers[i], sizeof(struct sockaddr));
-                sendto(handlers[i], levelstr[level], strlen(levelstr[level]), 0, &udp_handlers[i], sizeof(struct sockaddr));
-                if(_log_coloured)
-                    sendto(handlers[i], colourstart[level], strlen(colourstart[level]), 0, &udp_handlers[i], sizeof(struct sockaddr));
-                sendto(handlers[i], log_buf, length, 0, &udp_handlers[i], sizeof(struct sockaddr));
-                if(_log_coloured)
-                    sendto(handlers[i], colourstop, sizeof(colourstop)-1, 0, &udp_handlers[i], sizeof(struct sockaddr));
-                sendto(handlers[i], "\n", 1, 0, &udp_handlers[i], sizeof(struct sockaddr));
-		    }
+                sendto(handlers[i], buf, length, 0, &udp_handlers[i], sizeof(struct sockaddr));
 #endif
 		}
 	}
+}
+
+/**
+ * commits the log handlers that are files to their device.
+ */
+static void sync_log_handlers()
+{
+	for(int i = 0; i < MAX_LOG_HANDLERS; i++)
+	{
+		if(handlers[i] != -1 && !is_udp_handler(i) && isatty(handlers[i]) == 0)
+            fsync(handlers[i]);
+	}
+}
+
+#if USE_ASYNC_LOGGER
+/**
+ * log record writer, for the asynchronous logger...
+ *
+ * claims a slot in the log queue and formats the record straight into it.
+ * never blocks, the record is dropped and counted if the queue is full.
+ * the logger task is woken early when the queue reaches half full.
+ */
+static inline void write_log_record(logger_t* logger, log_level_t level, char* message, va_list va_args)
+{
+    log_record_t* record;
+    uint32_t pos;
+    int32_t diff;
+
+	if(level < _log_level)
+		return;
+
+	logger = logger != NULL ? logger : &_syslog;
+
+    pos = __atomic_load_n(&log_queue.head, __ATOMIC_RELAXED);
+    for(;;)
+    {
+        record = &log_queue.records[pos & (LOG_QUEUE_LENGTH - 1)];
+        diff = (int32_t)(__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) - pos);
+        if(diff == 0)
+        {
+            // on failure pos is updated to the current head
+            if(__atomic_compare_exchange_n(&log_queue.head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if(diff < 0)
+        {
+            __atomic_fetch_add(&log_queue.dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        else
+            pos = __atomic_load_n(&log_queue.head, __ATOMIC_RELAXED);
+    }
+
+#if USE_LOGGER_TIMESTAMP
+    record->timestamp = _log_timestamp && gettimeofday(&record->tv, NULL) == 0;
+#endif
+    record->length = format_log_record(record->data, sizeof(record->data), logger, level, message, va_args);
+
+    // hand the slot to the logger task
+    __atomic_store_n(&record->seq, pos + 1, __ATOMIC_RELEASE);
+
+    // wake the logger task early, once, when the queue reaches half full
+    if(pos - log_queue.tail == LOG_QUEUE_LENGTH/2)
+        xSemaphoreGive(log_queue.wake);
+}
+
+/**
+ * the logger task, drains the log queue...
+ *
+ * gathers as many records as fit in drain_buf, then writes them to each handler in one go.
+ * handlers that are files are synced when LOG_FSYNC_SIZE bytes have been written,
+ * or LOG_FSYNC_PERIOD ms after the first unsynced write.
+ */
+static void logger_task(void* pvParameters)
+{
+    (void)pvParameters;
+    log_record_t* record;
+    int length;
+    bool full;
+    uint32_t dropped = 0;
+    uint32_t unsynced = 0;
+    TickType_t first_unsynced = 0;
+
+    for(;;)
+    {
+        length = 0;
+        full = false;
+
+        if(log_queue.dropped != dropped)
+        {
+            length = snprintf(drain_buf, sizeof(drain_buf), "logger dropped %u records\n", (unsigned int)(log_queue.dropped - dropped));
+            dropped = log_queue.dropped;
+        }
+
+        for(;;)
+        {
+            record = &log_queue.records[log_queue.tail & (LOG_QUEUE_LENGTH - 1)];
+            if(__atomic_load_n(&record->seq, __ATOMIC_ACQUIRE) != log_queue.tail + 1)
+                break;
+            if(length + LOG_TIMESTAMP_BUFFER_SIZE + record->length > (int)sizeof(drain_buf))
+            {
+                full = true;
+                break;
+            }
+#if USE_LOGGER_TIMESTAMP
+            if(record->timestamp)
+                length += format_timestamp(drain_buf + length, &record->tv);
+#endif
+            memcpy(drain_buf + length, record->data, record->length);
+            length += record->length;
+
+            // release the slot for the next pass around the queue
+            __atomic_store_n(&record->seq, log_queue.tail + LOG_QUEUE_LENGTH, __ATOMIC_RELEASE);
+            log_queue.tail++;
+        }
+
+        if(length > 0)
+        {
+            write_log_handlers(drain_buf, length);
+            if(unsynced == 0)
+                first_unsynced = xTaskGetTickCount();
+            unsynced += length;
+        }
+
+        if(unsynced > 0 && (unsynced >= LOG_FSYNC_SIZE ||
+           (xTaskGetTickCount() - first_unsynced) >= LOG_FSYNC_PERIOD/portTICK_RATE_MS))
+        {
+            sync_log_handlers();
+            unsynced = 0;
+        }
+
+        if(!full)
+            xSemaphoreTake(log_queue.wake, LOG_DRAIN_PERIOD/portTICK_RATE_MS);
+    }
+}
+#else
+/**
+ * log record writer...
+ */
+static inline void write_log_record(logger_t* logger, log_level_t level, char* message, va_list va_args)
+{
+    int length = 0;
+#if USE_LOGGER_TIMESTAMP
+    struct timeval tv;
+#endif
+
+	if(level < _log_level)
+		return;
+#if USE_MUTEX
+	if(_logger_write_mutex == NULL)
+		return;
+#endif
+
+	logger = logger != NULL ? logger : &_syslog;
+
+	take_mutex(_logger_write_mutex);
+
+#if USE_LOGGER_TIMESTAMP
+    if(_log_timestamp && gettimeofday(&tv, NULL) == 0)
+        length = format_timestamp(log_buf, &tv);
+#endif
+    length += format_log_record(log_buf + length, sizeof(log_buf) - length, logger, level, message, va_args);
+
+    write_log_handlers(log_buf, length);
+    sync_log_handlers();
 
 	give_mutex(_logger_write_mutex);
 }
+#endif
 
 /**
  * creates a log record at the level LOG_SYSLOG
@@ -100,6 +100,76 @@
   * this is the size in bytes of the buffer used to format the log message.
   */
 #define LOG_TIMESTAMP_BUFFER_SIZE   32
+#endif
+
+ #ifndef USE_ASYNC_LOGGER
+ /**
+  * when set to 1, log records are formatted by the caller into a lock free queue,
+  * and written out by a low priority logger task. requires FreeRTOS.
+  * when set to 0, log records are written out by the caller, under a mutex.
+  */
+#define USE_ASYNC_LOGGER   0
+#endif
+
+#ifndef LOG_QUEUE_LENGTH
+ /**
+  * the number of records the asynchronous log queue holds, must be a power of 2.
+  * records logged while the queue is full are dropped, and counted.
+  */
+#define LOG_QUEUE_LENGTH   16
+#endif
+
+#ifndef LOG_RECORD_SIZE
+ /**
+  * the size in bytes of a record in the asynchronous log queue,
+  * excluding the timestamp. longer messages are truncated.
+  */
+#define LOG_RECORD_SIZE   128
+#endif
+
+#ifndef LOG_DRAIN_BUFFER_SIZE
+ /**
+  * the size in bytes of the buffer the logger task gathers records into,
+  * before writing them out to the log handlers.
+  */
+#define LOG_DRAIN_BUFFER_SIZE   1024
+#endif
+
+#ifndef LOG_DRAIN_PERIOD
+ /**
+  * the period in ms at which the logger task checks the log queue.
+  */
+#define LOG_DRAIN_PERIOD   20
+#endif
+
+#ifndef LOG_FSYNC_PERIOD
+ /**
+  * the logger task syncs log handlers that are files at least this often, in ms,
+  * while there is unsynced log data.
+  */
+#define LOG_FSYNC_PERIOD   1000
+#endif
+
+#ifndef LOG_FSYNC_SIZE
+ /**
+  * the logger task syncs log handlers that are files once this many bytes
+  * have been written since the last sync.
+  */
+#define LOG_FSYNC_SIZE   4096
+#endif
+
+#ifndef LOGGER_TASK_PRIORITY
+ /**
+  * priority of the logger task, above the idle task priority.
+  */
+#define LOGGER_TASK_PRIORITY   1
+#endif
+
+#ifndef LOGGER_TASK_STACK
+ /**
+  * stack size of the logger task, in addition to configMINIMAL_STACK_SIZE.
+  */
+#define LOGGER_TASK_STACK   128
 #endif
 
  /**
@@ -136,6 +206,7 @@ void log_remove_handler(int file);
 log_level_t log_level(log_level_t level);
 void log_timestamp(bool ts);
 void log_coloured(bool c);
+unsigned int log_dropped();
 
 void log_syslog(logger_t* logger, char* message, ...);
 void log_edebug(logger_t* logger, char* message, ...);
@@ -169,6 +240,7 @@ typedef  SemaphoreHandle_t logger_mutex_t;
 #define log_level(l)        0
 #define log_timestamp(ts)    {(void)ts;}
 #define log_coloured(c)    {(void)c;}
+#define log_dropped()       0
 #define log_syslog(l, ...) {(void)l;}
 #define log_edebug(l, ...) {(void)l;}
 #define log_debug(l, ...) {(void)l;}
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @defgroup pool fixed size block pools
+ *
+ * O(1) allocation of fixed size objects, for structures that are created and destroyed
+ * at a high rate, such as per connection and per file state. the storage of a pool is
+ * set aside once, so churn in these objects does not fragment the heap.
+ *
+ * when a pool is empty, pool_alloc() falls back to malloc() and counts a failure in the
+ * pool stats. pool_free() returns a block to wherever it came from. pool_alloc_from_isr()
+ * never falls back to the heap, it returns NULL when the pool is empty.
+ *
+ * @file pool.c
+ * @{
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pool.h"
+
+#if USE_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#define pool_lock()                 taskENTER_CRITICAL()
+#define pool_unlock()               taskEXIT_CRITICAL()
+#define pool_lock_from_isr()        portSET_INTERRUPT_MASK_FROM_ISR()
+#define pool_unlock_from_isr(mask)  portCLEAR_INTERRUPT_MASK_FROM_ISR(mask)
+#else
+#define pool_lock()
+#define pool_unlock()
+#define pool_lock_from_isr()        0
+#define pool_unlock_from_isr(mask)  (void)(mask)
+#endif
+
+#if POOL_USE_CCRAM
+#include "heap_ccram.h"
+#define pool_storage_malloc(size)   malloc_ccram(size)
+#define pool_storage_free(block)    free_ccram(block)
+#else
+#define pool_storage_malloc(size)   malloc(size)
+#define pool_storage_free(block)    free(block)
+#endif
+
+/**
+ * takes a block from the free list, or failing that one that was never used.
+ * call with the pool locked.
+ */
+static inline void* __pool_take(pool_t* pool)
+{
+    void* block = pool->free;
+
+    if(block)
+        pool->free = *(void**)block;
+    else if(pool->fresh < pool->count)
+        block = pool->storage + pool->block_size * pool->fresh++;
+
+    if(block)
+    {
+        if(++pool->stats.used > pool->stats.hwm)
+            pool->stats.hwm = pool->stats.used;
+    }
+    else
+        pool->stats.failures++;
+
+    return block;
+}
+
+/**
+ * puts a block on the free list. call with the pool locked.
+ */
+static inline void __pool_give(pool_t* pool, void* block)
+{
+    *(void**)block = pool->free;
+    pool->free = block;
+    pool->stats.used--;
+}
+
+/**
+ * sets up a pool, unless it is set up already.
+ * it is safe for several tasks to race to set up the same pool, only one storage area is kept.
+ *
+ * @param   pool is the pool to set up.
+ * @param   storage is the memory for the blocks, at least POOL_BLOCK_SIZE(size) * count bytes
+ *          aligned to POOL_ALIGNMENT. set to NULL to allocate it from the heap, or from the
+ *          CCRAM heap if POOL_USE_CCRAM is set to 1.
+ * @param   size is the size of the objects the pool holds.
+ * @param   count is the number of objects the pool holds.
+ * @retval  0 on success, -1 if the storage could not be allocated.
+ *          in that case every block is taken from the heap, as if the pool were empty.
+ */
+int pool_init(pool_t* pool, void* storage, size_t size, unsigned int count)
+{
+    void* allocated = NULL;
+    bool installed = false;
+
+    if(pool->storage)
+        return 0;
+
+    if(size < sizeof(void*))
+        size = sizeof(void*);
+    size = POOL_BLOCK_SIZE(size);
+
+    if(!storage)
+    {
+        allocated = pool_storage_malloc(size * count);
+        storage = allocated;
+    }
+
+    pool_lock();
+    if(!pool->storage)
+    {
+        pool->free = NULL;
+        pool->block_size = size;
+        pool->count = storage ? count : 0;
+        pool->fresh = 0;
+        memset(&pool->stats, 0, sizeof(pool_stats_t));
+        pool->storage = storage;
+        installed = true;
+    }
+    pool_unlock();
+
+    if(!installed && allocated)
+        pool_storage_free(allocated);
+
+    return installed && !storage ? -1 : 0;
+}
+
+/**
+ * @retval  true if the block is part of the pool storage, false if it came from the heap.
+ */
+bool pool_owns(pool_t* pool, void* block)
+{
+    uint8_t* start = pool->storage;
+    return start && (uint8_t*)block >= start && (uint8_t*)block < start + pool->block_size * pool->count;
+}
+
+/**
+ * allocates a block from a pool, or from the heap if the pool is empty.
+ *
+ * @retval  the block, or NULL if the pool is empty and the heap is exhausted,
+ *          or if the pool was never set up.
+ */
+void* pool_alloc(pool_t* pool)
+{
+    void* block = NULL;
+
+    pool_lock();
+    if(pool->storage)
+        block = __pool_take(pool);
+    else
+        pool->stats.failures++;
+    pool_unlock();
+
+    if(!block && pool->block_size)
+        block = malloc(pool->block_size);
+
+    return block;
+}
+
+/**
+ * frees a block allocated with pool_alloc(). NULL is ignored.
+ */
+void pool_free(pool_t* pool, void* block)
+{
+    if(!block)
+        return;
+
+    if(pool_owns(pool, block))
+    {
+        pool_lock();
+        __pool_give(pool, block);
+        pool_unlock();
+    }
+    else
+        free(block);
+}
+
+/**
+ * allocates a block from a pool, from an interrupt handler.
+ *
+ * @retval  the block, or NULL if the pool is empty or not set up.
+ */
+void* pool_alloc_from_isr(pool_t* pool)
+{
+    void* block = NULL;
+    unsigned long mask = pool_lock_from_isr();
+
+    if(pool->storage)
+        block = __pool_take(pool);
+    else
+        pool->stats.failures++;
+
+    pool_unlock_from_isr(mask);
+
+    return block;
+}
+
+/**
+ * frees a block to a pool, from an interrupt handler.
+ * the heap cannot be used from an interrupt handler, so only blocks that came from the pool
+ * storage may be freed this way, as they are by pool_alloc_from_isr().
+ * other blocks are ignored.
+ */
+void pool_free_from_isr(pool_t* pool, void* block)
+{
+    unsigned long mask;
+
+    if(!pool_owns(pool, block))
+        return;
+
+    mask = pool_lock_from_isr();
+    __pool_give(pool, block);
+    pool_unlock_from_isr(mask);
+}
+
+/**
+ * copies out the pool counters.
+ */
+void pool_get_stats(pool_t* pool, pool_stats_t* stats)
+{
+    pool_lock();
+    *stats = pool->stats;
+    pool_unlock();
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup pool
+ * @file pool.h
+ * @{
+ */
+
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * alignment of the blocks in a pool, enough for any member type.
+ */
+#define POOL_ALIGNMENT          8
+
+/**
+ * set to 1 to take the storage of pools initialised without storage of their own
+ * from the CCRAM heap (STM32F4 only). DMA cannot reach CCRAM, so only objects that are
+ * never DMA'd to or from should come from such pools.
+ */
+#ifndef POOL_USE_CCRAM
+#define POOL_USE_CCRAM          0
+#endif
+
+/**
+ * the size of a block holding an object of the given size.
+ */
+#define POOL_BLOCK_SIZE(size)   (((size) + POOL_ALIGNMENT - 1) & ~(size_t)(POOL_ALIGNMENT - 1))
+
+/**
+ * defines a static pool of length blocks of the given size, ready to use without pool_init().
+ * the storage is in main RAM.
+ */
+#define POOL_DEFINE(name, size, length) \
+    static uint64_t name##_storage[POOL_BLOCK_SIZE(size) * (length) / sizeof(uint64_t)]; \
+    static pool_t name = { \
+        .free = NULL, \
+        .storage = (uint8_t*)name##_storage, \
+        .block_size = POOL_BLOCK_SIZE(size), \
+        .count = (length), \
+        .fresh = 0, \
+        .stats = {0, 0, 0} \
+    }
+
+typedef struct {
+    unsigned int used;          ///< the number of blocks in use right now
+    unsigned int hwm;           ///< the highest number of blocks in use at once
+    unsigned int failures;      ///< the number of allocations made while the pool was empty
+} pool_stats_t;
+
+/**
+ * a pool of fixed size blocks.
+ * free blocks are kept in a list linked through their first word. blocks that were never
+ * handed out are not on the list, they are taken in order from the top of the storage,
+ * so a pool needs no setup beyond its storage pointer.
+ */
+typedef struct {
+    void* free;                 ///< blocks that were handed out and returned
+    uint8_t* storage;           ///< the blocks, NULL until the pool is initialised
+    size_t block_size;          ///< size of one block, a multiple of POOL_ALIGNMENT
+    unsigned int count;         ///< the number of blocks in storage
+    unsigned int fresh;         ///< the number of blocks handed out at least once
+    pool_stats_t stats;
+} pool_t;
+
+int pool_init(pool_t* pool, void* storage, size_t size, unsigned int count);
+void* pool_alloc(pool_t* pool);
+void pool_free(pool_t* pool, void* block);
+void* pool_alloc_from_isr(pool_t* pool);
+void pool_free_from_isr(pool_t* pool, void* block);
+bool pool_owns(pool_t* pool, void* block);
+void pool_get_stats(pool_t* pool, pool_stats_t* stats);
+
+#endif /* POOL_H_ */
+
+/**
+ * @}
+ */
@@ -0,0 +1,144 @@
+#include <string.h>
+#include <stdint.h>
+#include "gtest/gtest.h"
+extern "C" {
+#include "pool.h"
+}
+
+/**
+ * fixture
+ */
+typedef struct {
+	int a;
+	double b;
+	char c[13];
+} object_t;
+
+#define OBJECTS 4
+
+TEST(test_pool, test_block_size_is_aligned)
+{
+	ASSERT_EQ(POOL_BLOCK_SIZE(1), (size_t)8);
+	ASSERT_EQ(POOL_BLOCK_SIZE(8), (size_t)8);
+	ASSERT_EQ(POOL_BLOCK_SIZE(sizeof(object_t)) % POOL_ALIGNMENT, (size_t)0);
+	ASSERT_GE(POOL_BLOCK_SIZE(sizeof(object_t)), sizeof(object_t));
+}
+
+TEST(test_pool, test_alloc_free_from_storage)
+{
+	uint64_t storage[POOL_BLOCK_SIZE(sizeof(object_t)) * OBJECTS / sizeof(uint64_t)];
+	pool_t pool;
+	object_t* objects[OBJECTS];
+	pool_stats_t stats;
+
+	memset(&pool, 0, sizeof(pool));
+	ASSERT_EQ(pool_init(&pool, storage, sizeof(object_t), OBJECTS), 0);
+
+	for(int i = 0; i < OBJECTS; i++)
+	{
+		objects[i] = (object_t*)pool_alloc(&pool);
+		ASSERT_TRUE(pool_owns(&pool, objects[i]));
+		ASSERT_EQ((uintptr_t)objects[i] % POOL_ALIGNMENT, (uintptr_t)0);
+		objects[i]->a = i;
+		for(int j = 0; j < i; j++)
+			ASSERT_NE(objects[i], objects[j]);
+	}
+
+	for(int i = 0; i < OBJECTS; i++)
+		ASSERT_EQ(objects[i]->a, i);
+
+	pool_get_stats(&pool, &stats);
+	ASSERT_EQ(stats.used, (unsigned int)OBJECTS);
+	ASSERT_EQ(stats.hwm, (unsigned int)OBJECTS);
+	ASSERT_EQ(stats.failures, (unsigned int)0);
+
+	// the last block freed is the first handed out again
+	pool_free(&pool, objects[1]);
+	pool_free(&pool, objects[2]);
+	ASSERT_EQ(pool_alloc(&pool), (void*)objects[2]);
+	ASSERT_EQ(pool_alloc(&pool), (void*)objects[1]);
+
+	for(int i = 0; i < OBJECTS; i++)
+		pool_free(&pool, objects[i]);
+
+	pool_get_stats(&pool, &stats);
+	ASSERT_EQ(stats.used, (unsigned int)0);
+	ASSERT_EQ(stats.hwm, (unsigned int)OBJECTS);
+}
+
+TEST(test_pool, test_empty_pool_falls_back_to_heap)
+{
+	pool_t pool;
+	object_t* objects[OBJECTS];
+	pool_stats_t stats;
+
+	memset(&pool, 0, sizeof(pool));
+	ASSERT_EQ(pool_init(&pool, NULL, sizeof(object_t), OBJECTS), 0);
+
+	for(int i = 0; i < OBJECTS; i++)
+		objects[i] = (object_t*)pool_alloc(&pool);
+
+	object_t* extra = (object_t*)pool_alloc(&pool);
+	ASSERT_TRUE(extra != NULL);
+	ASSERT_FALSE(pool_owns(&pool, extra));
+	extra->a = 1;
+
+	pool_get_stats(&pool, &stats);
+	ASSERT_EQ(stats.used, (unsigned int)OBJECTS);
+	ASSERT_EQ(stats.failures, (unsigned int)1);
+
+	// only pool blocks come from an interrupt handler
+	ASSERT_TRUE(pool_alloc_from_isr(&pool) == NULL);
+
+	pool_free(&pool, extra);
+	pool_free_from_isr(&pool, objects[0]);
+	void* block = pool_alloc_from_isr(&pool);
+	ASSERT_EQ(block, (void*)objects[0]);
+
+	for(int i = 0; i < OBJECTS; i++)
+		pool_free(&pool, objects[i]);
+	pool_free(&pool, NULL);
+
+	pool_get_stats(&pool, &stats);
+	ASSERT_EQ(stats.used, (unsigned int)0);
+	ASSERT_EQ(stats.failures, (unsigned int)2);
+	free(pool.storage);
+}
+
+TEST(test_pool, test_init_twice_keeps_first_storage)
+{
+	uint64_t storage[POOL_BLOCK_SIZE(sizeof(object_t)) * OBJECTS / sizeof(uint64_t)];
+	pool_t pool;
+
+	memset(&pool, 0, sizeof(pool));
+	ASSERT_EQ(pool_init(&pool, storage, sizeof(object_t), OBJECTS), 0);
+	void* block = pool_alloc(&pool);
+	ASSERT_EQ(pool_init(&pool, NULL, sizeof(object_t), OBJECTS), 0);
+	ASSERT_EQ(pool.storage, (uint8_t*)storage);
+	ASSERT_TRUE(pool_owns(&pool, block));
+	pool_free(&pool, block);
+}
+
+TEST(test_pool, test_uninitialised_pool_allocates_nothing)
+{
+	pool_t pool;
+	memset(&pool, 0, sizeof(pool));
+	ASSERT_TRUE(pool_alloc(&pool) == NULL);
+	ASSERT_TRUE(pool_alloc_from_isr(&pool) == NULL);
+}
+
+POOL_DEFINE(static_pool, sizeof(object_t), OBJECTS);
+
+TEST(test_pool, test_defined_pool_needs_no_init)
+{
+	object_t* objects[OBJECTS];
+
+	for(int i = 0; i < OBJECTS; i++)
+	{
+		objects[i] = (object_t*)pool_alloc(&static_pool);
+		ASSERT_TRUE(pool_owns(&static_pool, objects[i]));
+	}
+	for(int i = 0; i < OBJECTS; i++)
+		pool_free(&static_pool, objects[i]);
+	ASSERT_EQ(static_pool.stats.used, (unsigned int)0);
+}
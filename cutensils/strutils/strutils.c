@@ -41,6 +41,7 @@
 
 #include "strutils.h"
 #include <stdio.h>
+#include <stdint.h>
 #include <ctype.h>
 #include <math.h>
 
@@ -158,27 +159,21 @@ static void strreverse(char* begin, char* end)
         aux=*end, *end--=*begin, *begin++=aux;
 }
 
-char* itoa(int value, char* str, int base)
+/**
+ * converts a value to ascii in the given base, the slow way - a division per digit.
+ * used for the bases that do not have a fast path.
+ */
+static char* utoa_base(uint64_t value, char* str, int base, bool negative)
 {
     static char num[] = "0123456789abcdefghijklmnopqrstuvwxyz";
     char* wstr=str;
-    int sign;
 
-    // Validate base
-    if (base<2 || base>35)
-    {
-        *wstr='\0';
-        return 0;
-    }
-    // Take care of sign
-    if ((sign=value) < 0)
-        value = -value;
     // Conversion. Number is reversed.
     do
         *wstr++ = num[value%base];
     while(value /= base);
     // append sign
-    if((base == 10) && (sign < 0))
+    if((base == 10) && negative)
         *wstr++='-';
 
     // terminate
@@ -189,85 +184,464 @@ char* itoa(int value, char* str, int base)
     return str;
 }
 
+/**
+ * pairs of decimal digits, 00 to 99, so that two digits are made per division.
+ */
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * writes value as exactly length decimal digits, ending at end, zero filled.
+ * the divisions by 100 are by a constant, so compile to a multiply by the reciprocal.
+ */
+static inline void utoa10_digits(uint32_t value, char* end, int length)
+{
+    uint32_t q;
+
+    while(length >= 2)
+    {
+        q = value / 100;
+        end -= 2;
+        end[0] = digit_pairs[(value - (q * 100)) * 2];
+        end[1] = digit_pairs[((value - (q * 100)) * 2) + 1];
+        value = q;
+        length -= 2;
+    }
+    if(length)
+        *--end = (char)('0' + value);
+}
+
+/**
+ * @retval  the number of decimal digits in value.
+ */
+static inline int utoa10_length(uint32_t value)
+{
+    if(value < 10000)
+    {
+        if(value < 100)
+            return value < 10 ? 1 : 2;
+        return value < 1000 ? 3 : 4;
+    }
+    if(value < 100000000)
+    {
+        if(value < 1000000)
+            return value < 100000 ? 5 : 6;
+        return value < 10000000 ? 7 : 8;
+    }
+    return value < 1000000000 ? 9 : 10;
+}
+
+/**
+ * converts an unsigned int to decimal ascii.
+ *
+ * two digits are made per division, and the divisions are by a constant.
+ *
+ * @param   value is the value to convert.
+ * @param   str is the buffer to write to, of at least 11 characters.
+ * @retval  the length of the string written, not including the terminating null.
+ */
+int uitoa10(uint32_t value, char* str)
+{
+    int length = utoa10_length(value);
+    utoa10_digits(value, str + length, length);
+    str[length] = '\0';
+    return length;
+}
+
+/**
+ * converts an unsigned 64 bit int to decimal ascii.
+ *
+ * the value is split into 8 digit parts, so that there are at most two 64 bit divisions
+ * and the digits are made with 32 bit arithmetic.
+ *
+ * @param   value is the value to convert.
+ * @param   str is the buffer to write to, of at least 21 characters.
+ * @retval  the length of the string written, not including the terminating null.
+ */
+int duitoa10(uint64_t value, char* str)
+{
+    uint32_t parts[3];
+    int count = 0;
+    int length;
+
+    while(value > UINT32_MAX)
+    {
+        parts[count++] = (uint32_t)(value % 100000000);
+        value /= 100000000;
+    }
+
+    length = uitoa10((uint32_t)value, str);
+    while(count--)
+    {
+        utoa10_digits(parts[count], str + length + 8, 8);
+        length += 8;
+    }
+    str[length] = '\0';
+    return length;
+}
+
+/**
+ * converts an unsigned 64 bit int to hexadecimal ascii, with no leading zeros.
+ *
+ * @param   value is the value to convert.
+ * @param   str is the buffer to write to, of at least 17 characters.
+ * @param   upper is true to use upper case digits.
+ * @retval  the length of the string written, not including the terminating null.
+ */
+int duitoa16(uint64_t value, char* str, bool upper)
+{
+    const char* num = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    int length = 1;
+    int i;
+
+    while(length < 16 && (value >> (length * 4)))
+        length++;
+
+    for(i = length - 1; i >= 0; i--)
+    {
+        str[i] = num[value & 0x0F];
+        value >>= 4;
+    }
+    str[length] = '\0';
+    return length;
+}
+
+/**
+ * convert int to ascii.
+ * for bases other than 10 negative values are converted without the sign.
+ */
+char* itoa(int value, char* str, int base)
+{
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+
+    if(base == 10)
+    {
+        if(value < 0)
+            *str = '-';
+        uitoa10(magnitude, value < 0 ? str + 1 : str);
+    }
+    else if(base == 16)
+        duitoa16(magnitude, str, false);
+    else if (base<2 || base>35)
+    {
+        *str='\0';
+        return 0;
+    }
+    else
+        utoa_base(magnitude, str, base, value < 0);
+
+    return str;
+}
+
 /**
  * convert long long/int64_t type to ascii.
+ * for bases other than 10 negative values are converted without the sign.
  */
 char* ditoa(int64_t value, char* str, int base)
 {
-    static char num[] = "0123456789abcdefghijklmnopqrstuvwxyz";
-    char* wstr=str;
-    int64_t sign;
+    uint64_t magnitude = value < 0 ? 0u - (uint64_t)value : (uint64_t)value;
 
-    // Validate base
-    if (base<2 || base>35)
+    if(base == 10)
+    {
+        if(value < 0)
+            *str = '-';
+        duitoa10(magnitude, value < 0 ? str + 1 : str);
+    }
+    else if(base == 16)
+        duitoa16(magnitude, str, false);
+    else if (base<2 || base>35)
     {
-        *wstr='\0';
+        *str='\0';
         return 0;
     }
-    // Take care of sign
-    if ((sign=value) < 0)
-        value = -value;
-    // Conversion. Number is reversed.
-    do
-        *wstr++ = num[value%base];
-    while(value /= base);
-    // append sign
-    if((base == 10) && (sign < 0))
-        *wstr++='-';
-
-    // terminate
-    *wstr='\0';
-    // Reverse string
-    strreverse(str,wstr-1);
+    else
+        utoa_base(magnitude, str, base, value < 0);
 
     return str;
 }
 
-char* ftoascii(char *dst, float num, int dp)
+/**
+ * a little big number, of 32 bit limbs least significant first.
+ * big enough to hold the integer part of the largest double, or the fraction of the smallest.
+ */
+#define DTOA_LIMBS      36
+
+/**
+ * @retval  true once the digit after the last one to keep has been found, so the decimal can be rounded.
+ *          that is when there are more than fraction digits after the decimal point or more
+ *          than significant digits in all. also true once the decimal is full.
+ */
+static inline bool dtodecimal_done(decimal_t* dec, int fraction, int significant)
 {
-    if(isnan(num))
-        strcpy(dst, "nan");
-    else if(isinf(num))
-        strcpy(dst, "inf");
-    else if(num == (float)0.0)
-        strcpy(dst, "0");
-    else
+    return dec->ndigits - dec->decpt > fraction || dec->ndigits > significant || dec->ndigits >= DTOA_MAX_DIGITS;
+}
+
+/**
+ * appends a digit to the decimal. leading zeros are not held, they move the decimal point.
+ */
+static inline void dtodecimal_put(decimal_t* dec, char digit)
+{
+    if(dec->ndigits == 0 && digit == '0')
+        dec->decpt--;
+    else if(dec->ndigits < DTOA_MAX_DIGITS)
+        dec->digits[dec->ndigits++] = digit;
+    else if(digit != '0')
+        dec->sticky = true;
+}
+
+/**
+ * converts an integer part of 2^64 or more, which has no fraction.
+ * it is divided down by 10^9, and the 9 digit parts written out most significant first.
+ */
+static void __attribute__((noinline)) dtodecimal_big(uint64_t mantissa, int exponent, decimal_t* dec)
+{
+    uint32_t limbs[DTOA_LIMBS];
+    uint32_t parts[DTOA_LIMBS];
+    char part[10];
+    uint64_t rem;
+    int nlimbs;
+    int nparts = 0;
+    int shift = exponent % 32;
+    int i, length;
+
+    nlimbs = exponent / 32;
+    memset(limbs, 0, nlimbs * sizeof(uint32_t));
+    limbs[nlimbs++] = (uint32_t)(mantissa << shift);
+    limbs[nlimbs++] = (uint32_t)(mantissa >> (32 - shift));
+    limbs[nlimbs++] = (uint32_t)((mantissa >> (32 - shift)) >> 32);
+    while(nlimbs && !limbs[nlimbs - 1])
+        nlimbs--;
+
+    while(nlimbs)
     {
-        char fmt[9];
-        unsigned int pres = 1;
-        int i;
-        for(i = 0; i < dp; i++)
-            pres *= 10;
-        sprintf(fmt, "%%d.%%.%dd", dp);
-        sprintf(dst, fmt, (int)num, (int)((num-(int)num)*pres));
+        rem = 0;
+        for(i = nlimbs - 1; i >= 0; i--)
+        {
+            rem = (rem << 32) | limbs[i];
+            limbs[i] = (uint32_t)(rem / 1000000000);
+            rem %= 1000000000;
+        }
+        parts[nparts++] = (uint32_t)rem;
+        while(nlimbs && !limbs[nlimbs - 1])
+            nlimbs--;
+    }
+
+    length = uitoa10(parts[--nparts], part);
+    dec->decpt = length + (nparts * 9);
+    for(i = 0; i < length; i++)
+        dtodecimal_put(dec, part[i]);
+    while(nparts--)
+    {
+        utoa10_digits(parts[nparts], part + 9, 9);
+        for(i = 0; i < 9; i++)
+            dtodecimal_put(dec, part[i]);
     }
-    return dst;
 }
 
 /**
- * todo - should be "%%lld.%%.%dlld" and cast to (long long int), but appleseed printf cant do lld yet.
+ * converts a fraction of more than 60 bits. the fraction is held as a big number with
+ * the binary point above the top limb, so that multiplying by 10 carries the next digit out.
+ * the limbs below the lowest set bit stay zero, and are skipped.
  */
-char* dtoascii(char *dst, double num, int dp)
+static void __attribute__((noinline)) dtodecimal_small(uint64_t fraction, int bits, decimal_t* dec, int fraction_digits, int significant_digits)
+{
+    uint32_t limbs[DTOA_LIMBS];
+    uint64_t t;
+    int nlimbs = (bits + 31) / 32;
+    int shift = (nlimbs * 32) - bits;
+    int low = 0;
+    int i;
+
+    memset(limbs, 0, sizeof(limbs));
+    limbs[0] = (uint32_t)(fraction << shift);
+    limbs[1] = (uint32_t)(fraction >> (32 - shift));
+    limbs[2] = (uint32_t)((fraction >> (32 - shift)) >> 32);
+
+    while(low < nlimbs)
+    {
+        t = 0;
+        for(i = low; i < nlimbs; i++)
+        {
+            t += (uint64_t)limbs[i] * 10;
+            limbs[i] = (uint32_t)t;
+            t >>= 32;
+        }
+        while(low < nlimbs && !limbs[low])
+            low++;
+        dtodecimal_put(dec, (char)('0' + t));
+        if(dtodecimal_done(dec, fraction_digits, significant_digits))
+            break;
+    }
+    dec->sticky |= low < nlimbs;
+}
+
+/**
+ * converts a double to its exact decimal digits, rounded half to even at the given precision.
+ * no floating point arithmetic is used, so the result is correct for every double.
+ *
+ * @param   value is the value to convert, must not be infinite or NaN.
+ * @param   dec is the decimal to write to. dec->ndigits is 0 for a value of zero.
+ * @param   precision is the number of digits to keep, after the decimal point if fixed is set,
+ *          otherwise significant digits, of which at least 1 are kept.
+ * @param   fixed selects the meaning of precision, as for the printf %f or %e conversions.
+ */
+void dtodecimal(double value, decimal_t* dec, int precision, bool fixed)
 {
-    if(isnan(num))
-        strcpy(dst, "nan");
-    else if(isinf(num))
-        strcpy(dst, "inf");
-    else if(num == (double)0.0)
-        strcpy(dst, "0");
+    union {
+        double d;
+        uint64_t u;
+    } bits = {.d = value};
+    uint64_t mantissa = bits.u & 0x000FFFFFFFFFFFFFull;
+    int exponent = (int)((bits.u >> 52) & 0x7FF);
+    uint64_t integer;
+    uint64_t fraction = 0;
+    uint64_t mask;
+    char part[21];
+    int fraction_digits;
+    int significant_digits;
+    int keep;
+    int length;
+    int i;
+
+    dec->negative = bits.u >> 63;
+    dec->ndigits = 0;
+    dec->decpt = 0;
+    dec->sticky = false;
+
+    if(!fixed && precision < 1)
+        precision = 1;
+
+    if(exponent)
+        mantissa |= 0x0010000000000000ull;
     else
+        exponent = 1;
+    exponent -= 1075;
+
+    if(!mantissa)
+        return;
+    // trailing zero bits only make the fraction longer
+    while(!(mantissa & 1))
     {
-        char fmt[13];
-        unsigned int pres = 1;
-        int i;
-        for(i = 0; i < dp; i++)
-            pres *= 10;
-        sprintf(fmt, "%%lld.%%.%dllu", dp);
-        sprintf(dst, fmt, (int)num, (int64_t)((num-(int64_t)num)*pres));
+        mantissa >>= 1;
+        exponent++;
     }
-    return dst;
+
+    // the digits to find, before rounding
+    fraction_digits = fixed ? precision : INT32_MAX;
+    significant_digits = fixed ? INT32_MAX : precision;
+
+    if(exponent >= 12)
+        dtodecimal_big(mantissa, exponent, dec);
+    else
+    {
+        if(exponent >= 0)
+            integer = mantissa << exponent;
+        else if(exponent > -64)
+        {
+            integer = mantissa >> -exponent;
+            fraction = mantissa & ((1ull << -exponent) - 1);
+        }
+        else
+        {
+            integer = 0;
+            fraction = mantissa;
+        }
+
+        if(integer)
+        {
+            length = duitoa10(integer, part);
+            dec->decpt = length;
+            for(i = 0; i < length; i++)
+                dtodecimal_put(dec, part[i]);
+        }
+
+        if(fraction && !dtodecimal_done(dec, fraction_digits, significant_digits))
+        {
+            if(exponent >= -60)
+            {
+                // the fraction times 10 fits in 64 bits, the digit is carried out above the binary point
+                mask = (1ull << -exponent) - 1;
+                do {
+                    fraction *= 10;
+                    dtodecimal_put(dec, (char)('0' + (fraction >> -exponent)));
+                    fraction &= mask;
+                } while(fraction && !dtodecimal_done(dec, fraction_digits, significant_digits));
+                dec->sticky |= fraction != 0;
+            }
+            else
+                dtodecimal_small(fraction, -exponent, dec, fraction_digits, significant_digits);
+        }
+        else
+            dec->sticky |= fraction != 0;
+    }
+
+    // the number of digits to keep
+    keep = fixed ? dec->decpt + precision : precision;
+
+    if(keep < dec->ndigits)
+    {
+        char round = keep >= 0 ? dec->digits[keep] : '0';
+        bool above = dec->sticky;
+
+        for(i = keep + 1; i < dec->ndigits && !above; i++)
+            above = dec->digits[i] != '0';
+
+        // round up above half way, or at half way to an even digit
+        if(round > '5' || (round == '5' && (above || (keep > 0 && (dec->digits[keep - 1] & 1)))))
+        {
+            for(i = keep - 1; i >= 0 && dec->digits[i] == '9'; i--)
+                ;
+            if(i < 0)
+            {
+                // carried out of the top digit
+                dec->digits[0] = '1';
+                dec->decpt++;
+                keep = 1;
+            }
+            else
+            {
+                dec->digits[i]++;
+                keep = i + 1;
+            }
+        }
+        dec->ndigits = keep > 0 ? keep : 0;
+    }
+
+    // trailing zeros are not held
+    while(dec->ndigits && dec->digits[dec->ndigits - 1] == '0')
+        dec->ndigits--;
+    if(!dec->ndigits)
+        dec->decpt = 0;
 }
 
+/**
+ * convert a float to ascii, with dp digits after the decimal point.
+ */
+char* ftoascii(char *dst, float num, int dp)
+{
+    return dtoascii(dst, (double)num, dp);
+}
+
+/**
+ * convert a double to ascii, with dp digits after the decimal point.
+ * dst must have room for the integer part, the decimal point, dp digits and the sign.
+ */
+char* dtoascii(char *dst, double num, int dp)
+{
+    char fmt[8];
+    sprintf(fmt, "%%.%df", dp);
+    sprintf(dst, fmt, num);
+    return dst;
+}
 
 /**
  * @}
@@ -56,8 +56,30 @@ char* itoa(int value, char* str, int base);
 char* ditoa(int64_t value, char* str, int base);
 #endif
 
+int uitoa10(uint32_t value, char* str);
+int duitoa10(uint64_t value, char* str);
+int duitoa16(uint64_t value, char* str, bool upper);
+
 #define DEFAULT_FTOA_DECIMAL_PLACES 6
 
+/**
+ * the number of significant digits held by dtodecimal(). only the fixed point conversion of
+ * values of 1e40 or more reaches further, and those digits are zero.
+ */
+#define DTOA_MAX_DIGITS 40
+
+/**
+ * a double in decimal, the value is 0.digits x 10^decpt.
+ */
+typedef struct {
+    char digits[DTOA_MAX_DIGITS];   ///< ascii digits, without leading or trailing zeros. not null terminated.
+    int ndigits;                    ///< the number of digits held, 0 for a value of zero.
+    int decpt;                      ///< the position of the decimal point in digits.
+    bool negative;                  ///< the sign of the value.
+    bool sticky;                    ///< set while converting, if non zero digits were dropped.
+} decimal_t;
+
+void dtodecimal(double value, decimal_t* dec, int precision, bool fixed);
 char* ftoascii(char *dst, float num, int dp);
 char* dtoascii(char *dst, double num, int dp);
 
@@ -0,0 +1,523 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/*
+ * FreeRTOS port that runs the kernel as a process on a POSIX host (Linux).
+ *
+ * Each task is backed by a pthread. The kernel decides which task runs, and
+ * every other task thread is parked on its own resume event, so only one task
+ * thread ever executes at a time - just as on a single core target.
+ *
+ * - the tick interrupt is SIGALRM, generated by an interval timer.
+ * - simulated peripheral interrupts are SIGUSR1, see xPortGenerateSimulatedInterrupt().
+ * - disabling interrupts blocks both signals in the calling thread.
+ *
+ * The pthread does not run on the stack allocated by the kernel, the top of
+ * that stack is used to hold the thread control structure instead.
+ *
+ * Note: a task that is preempted while inside a host library call that takes
+ * a lock (malloc, stdio on a host FILE, etc) will hold that lock until it runs
+ * again. Host calls of that kind should be made inside a critical section.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define portSIG_TICK					SIGALRM
+#define portSIG_INTERRUPT				SIGUSR1
+#define portMAX_PENDING_INTERRUPTS		32
+
+/* A latching event, a thread waits on it until it is signalled. */
+typedef struct
+{
+	pthread_mutex_t xMutex;
+	pthread_cond_t xCond;
+	BaseType_t xSignalled;
+} Event_t;
+
+/* The host thread that backs a task. */
+typedef struct
+{
+	pthread_t xThread;
+	TaskFunction_t pxCode;
+	void *pvParameters;
+	volatile BaseType_t xDying;
+	Event_t xResume;
+} Thread_t;
+
+typedef struct
+{
+	PortInterruptHandler_t pxHandler;
+	void *pvContext;
+} PendingInterrupt_t;
+
+/* Defined in tasks.c. */
+extern void * volatile pxCurrentTCB;
+
+static volatile UBaseType_t uxCriticalNesting = 0;
+static volatile BaseType_t xYieldPendingFromISR = pdFALSE;
+static Event_t xSchedulerEnd = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, pdFALSE };
+
+static pthread_mutex_t xInterruptMutex = PTHREAD_MUTEX_INITIALIZER;
+static PendingInterrupt_t xPendingInterrupts[ portMAX_PENDING_INTERRUPTS ];
+static UBaseType_t uxPendingHead = 0;
+static UBaseType_t uxPendingTail = 0;
+/*-----------------------------------------------------------*/
+
+static void prvInterruptSignals( sigset_t *pxSignals )
+{
+	sigemptyset( pxSignals );
+	sigaddset( pxSignals, portSIG_TICK );
+	sigaddset( pxSignals, portSIG_INTERRUPT );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventInit( Event_t *pxEvent )
+{
+	pthread_mutex_init( &pxEvent->xMutex, NULL );
+	pthread_cond_init( &pxEvent->xCond, NULL );
+	pxEvent->xSignalled = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventDestroy( Event_t *pxEvent )
+{
+	pthread_cond_destroy( &pxEvent->xCond );
+	pthread_mutex_destroy( &pxEvent->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventSignal( Event_t *pxEvent )
+{
+	pthread_mutex_lock( &pxEvent->xMutex );
+	pxEvent->xSignalled = pdTRUE;
+	pthread_cond_signal( &pxEvent->xCond );
+	pthread_mutex_unlock( &pxEvent->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+static void prvUnlockMutex( void *pvMutex )
+{
+	pthread_mutex_unlock( ( pthread_mutex_t * ) pvMutex );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventWait( Event_t *pxEvent )
+{
+	pthread_mutex_lock( &pxEvent->xMutex );
+
+	/* A parked thread is cancelled when its task is deleted by another task. */
+	pthread_cleanup_push( prvUnlockMutex, &pxEvent->xMutex );
+	while( pxEvent->xSignalled == pdFALSE )
+	{
+		pthread_cond_wait( &pxEvent->xCond, &pxEvent->xMutex );
+	}
+	pxEvent->xSignalled = pdFALSE;
+	pthread_cleanup_pop( 1 );
+}
+/*-----------------------------------------------------------*/
+
+static Thread_t *prvGetThreadFromTask( void *pxTask )
+{
+	/* pxTopOfStack is the first member of the TCB, and sits just below the
+	thread structure - see pxPortInitialiseStack(). */
+	StackType_t *pxTopOfStack = *( StackType_t ** ) pxTask;
+	return ( Thread_t * ) ( pxTopOfStack + 1 );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Resume the thread of the task the kernel selected, and park the calling
+ * thread until its task is selected again.
+ */
+static void prvSwitchThread( Thread_t *pxThreadToResume, Thread_t *pxThreadToSuspend )
+{
+	UBaseType_t uxSavedCriticalNesting;
+
+	if( pxThreadToResume != pxThreadToSuspend )
+	{
+		uxSavedCriticalNesting = uxCriticalNesting;
+
+		prvEventSignal( &pxThreadToResume->xResume );
+
+		if( pxThreadToSuspend->xDying != pdFALSE )
+		{
+			pthread_exit( NULL );
+		}
+
+		prvEventWait( &pxThreadToSuspend->xResume );
+
+		uxCriticalNesting = uxSavedCriticalNesting;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvServiceInterrupts( void )
+{
+	PendingInterrupt_t xInterrupt;
+	BaseType_t xSwitchRequired = pdFALSE;
+
+	for( ;; )
+	{
+		pthread_mutex_lock( &xInterruptMutex );
+		if( uxPendingTail == uxPendingHead )
+		{
+			pthread_mutex_unlock( &xInterruptMutex );
+			break;
+		}
+		xInterrupt = xPendingInterrupts[ uxPendingTail ];
+		uxPendingTail = ( uxPendingTail + 1 ) % portMAX_PENDING_INTERRUPTS;
+		pthread_mutex_unlock( &xInterruptMutex );
+
+		if( xInterrupt.pxHandler( xInterrupt.pvContext ) != pdFALSE )
+		{
+			xSwitchRequired = pdTRUE;
+		}
+	}
+
+	return xSwitchRequired;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * The interrupt entry point. Both signals are blocked while it runs.
+ */
+static void prvSignalHandler( int iSignal )
+{
+	Thread_t *pxThreadToSuspend;
+	BaseType_t xSwitchRequired = pdFALSE;
+	int iSavedErrno = errno;
+
+	if( pxCurrentTCB == NULL )
+	{
+		return;
+	}
+
+	pxThreadToSuspend = prvGetThreadFromTask( pxCurrentTCB );
+
+	/* Only the running task may be interrupted. Signals should never be
+	delivered elsewhere, but pass them on if they are. */
+	if( pthread_equal( pthread_self(), pxThreadToSuspend->xThread ) == 0 )
+	{
+		pthread_kill( pxThreadToSuspend->xThread, iSignal );
+		return;
+	}
+
+	uxCriticalNesting++;
+
+	if( iSignal == portSIG_TICK )
+	{
+		xSwitchRequired = xTaskIncrementTick();
+	}
+
+	if( prvServiceInterrupts() != pdFALSE )
+	{
+		xSwitchRequired = pdTRUE;
+	}
+
+	if( xYieldPendingFromISR != pdFALSE )
+	{
+		xYieldPendingFromISR = pdFALSE;
+		xSwitchRequired = pdTRUE;
+	}
+
+	#if( configUSE_PREEMPTION == 1 )
+	{
+		if( xSwitchRequired != pdFALSE )
+		{
+			vTaskSwitchContext();
+			prvSwitchThread( prvGetThreadFromTask( pxCurrentTCB ), pxThreadToSuspend );
+		}
+	}
+	#else
+	{
+		( void ) xSwitchRequired;
+	}
+	#endif
+
+	uxCriticalNesting--;
+	errno = iSavedErrno;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvThreadEntry( void *pvParameters )
+{
+	Thread_t *pxThread = ( Thread_t * ) pvParameters;
+
+	/* Wait to be scheduled for the first time. */
+	prvEventWait( &pxThread->xResume );
+
+	/* Tasks start with interrupts enabled. */
+	uxCriticalNesting = 0;
+	portENABLE_INTERRUPTS();
+
+	pxThread->pxCode( pxThread->pvParameters );
+
+	/* Tasks must not return, remove this one if it did. */
+	vTaskDelete( NULL );
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+	Thread_t *pxThread;
+	sigset_t xSignals;
+	sigset_t xOriginalSignals;
+	int iRet;
+
+	/* Place the thread structure at the top of the stack. */
+	pxThread = ( Thread_t * ) ( ( ( portPOINTER_SIZE_TYPE ) ( pxTopOfStack + 1 ) - sizeof( Thread_t ) ) & ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK ) );
+
+	pxThread->pxCode = pxCode;
+	pxThread->pvParameters = pvParameters;
+	pxThread->xDying = pdFALSE;
+	prvEventInit( &pxThread->xResume );
+
+	/* The new thread must not take interrupts until it is scheduled, it
+	inherits the signal mask it is created with. */
+	prvInterruptSignals( &xSignals );
+	pthread_sigmask( SIG_BLOCK, &xSignals, &xOriginalSignals );
+	iRet = pthread_create( &pxThread->xThread, NULL, prvThreadEntry, pxThread );
+	pthread_sigmask( SIG_SETMASK, &xOriginalSignals, NULL );
+
+	configASSERT( iRet == 0 );
+	( void ) iRet;
+
+	return ( StackType_t * ) pxThread - 1;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+	struct sigaction xAction;
+	struct itimerval xTimer;
+	sigset_t xSignals;
+
+	/* The thread that starts the scheduler never runs a task, and so must
+	never take an interrupt. */
+	prvInterruptSignals( &xSignals );
+	pthread_sigmask( SIG_BLOCK, &xSignals, NULL );
+
+	memset( &xAction, 0, sizeof( xAction ) );
+	xAction.sa_handler = prvSignalHandler;
+	xAction.sa_mask = xSignals;
+	xAction.sa_flags = SA_RESTART;
+	sigaction( portSIG_TICK, &xAction, NULL );
+	sigaction( portSIG_INTERRUPT, &xAction, NULL );
+
+	/* Initialise the critical nesting count ready for the first task. */
+	uxCriticalNesting = 0;
+
+	/* Start the timer that generates the tick interrupt. */
+	xTimer.it_interval.tv_sec = 0;
+	xTimer.it_interval.tv_usec = 1000000UL / configTICK_RATE_HZ;
+	xTimer.it_value = xTimer.it_interval;
+	setitimer( ITIMER_REAL, &xTimer, NULL );
+
+	/* Start the first task. */
+	prvEventSignal( &prvGetThreadFromTask( pxCurrentTCB )->xResume );
+
+	/* Park here until vTaskEndScheduler() is called. */
+	prvEventWait( &xSchedulerEnd );
+
+	memset( &xTimer, 0, sizeof( xTimer ) );
+	setitimer( ITIMER_REAL, &xTimer, NULL );
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+	struct itimerval xTimer;
+
+	memset( &xTimer, 0, sizeof( xTimer ) );
+	setitimer( ITIMER_REAL, &xTimer, NULL );
+
+	/* Hand control back to the thread that started the scheduler, the calling
+	task stays parked for good. */
+	prvEventSignal( &xSchedulerEnd );
+	prvEventWait( &prvGetThreadFromTask( pxCurrentTCB )->xResume );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+	Thread_t *pxThreadToSuspend;
+
+	vPortEnterCritical();
+
+	pxThreadToSuspend = prvGetThreadFromTask( pxCurrentTCB );
+	vTaskSwitchContext();
+	prvSwitchThread( prvGetThreadFromTask( pxCurrentTCB ), pxThreadToSuspend );
+
+	vPortExitCritical();
+}
+/*-----------------------------------------------------------*/
+
+void vPortYieldFromISR( void )
+{
+	/* Latched, the switch is made on the way out of the interrupt. */
+	xYieldPendingFromISR = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	portDISABLE_INTERRUPTS();
+	uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	configASSERT( uxCriticalNesting );
+	uxCriticalNesting--;
+	if( uxCriticalNesting == 0 )
+	{
+		portENABLE_INTERRUPTS();
+	}
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPortSetInterruptMask( void )
+{
+	sigset_t xSignals;
+	sigset_t xOriginalSignals;
+
+	prvInterruptSignals( &xSignals );
+	pthread_sigmask( SIG_BLOCK, &xSignals, &xOriginalSignals );
+
+	return sigismember( &xOriginalSignals, portSIG_TICK ) == 1 ? 1UL : 0UL;
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( uint32_t ulNewMaskValue )
+{
+	sigset_t xSignals;
+
+	if( ulNewMaskValue == 0UL )
+	{
+		prvInterruptSignals( &xSignals );
+		pthread_sigmask( SIG_UNBLOCK, &xSignals, NULL );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortThreadDying( void *pxTaskToDelete, volatile BaseType_t *pxPendYield )
+{
+	( void ) pxPendYield;
+
+	/* The calling task is deleting itself, its thread exits on the way out
+	of the next context switch. */
+	prvGetThreadFromTask( pxTaskToDelete )->xDying = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortCleanUpTCB( void *pxTCB )
+{
+	Thread_t *pxThread = prvGetThreadFromTask( pxTCB );
+	uint32_t ulMask;
+
+	/* Called by the idle task before the stack (and so the thread structure)
+	is freed. A task deleted by another task is still parked, and is cancelled.
+	pthread_join() frees the thread stack under a C library lock that
+	pthread_create() takes with interrupts masked, so the idle task must not be
+	switched out while it holds that lock. */
+	ulMask = ulPortSetInterruptMask();
+	if( pxThread->xDying == pdFALSE )
+	{
+		pthread_cancel( pxThread->xThread );
+	}
+	pthread_join( pxThread->xThread, NULL );
+	prvEventDestroy( &pxThread->xResume );
+	vPortClearInterruptMask( ulMask );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortGenerateSimulatedInterrupt( PortInterruptHandler_t pxHandler, void *pvContext )
+{
+	BaseType_t xReturn = pdFAIL;
+	sigset_t xSignals;
+	sigset_t xOriginalSignals;
+
+	/* The handler takes xInterruptMutex too, so keep it out while it is held. */
+	prvInterruptSignals( &xSignals );
+	pthread_sigmask( SIG_BLOCK, &xSignals, &xOriginalSignals );
+
+	pthread_mutex_lock( &xInterruptMutex );
+	if( ( ( uxPendingHead + 1 ) % portMAX_PENDING_INTERRUPTS ) != uxPendingTail )
+	{
+		xPendingInterrupts[ uxPendingHead ].pxHandler = pxHandler;
+		xPendingInterrupts[ uxPendingHead ].pvContext = pvContext;
+		uxPendingHead = ( uxPendingHead + 1 ) % portMAX_PENDING_INTERRUPTS;
+		xReturn = pdPASS;
+	}
+	pthread_mutex_unlock( &xInterruptMutex );
+
+	pthread_sigmask( SIG_SETMASK, &xOriginalSignals, NULL );
+
+	if( xReturn == pdPASS )
+	{
+		kill( getpid(), portSIG_INTERRUPT );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortCreateSimulatedInterruptThread( pthread_t *pxThread, void *( *pxEntry )( void * ), void *pvArg )
+{
+	sigset_t xSignals;
+	sigset_t xOriginalSignals;
+	int iRet;
+
+	prvInterruptSignals( &xSignals );
+	pthread_sigmask( SIG_BLOCK, &xSignals, &xOriginalSignals );
+	iRet = pthread_create( pxThread, NULL, pxEntry, pvArg );
+	pthread_sigmask( SIG_SETMASK, &xOriginalSignals, NULL );
+
+	return iRet == 0 ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
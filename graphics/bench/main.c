@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * graphics benchmark.
+ *
+ * draws each primitive onto the host framebuffer display, see device/HOST/lcd_host.c, and
+ * reports the bus traffic it generated. every bus cycle is a write or read strobe on the target,
+ * so the cycles per changed pixel is the overhead of a primitive over just writing its pixels.
+ *
+ * each primitive is drawn once onto a cleared display to count its traffic, then drawn
+ * BENCH_ITERATIONS more times to time it on the host. the host time is only useful to compare
+ * primitives, the target time is set by the bus cycles.
+ * with BENCH_DUMP set, the display is saved after each primitive to bench-<name>.ppm.
+ * with USE_GRAPHIC_GLYPH_CACHE set, the glyph cache statistics are reported at the end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "systime.h"
+#include "lcd.h"
+#include "graphics.h"
+#include "shape.h"
+#include "text.h"
+#include "image.h"
+#include "images.h"
+#if USE_GRAPHIC_GLYPH_CACHE
+#include "glyph_cache.h"
+#endif
+
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS    20
+#endif
+
+#ifndef BENCH_DUMP
+#define BENCH_DUMP          0
+#endif
+
+typedef struct {
+    const char* name;
+    void(*draw)();
+} bench_t;
+
+static const point_t origin = {40, 40};
+
+static void draw_background()
+{
+    set_background_colour(DARK_BLUE);
+}
+
+static void draw_square(shape_name_t type, bool fill, point_t size, uint16_t radius)
+{
+    shape_t shape = {
+        .type = type,
+        .fill_colour = MID_ORANGE,
+        .border_colour = WHITE,
+        .fill = fill,
+        .size = size,
+        .radius = radius,
+    };
+    draw_shape(&shape, origin);
+}
+
+static void draw_filled_square()
+{
+    draw_square(SQUARE, true, (point_t){160, 120}, 0);
+}
+
+static void draw_outline_square()
+{
+    draw_square(SQUARE, false, (point_t){160, 120}, 0);
+}
+
+static void draw_rounded_square()
+{
+    draw_square(SQUARE, true, (point_t){160, 120}, 16);
+}
+
+static void draw_filled_circle()
+{
+    draw_square(CIRCLE, true, (point_t){120, 120}, 60);
+}
+
+static void draw_outline_circle()
+{
+    draw_square(CIRCLE, false, (point_t){120, 120}, 60);
+}
+
+static void draw_horizontal_line()
+{
+    draw_square(LINE, false, (point_t){160, 0}, 0);
+}
+
+static void draw_vertical_line()
+{
+    draw_square(LINE, false, (point_t){0, 120}, 0);
+}
+
+static void draw_diagonal_line()
+{
+    draw_square(LINE, false, (point_t){160, 120}, 0);
+}
+
+static void draw_dot()
+{
+    draw_square(DOT, false, (point_t){1, 1}, 0);
+}
+
+static void draw_text(const font_t* font, bool raw)
+{
+    text_t text;
+    text_init(&text, (point_t){240, 60}, "Hello, 0123", 8);
+    text_set_font(&text, font);
+    text_set_colour(&text, WHITE);
+    text_set_background_colour(&text, DARK_GREY);
+    if(raw)
+        text_draw_raw(&text, origin, false);
+    else
+        text_draw(&text, origin);
+}
+
+static void draw_text_raw_16()
+{
+    draw_text(&Ubuntu_16, true);
+}
+
+static void draw_text_raw_32()
+{
+    draw_text(&Ubuntu_32, true);
+}
+
+static void draw_text_raw_64()
+{
+    draw_text(&Ubuntu_64, true);
+}
+
+static void draw_text_32()
+{
+    draw_text(&Ubuntu_32, false);
+}
+
+static void draw_image()
+{
+    micro_sd_gray_aa.location = origin;
+    image_draw(&micro_sd_gray_aa);
+}
+
+static const bench_t benches[] = {
+    {"background", draw_background},
+    {"square", draw_filled_square},
+    {"square-outline", draw_outline_square},
+    {"square-rounded", draw_rounded_square},
+    {"circle", draw_filled_circle},
+    {"circle-outline", draw_outline_circle},
+    {"line-h", draw_horizontal_line},
+    {"line-v", draw_vertical_line},
+    {"line-diagonal", draw_diagonal_line},
+    {"dot", draw_dot},
+    {"text-raw-16", draw_text_raw_16},
+    {"text-raw-32", draw_text_raw_32},
+    {"text-raw-64", draw_text_raw_64},
+    {"text-32", draw_text_32},
+    {"image", draw_image},
+};
+
+static uint64_t time_us()
+{
+    unsigned long secs, usecs;
+    get_hw_time(&secs, &usecs);
+    return ((uint64_t)secs * 1000000) + usecs;
+}
+
+static void run_bench(const bench_t* bench)
+{
+    lcd_host_stats_t stats;
+    uint32_t cycles;
+    uint64_t start;
+    int i;
+
+    set_background_colour(BLACK);
+    lcd_host_reset_stats();
+    bench->draw();
+    lcd_host_get_stats(&stats);
+
+#if BENCH_DUMP
+    char path[64];
+    sprintf(path, "bench-%s.ppm", bench->name);
+    if(lcd_host_dump_ppm(path) == -1)
+        printf("failed to write %s\n", path);
+#endif
+
+    start = time_us();
+    for(i = 0; i < BENCH_ITERATIONS; i++)
+        bench->draw();
+
+    cycles = stats.cmd_writes + stats.reg_writes + stats.pixels + stats.reads;
+    printf("  %15s %8d %7d %7d %8d %8d %6d.%02d %8d\n", bench->name,
+            (int)cycles, (int)stats.cursor_sets, (int)stats.window_sets,
+            (int)stats.pixels, (int)stats.pixels_changed,
+            stats.pixels_changed ? (int)(cycles / stats.pixels_changed) : 0,
+            stats.pixels_changed ? (int)(((cycles % stats.pixels_changed) * 100) / stats.pixels_changed) : 0,
+            (int)((time_us() - start) / BENCH_ITERATIONS));
+}
+
+int main(void)
+{
+    uint32_t i;
+#if USE_GRAPHIC_GLYPH_CACHE
+    glyph_cache_stats_t cache;
+#endif
+
+    lcd_init();
+    graphics_init();
+
+    printf("graphics primitives on a %dx%d display, bus cycles for one draw onto a cleared display\n",
+            LCD_WIDTH, LCD_HEIGHT);
+    printf("  %15s %8s %7s %7s %8s %8s %9s %8s\n", "primitive", "cycles", "cursor", "window",
+            "pixels", "changed", "cyc/pixel", "host us");
+    for(i = 0; i < sizeof(benches)/sizeof(benches[0]); i++)
+        run_bench(&benches[i]);
+
+#if USE_GRAPHIC_GLYPH_CACHE
+    glyph_cache_get_stats(&cache);
+    printf("glyph cache %d hits, %d misses, %d evictions, %d of %d bytes\n",
+            (int)cache.hits, (int)cache.misses, (int)cache.evictions, (int)cache.used, GLYPH_CACHE_SIZE);
+#endif
+
+    printf("framebuffer checksum %08x\n", (unsigned int)lcd_host_checksum());
+    exit(0);
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "glyph_cache.h"
+#if GLYPH_CACHE_USE_CCRAM
+#include "heap_ccram.h"
+#define glyph_cache_malloc(size)    malloc_ccram(size)
+#else
+#define glyph_cache_malloc(size)    malloc(size)
+#endif
+
+#if GLYPH_CACHE_GLYPH_MAX > GLYPH_CACHE_SIZE
+#error "GLYPH_CACHE_GLYPH_MAX must not be larger than GLYPH_CACHE_SIZE"
+#endif
+
+/**
+ * LRU cache of glyphs pre-rendered to display pixels, for one foreground and background colour.
+ *
+ * the pixels of all cached glyphs are packed into one arena of GLYPH_CACHE_SIZE bytes,
+ * allocated on first use. when a glyph is evicted, the glyphs above it are moved down
+ * to close the gap, so the arena never fragments no matter how glyph sizes vary.
+ *
+ * not thread safe on its own, it is used by the text routines under the LCD lock.
+ */
+
+typedef struct {
+    const character_t* ch;      ///< the glyph, NULL if the entry is free
+    colour_t colour;
+    colour_t background;
+    uint32_t offset;            ///< position of the pixels in the arena, in pixels
+    uint32_t length;            ///< number of pixels
+    uint32_t used;              ///< value of the use counter at the last hit
+} glyph_cache_entry_t;
+
+static colour_t* arena;
+static uint32_t arena_used;
+static uint32_t use_counter;
+static glyph_cache_entry_t entries[GLYPH_CACHE_ENTRIES];
+static glyph_cache_stats_t stats;
+
+/**
+ * decodes the RLE (count, alpha) glyph data into display pixels.
+ * the blend is worked out once per run rather than once per pixel.
+ */
+static void glyph_render(const character_t* ch, colour_t colour, colour_t background, colour_t* pixels)
+{
+    int32_t pix = ch->width * ch->height;
+    const uint8_t* run = ch->data;
+    colour_t blended;
+    uint8_t count;
+
+    while(pix > 0)
+    {
+        count = run[0];
+        if(run[1] == 0)
+            blended = background;
+        else if(run[1] == MAX_ALPHA)
+            blended = colour;
+        else
+            blended = blend_colour(colour, run[1], background, MAX_ALPHA);
+        run += 2;
+
+        if(count > pix)
+            count = pix;
+        pix -= count;
+        while(count--)
+            *pixels++ = blended;
+    }
+}
+
+/**
+ * removes an entry, moving the pixels of all glyphs stored above it down to close the gap.
+ */
+static void glyph_cache_evict(glyph_cache_entry_t* victim)
+{
+    uint32_t offset = victim->offset;
+    uint32_t length = victim->length;
+    int i;
+
+    memmove(arena + offset, arena + offset + length, (arena_used - offset - length) * sizeof(colour_t));
+    arena_used -= length;
+
+    for(i = 0; i < GLYPH_CACHE_ENTRIES; i++)
+    {
+        if(entries[i].ch && entries[i].offset > offset)
+            entries[i].offset -= length;
+    }
+
+    victim->ch = NULL;
+    stats.evictions++;
+}
+
+/**
+ * @retval the least recently used entry, or NULL if the cache is empty.
+ */
+static glyph_cache_entry_t* glyph_cache_lru(void)
+{
+    glyph_cache_entry_t* lru = NULL;
+    int i;
+
+    for(i = 0; i < GLYPH_CACHE_ENTRIES; i++)
+    {
+        if(entries[i].ch && (!lru || (use_counter - entries[i].used) > (use_counter - lru->used)))
+            lru = &entries[i];
+    }
+
+    return lru;
+}
+
+/**
+ * looks up a glyph pre-rendered in the given colours, rendering it into the cache on a miss.
+ *
+ * @param   ch is the glyph to look up.
+ * @param   colour is the text colour.
+ * @param   background is the colour the glyph is blended onto.
+ * @retval  a pointer to ch->width * ch->height pixels in display order, valid until the
+ *          next call, or NULL if the glyph is not cached (larger than GLYPH_CACHE_GLYPH_MAX,
+ *          or out of memory).
+ */
+const colour_t* glyph_cache_get(const character_t* ch, colour_t colour, colour_t background)
+{
+    uint32_t length = ch->width * ch->height;
+    glyph_cache_entry_t* entry = NULL;
+    int i;
+
+    if(length * sizeof(colour_t) > GLYPH_CACHE_GLYPH_MAX)
+        return NULL;
+
+    use_counter++;
+
+    for(i = 0; i < GLYPH_CACHE_ENTRIES; i++)
+    {
+        if(entries[i].ch == ch && entries[i].colour == colour && entries[i].background == background)
+        {
+            entries[i].used = use_counter;
+            stats.hits++;
+            return arena + entries[i].offset;
+        }
+        if(!entries[i].ch && !entry)
+            entry = &entries[i];
+    }
+
+    if(!arena)
+    {
+        arena = glyph_cache_malloc(GLYPH_CACHE_SIZE);
+        if(!arena)
+            return NULL;
+    }
+
+    // make room, in entries and in the arena
+    if(!entry)
+    {
+        entry = glyph_cache_lru();
+        glyph_cache_evict(entry);
+    }
+    while((arena_used + length) * sizeof(colour_t) > GLYPH_CACHE_SIZE)
+        glyph_cache_evict(glyph_cache_lru());
+
+    entry->ch = ch;
+    entry->colour = colour;
+    entry->background = background;
+    entry->offset = arena_used;
+    entry->length = length;
+    entry->used = use_counter;
+    arena_used += length;
+    stats.misses++;
+
+    glyph_render(ch, colour, background, arena + entry->offset);
+
+    return arena + entry->offset;
+}
+
+/**
+ * drops all cached glyphs. the memory is kept for reuse.
+ */
+void glyph_cache_flush(void)
+{
+    memset(entries, 0, sizeof(entries));
+    arena_used = 0;
+}
+
+/**
+ * copies the cache statistics into s.
+ */
+void glyph_cache_get_stats(glyph_cache_stats_t* s)
+{
+    *s = stats;
+    s->used = arena_used * sizeof(colour_t);
+}
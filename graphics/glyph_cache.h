@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "font.h"
+#include "graphics.h"
+
+#ifndef GLYPH_CACHE_H_
+#define GLYPH_CACHE_H_
+
+/**
+ * memory budget of the glyph cache in bytes, each cached glyph takes width*height*2 bytes.
+ */
+#ifndef GLYPH_CACHE_SIZE
+#define GLYPH_CACHE_SIZE        16384
+#endif
+
+/**
+ * the largest glyph, in bytes, that is cached. bigger glyphs are drawn straight from the
+ * font, caching them would evict most of the smaller glyphs for little gain.
+ */
+#ifndef GLYPH_CACHE_GLYPH_MAX
+#define GLYPH_CACHE_GLYPH_MAX   (GLYPH_CACHE_SIZE / 8)
+#endif
+
+/**
+ * the maximum number of glyphs held in the cache at once.
+ */
+#ifndef GLYPH_CACHE_ENTRIES
+#define GLYPH_CACHE_ENTRIES     64
+#endif
+
+/**
+ * set to 1 to take the cache memory from the CCRAM heap (STM32F4 only).
+ * CPU writes to the display are fine from CCRAM, DMA cannot reach it.
+ */
+#ifndef GLYPH_CACHE_USE_CCRAM
+#define GLYPH_CACHE_USE_CCRAM   0
+#endif
+
+typedef struct {
+    uint32_t hits;          ///< number of glyphs drawn from the cache
+    uint32_t misses;        ///< number of glyphs rendered into the cache
+    uint32_t evictions;     ///< number of glyphs dropped to make room
+    uint32_t used;          ///< bytes of the budget in use
+} glyph_cache_stats_t;
+
+const colour_t* glyph_cache_get(const character_t* ch, colour_t colour, colour_t background);
+void glyph_cache_flush(void);
+void glyph_cache_get_stats(glyph_cache_stats_t* stats);
+
+#endif // GLYPH_CACHE_H_
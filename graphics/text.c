@@ -31,6 +31,9 @@
  */
 
 #include "text.h"
+#if USE_GRAPHIC_GLYPH_CACHE
+#include "glyph_cache.h"
+#endif
 
 const text_t text_defaults = {
     .colour = WHITE,
@@ -242,6 +245,9 @@ void text_redraw_background(text_t* text, point_t location)
  * where the text should be. if false, draws the text like normal.
  *
  * does not draw the textbox background.
+ *
+ * with USE_GRAPHIC_GLYPH_CACHE set, glyphs are taken pre-rendered from the glyph cache
+ * and written to the display straight from memory.
  */
 void text_draw_raw(text_t* text, point_t location, bool blank)
 {
@@ -250,9 +256,12 @@ void text_draw_raw(text_t* text, point_t location, bool blank)
     int16_t run;
     int16_t run_count;
     int16_t pix;
-    uint8_t alpha = 0;
+    colour_t blended = 0;
     const character_t* ch;
     const char* str;
+#if USE_GRAPHIC_GLYPH_CACHE
+    const colour_t* pixels;
+#endif
 
     if(text->buffer)
         str = text->buffer;
@@ -278,6 +287,13 @@ void text_draw_raw(text_t* text, point_t location, bool blank)
             while(pix--)
                 write_data(text->shape.fill_colour);
         }
+#if USE_GRAPHIC_GLYPH_CACHE
+        else if((pixels = glyph_cache_get(ch, text->colour, text->shape.fill_colour)))
+        {
+            while(pix--)
+                write_data(*pixels++);
+        }
+#endif
         else
         {
             while(pix--)
@@ -285,18 +301,18 @@ void text_draw_raw(text_t* text, point_t location, bool blank)
                 if(!run_count)
                 {
                     run_count = ch->data[run];
-                    alpha = ch->data[run+1];
+                    // speed up writes, no math for alpha = 0 or 255, and only one blend per run
+                    if(ch->data[run+1] == 0)
+                        blended = text->shape.fill_colour;
+                    else if(ch->data[run+1] == MAX_ALPHA)
+                        blended = text->colour;
+                    else
+                        blended = blend_colour(text->colour, ch->data[run+1], text->shape.fill_colour, MAX_ALPHA);
                     run += 2;
                 }
                 run_count--;
 
-                // speed up writes, no math for alpha = 0 or 255
-                if(alpha == 0)
-                    write_data(text->shape.fill_colour);
-                else if(alpha == MAX_ALPHA)
-                    write_data(text->colour);
-                else
-                    write_data(blend_colour(text->colour, alpha, text->shape.fill_colour, MAX_ALPHA));
+                write_data(blended);
             }
         }
         location.x += ch->xadvance;
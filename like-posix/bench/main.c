@@ -0,0 +1,531 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * like-posix file table benchmark.
+ *
+ * BENCH_TASKS tasks run the same workload in parallel, timing every call they make.
+ * each workload reports a latency histogram per call, and how often the file table lock
+ * and the per file read/write locks were waited on (see LIKEPOSIX_LOCK_STATS).
+ *
+ * - files:     each task opens its own file, writes, seeks, reads, dups and closes it.
+ * - shared:    all tasks seek, write and read one file descriptor.
+ * - fifo:      each task writes to and reads from its own loopback device.
+ * - sockets:   each task sends UDP datagrams to itself, at the interface address. the host
+ *              ethernet interface (see ethernetif.c) loops every frame it sends back in, so
+ *              the datagrams go through the whole LwIP stack.
+ *              only built when ENABLE_LIKEPOSIX_SOCKETS is set.
+ * - asset:     each task opens, reads through and closes a web page, first a copy of it on the
+ *              FAT file system, then the original in the read only file system image.
+ *              only built when USE_ROMFS is set.
+ *
+ * then a single task times open()/close() with an increasing number of files already open,
+ * which shows the cost of the file table scan.
+ *
+ * the timings come from the host clock, and so include time spent by other tasks
+ * while a call was blocked or preempted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "sdfs.h"
+#include "syscalls.h"
+
+#if ENABLE_LIKEPOSIX_SOCKETS
+#include <sys/socket.h>
+#include "net.h"
+#endif
+
+#ifndef BENCH_TASKS
+#define BENCH_TASKS             4
+#endif
+#define BENCH_ITERATIONS        500
+#define BENCH_TRANSFER          64
+#define BENCH_FIFO_LENGTH       256
+#define BENCH_SOCKET_PORT       5100
+#define BENCH_SOCKET_TIMEOUT    1000
+#define BENCH_IPADDR            "10.0.0.2"
+#define BENCH_RESOLV_CONF_PATH  "/bench/resolv"
+#define BENCH_NETIF_CONF_PATH   "/bench/interface"
+#define BENCH_SHARED_FILE       "/bench/shared.bin"
+#define BENCH_ROM_ASSET         "/var/lib/httpd/index.html"
+#define BENCH_FAT_ASSET         "/bench/index.html"
+
+/**
+ * histogram bucket 0 counts calls under 1us, bucket n counts calls from 2^(n-1)us up to 2^n us.
+ * the last bucket counts everything longer.
+ */
+#define HIST_BUCKETS            16
+
+#if BENCH_TASKS > DEVICE_TABLE_LENGTH - 1
+#error BENCH_TASKS must be less than DEVICE_TABLE_LENGTH, each task needs a loopback device
+#endif
+
+typedef enum {
+    OP_OPEN,
+    OP_CLOSE,
+    OP_WRITE,
+    OP_READ,
+    OP_LSEEK,
+    OP_DUP,
+    OP_COUNT
+} op_t;
+
+static const char* op_names[OP_COUNT] = {"open", "close", "write", "read", "lseek", "dup"};
+
+typedef struct {
+    unsigned int count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    unsigned int buckets[HIST_BUCKETS];
+} histogram_t;
+
+typedef struct _worker_t worker_t;
+typedef void(*workload_fn_t)(worker_t*);
+
+struct _worker_t {
+    int id;
+    workload_fn_t workload;
+    int fd;                                 ///< shared file descriptor, for the shared workload
+    unsigned int errors;
+    histogram_t hist[OP_COUNT];
+};
+
+static worker_t workers[BENCH_TASKS];
+static SemaphoreHandle_t done;
+static const char* asset;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+static void hist_add(histogram_t* hist, uint64_t ns)
+{
+    uint64_t us = ns / 1000;
+    int bucket = 0;
+
+    while(us && bucket < HIST_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+
+    hist->count++;
+    hist->total_ns += ns;
+    if(ns > hist->max_ns)
+        hist->max_ns = ns;
+    hist->buckets[bucket]++;
+}
+
+static void hist_merge(histogram_t* into, const histogram_t* from)
+{
+    int i;
+    into->count += from->count;
+    into->total_ns += from->total_ns;
+    if(from->max_ns > into->max_ns)
+        into->max_ns = from->max_ns;
+    for(i = 0; i < HIST_BUCKETS; i++)
+        into->buckets[i] += from->buckets[i];
+}
+
+/**
+ * times one call, adds it to the worker's histogram for op, and counts failures.
+ * evaluates to the result of the call.
+ */
+#define TIMED(worker, op, call)                                         \
+    ({                                                                  \
+        uint64_t _start = now_ns();                                     \
+        int _res = (call);                                              \
+        hist_add(&(worker)->hist[op], now_ns() - _start);               \
+        if(_res < 0)                                                    \
+            (worker)->errors++;                                         \
+        _res;                                                           \
+    })
+
+/**
+ * loopback device, whatever is written comes back to be read.
+ * runs in the writing task, from write().
+ */
+static int loopback_write_enable(dev_ioctl_t* device)
+{
+    char buf[BENCH_TRANSFER];
+    uint32_t n;
+
+    while((n = ringbuf_get(device->pipe.write, buf, sizeof(buf))) > 0)
+        ringbuf_put(device->pipe.read, buf, n);
+
+    return 0;
+}
+
+static void workload_files(worker_t* worker)
+{
+    char path[32];
+    char buf[BENCH_TRANSFER];
+    int i, fd, dupfd;
+
+    sprintf(path, "/bench/f%d.bin", worker->id);
+    memset(buf, worker->id, sizeof(buf));
+
+    for(i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        fd = TIMED(worker, OP_OPEN, open(path, O_RDWR|O_CREAT, 0));
+        if(fd < 0)
+            continue;
+        TIMED(worker, OP_WRITE, write(fd, buf, sizeof(buf)));
+        TIMED(worker, OP_LSEEK, lseek(fd, 0, SEEK_SET));
+        TIMED(worker, OP_READ, read(fd, buf, sizeof(buf)));
+        dupfd = TIMED(worker, OP_DUP, dup(fd));
+        if(dupfd >= 0)
+            TIMED(worker, OP_CLOSE, close(dupfd));
+        TIMED(worker, OP_CLOSE, close(fd));
+    }
+}
+
+static void workload_shared(worker_t* worker)
+{
+    char buf[BENCH_TRANSFER];
+    int i;
+
+    memset(buf, worker->id, sizeof(buf));
+
+    for(i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        TIMED(worker, OP_LSEEK, lseek(worker->fd, worker->id * BENCH_TRANSFER, SEEK_SET));
+        TIMED(worker, OP_WRITE, write(worker->fd, buf, sizeof(buf)));
+        TIMED(worker, OP_LSEEK, lseek(worker->fd, worker->id * BENCH_TRANSFER, SEEK_SET));
+        TIMED(worker, OP_READ, read(worker->fd, buf, sizeof(buf)));
+    }
+}
+
+static void workload_fifo(worker_t* worker)
+{
+    char path[32];
+    char buf[BENCH_TRANSFER];
+    int i, fd;
+
+    sprintf(path, DEVICE_INTERFACE_DIRECTORY "loop%d", worker->id);
+    memset(buf, worker->id, sizeof(buf));
+
+    // for devices the mode argument is the FIFO length
+    fd = TIMED(worker, OP_OPEN, open(path, O_RDWR, BENCH_FIFO_LENGTH));
+    if(fd < 0)
+        return;
+
+    for(i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        TIMED(worker, OP_WRITE, write(fd, buf, sizeof(buf)));
+        TIMED(worker, OP_READ, read(fd, buf, sizeof(buf)));
+    }
+
+    TIMED(worker, OP_CLOSE, close(fd));
+}
+
+#if ENABLE_LIKEPOSIX_SOCKETS
+static void workload_sockets(worker_t* worker)
+{
+    struct sockaddr_in addr;
+    char buf[BENCH_TRANSFER];
+    int timeout = BENCH_SOCKET_TIMEOUT;    // lwip takes the receive timeout in ms
+    int i, fd;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(BENCH_SOCKET_PORT + worker->id);
+    addr.sin_addr.s_addr = inet_addr(BENCH_IPADDR);
+    memset(buf, worker->id, sizeof(buf));
+
+    fd = TIMED(worker, OP_OPEN, socket(AF_INET, SOCK_DGRAM, 0));
+    if(fd < 0)
+        return;
+    // a lost datagram counts as an error, rather than blocking the task for good
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0)
+    {
+        for(i = 0; i < BENCH_ITERATIONS; i++)
+        {
+            TIMED(worker, OP_WRITE, sendto(fd, buf, sizeof(buf), 0, (struct sockaddr*)&addr, sizeof(addr)));
+            TIMED(worker, OP_READ, recv(fd, buf, sizeof(buf), 0));
+        }
+    }
+    else
+        worker->errors++;
+
+    TIMED(worker, OP_CLOSE, closesocket(fd));
+}
+
+static void write_file(const char* path, const char* content)
+{
+    int fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0);
+    if(fd >= 0)
+    {
+        write(fd, content, strlen(content));
+        close(fd);
+    }
+    else
+        printf("failed to write %s\n", path);
+}
+
+/**
+ * brings up LwIP on the host loopback interface, with a static address.
+ * the configuration is written to the RAM disk, the files in /etc/network are in the
+ * read only image.
+ */
+static bool net_up(void)
+{
+    static netconf_t netconf;
+
+    write_file(BENCH_RESOLV_CONF_PATH, "resolv static\nhostname bench\n");
+    write_file(BENCH_NETIF_CONF_PATH,
+            "ipaddr " BENCH_IPADDR "\n"
+            "netmask 255.255.255.0\n"
+            "gateway 10.0.0.1\n"
+            "macaddr 02:00:00:00:00:01\n");
+
+    net_config(&netconf, BENCH_RESOLV_CONF_PATH, BENCH_NETIF_CONF_PATH);
+    net_init(&netconf);
+    return wait_for_address(&netconf);
+}
+#endif
+
+#if USE_ROMFS
+static void workload_asset(worker_t* worker)
+{
+    char buf[_MAX_SS];
+    int i, fd, n;
+
+    for(i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        fd = TIMED(worker, OP_OPEN, open(asset, O_RDONLY, 0));
+        if(fd < 0)
+            continue;
+        do {
+            n = TIMED(worker, OP_READ, read(fd, buf, sizeof(buf)));
+        } while(n > 0);
+        TIMED(worker, OP_CLOSE, close(fd));
+    }
+}
+
+/**
+ * copies the web page out of the read only file system image, onto the FAT file system.
+ */
+static void copy_asset(void)
+{
+    char buf[_MAX_SS];
+    int in = open(BENCH_ROM_ASSET, O_RDONLY, 0);
+    int out = open(BENCH_FAT_ASSET, O_WRONLY|O_CREAT|O_TRUNC, 0);
+    int n;
+
+    while((n = read(in, buf, sizeof(buf))) > 0)
+        write(out, buf, n);
+
+    close(out);
+    close(in);
+}
+#endif
+
+static void worker_task(void* ctx)
+{
+    worker_t* worker = (worker_t*)ctx;
+    worker->workload(worker);
+    xSemaphoreGive(done);
+    vTaskDelete(NULL);
+}
+
+static void print_lock_stats(const char* name, const lock_stats_t* stats)
+{
+    printf("  %s lock: %u taken, %u contended, %u timeouts\n", name,
+            (unsigned int)stats->taken, (unsigned int)stats->contended, (unsigned int)stats->timeouts);
+}
+
+static void print_histograms(const histogram_t* hist)
+{
+    int op, b;
+
+    printf("  %-6s %7s %9s %9s  histogram, calls per bucket: <1us", "call", "calls", "mean us", "max us");
+    for(b = 1; b < HIST_BUCKETS - 1; b++)
+        printf(" <%d", 1 << b);
+    printf(" more\n");
+
+    for(op = 0; op < OP_COUNT; op++)
+    {
+        if(!hist[op].count)
+            continue;
+        printf("  %-6s %7u %9u %9u  ", op_names[op], hist[op].count,
+                (unsigned int)(hist[op].total_ns / hist[op].count / 1000), (unsigned int)(hist[op].max_ns / 1000));
+        for(b = 0; b < HIST_BUCKETS; b++)
+            printf(" %u", hist[op].buckets[b]);
+        printf("\n");
+    }
+}
+
+/**
+ * runs a workload in BENCH_TASKS tasks at once, then reports the merged histograms
+ * and the lock counters.
+ */
+static void run(const char* name, workload_fn_t workload, int fd)
+{
+    histogram_t hist[OP_COUNT];
+    file_table_lock_stats_t stats;
+    unsigned int errors = 0;
+    uint64_t start, elapsed;
+    int i, op;
+
+    memset(workers, 0, sizeof(workers));
+    memset(hist, 0, sizeof(hist));
+    file_table_reset_lock_stats();
+
+    start = now_ns();
+    for(i = 0; i < BENCH_TASKS; i++)
+    {
+        workers[i].id = i;
+        workers[i].workload = workload;
+        workers[i].fd = fd;
+        xTaskCreate(worker_task, "bench", configMINIMAL_STACK_SIZE * 4, &workers[i], tskIDLE_PRIORITY + 1, NULL);
+    }
+    for(i = 0; i < BENCH_TASKS; i++)
+        xSemaphoreTake(done, portMAX_DELAY);
+    elapsed = now_ns() - start;
+
+    file_table_lock_stats(&stats);
+    for(i = 0; i < BENCH_TASKS; i++)
+    {
+        errors += workers[i].errors;
+        for(op = 0; op < OP_COUNT; op++)
+            hist_merge(&hist[op], &workers[i].hist[op]);
+    }
+
+    printf("%s: %d tasks, %u ms, %u errors\n", name, BENCH_TASKS, (unsigned int)(elapsed / 1000000), errors);
+    print_histograms(hist);
+    print_lock_stats("file table", &stats.filtab);
+    print_lock_stats("read", &stats.read);
+    print_lock_stats("write", &stats.write);
+}
+
+/**
+ * times open()/close() of one file, with a number of other descriptors already open.
+ * the other descriptors are dups, which take file table slots but no FatFs file objects.
+ */
+static void run_table_scan(void)
+{
+    int held[FILE_TABLE_LENGTH];
+    int nheld, i, fd, base;
+    uint64_t start;
+
+    printf("open/close with the file table filling up, 1 task\n");
+
+    base = open("/bench/scan.bin", O_RDWR|O_CREAT, 0);
+    for(nheld = 0; nheld < FILE_TABLE_LENGTH - 2; )
+    {
+        start = now_ns();
+        for(i = 0; i < BENCH_ITERATIONS; i++)
+        {
+            fd = open("/bench/f0.bin", O_RDONLY, 0);
+            close(fd);
+        }
+        printf("  %2d open: %u us per open+close\n", nheld + 1,
+                (unsigned int)((now_ns() - start) / BENCH_ITERATIONS / 1000));
+
+        for(i = 0; i < 4 && nheld < FILE_TABLE_LENGTH - 2; i++)
+            held[nheld++] = dup(base);
+    }
+
+    while(nheld)
+        close(held[--nheld]);
+    close(base);
+}
+
+int main(void)
+{
+    char path[32];
+    int i, fd;
+
+    done = xSemaphoreCreateCounting(BENCH_TASKS, 0);
+
+    sdfs_init();
+    while(!sdfs_ready())
+        vTaskDelay(10);
+
+    mkdir("/bench", 0);
+    // the RAM disk starts out empty, and install_device() can't create the directory
+    // from DEVICE_INTERFACE_DIRECTORY itself because of its trailing '/'
+    mkdir("/dev", 0);
+    for(i = 0; i < BENCH_TASKS; i++)
+    {
+        sprintf(path, DEVICE_INTERFACE_DIRECTORY "loop%d", i);
+        install_device(path, NULL, NULL, loopback_write_enable, NULL, NULL, NULL);
+    }
+
+#if ENABLE_LIKEPOSIX_SOCKETS
+    if(!net_up())
+    {
+        printf("no address\n");
+        exit(1);
+    }
+#endif
+
+    run("files", workload_files, -1);
+
+    fd = open(BENCH_SHARED_FILE, O_RDWR|O_CREAT|O_TRUNC, 0);
+    run("shared", workload_shared, fd);
+    close(fd);
+
+    run("fifo", workload_fifo, -1);
+
+#if ENABLE_LIKEPOSIX_SOCKETS
+    run("sockets", workload_sockets, -1);
+#endif
+
+#if USE_ROMFS
+    copy_asset();
+    asset = BENCH_FAT_ASSET;
+    run("asset, FAT file system", workload_asset, -1);
+    asset = BENCH_ROM_ASSET;
+    run("asset, romfs", workload_asset, -1);
+#endif
+
+    run_table_scan();
+
+    exit(0);
+    return 0;
+}
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup syscalls
+ *
+ * @file ringbuf.c
+ * @{
+ */
+
+#include <string.h>
+#include "ringbuf.h"
+
+/**
+ * keeps the compiler from moving buffer accesses across index updates.
+ * the producer and consumer share a single core, so no hardware barrier is needed.
+ */
+#define ringbuf_barrier()       __asm volatile ("" ::: "memory")
+
+/**
+ * creates a ring buffer able to hold length bytes.
+ *
+ * @param   length is the number of bytes the ring buffer can hold.
+ * @retval  a pointer to the new ring buffer, or NULL on failure.
+ */
+ringbuf_t* ringbuf_create(uint32_t length)
+{
+    ringbuf_t* rb = pvPortMalloc(sizeof(ringbuf_t) + length + 1);
+
+    if(rb)
+    {
+        rb->buffer = (uint8_t*)(rb + 1);
+        rb->size = length + 1;
+        rb->head = 0;
+        rb->tail = 0;
+        rb->threshold = 0;
+        rb->notify = NULL;
+        rb->wake = xSemaphoreCreateBinary();
+        if(!rb->wake)
+        {
+            vPortFree(rb);
+            rb = NULL;
+        }
+    }
+
+    return rb;
+}
+
+/**
+ * frees a ring buffer created by ringbuf_create().
+ */
+void ringbuf_delete(ringbuf_t* rb)
+{
+    vSemaphoreDelete(rb->wake);
+    vPortFree(rb);
+}
+
+/**
+ * discards all data in the ring buffer.
+ */
+void ringbuf_reset(ringbuf_t* rb)
+{
+    taskENTER_CRITICAL();
+    rb->tail = rb->head;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @retval  the number of bytes that may be read from the ring buffer.
+ */
+uint32_t ringbuf_used(ringbuf_t* rb)
+{
+    uint32_t head = rb->head;
+    uint32_t tail = rb->tail;
+    return head >= tail ? head - tail : rb->size - tail + head;
+}
+
+/**
+ * @retval  the number of bytes that may be written to the ring buffer.
+ */
+uint32_t ringbuf_space(ringbuf_t* rb)
+{
+    return rb->size - 1 - ringbuf_used(rb);
+}
+
+/**
+ * copies up to count bytes into the ring buffer, without blocking.
+ * wakes a consumer that waits for data, once its threshold is reached.
+ *
+ * @retval  the number of bytes copied.
+ */
+static uint32_t ringbuf_put_common(ringbuf_t* rb, const void* data, uint32_t count, bool* wake)
+{
+    uint32_t head = rb->head;
+    uint32_t chunk;
+
+    if(count > ringbuf_space(rb))
+        count = ringbuf_space(rb);
+
+    chunk = rb->size - head;
+    if(chunk > count)
+        chunk = count;
+
+    memcpy(rb->buffer + head, data, chunk);
+    memcpy(rb->buffer, (const uint8_t*)data + chunk, count - chunk);
+
+    head += count;
+    if(head >= rb->size)
+        head -= rb->size;
+
+    ringbuf_barrier();
+    rb->head = head;
+
+    *wake = rb->threshold && ringbuf_used(rb) >= rb->threshold;
+    if(*wake)
+        rb->threshold = 0;
+
+    return count;
+}
+
+/**
+ * copies up to count bytes out of the ring buffer, without blocking.
+ * wakes a producer that waits for space, once its threshold is reached.
+ *
+ * @retval  the number of bytes copied.
+ */
+static uint32_t ringbuf_get_common(ringbuf_t* rb, void* data, uint32_t count, bool* wake)
+{
+    uint32_t tail = rb->tail;
+    uint32_t chunk;
+
+    if(count > ringbuf_used(rb))
+        count = ringbuf_used(rb);
+
+    chunk = rb->size - tail;
+    if(chunk > count)
+        chunk = count;
+
+    memcpy(data, rb->buffer + tail, chunk);
+    memcpy((uint8_t*)data + chunk, rb->buffer, count - chunk);
+
+    tail += count;
+    if(tail >= rb->size)
+        tail -= rb->size;
+
+    ringbuf_barrier();
+    rb->tail = tail;
+
+    *wake = rb->threshold && ringbuf_space(rb) >= rb->threshold;
+    if(*wake)
+        rb->threshold = 0;
+
+    return count;
+}
+
+/**
+ * copies up to count bytes into the ring buffer from a task, without blocking.
+ *
+ * @retval  the number of bytes copied.
+ */
+uint32_t ringbuf_put(ringbuf_t* rb, const void* data, uint32_t count)
+{
+    bool wake;
+    SemaphoreHandle_t notify = rb->notify;
+    count = ringbuf_put_common(rb, data, count, &wake);
+    if(wake)
+        xSemaphoreGive(rb->wake);
+    if(notify && count)
+        xSemaphoreGive(notify);
+    return count;
+}
+
+/**
+ * copies up to count bytes out of the ring buffer from a task, without blocking.
+ *
+ * @retval  the number of bytes copied.
+ */
+uint32_t ringbuf_get(ringbuf_t* rb, void* data, uint32_t count)
+{
+    bool wake;
+    SemaphoreHandle_t notify = rb->notify;
+    count = ringbuf_get_common(rb, data, count, &wake);
+    if(wake)
+        xSemaphoreGive(rb->wake);
+    if(notify && count)
+        xSemaphoreGive(notify);
+    return count;
+}
+
+/**
+ * copies up to count bytes into the ring buffer from an interrupt.
+ *
+ * @param   woken is set to pdTRUE if a task was woken that should run on exiting the interrupt.
+ * @retval  the number of bytes copied.
+ */
+uint32_t ringbuf_put_from_isr(ringbuf_t* rb, const void* data, uint32_t count, BaseType_t* woken)
+{
+    bool wake;
+    SemaphoreHandle_t notify = rb->notify;
+    count = ringbuf_put_common(rb, data, count, &wake);
+    if(wake)
+        xSemaphoreGiveFromISR(rb->wake, woken);
+    if(notify && count)
+        xSemaphoreGiveFromISR(notify, woken);
+    return count;
+}
+
+/**
+ * copies up to count bytes out of the ring buffer from an interrupt.
+ *
+ * @param   woken is set to pdTRUE if a task was woken that should run on exiting the interrupt.
+ * @retval  the number of bytes copied.
+ */
+uint32_t ringbuf_get_from_isr(ringbuf_t* rb, void* data, uint32_t count, BaseType_t* woken)
+{
+    bool wake;
+    SemaphoreHandle_t notify = rb->notify;
+    count = ringbuf_get_common(rb, data, count, &wake);
+    if(wake)
+        xSemaphoreGiveFromISR(rb->wake, woken);
+    if(notify && count)
+        xSemaphoreGiveFromISR(notify, woken);
+    return count;
+}
+
+/**
+ * blocks until ready() reports that count has been reached, or the timeout expires.
+ */
+static bool ringbuf_wait(ringbuf_t* rb, uint32_t count, TickType_t timeout, uint32_t(*ready)(ringbuf_t*))
+{
+    TimeOut_t xTimeOut;
+
+    if(ready(rb) >= count)
+        return true;
+    if(timeout == 0)
+        return false;
+
+    vTaskSetTimeOutState(&xTimeOut);
+
+    // clear any stale wake up, then publish the threshold before checking again,
+    // so that data arriving in between still gives the semaphore
+    xSemaphoreTake(rb->wake, 0);
+    rb->threshold = count;
+    ringbuf_barrier();
+
+    while(ready(rb) < count)
+    {
+        if(xTaskCheckForTimeOut(&xTimeOut, &timeout) == pdTRUE)
+            break;
+        xSemaphoreTake(rb->wake, timeout);
+        rb->threshold = count;
+    }
+
+    rb->threshold = 0;
+    return ready(rb) >= count;
+}
+
+/**
+ * blocks until at least count bytes may be read, or the timeout expires.
+ *
+ * @param   count is the number of bytes to wait for, limited to the ring buffer capacity.
+ * @param   timeout is the maximum time to wait, in ticks.
+ * @retval  true if count bytes are available.
+ */
+bool ringbuf_wait_used(ringbuf_t* rb, uint32_t count, TickType_t timeout)
+{
+    if(count > rb->size - 1)
+        count = rb->size - 1;
+    return ringbuf_wait(rb, count, timeout, ringbuf_used);
+}
+
+/**
+ * blocks until at least count bytes may be written, or the timeout expires.
+ *
+ * @param   count is the number of bytes of space to wait for, limited to the ring buffer capacity.
+ * @param   timeout is the maximum time to wait, in ticks.
+ * @retval  true if count bytes of space are available.
+ */
+bool ringbuf_wait_space(ringbuf_t* rb, uint32_t count, TickType_t timeout)
+{
+    if(count > rb->size - 1)
+        count = rb->size - 1;
+    return ringbuf_wait(rb, count, timeout, ringbuf_space);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup syscalls
+ *
+ * @file ringbuf.h
+ * @{
+ */
+#ifndef LIKE_POSIX_RINGBUF_H_
+#define LIKE_POSIX_RINGBUF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/**
+ * single producer, single consumer byte ring buffer.
+ *
+ * head is only ever written by the producer, tail only by the consumer, so
+ * one side may live in an interrupt while the other lives in a task without
+ * any locking. data moves in and out with memcpy, at most two per call.
+ *
+ * only one side may block at a time, by waiting for a threshold of bytes
+ * (the consumer) or of free space (the producer) to become available.
+ *
+ * notify may be set by a task waiting on several ring buffers at once (see poll()),
+ * it is given on every put or get that moves data.
+ */
+typedef struct {
+    uint8_t* buffer;                ///< storage, size bytes long
+    uint32_t size;                  ///< storage size, one byte is always kept free
+    volatile uint32_t head;         ///< next position to write, written by the producer only
+    volatile uint32_t tail;         ///< next position to read, written by the consumer only
+    volatile uint32_t threshold;    ///< the amount the blocked side waits for, 0 when nothing is blocked
+    SemaphoreHandle_t wake;         ///< given when the threshold is reached
+    SemaphoreHandle_t volatile notify;  ///< given whenever data moves while set, NULL otherwise
+} ringbuf_t;
+
+ringbuf_t* ringbuf_create(uint32_t length);
+void ringbuf_delete(ringbuf_t* rb);
+void ringbuf_reset(ringbuf_t* rb);
+uint32_t ringbuf_used(ringbuf_t* rb);
+uint32_t ringbuf_space(ringbuf_t* rb);
+
+uint32_t ringbuf_put(ringbuf_t* rb, const void* data, uint32_t count);
+uint32_t ringbuf_get(ringbuf_t* rb, void* data, uint32_t count);
+uint32_t ringbuf_put_from_isr(ringbuf_t* rb, const void* data, uint32_t count, BaseType_t* woken);
+uint32_t ringbuf_get_from_isr(ringbuf_t* rb, void* data, uint32_t count, BaseType_t* woken);
+
+bool ringbuf_wait_used(ringbuf_t* rb, uint32_t count, TickType_t timeout);
+bool ringbuf_wait_space(ringbuf_t* rb, uint32_t count, TickType_t timeout);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* LIKE_POSIX_RINGBUF_H_ */
+
+/**
+ * @}
+ */
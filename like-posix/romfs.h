@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup syscalls
+ *
+ * @file romfs.h
+ * @{
+ */
+#ifndef LIKE_POSIX_ROMFS_H_
+#define LIKE_POSIX_ROMFS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/**
+ * a file in the read only file system image.
+ *
+ * the contents are a const array, so on a device they are read straight from flash.
+ * data is 4 byte aligned, and followed by a 0 that is not counted in size.
+ */
+typedef struct {
+    const char* name;       ///< the full path of the file, including the mount point
+    const uint8_t* data;    ///< the file contents
+    uint32_t size;          ///< the file size in bytes
+} romfs_entry_t;
+
+/**
+ * read only file system image.
+ *
+ * entries is sorted by name, in strcmp() order.
+ */
+typedef struct {
+    const romfs_entry_t* entries;
+    uint32_t count;
+} romfs_t;
+
+/**
+ * the image generated at build time from ROMFS_SOURCE_DIR by build-env/tools/mkromfs.py,
+ * and mounted at ROMFS_MOUNT_POINT. see build-env/setup.mk.
+ */
+extern const romfs_t romfs_image;
+
+const romfs_entry_t* romfs_find(const char* path);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* LIKE_POSIX_ROMFS_H_ */
+
+/**
+ * @}
+ */
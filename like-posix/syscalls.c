@@ -63,10 +63,12 @@
 //#include <errno.h>
 #include <time.h>
 #include <string.h>
+#include <poll.h>
 #include "syscalls.h"
 #include "cutensils.h"
 #include "strutils.h"
 #include "systime.h"
+#include "romfs.h"
 
 
 /**
@@ -82,14 +84,30 @@ typedef struct {
 	SemaphoreHandle_t read_lock; 	///< file read lock, mutex
 	SemaphoreHandle_t write_lock; 	///< file write lock, mutex
 	unsigned char dupcount;	///< increments for every dup / dup2
+	unsigned short refs;	///< file table slots and calls using the entry, it is deleted when this drops to 0
+	const romfs_entry_t* rom;	///< regular file in the read only file system image, or NULL
+	uint32_t position;		///< file position, used only for rom
 }filtab_entry_t;
 
+/**
+ * the number of words in the file table slot bitmap.
+ */
+#define FILE_TABLE_WORDS    ((FILE_TABLE_LENGTH + 31) / 32)
+
 /**
  * file table definition.
+ *
+ * the slots and the slot bitmap are changed in short critical sections, so looking up a
+ * file descriptor never waits on the file table lock. a file table entry is reference
+ * counted, so it stays valid for the length of a call that uses it, even if the file
+ * descriptor is closed meanwhile. the generation of a slot changes every time it is
+ * emptied, so a call that waited for a file lock can tell if its descriptor was closed.
  */
 typedef struct {
 	int count;									///< the number of open files, 0 means nothing open yet
 	filtab_entry_t* tab[FILE_TABLE_LENGTH];		///< the file table
+	unsigned short gen[FILE_TABLE_LENGTH];		///< slot generations
+	uint32_t used[FILE_TABLE_WORDS];			///< slots in use, slot n is bit 31 - n%32 of word n/32
 	dev_ioctl_t* devtab[DEVICE_TABLE_LENGTH];	///< the device table
 	SemaphoreHandle_t lock;                     ///< file table lock.
 	int hwm;                                    ///< file table high water mark
@@ -104,16 +122,92 @@ typedef struct {
 #define DEFAULT_FILETABLE_TIMEOUT		40000
 #define DEFAULT_FILE_LOCK_TIMEOUT		10000
 
-#define lock_filtab()                   (xSemaphoreTake(filtab.lock, DEFAULT_FILETABLE_TIMEOUT/portTICK_RATE_MS) == pdTRUE)
+/**
+ * the period in milliseconds at which poll() checks sockets, while it waits on device FIFOs too.
+ */
+#ifndef POLL_SOCKET_PERIOD
+#define POLL_SOCKET_PERIOD              10
+#endif
+
+/**
+ * the most bytes sendfile() reads from a file at once, rounded down to whole sectors.
+ * by default the TCP send buffer, so each read fills the send window.
+ */
+#ifndef SENDFILE_BUFFER_SIZE
+#if ENABLE_LIKEPOSIX_SOCKETS
+#define SENDFILE_BUFFER_SIZE            TCP_SND_BUF
+#else
+#define SENDFILE_BUFFER_SIZE            (2 * _MAX_SS)
+#endif
+#endif
+
+#if LIKEPOSIX_LOCK_STATS
+static file_table_lock_stats_t lock_stats;
+
+/**
+ * takes a lock, counting whether it had to wait for it and whether it timed out.
+ * the counters are shared by all locks of a kind, so are updated in a critical section.
+ */
+static inline BaseType_t __take_lock(SemaphoreHandle_t lock, TickType_t timeout, lock_stats_t* stats)
+{
+    bool contended = false;
+    BaseType_t taken = xSemaphoreTake(lock, 0);
+
+    if(taken != pdTRUE)
+    {
+        contended = true;
+        taken = xSemaphoreTake(lock, timeout);
+    }
+
+    taskENTER_CRITICAL();
+    if(contended)
+        stats->contended++;
+    if(taken == pdTRUE)
+        stats->taken++;
+    else
+        stats->timeouts++;
+    taskEXIT_CRITICAL();
+
+    return taken;
+}
+#else
+#define __take_lock(lock, timeout, stats)       xSemaphoreTake(lock, timeout)
+#endif
+
+/**
+ * looks up a regular file in the read only file system image, see romfs.h.
+ */
+#if USE_ROMFS
+#define __romfs_find(name)              romfs_find(name)
+#else
+#define __romfs_find(name)              ((const romfs_entry_t*)NULL)
+#endif
+
+/**
+ * the position and size of a regular file, on the FAT file system or in the read only file system image.
+ */
+#define __file_tell(fte)                ((fte)->rom ? (fte)->position : f_tell(&(fte)->file))
+#define __file_size(fte)                ((fte)->rom ? (fte)->rom->size : f_size(&(fte)->file))
+
+#define lock_filtab()                   (__take_lock(filtab.lock, DEFAULT_FILETABLE_TIMEOUT/portTICK_RATE_MS, &lock_stats.filtab) == pdTRUE)
 #define unlock_filtab()                 xSemaphoreGive(filtab.lock)
 
 
+#if FAMILY != HOST
+// newlib support, the host C library provides these
 #undef errno
 extern int errno;
 char *__env[1] = {0};
 char **__environ = __env;
+#endif
 static _filtab_t filtab;
 
+/**
+ * file table entries, see FILE_TABLE_POOL_LENGTH.
+ * kept in main RAM, FatFs may DMA straight to and from the file sector buffer.
+ */
+POOL_DEFINE(filtab_pool, sizeof(filtab_entry_t), FILE_TABLE_POOL_LENGTH);
+
 /**
  * to make STDIO work with serial IO,
  * please define "void phy_putc(char c)" somewhere
@@ -145,7 +239,7 @@ inline filtab_entry_t* __get_entry(int file)
 {
 	file -= FILE_TABLE_OFFSET;
 
-	if(!filtab.count || file < 0 || (file > FILE_TABLE_LENGTH))
+	if(file < 0 || file >= FILE_TABLE_LENGTH)
 		return NULL;
 
 	return filtab.tab[file];
@@ -159,40 +253,81 @@ inline filtab_entry_t* __get_entry(int file)
  */
 inline void __delete_filtab_item(filtab_entry_t* fte)
 {
-	if(fte->dupcount > 0)
-		fte->dupcount--;
-	else
+	if(((fte->mode == S_IFREG) && !fte->rom) || (fte->mode == S_IFIFO))
 	{
-		if((fte->mode == S_IFREG) || (fte->mode == S_IFIFO))
-		{
-			// #1 close the file
-			f_close(&fte->file);
-			// # 2 remove pipe
-			if(fte->device)
-			{
-				// remove read & write queues
-				if(fte->device->pipe.read)
-					vQueueDelete(fte->device->pipe.read);
-				if(fte->device->pipe.write)
-					vQueueDelete(fte->device->pipe.write);
-			}
-		}
-	#if ENABLE_LIKEPOSIX_SOCKETS
-		else if(fte->mode == S_IFSOCK)
+		// #1 close the file
+		f_close(&fte->file);
+		// # 2 remove pipe
+		if(fte->device)
 		{
-			if(fte->fdes != -1)
-				lwip_close(fte->fdes);
+			// remove read & write ring buffers
+			if(fte->device->pipe.read)
+				ringbuf_delete(fte->device->pipe.read);
+			if(fte->device->pipe.write)
+				ringbuf_delete(fte->device->pipe.write);
 		}
-	#endif
+	}
+#if ENABLE_LIKEPOSIX_SOCKETS
+	else if(fte->mode == S_IFSOCK)
+	{
+		if(fte->fdes != -1)
+			lwip_close(fte->fdes);
+	}
+#endif
 
-		if(fte->read_lock != NULL)
-			 vSemaphoreDelete(fte->read_lock);
-		if(fte->write_lock != NULL)
-			 vSemaphoreDelete(fte->write_lock);
+	if(fte->read_lock != NULL)
+		 vSemaphoreDelete(fte->read_lock);
+	if(fte->write_lock != NULL)
+		 vSemaphoreDelete(fte->write_lock);
+
+	// #3 delete file table node
+	pool_free(&filtab_pool, fte);
+}
+
+/**
+ * get the file table entry for the specified file descriptor, and take a reference to it.
+ * the entry is not deleted until the reference is released with __release_entry(),
+ * even if the file descriptor is closed meanwhile.
+ *
+ * @param	file is a file descriptor.
+ * @param	gen is set to the generation of the file table slot, may be NULL.
+ * @retval 	the file table entry, or NULL if the file descriptor is not open.
+ */
+static inline filtab_entry_t* __acquire_entry(int file, unsigned short* gen)
+{
+	filtab_entry_t* fte;
+
+	file -= FILE_TABLE_OFFSET;
+
+	if(file < 0 || file >= FILE_TABLE_LENGTH)
+		return NULL;
 
-		// #3 delete file table node
-		vPortFree(fte);
+	taskENTER_CRITICAL();
+	fte = filtab.tab[file];
+	if(fte)
+	{
+		fte->refs++;
+		if(gen)
+			*gen = filtab.gen[file];
 	}
+	taskEXIT_CRITICAL();
+
+	return fte;
+}
+
+/**
+ * releases a reference to a file table entry, deleting it if it was the last.
+ */
+static inline void __release_entry(filtab_entry_t* fte)
+{
+	unsigned short refs;
+
+	taskENTER_CRITICAL();
+	refs = --fte->refs;
+	taskEXIT_CRITICAL();
+
+	if(refs == 0)
+		__delete_filtab_item(fte);
 }
 
 /**
@@ -203,7 +338,7 @@ inline void __delete_filtab_item(filtab_entry_t* fte)
  * if mode contains S_IFREG, the file number returned operates on a regular file, as per the conditions
  * given in flags.
  *
- * if mode contains S_IFIFO, the file number returned operates on a pair of queues, rather than a file.
+ * if mode contains S_IFIFO, the file number returned operates on a pair of ring buffers, rather than a file.
  *  - if flags contains FREAD, then a read queue of length bytes becomes available to the read() function.
  *  - if flags contains FWRITE, then a write queue of length bytes becomes available to the write() function.
  *  - the opposing ends of the queues may be interfaced to a device in a device driver module...
@@ -215,7 +350,7 @@ inline void __delete_filtab_item(filtab_entry_t* fte)
  * 			When used by S_IFSOCK, specify O_CREAT to open a new socket, or anything else to specify accept.
  * @param 	mode is one of S_IFDIR | S_IFCHR | S_IFBLK | S_IFREG | S_IFLNK | S_IFSOCK | S_IFIFO.
  * 			only S_IFREG, S_IFSOCK and S_IFIFO are supported.
- * @param   length specifies the queue length to assign to S_IFIFO type devices only. may be set to 0 for S_IFSOCK and S_IFREG.
+ * @param   length specifies the ring buffer length to assign to S_IFIFO type devices only. may be set to 0 for S_IFSOCK and S_IFREG.
  * @param   when flags is set to O_CREAT, sockparam1 specifies the socket namespace to assign to S_IFSOCK type devices only. may be set to 0 for S_IFIFO and S_IFREG.
  * 			when flags is not set to O_CREAT, sockparam1 specifies the socket file descriptor to accept with, for S_IFSOCK type devices only. may be set to 0 for S_IFIFO and S_IFREG.
  * @param   sockparam2 specifies the socket style to assign to S_IFSOCK type devices only. may be set to 0 for S_IFIFO and S_IFREG.
@@ -225,13 +360,13 @@ inline void __delete_filtab_item(filtab_entry_t* fte)
  *
  * @retval 0 on success, -1 on failure.
  */
-inline int __create_filtab_item(filtab_entry_t** fdes, const char* name, int flags, int mode, int length, int sockparam1, int sockparam2, int sockparam3)
+inline int __create_filtab_item(filtab_entry_t** fdes, const char* name, int flags, int mode, int length, int sockparam1, intptr_t sockparam2, intptr_t sockparam3)
 {
 	int success = EOF;
 	BYTE ff_flags = 0;
 
 	// create new file table node
-	filtab_entry_t* fte = (filtab_entry_t*)pvPortMalloc(sizeof(filtab_entry_t));
+	filtab_entry_t* fte = (filtab_entry_t*)pool_alloc(&filtab_pool);
 
 	if(fte)
 	{
@@ -243,6 +378,9 @@ inline int __create_filtab_item(filtab_entry_t** fdes, const char* name, int fla
 		fte->read_lock = NULL;
 		fte->write_lock = NULL;
 		fte->dupcount = 0;
+		fte->refs = 0;
+		fte->rom = NULL;
+		fte->position = 0;
 
 		/**********************************
 		 * create file
@@ -250,6 +388,8 @@ inline int __create_filtab_item(filtab_entry_t** fdes, const char* name, int fla
 
 		if(fte->mode == S_IFREG)
 		{
+			fte->rom = __romfs_find(name);
+
 			if(fte->flags&FREAD)
 				ff_flags |= FA_READ;
 			if(fte->flags&FWRITE)
@@ -273,8 +413,14 @@ inline int __create_filtab_item(filtab_entry_t** fdes, const char* name, int fla
 		    ff_flags = FA_READ;
 		}
 
+		if(fte->rom)
+		{
+			// read from flash, the FAT file system is not used. the image may not be written
+			if(!(fte->flags & FWRITE))
+				success = 0;
+		}
 		// we only open the device file if ff_flags has a non zero value
-		if(ff_flags == 0 || (name && f_open(&fte->file, (const TCHAR*)name, (BYTE)ff_flags) == FR_OK))
+		else if(ff_flags == 0 || (name && f_open(&fte->file, (const TCHAR*)name, (BYTE)ff_flags) == FR_OK))
 		{
 			if(fte->mode == S_IFREG)
 			{
@@ -303,26 +449,26 @@ inline int __create_filtab_item(filtab_entry_t** fdes, const char* name, int fla
 				// populate "pipe", timeout values
 				if(fte->device)
 				{
-				    if(fte->flags & O_NONBLOCK)
-				        fte->device->timeout = 0;
-				    else
-				        fte->device->timeout = DEFAULT_DEVICE_TIMEOUT/portTICK_RATE_MS;
+					if(fte->flags & O_NONBLOCK)
+						fte->device->timeout = 0;
+					else
+						fte->device->timeout = DEFAULT_DEVICE_TIMEOUT/portTICK_RATE_MS;
 
-					// create write device queue
+					// create write device ring buffer
 					char write_q = 1;
 					fte->device->pipe.write = NULL;
 					if(fte->flags&FWRITE)
 					{
-						fte->device->pipe.write = xQueueCreate(fte->size, 1);
+						fte->device->pipe.write = ringbuf_create(fte->size);
 						write_q = fte->device->pipe.write ? 1 : 0;
 					}
 
-					// create read device queue
+					// create read device ring buffer
 					char read_q = 1;
 					fte->device->pipe.read = NULL;
 					if(fte->flags&FREAD)
 					{
-						fte->device->pipe.read = xQueueCreate(fte->size, 1);
+						fte->device->pipe.read = ringbuf_create(fte->size);
 						read_q = fte->device->pipe.read ? 1 : 0;
 					}
 
@@ -333,7 +479,7 @@ inline int __create_filtab_item(filtab_entry_t** fdes, const char* name, int fla
 #if ENABLE_LIKEPOSIX_SOCKETS
 			else if(fte->mode == S_IFSOCK)
 			{
-				if(fte->flags & FCREAT)
+				if(fte->flags & O_CREAT)
 				{
 					fte->flags = FWRITE | FREAD;
 					fte->size = 0;
@@ -376,65 +522,120 @@ inline int __create_filtab_item(filtab_entry_t** fdes, const char* name, int fla
 }
 
 /**
- * put a file table entry into file table.
- * NOTE: locks the file table. may not be called within a function that locks the file table.
+ * the bit of a slot in its word of the slot bitmap.
+ */
+#define slot_bit(slot)          (0x80000000UL >> ((slot) & 31))
+
+/**
+ * fills an empty file table slot. must be called in a critical section.
+ */
+static inline void __fill_slot(filtab_entry_t* fte, int slot, bool dup)
+{
+	filtab.tab[slot] = fte;
+	filtab.used[slot / 32] |= slot_bit(slot);
+	fte->refs++;
+	if(dup)
+		fte->dupcount++;
+	filtab.count++;
+	if(filtab.hwm < filtab.count)
+		filtab.hwm = filtab.count;
+}
+
+/**
+ * put a file table entry into file table, at the lowest free file descriptor.
+ * the lowest free slot is found by counting the leading zeros of the inverted slot bitmap.
  *
  * @param 	fte is a pointer to a file table entry, which NEEDS to have been pre initialized.
+ * @param	dup is true if fte is already in the file table.
  * @retval 	the file descriptor if successful, or -1 on error.
  */
-inline int __insert_entry(filtab_entry_t* fte)
+inline int __insert_entry(filtab_entry_t* fte, bool dup)
 {
 	int ret = EOF;
-	if(lock_filtab())
+	uint32_t free;
+	int slot;
+	int word;
+
+	taskENTER_CRITICAL();
+	for(word = 0; word < FILE_TABLE_WORDS; word++)
 	{
-		int file;
-		for(file = 0; file < FILE_TABLE_LENGTH; file++)
+		free = ~filtab.used[word];
+		if(free)
 		{
-			if(filtab.tab[file] == NULL)
+			slot = word * 32 + __builtin_clz(free);
+			if(slot < FILE_TABLE_LENGTH)
 			{
-				filtab.tab[file] = fte;
-				filtab.count++;
-				if(filtab.hwm < filtab.count)
-					filtab.hwm = filtab.count;
-				ret = file + FILE_TABLE_OFFSET;
-				break;
+				__fill_slot(fte, slot, dup);
+				ret = slot + FILE_TABLE_OFFSET;
 			}
+			break;
 		}
-		unlock_filtab();
 	}
+	taskEXIT_CRITICAL();
 
 	return ret;
 }
 
 /**
  * put a file table entry into file table at the specified file index.
- * NOTE: locks the file table. may not be called within a function that locks the file table.
  *
  * @param 	fte is a pointer to a file table entry, which NEEDS to have been pre initialized.
  * @param 	file is a file descriptor.
+ * @param	dup is true if fte is already in the file table.
  * @retval 	the file descriptor if successful, or -1 on error.
  */
-inline int __insert_entry_at(filtab_entry_t* fte, int file)
+inline int __insert_entry_at(filtab_entry_t* fte, int file, bool dup)
 {
 	int ret = EOF;
-	if(lock_filtab())
-	{
-		file -= FILE_TABLE_OFFSET;
+	int slot = file - FILE_TABLE_OFFSET;
 
-		if(filtab.tab[file] == NULL)
-		{
-			filtab.tab[file] = fte;
-			filtab.count++;
-			if(filtab.hwm < filtab.count)
-				filtab.hwm = filtab.count;
-			ret = file + FILE_TABLE_OFFSET;
-		}
-		unlock_filtab();
+	if(slot < 0 || slot >= FILE_TABLE_LENGTH)
+		return EOF;
+
+	taskENTER_CRITICAL();
+	if(filtab.tab[slot] == NULL)
+	{
+		__fill_slot(fte, slot, dup);
+		ret = file;
 	}
+	taskEXIT_CRITICAL();
 
 	return ret;
 }
 
+/**
+ * take a file table entry out of the file table, and start a new generation of its slot.
+ * the reference held by the slot passes to the caller.
+ *
+ * @param 	file is a file descriptor.
+ * @param	last is set to true if no other file descriptor refers to the entry.
+ * @retval 	the file table entry, or NULL if the file descriptor was not open.
+ */
+static inline filtab_entry_t* __remove_entry(int file, bool* last)
+{
+	filtab_entry_t* fte = NULL;
+	int slot = file - FILE_TABLE_OFFSET;
+
+	if(slot < 0 || slot >= FILE_TABLE_LENGTH)
+		return NULL;
+
+	taskENTER_CRITICAL();
+	fte = filtab.tab[slot];
+	if(fte)
+	{
+		filtab.tab[slot] = NULL;
+		filtab.used[slot / 32] &= ~slot_bit(slot);
+		filtab.gen[slot]++;
+		filtab.count--;
+		*last = fte->dupcount == 0;
+		if(!*last)
+			fte->dupcount--;
+	}
+	taskEXIT_CRITICAL();
+
+	return fte;
+}
+
 /**
  * determine the mode to open the file with - this is a customization of the mode passed into _open()...
  *
@@ -549,7 +750,7 @@ dev_ioctl_t* install_device(char* name,
     else
         log_error(NULL, "failed to open device %s", name);
 
-	return ret;
+    return ret;
 }
 
 /**
@@ -568,10 +769,48 @@ int file_table_hwm()
     return filtab.hwm;
 }
 
+/**
+ * copies out the lock counters, all zero unless LIKEPOSIX_LOCK_STATS is set to 1.
+ *
+ * @param   stats is populated with the file table lock counters, and the read and write lock
+ *          counters summed over all files.
+ */
+void file_table_lock_stats(file_table_lock_stats_t* stats)
+{
+#if LIKEPOSIX_LOCK_STATS
+    taskENTER_CRITICAL();
+    *stats = lock_stats;
+    taskEXIT_CRITICAL();
+#else
+    memset(stats, 0, sizeof(file_table_lock_stats_t));
+#endif
+}
+
+/**
+ * copies out the file table entry pool counters.
+ * failures counts the entries taken from the heap because the pool was empty.
+ */
+void file_table_pool_stats(pool_stats_t* stats)
+{
+    pool_get_stats(&filtab_pool, stats);
+}
+
+/**
+ * zeroes the lock counters.
+ */
+void file_table_reset_lock_stats()
+{
+#if LIKEPOSIX_LOCK_STATS
+    taskENTER_CRITICAL();
+    memset(&lock_stats, 0, sizeof(file_table_lock_stats_t));
+    taskEXIT_CRITICAL();
+#endif
+}
+
 /**
  * system call, 'open'
  *
- * opens a file for disk IO, or a FreeRTOS Queue, for
+ * opens a file for disk IO, or a ring buffer pair, for
  * device IO or data transfer/sharing.
  *
  * **this is a non standard implementation**
@@ -581,7 +820,7 @@ int file_table_hwm()
  * 			if mode is S_IFREG, may be a combination of:
  *  		one of O_RDONLY, O_WRONLY, or O_RDWR,
  * 			and any of O_APPEND | O_CREAT | O_TRUNC
- * @param	mode - repurposed - in the case of device files, specified the queue length.
+ * @param	mode - repurposed - in the case of device files, specified the ring buffer length.
  * 			otherwise ignored.
  * @retval	returns a file descriptor, that may be used with
  * 			read(), write(), close(), or -1 if there was an error.
@@ -610,7 +849,7 @@ int _open(const char *name, int flags, int mode)
 		}
 
 		// add file to table
-		file = __insert_entry(fte);
+		file = __insert_entry(fte, false);
 
 		// add failed, close and delete
 		if(file == EOF)
@@ -637,6 +876,8 @@ int _open(const char *name, int flags, int mode)
 int _close(int file)
 {
 	int res = EOF;
+	filtab_entry_t* fte = NULL;
+	bool last = false;
 
 	if(file == STDOUT_FILENO || file == STDERR_FILENO)
 	{
@@ -644,33 +885,61 @@ int _close(int file)
 	}
 	else if(lock_filtab())
 	{
-		filtab_entry_t* fte = __get_entry(file);
+		// poll() scans the file table under the lock, it must not see the entry go mid scan
+		fte = __remove_entry(file, &last);
+		unlock_filtab();
+	}
 
-		if(fte)
+	if(fte)
+	{
+		if(last)
 		{
+			// wait for reads and writes in progress, those waiting to start will see the file closed
 			if(fte->flags & FWRITE)
-				xSemaphoreTake(fte->write_lock, DEFAULT_FILE_LOCK_TIMEOUT/portTICK_RATE_MS);
+				__take_lock(fte->write_lock, DEFAULT_FILE_LOCK_TIMEOUT/portTICK_RATE_MS, &lock_stats.write);
 
 			if(fte->flags & FREAD)
-				xSemaphoreTake(fte->read_lock, DEFAULT_FILE_LOCK_TIMEOUT/portTICK_RATE_MS);
+				__take_lock(fte->read_lock, DEFAULT_FILE_LOCK_TIMEOUT/portTICK_RATE_MS, &lock_stats.read);
 
-			// disable device IO first
+			// disable device IO
 			if((fte->mode == S_IFIFO) && fte->device && fte->device->close)
 			{
 				// call device close
 				fte->device->close(fte->device);
 			}
-			// then remove the file table entry
-			filtab.tab[file-FILE_TABLE_OFFSET] = NULL;
-			filtab.count--;
 
 			xSemaphoreGive(fte->write_lock);
 			xSemaphoreGive(fte->read_lock);
-
-			// then delete all the file structures
-			__delete_filtab_item(fte);
-			res = 0;
 		}
+
+		// then delete all the file structures, once no call is using them
+		__release_entry(fte);
+		res = 0;
+	}
+
+	return res;
+}
+
+/**
+ * enters a file table entry at another file descriptor, if file is still open.
+ * _close() takes entries out under the file table lock, so under it too, file is either
+ * still open and the new descriptor counts against closing it, or already closed (maybe
+ * reopened, when the generation of its slot has moved on) and the entry is refused.
+ *
+ * @param	fte is the entry of file, with a reference taken by __acquire_entry().
+ * @param	gen is the generation of the slot of file, from __acquire_entry().
+ * @param	new is the file descriptor to enter it at, or -1 for the lowest free one.
+ * @retval	the new file descriptor, or -1 on error.
+ */
+static int __dup_entry(filtab_entry_t* fte, int file, unsigned short gen, int new)
+{
+	int res = EOF;
+
+	if(lock_filtab())
+	{
+		// the reference taken by the caller is one, the slots holding the entry are the rest
+		if(filtab.gen[file - FILE_TABLE_OFFSET] == gen && fte->refs > 1)
+			res = new == EOF ? __insert_entry(fte, true) : __insert_entry_at(fte, new, true);
 		unlock_filtab();
 	}
 
@@ -679,30 +948,32 @@ int _close(int file)
 
 /**
  * TODO: doesnt work for STDIN_FILENO, STDOUTFILENO, STDERR_FILENO
- * TODO: not thread safe
  */
 int _dup(int file)
 {
 	int res = EOF;
-	filtab_entry_t* fte = __get_entry(file);
+	unsigned short gen;
+	filtab_entry_t* fte = __acquire_entry(file, &gen);
 	if(fte)
 	{
-		res = __insert_entry(fte);
-		if(res != EOF)
-			fte->dupcount++;
+		res = __dup_entry(fte, file, gen, EOF);
+		__release_entry(fte);
 	}
 	return res;
 }
 
 /**
  * TODO: doesnt work for STDIN_FILENO, STDOUTFILENO, STDERR_FILENO
- * TODO: not thread safe
  */
 int _dup2(int old, int new)
 {
 	int res = EOF;
+	unsigned short gen;
+
+	if(new < 0)
+		return EOF;
 
-	filtab_entry_t* fteold = __get_entry(old);
+	filtab_entry_t* fteold = __acquire_entry(old, &gen);
 
 	if(fteold)
 	{
@@ -713,44 +984,62 @@ int _dup2(int old, int new)
 			if(__get_entry(new))
 				_close(new);
 
-			res = __insert_entry_at(fteold, new);
-			if(res != EOF)
-				fteold->dupcount++;
+			res = __dup_entry(fteold, old, gen, new);
 		}
+		__release_entry(fteold);
 	}
 
 	return res;
 }
 
+/**
+ * takes the read and or write locks of a file, as its flags allow.
+ * does not wait on the file table lock, so calls on different files never wait for each other.
+ *
+ * @retval	the file table entry, or NULL if the file is not open, the locks timed out,
+ * 			or the file was closed while waiting for them.
+ * 			release the entry with __unlock().
+ */
 static inline filtab_entry_t* __lock(int file, bool read, bool write)
 {
-	int lock_successful = pdTRUE;
-	if(lock_filtab())
-	{
-		filtab_entry_t* fte = __get_entry(file);
-		if(fte)
-		{
-			if(write && (fte->flags & FWRITE))
-				lock_successful = xSemaphoreTake(fte->write_lock, DEFAULT_FILE_LOCK_TIMEOUT/portTICK_RATE_MS);
+	unsigned short gen;
+	bool locked = true;
+	bool locked_write = false;
+	bool locked_read = false;
+	filtab_entry_t* fte = __acquire_entry(file, &gen);
+
+	if(!fte)
+		return NULL;
+
+	if(write && (fte->flags & FWRITE))
+		locked = locked_write = __take_lock(fte->write_lock, DEFAULT_FILE_LOCK_TIMEOUT/portTICK_RATE_MS, &lock_stats.write) == pdTRUE;
+
+	if(locked && read && (fte->flags & FREAD))
+		locked = locked_read = __take_lock(fte->read_lock, DEFAULT_FILE_LOCK_TIMEOUT/portTICK_RATE_MS, &lock_stats.read) == pdTRUE;
+
+	// the file may have been closed, and maybe reopened, while waiting for the locks
+	if(locked && filtab.gen[file - FILE_TABLE_OFFSET] == gen)
+		return fte;
+
+	if(locked_write)
+		xSemaphoreGive(fte->write_lock);
+	if(locked_read)
+		xSemaphoreGive(fte->read_lock);
+	__release_entry(fte);
 
-			if(read && (fte->flags & FREAD) && (lock_successful == pdTRUE))
-				lock_successful = xSemaphoreTake(fte->read_lock, DEFAULT_FILE_LOCK_TIMEOUT/portTICK_RATE_MS);
-		}
-		unlock_filtab();
-		if(lock_successful == pdTRUE)
-			return fte;
-		else
-			return NULL;
-	}
 	return NULL;
 }
 
+/**
+ * gives the locks taken by __lock(), and releases the file table entry.
+ */
 static inline void __unlock(filtab_entry_t* fte, bool read, bool write)
 {
 	if(write && (fte->flags & FWRITE))
 		xSemaphoreGive(fte->write_lock);
 	if(read && (fte->flags & FREAD))
 		xSemaphoreGive(fte->read_lock);
+	__release_entry(fte);
 }
 
 /**
@@ -789,38 +1078,29 @@ int _write(int file, char *buffer, unsigned int count)
 				}
 				else if((fte->mode == S_IFIFO) && fte->device)
 				{
-				    unsigned int timeout = 0;
-					bool tx_idle = uxQueueMessagesWaiting(fte->device->pipe.write) == 0;
+					ringbuf_t* rb = fte->device->pipe.write;
+					unsigned int space;
 
-					// write the remaining data
-					n = 0;
+					// copy in as much as fits, then enable the physical device to write
+					// and wait for it to drain at least half the ring buffer, or the remainder.
+					n = ringbuf_put(rb, buffer, count);
 					while(n < (int)count)
-					{
-						if(xQueueSend(fte->device->pipe.write, buffer, timeout) != pdTRUE)
-						{
-							if(timeout)
-								break;
-							else
-							{
-								timeout = fte->device->timeout;
-								// enable the physical device to write
-								if(fte->device->write_enable)
-									fte->device->write_enable(fte->device);
-								tx_idle = false;
-							}
-						}
-						else
-						{
-							n++;
-							buffer++;
-						}
-					}
-
-					if(tx_idle)
 					{
 						if(fte->device->write_enable)
 							fte->device->write_enable(fte->device);
+
+						space = (rb->size - 1) / 2;
+						if(space > count - n)
+							space = count - n;
+
+						if(!ringbuf_wait_space(rb, space, fte->device->timeout))
+							break;
+
+						n += ringbuf_put(rb, buffer + n, count - n);
 					}
+
+					if(n > 0 && fte->device->write_enable)
+						fte->device->write_enable(fte->device);
 				}
 #if ENABLE_LIKEPOSIX_SOCKETS
 				else if(fte->mode == S_IFSOCK)
@@ -868,19 +1148,26 @@ int _read(int file, char *buffer, int count)
 			{
 				if(fte->mode == S_IFREG)
 				{
-					if(f_read(&fte->file, (void*)buffer, (UINT)count, (UINT*)&n) != FR_OK)
+					if(fte->rom)
+					{
+						// straight out of flash
+						n = fte->position < fte->rom->size ? fte->rom->size - fte->position : 0;
+						if(n > count)
+							n = count;
+						memcpy(buffer, fte->rom->data + fte->position, n);
+						fte->position += n;
+					}
+					else if(f_read(&fte->file, (void*)buffer, (UINT)count, (UINT*)&n) != FR_OK)
 						n = EOF;
 				}
 				else if((fte->mode == S_IFIFO) && fte->device)
 				{
 					timeout = fte->device->timeout;
 
-					for(n = 0; n < count; n++)
-					{
-						if(xQueueReceive(fte->device->pipe.read, buffer++, timeout) != pdTRUE)
-							break;
-						timeout = 0;
-					}
+					// wait for the first byte, then take whatever has arrived
+					n = 0;
+					if(ringbuf_wait_used(fte->device->pipe.read, 1, timeout))
+						n = ringbuf_get(fte->device->pipe.read, buffer, count);
 				}
 	#if ENABLE_LIKEPOSIX_SOCKETS
 				else if(fte->mode == S_IFSOCK)
@@ -913,7 +1200,8 @@ int _fsync(int file)
 		{
 			if(fte->mode == S_IFREG)
 			{
-				f_sync(&fte->file);
+				if(!fte->rom)
+					f_sync(&fte->file);
 				res = 0;
 			}
 			__unlock(fte, false, true);
@@ -955,7 +1243,7 @@ int _fstat(int file, struct stat *st)
 			{
 				if(fte->mode == S_IFREG)
 				{
-					st->st_size = f_size(&fte->file);
+					st->st_size = __file_size(fte);
 					st->st_blksize = _MAX_SS;
 				}
 				if(fte->mode == S_IFIFO)
@@ -983,7 +1271,7 @@ long int _ftell(int file)
 	if(fte)
 	{
 		if(fte->mode == S_IFREG)
-			res = f_tell(&fte->file);
+			res = __file_tell(fte);
 		__unlock(fte, false, true);
 	}
 
@@ -1053,14 +1341,22 @@ int _lseek(int file, int offset, int whence)
 		if(fte->mode == S_IFREG)
 		{
 			if(whence == SEEK_CUR)
-				offset = f_tell(&fte->file) + offset;
+				offset = __file_tell(fte) + offset;
 			else if(whence == SEEK_END)
-				offset = f_size(&fte->file) - offset;
+				offset = __file_size(fte) - offset;
 
 			if(offset < 0)
 			    offset = 0;
 
-			if(f_lseek(&fte->file, offset) == FR_OK)
+			if(fte->rom)
+			{
+				// as FatFs does for files opened read only, stop at the end of the file
+				if((uint32_t)offset > fte->rom->size)
+					offset = fte->rom->size;
+				fte->position = offset;
+				res = 0;
+			}
+			else if(f_lseek(&fte->file, offset) == FR_OK)
 				res = 0;
 		}
 		__unlock(fte, true, true);
@@ -1069,6 +1365,163 @@ int _lseek(int file, int offset, int whence)
 	return res;
 }
 
+/**
+ * writes a whole buffer to a file table entry opened for writing, or to stdout.
+ *
+ * @param	out is the file table entry of out_fd when it is a socket, or NULL.
+ * @param	more is true if more data follows straight away.
+ * @retval	the number of bytes written, less than length on error.
+ */
+static int __sendfile_write(filtab_entry_t* out, int out_fd, const char* buffer, int length, bool more)
+{
+	int written = 0;
+	int n;
+
+	while(written < length)
+	{
+#if ENABLE_LIKEPOSIX_SOCKETS
+		if(out)
+			n = lwip_send(out->fdes, buffer + written, length - written, more ? MSG_MORE : 0);
+		else
+#endif
+			n = _write(out_fd, (char*)buffer + written, length - written);
+		if(n < 1)
+			break;
+		written += n;
+	}
+	(void)out;
+	(void)more;
+
+	return written;
+}
+
+/**
+ * copies data from a regular file to another file, usually a socket, without the caller
+ * reading it through a buffer of its own.
+ *
+ * the file is read in runs of whole sectors, which FatFs reads straight into the transfer
+ * buffer, rather than through the file sector buffer. for sockets, each run is handed to
+ * LwIP in one send, which fills the TCP send window when SENDFILE_BUFFER_SIZE is TCP_SND_BUF.
+ * files in the read only file system image are written straight from flash, with no transfer buffer.
+ *
+ * @param	out_fd is the file descriptor to write to. sockets are written directly,
+ * 			other files via write().
+ * @param	in_fd is the file descriptor of a regular file, opened for reading.
+ * @param	offset is the position in in_fd to start reading from, and is set to the position
+ * 			after the last byte sent. the file position of in_fd is not changed.
+ * 			if NULL, reading starts at the file position of in_fd, which is moved past the bytes sent.
+ * @param	count is the number of bytes to send, fewer are sent if the end of the file is reached first.
+ * @retval	the number of bytes sent, or -1 on error.
+ */
+int _sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+	filtab_entry_t* in = __lock(in_fd, true, false);
+	filtab_entry_t* out = NULL;
+	char* buffer = NULL;
+	DWORD start;
+	DWORD position;
+	size_t remaining;
+	unsigned int size;
+	unsigned int chunk;
+	UINT n;
+	int sent = EOF;
+
+	if(!in)
+		return EOF;
+
+	if(in->mode != S_IFREG || !(in->flags & FREAD))
+	{
+		__unlock(in, true, false);
+		return EOF;
+	}
+
+#if ENABLE_LIKEPOSIX_SOCKETS
+	out = __lock(out_fd, false, true);
+	if(out && out->mode != S_IFSOCK)
+	{
+		__unlock(out, false, true);
+		out = NULL;
+	}
+#endif
+
+	if(in->rom)
+	{
+		position = offset ? (DWORD)*offset : in->position;
+		remaining = position < in->rom->size ? in->rom->size - position : 0;
+		if(remaining > count)
+			remaining = count;
+
+		sent = __sendfile_write(out, out_fd, (const char*)in->rom->data + position, remaining, false);
+
+		if(offset)
+			*offset += sent;
+		else
+			in->position = position + sent;
+
+		if(out)
+			__unlock(out, false, true);
+		__unlock(in, true, false);
+
+		return sent;
+	}
+
+	start = f_tell(&in->file);
+	position = offset ? (DWORD)*offset : start;
+
+	remaining = position < f_size(&in->file) ? f_size(&in->file) - position : 0;
+	if(remaining > count)
+		remaining = count;
+
+	// no bigger than needed to get from position to the end of the last sector to send
+	size = (SENDFILE_BUFFER_SIZE / _MAX_SS) * _MAX_SS;
+	if(size < _MAX_SS)
+		size = _MAX_SS;
+	if(size > (position % _MAX_SS) + remaining)
+		size = (((position % _MAX_SS) + remaining + _MAX_SS - 1) / _MAX_SS) * _MAX_SS;
+
+	if(remaining == 0)
+		sent = 0;
+	else if(f_lseek(&in->file, position) == FR_OK && (buffer = malloc(size)))
+	{
+		sent = 0;
+		while(remaining > 0)
+		{
+			// the first read ends on a sector boundary, the rest are whole sectors
+			chunk = size - (position % _MAX_SS);
+			if(chunk > remaining)
+				chunk = remaining;
+
+			if(f_read(&in->file, buffer, chunk, &n) != FR_OK || n == 0)
+				break;
+
+			position += n;
+			remaining -= n;
+
+			chunk = __sendfile_write(out, out_fd, buffer, n, remaining > 0);
+			sent += chunk;
+			if(chunk != n)
+				break;
+		}
+		free(buffer);
+	}
+
+	// leave the file position where it was if an offset was given, or just past the bytes sent
+	if(offset)
+	{
+		if(sent > 0)
+			*offset += sent;
+		f_lseek(&in->file, start);
+	}
+	else
+		f_lseek(&in->file, start + (sent > 0 ? sent : 0));
+
+	if(out)
+		__unlock(out, false, true);
+	__unlock(in, true, false);
+
+	return sent;
+}
+
 int _chdir(const char *path)
 {
     return f_chdir((TCHAR*)path) == FR_OK ? 0 : -1;
@@ -1103,12 +1556,18 @@ char* _getcwd(char* buffer, size_t size)
 
 int _unlink(char *name)
 {
+	if(__romfs_find(name))
+		return EOF;
+
 	FRESULT res = f_unlink((const TCHAR*)name);
 	return res == FR_OK ? 0 : EOF;
 }
 
 int _rename(const char *oldname, const char *newname)
 {
+	if(__romfs_find(oldname) || __romfs_find(newname))
+		return EOF;
+
 	FRESULT res = f_rename((const TCHAR*)oldname, (const TCHAR*)newname);
 	return res == FR_OK ? 0 : EOF;
 }
@@ -1116,6 +1575,9 @@ int _rename(const char *oldname, const char *newname)
 void _exit(int i)
 {
 	printf("Program exit with code %d", i);
+#if FAMILY == HOST
+	host_exit(i);
+#endif
 	while (1);
 }
 
@@ -1167,6 +1629,7 @@ int times(struct tm *buf)
 	return -1;
 }
 
+#if FAMILY != HOST
 //#ifdef __cplusplus
 //#ifndef _init()
 void _init()
@@ -1181,6 +1644,7 @@ void _fini()
 }
 //#endif
 //#endif
+#endif
 
 int _wait(int *status)
 {
@@ -1196,20 +1660,20 @@ int __tcflush(filtab_entry_t* fte, int flags)
 	{
 		if(flags == TCIFLUSH)
 		{
-			xQueueReset(fte->device->pipe.read);
+			ringbuf_reset(fte->device->pipe.read);
 			res = 0;
 		}
 
 		else if(flags == TCOFLUSH)
 		{
-			xQueueReset(fte->device->pipe.write);
+			ringbuf_reset(fte->device->pipe.write);
 			res = 0;
 		}
 
 		else if(flags == TCIOFLUSH)
 		{
-			xQueueReset(fte->device->pipe.write);
-			xQueueReset(fte->device->pipe.read);
+			ringbuf_reset(fte->device->pipe.write);
+			ringbuf_reset(fte->device->pipe.read);
 			res = 0;
 		}
 	}
@@ -1218,16 +1682,12 @@ int __tcflush(filtab_entry_t* fte, int flags)
 
 int __tcdrain(filtab_entry_t* fte)
 {
-    unsigned long timeout;
     int res = EOF;
 
 	if(fte->mode == S_IFIFO)
 	{
-		timeout = get_hw_time_ms() + fte->device->timeout;
-		while(uxQueueMessagesWaiting(fte->device->pipe.write) > 0 && get_hw_time_ms() < timeout)
-			portYIELD();
-
-		if(get_hw_time_ms() < timeout)
+		ringbuf_t* rb = fte->device->pipe.write;
+		if(ringbuf_wait_space(rb, rb->size - 1, fte->device->timeout))
 			res = 0;
 	}
 
@@ -1392,6 +1852,385 @@ int _tcflow(int file, int flags)
     return res;
 }
 
+/**
+ * a semaphore a task blocks on in poll(), given by the ring buffers it waits for.
+ * waiters are never freed, they return to a free list, so that a late give from a
+ * preempted ringbuf_put() or ringbuf_get() can never land on a deleted semaphore.
+ */
+typedef struct _poll_waiter_t {
+	SemaphoreHandle_t notify;
+	struct _poll_waiter_t* next;
+} poll_waiter_t;
+
+static poll_waiter_t* poll_waiters;
+
+/**
+ * takes a waiter from the free list, or makes a new one.
+ * must be called with the file table locked.
+ */
+static poll_waiter_t* __get_poll_waiter()
+{
+	poll_waiter_t* waiter = poll_waiters;
+
+	if(waiter)
+		poll_waiters = waiter->next;
+	else
+	{
+		waiter = pvPortMalloc(sizeof(poll_waiter_t));
+		if(waiter)
+		{
+			waiter->notify = xSemaphoreCreateBinary();
+			if(!waiter->notify)
+			{
+				vPortFree(waiter);
+				waiter = NULL;
+			}
+		}
+	}
+
+	return waiter;
+}
+
+/**
+ * deregisters a waiter from all the ring buffers it was registered with,
+ * and returns it to the free list.
+ * must be called with the file table locked.
+ */
+static void __put_poll_waiter(poll_waiter_t* waiter, struct pollfd *fds, nfds_t nfds)
+{
+	filtab_entry_t* fte;
+	nfds_t i;
+
+	for(i = 0; i < nfds; i++)
+	{
+		fte = __get_entry(fds[i].fd);
+		if(fte && (fte->mode == S_IFIFO) && fte->device)
+		{
+			if(fte->device->pipe.read && fte->device->pipe.read->notify == waiter->notify)
+				fte->device->pipe.read->notify = NULL;
+			if(fte->device->pipe.write && fte->device->pipe.write->notify == waiter->notify)
+				fte->device->pipe.write->notify = NULL;
+		}
+	}
+
+	waiter->next = poll_waiters;
+	poll_waiters = waiter;
+}
+
+/**
+ * sets revents for every entry in fds that is not a socket.
+ * device FIFOs are registered with notify first, when it is not NULL, so that
+ * data moving after the check still wakes the poller.
+ * must be called with the file table locked.
+ *
+ * @param	lwipfd is set to the lwip file descriptor of each socket, or -1.
+ * @param	fifos is set to the number of device FIFOs that may become ready.
+ * @param	sockets is set to the number of sockets found.
+ * @retval	the number of entries in fds that are ready.
+ */
+static int __poll_scan(struct pollfd *fds, nfds_t nfds, SemaphoreHandle_t notify, int* lwipfd, int* fifos, int* sockets)
+{
+	filtab_entry_t* fte;
+	ringbuf_t* rb;
+	int ready = 0;
+	nfds_t i;
+
+	*fifos = 0;
+	*sockets = 0;
+
+	for(i = 0; i < nfds; i++)
+	{
+		fds[i].revents = 0;
+		lwipfd[i] = -1;
+
+		if(fds[i].fd < 0)
+			continue;
+
+		// stdio and regular files never block, or block in phy_getc() where we cant see
+		if(fds[i].fd == STDIN_FILENO)
+			fds[i].revents = fds[i].events & POLLIN;
+		else if(fds[i].fd == STDOUT_FILENO || fds[i].fd == STDERR_FILENO)
+			fds[i].revents = fds[i].events & POLLOUT;
+		else
+		{
+			fte = __get_entry(fds[i].fd);
+
+			if(!fte)
+				fds[i].revents = POLLNVAL;
+			else if(fte->mode == S_IFREG)
+				fds[i].revents = fds[i].events & (POLLIN|POLLOUT);
+			else if((fte->mode == S_IFIFO) && fte->device)
+			{
+				rb = fte->device->pipe.read;
+				if(rb && (fds[i].events & POLLIN))
+				{
+					if(notify)
+						rb->notify = notify;
+					if(ringbuf_used(rb) > 0)
+						fds[i].revents |= POLLIN;
+					(*fifos)++;
+				}
+				rb = fte->device->pipe.write;
+				if(rb && (fds[i].events & POLLOUT))
+				{
+					if(notify)
+						rb->notify = notify;
+					if(ringbuf_space(rb) > 0)
+						fds[i].revents |= POLLOUT;
+					(*fifos)++;
+				}
+			}
+#if ENABLE_LIKEPOSIX_SOCKETS
+			else if(fte->mode == S_IFSOCK)
+			{
+				lwipfd[i] = fte->fdes;
+				(*sockets)++;
+			}
+#endif
+		}
+
+		if(fds[i].revents)
+			ready++;
+	}
+
+	return ready;
+}
+
+#if ENABLE_LIKEPOSIX_SOCKETS
+/**
+ * sets revents for every socket in fds, via lwip_select().
+ *
+ * @param	lwipfd holds the lwip file descriptor of each socket, or -1.
+ * @param	timeout is the time to wait in ticks, may be portMAX_DELAY.
+ * @retval	the number of sockets that are ready, or -1 on error.
+ */
+static int __poll_sockets(struct pollfd *fds, nfds_t nfds, const int* lwipfd, TickType_t timeout)
+{
+	fd_set readfds;
+	fd_set writefds;
+	fd_set exceptfds;
+	struct timeval tv;
+	int maxfd = -1;
+	int ready = 0;
+	nfds_t i;
+
+	FD_ZERO(&readfds);
+	FD_ZERO(&writefds);
+	FD_ZERO(&exceptfds);
+
+	for(i = 0; i < nfds; i++)
+	{
+		if(lwipfd[i] < 0)
+			continue;
+		if(fds[i].events & POLLIN)
+			FD_SET(lwipfd[i], &readfds);
+		if(fds[i].events & POLLOUT)
+			FD_SET(lwipfd[i], &writefds);
+		FD_SET(lwipfd[i], &exceptfds);
+		if(lwipfd[i] > maxfd)
+			maxfd = lwipfd[i];
+	}
+
+	tv.tv_sec = (timeout * portTICK_RATE_MS) / 1000;
+	tv.tv_usec = ((timeout * portTICK_RATE_MS) % 1000) * 1000;
+
+	if(lwip_select(maxfd + 1, &readfds, &writefds, &exceptfds, timeout == portMAX_DELAY ? NULL : &tv) < 0)
+		return EOF;
+
+	for(i = 0; i < nfds; i++)
+	{
+		if(lwipfd[i] < 0)
+			continue;
+		if(FD_ISSET(lwipfd[i], &readfds))
+			fds[i].revents |= POLLIN;
+		if(FD_ISSET(lwipfd[i], &writefds))
+			fds[i].revents |= POLLOUT;
+		if(FD_ISSET(lwipfd[i], &exceptfds))
+			fds[i].revents |= POLLERR;
+		if(fds[i].revents)
+			ready++;
+	}
+
+	return ready;
+}
+#endif
+
+/**
+ * waits for one or more file descriptors to become ready for IO.
+ *
+ * - regular files and stdio are always ready.
+ * - device FIFOs are ready to read when their read ring buffer holds data,
+ *   and ready to write when their write ring buffer has space.
+ * - sockets are handed to lwip_select(). when sockets and device FIFOs are polled
+ *   together, the sockets are checked every POLL_SOCKET_PERIOD milliseconds.
+ *
+ * only one task at a time should poll a given device FIFO, the last to start
+ * polling is the one that is woken.
+ *
+ * @param	fds is an array of nfds file descriptors and the events to wait for.
+ * @param	timeout is the time to wait in milliseconds, 0 to return immediately,
+ * 			or -1 to wait forever.
+ * @retval	the number of entries in fds with non zero revents, 0 on timeout, or -1 on error.
+ */
+int _poll(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+	TickType_t remaining = timeout < 0 ? portMAX_DELAY : (TickType_t)timeout/portTICK_RATE_MS;
+	TickType_t wait;
+	TimeOut_t xTimeOut;
+	poll_waiter_t* waiter = NULL;
+	int lwipfd[nfds > 0 ? nfds : 1];
+	int fifos;
+	int sockets;
+	int ready;
+
+	vTaskSetTimeOutState(&xTimeOut);
+
+	for(;;)
+	{
+		if(!lock_filtab())
+		{
+			ready = EOF;
+			break;
+		}
+		if(waiter)
+			xSemaphoreTake(waiter->notify, 0);
+		ready = __poll_scan(fds, nfds, waiter ? waiter->notify : NULL, lwipfd, &fifos, &sockets);
+		unlock_filtab();
+
+#if ENABLE_LIKEPOSIX_SOCKETS
+		if(sockets)
+		{
+			// with nothing else to wait for, lwip may block for the whole timeout
+			int n = __poll_sockets(fds, nfds, lwipfd, ready || fifos ? 0 : remaining);
+			if(n < 0)
+				ready = EOF;
+			else
+				ready += n;
+			if(ready || !fifos)
+				break;
+		}
+#endif
+		if(ready || remaining == 0)
+			break;
+
+		if(!waiter)
+		{
+			// register with the device FIFOs, then check them again
+			if(!lock_filtab())
+				return EOF;
+			waiter = __get_poll_waiter();
+			unlock_filtab();
+			if(!waiter)
+			{
+				errno = ENOMEM;
+				return EOF;
+			}
+			continue;
+		}
+
+		wait = remaining;
+		if(sockets && wait > POLL_SOCKET_PERIOD/portTICK_RATE_MS)
+			wait = POLL_SOCKET_PERIOD/portTICK_RATE_MS;
+		xSemaphoreTake(waiter->notify, wait);
+
+		if(xTaskCheckForTimeOut(&xTimeOut, &remaining) == pdTRUE)
+			remaining = 0;
+	}
+
+	if(waiter)
+	{
+		// must not be left registered, the waiter goes back to the free list regardless
+		while(!lock_filtab());
+		__put_poll_waiter(waiter, fds, nfds);
+		unlock_filtab();
+	}
+
+	return ready;
+}
+
+/**
+ * waits for one or more file descriptors to become ready for IO.
+ * implemented over _poll(), see there for how each kind of file is treated.
+ *
+ * @param	nfds is one more than the highest file descriptor in any of the sets.
+ * @param	readfds, writefds, exceptfds are the sets of file descriptors to check, any may be NULL.
+ * 			on return, they hold the file descriptors that are ready.
+ * @param	timeout is the time to wait, or NULL to wait forever.
+ * @retval	the number of bits set in all the sets, 0 on timeout, or -1 on error.
+ */
+int _select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout)
+{
+	int entries = 0;
+	int count = 0;
+	int fd;
+	int i;
+
+	for(fd = 0; fd < nfds; fd++)
+	{
+		if((readfds && FD_ISSET(fd, readfds)) ||
+			(writefds && FD_ISSET(fd, writefds)) ||
+			(exceptfds && FD_ISSET(fd, exceptfds)))
+			entries++;
+	}
+
+	struct pollfd fds[entries > 0 ? entries : 1];
+
+	for(fd = 0, i = 0; fd < nfds && i < entries; fd++)
+	{
+		fds[i].fd = fd;
+		fds[i].events = 0;
+		if(readfds && FD_ISSET(fd, readfds))
+			fds[i].events |= POLLIN;
+		if(writefds && FD_ISSET(fd, writefds))
+			fds[i].events |= POLLOUT;
+		if(exceptfds && FD_ISSET(fd, exceptfds))
+			fds[i].events |= POLLPRI;
+		if(fds[i].events)
+			i++;
+	}
+
+	if(_poll(fds, entries, timeout ? (int)(timeout->tv_sec * 1000 + timeout->tv_usec / 1000) : -1) < 0)
+		return EOF;
+
+	for(i = 0; i < entries; i++)
+	{
+		if(fds[i].revents & POLLNVAL)
+		{
+			errno = EBADF;
+			return EOF;
+		}
+	}
+
+	if(readfds)
+		FD_ZERO(readfds);
+	if(writefds)
+		FD_ZERO(writefds);
+	if(exceptfds)
+		FD_ZERO(exceptfds);
+
+	// errors and hang ups make a read return straight away, so count as readable
+	for(i = 0; i < entries; i++)
+	{
+		if((fds[i].events & POLLIN) && (fds[i].revents & (POLLIN|POLLERR|POLLHUP)))
+		{
+			FD_SET(fds[i].fd, readfds);
+			count++;
+		}
+		if((fds[i].events & POLLOUT) && (fds[i].revents & (POLLOUT|POLLERR)))
+		{
+			FD_SET(fds[i].fd, writefds);
+			count++;
+		}
+		if((fds[i].events & POLLPRI) && (fds[i].revents & (POLLPRI|POLLERR)))
+		{
+			FD_SET(fds[i].fd, exceptfds);
+			count++;
+		}
+	}
+
+	return count;
+}
+
 #if ENABLE_LIKEPOSIX_SOCKETS
 
 /**
@@ -1404,7 +2243,7 @@ int _tcflow(int file, int flags)
     	if(fte->mode == S_IFSOCK) {                                 \
     		res = lwip_function(fte->fdes, __VA_ARGS__);     		\
     	}															\
-		__unlock(fte, true, true);									\
+		__unlock(fte, read, write);									\
     }																\
 	return res;
 
@@ -1427,7 +2266,7 @@ int socket(int namespace, int style, int protocol)
 	if(__create_filtab_item(&fte, NULL, O_CREAT, __determine_mode(NULL), 0, namespace, style, protocol) == 0)
 	{
 		// add file to table
-		file = __insert_entry(fte);
+		file = __insert_entry(fte, false);
 
 		// add failed, close and delete
 		if(file == EOF)
@@ -1452,20 +2291,22 @@ int accept(int sockfd, struct sockaddr *addr, socklen_t *length_ptr)
 
 	filtab_entry_t* fte = NULL;
 	int file = EOF;
-	filtab_entry_t* parent = __get_entry(sockfd);
+	filtab_entry_t* parent = __acquire_entry(sockfd, NULL);
 
-	if(parent && parent->fdes != -1)
+	if(parent)
 	{
 		// if we got 0 here it means a file table entry was made successfully
-		if(__create_filtab_item(&fte, NULL, 0, __determine_mode(NULL), 0, parent->fdes, (int)addr, (int)length_ptr) == 0)
+		if(parent->fdes != -1 &&
+		   __create_filtab_item(&fte, NULL, 0, __determine_mode(NULL), 0, parent->fdes, (intptr_t)addr, (intptr_t)length_ptr) == 0)
 		{
 			// add file to table
-			file = __insert_entry(fte);
+			file = __insert_entry(fte, false);
 
 			// add failed, close and delete
 			if(file == EOF)
 				__delete_filtab_item(fte);
 		}
+		__release_entry(parent);
 	}
 
 	return file;
@@ -1531,14 +2372,6 @@ int sendto(int sockfd, const void *buffer, size_t size, int flags, struct sockad
     SOCKET_WRAPPER(lwip_sendto, false, true, sockfd, buffer, size, flags, addr, length);
 }
 
-/**
- * TODO - finish me
- */
-//int select(int nfds, fd_set *read-fds, fd_set *write-fds, fd_set *except-fds, struct timeval *timeout)
-//{
-//    SOCKET_WRAPPER(lwip_select, sockfd, buffer, size, flags, addr, length);
-//}
-
 int ioctlsocket(int sockfd, int cmd, void* argp)
 {
     SOCKET_WRAPPER(lwip_ioctl, true, true, sockfd, cmd, argp);
@@ -48,6 +48,8 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
+#include "ringbuf.h"
+#include "pool.h"
 #endif
 
 #if USE_DRIVER_FAT_FILESYSTEM
@@ -58,6 +60,14 @@
  extern "C" {
 #endif
 
+/**
+ * the FREAD and FWRITE are not there on all libc's
+ */
+#ifndef FREAD
+#define FREAD   1
+#define FWRITE  2
+#endif
+
 #ifndef FILE_TABLE_OFFSET
 #error FILE_TABLE_OFFSET must be defined - normally defined in likeposix_config.h
 #endif
@@ -74,6 +84,23 @@
 #error ENABLE_LIKEPOSIX_SOCKETS must be defined - normally defined in likeposix_config.h
 #endif
 
+/**
+ * set to 1 in likeposix_config.h to count how often the file table lock and the per file
+ * read and write locks are waited on, see file_table_lock_stats().
+ */
+#ifndef LIKEPOSIX_LOCK_STATS
+#define LIKEPOSIX_LOCK_STATS    0
+#endif
+
+/**
+ * the number of file table entries kept in a pool in main RAM, so opening and closing files
+ * does not fragment the heap. entries beyond this are taken from the heap.
+ * each entry holds a FatFs file, including its sector buffer unless _FS_TINY is set.
+ */
+#ifndef FILE_TABLE_POOL_LENGTH
+#define FILE_TABLE_POOL_LENGTH  16
+#endif
+
 #define MAX_DEVICE_TABLE_ENTRIES		255
 #if DEVICE_TABLE_LENGTH >=MAX_DEVICE_TABLE_ENTRIES
 #error DEVICE_TABLE_LENGTH must be less than MAX_DEVICE_TABLE_ENTRIES
@@ -87,11 +114,11 @@
  typedef int(*dev_ioctl_fn_t)(dev_ioctl_t*);
 
  /**
-  *  definition of queue pair, use for device driver communication
+  *  definition of ring buffer pair, use for device driver communication
   */
  typedef struct {
- 	QueueHandle_t write;	///< queue that directs data written from application, to a physical device
- 	QueueHandle_t read;		///< queue that directs data written from a physical device, to the application
+ 	ringbuf_t* write;	///< ring buffer that directs data written from application, to a physical device
+ 	ringbuf_t* read;	///< ring buffer that directs data written from a physical device, to the application
  } queue_pair_t;
 
  /**
@@ -120,6 +147,28 @@ dev_ioctl_t* install_device(char* name,
 int file_table_open_files();
 int file_table_hwm();
 
+/**
+ * counters for one kind of lock.
+ */
+typedef struct {
+    unsigned long taken;        ///< the number of times the lock was taken
+    unsigned long contended;    ///< the number of times the lock was held by another task when requested
+    unsigned long timeouts;     ///< the number of times the lock could not be taken before the timeout
+} lock_stats_t;
+
+/**
+ * file table lock counters, see LIKEPOSIX_LOCK_STATS.
+ */
+typedef struct {
+    lock_stats_t filtab;        ///< the file table lock, taken by open, close and every file operation
+    lock_stats_t read;          ///< the per file read locks
+    lock_stats_t write;         ///< the per file write locks
+} file_table_lock_stats_t;
+
+void file_table_lock_stats(file_table_lock_stats_t* stats);
+void file_table_reset_lock_stats();
+void file_table_pool_stats(pool_stats_t* stats);
+
 #endif
 
 #ifdef __cplusplus
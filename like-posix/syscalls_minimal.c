@@ -25,12 +25,18 @@
 #include <time.h>
 #include <sys/stat.h>
 #include <string.h>
+#if FAMILY == HOST
+#include "board_config.h"
+#endif
 
 
+#if FAMILY != HOST
+// newlib support, the host C library provides these
 #undef errno
 extern int errno;
 char *__env[1] = {0};
 char **__environ = __env;
+#endif
 extern unsigned int _heap;
 extern unsigned int _eheap;
  caddr_t heap = NULL;
@@ -45,6 +51,9 @@ extern void phy_putc(char c) __attribute__((weak));
 void _exit(int i)
 {
     (void)i;
+#if FAMILY == HOST
+    host_exit(i);
+#endif
 	while (1);
 }
 
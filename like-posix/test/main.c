@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * like-posix host checks.
+ *
+ * poll() and select() are checked against each kind of file they treat differently:
+ *
+ * - a regular file, which is always ready.
+ * - a device FIFO, which becomes readable when a helper task puts data in its read ring
+ *   buffer, the way a device driver would.
+ * - a UDP socket, which is writable straight away, and becomes readable when a helper
+ *   task sends it a datagram over the host loopback interface (see ethernetif.c).
+ * - a device FIFO and a socket polled together, with the socket becoming readable.
+ *
+ * with nothing ready, a timeout of 0 must return straight away, and a longer timeout
+ * must expire without returning early.
+ *
+ * then dup() races close() on a device FIFO: one task dups and closes the descriptor in a
+ * loop, while another closes it. a dup that succeeds must find the device still open.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "sdfs.h"
+#include "syscalls.h"
+#include "net.h"
+
+#define TEST_IPADDR             "10.0.0.2"
+#define TEST_RESOLV_CONF_PATH   "/test/resolv"
+#define TEST_NETIF_CONF_PATH    "/test/interface"
+#define TEST_FILE               "/test/file.bin"
+#define TEST_FIFO               DEVICE_INTERFACE_DIRECTORY "fifo"
+#define TEST_FIFO_LENGTH        64
+#define TEST_RACE_FIFO          DEVICE_INTERFACE_DIRECTORY "race"
+#define TEST_RACE_ITERATIONS    200
+#define TEST_PORT               5200
+#define TEST_DELAY              50      ///< ms before a helper task makes a file ready
+#define TEST_TIMEOUT            200     ///< ms that a timeout check waits
+#define TEST_LONG_TIMEOUT       2000    ///< ms to wait for something that should become ready
+
+static int checks;
+static int failures;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        checks++;                                                                   \
+        if(!(cond))                                                                 \
+        {                                                                           \
+            failures++;                                                             \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);         \
+        }                                                                           \
+    } while(0)
+
+static dev_ioctl_t* fifo_device;
+
+static volatile bool race_device_open;
+static volatile int race_fd;
+static volatile int race_dups;
+static volatile int race_dups_closed;
+static SemaphoreHandle_t race_ready;
+static SemaphoreHandle_t race_done;
+
+static unsigned int now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned int)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/**
+ * puts a byte in the FIFO read ring buffer after TEST_DELAY ms, as a device driver would.
+ */
+static void fifo_put_task(void* parameters)
+{
+    (void)parameters;
+    vTaskDelay(TEST_DELAY/portTICK_RATE_MS);
+    ringbuf_put(fifo_device->pipe.read, "f", 1);
+    vTaskDelete(NULL);
+}
+
+/**
+ * sends a datagram to TEST_PORT after TEST_DELAY ms.
+ */
+static void socket_send_task(void* parameters)
+{
+    struct sockaddr_in addr;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    (void)parameters;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_PORT);
+    addr.sin_addr.s_addr = inet_addr(TEST_IPADDR);
+
+    vTaskDelay(TEST_DELAY/portTICK_RATE_MS);
+    if(fd >= 0)
+    {
+        sendto(fd, "s", 1, 0, (struct sockaddr*)&addr, sizeof(addr));
+        closesocket(fd);
+    }
+    vTaskDelete(NULL);
+}
+
+static void start_helper(TaskFunction_t helper)
+{
+    xTaskCreate(helper, "helper", configMINIMAL_STACK_SIZE * 4, NULL, tskIDLE_PRIORITY + 1, NULL);
+}
+
+/**
+ * polls one file descriptor, sets *revents and *elapsed (in ms).
+ */
+static int poll_one(int fd, short events, int timeout, short* revents, unsigned int* elapsed)
+{
+    struct pollfd pfd = {.fd = fd, .events = events, .revents = 0};
+    unsigned int start = now_ms();
+    int ret = poll(&pfd, 1, timeout);
+    *elapsed = now_ms() - start;
+    *revents = pfd.revents;
+    return ret;
+}
+
+/**
+ * selects on one file descriptor, for reading and/or writing. on return *readable and
+ * *writable are set from the sets, and *elapsed is in ms.
+ */
+static int select_one(int fd, bool read, bool write, int timeout, bool* readable, bool* writable, unsigned int* elapsed)
+{
+    fd_set readfds;
+    fd_set writefds;
+    struct timeval tv = {.tv_sec = timeout / 1000, .tv_usec = (timeout % 1000) * 1000};
+    unsigned int start = now_ms();
+    int ret;
+
+    FD_ZERO(&readfds);
+    FD_ZERO(&writefds);
+    if(read)
+        FD_SET(fd, &readfds);
+    if(write)
+        FD_SET(fd, &writefds);
+
+    // select() is lwip_select() when the socket API is not wrapped, call the like-posix one
+    ret = _select(fd + 1, read ? &readfds : NULL, write ? &writefds : NULL, NULL, &tv);
+    *elapsed = now_ms() - start;
+    *readable = read && FD_ISSET(fd, &readfds);
+    *writable = write && FD_ISSET(fd, &writefds);
+    return ret;
+}
+
+/**
+ * checks that nothing is reported ready on fd, first with a timeout of 0, then with
+ * TEST_TIMEOUT, which must expire.
+ */
+static void check_not_readable(int fd)
+{
+    unsigned int elapsed;
+    short revents;
+    bool readable, writable;
+
+    CHECK(poll_one(fd, POLLIN, 0, &revents, &elapsed) == 0);
+    CHECK(revents == 0);
+    CHECK(elapsed < TEST_DELAY);
+
+    CHECK(poll_one(fd, POLLIN, TEST_TIMEOUT, &revents, &elapsed) == 0);
+    CHECK(revents == 0);
+    CHECK(elapsed >= TEST_TIMEOUT - portTICK_RATE_MS);
+
+    CHECK(select_one(fd, true, false, 0, &readable, &writable, &elapsed) == 0);
+    CHECK(!readable);
+    CHECK(elapsed < TEST_DELAY);
+
+    CHECK(select_one(fd, true, false, TEST_TIMEOUT, &readable, &writable, &elapsed) == 0);
+    CHECK(!readable);
+    CHECK(elapsed >= TEST_TIMEOUT - portTICK_RATE_MS);
+}
+
+static void check_file(void)
+{
+    unsigned int elapsed;
+    short revents;
+    bool readable, writable;
+    int fd = open(TEST_FILE, O_RDWR|O_CREAT|O_TRUNC, 0);
+
+    CHECK(fd >= 0);
+    CHECK(poll_one(fd, POLLIN|POLLOUT, 0, &revents, &elapsed) == 1);
+    CHECK(revents == (POLLIN|POLLOUT));
+    CHECK(select_one(fd, true, true, 0, &readable, &writable, &elapsed) == 2);
+    CHECK(readable && writable);
+    close(fd);
+}
+
+static void check_fifo(void)
+{
+    unsigned int elapsed;
+    short revents;
+    bool readable, writable;
+    char c;
+    // for devices the mode argument is the FIFO length
+    int fd = open(TEST_FIFO, O_RDWR, TEST_FIFO_LENGTH);
+
+    CHECK(fd >= 0);
+    if(fd < 0)
+        return;
+
+    check_not_readable(fd);
+
+    // the write ring buffer is empty, so there is space
+    CHECK(poll_one(fd, POLLOUT, 0, &revents, &elapsed) == 1);
+    CHECK(revents == POLLOUT);
+
+    start_helper(fifo_put_task);
+    CHECK(poll_one(fd, POLLIN, TEST_LONG_TIMEOUT, &revents, &elapsed) == 1);
+    CHECK(revents == POLLIN);
+    CHECK(elapsed < TEST_LONG_TIMEOUT);
+    CHECK(read(fd, &c, 1) == 1 && c == 'f');
+
+    start_helper(fifo_put_task);
+    CHECK(select_one(fd, true, false, TEST_LONG_TIMEOUT, &readable, &writable, &elapsed) == 1);
+    CHECK(readable);
+    CHECK(elapsed < TEST_LONG_TIMEOUT);
+    CHECK(read(fd, &c, 1) == 1 && c == 'f');
+
+    close(fd);
+}
+
+static void check_socket(void)
+{
+    struct sockaddr_in addr;
+    struct pollfd pfds[2];
+    unsigned int elapsed;
+    short revents;
+    bool readable, writable;
+    char c;
+    int fifo;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    CHECK(fd >= 0);
+    if(fd < 0)
+        return;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_PORT);
+    addr.sin_addr.s_addr = inet_addr(TEST_IPADDR);
+    CHECK(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+
+    check_not_readable(fd);
+
+    CHECK(poll_one(fd, POLLOUT, 0, &revents, &elapsed) == 1);
+    CHECK(revents == POLLOUT);
+    CHECK(select_one(fd, false, true, 0, &readable, &writable, &elapsed) == 1);
+    CHECK(writable);
+
+    start_helper(socket_send_task);
+    CHECK(poll_one(fd, POLLIN, TEST_LONG_TIMEOUT, &revents, &elapsed) == 1);
+    CHECK(revents == POLLIN);
+    CHECK(elapsed < TEST_LONG_TIMEOUT);
+    CHECK(recv(fd, &c, 1, 0) == 1 && c == 's');
+
+    start_helper(socket_send_task);
+    CHECK(select_one(fd, true, true, TEST_LONG_TIMEOUT, &readable, &writable, &elapsed) == 1);
+    CHECK(!readable && writable);
+    // writable returns straight away, wait for the datagram on its own
+    CHECK(select_one(fd, true, false, TEST_LONG_TIMEOUT, &readable, &writable, &elapsed) == 1);
+    CHECK(readable);
+    CHECK(recv(fd, &c, 1, 0) == 1 && c == 's');
+
+    // a socket and an idle device FIFO together, the socket is checked every POLL_SOCKET_PERIOD
+    fifo = open(TEST_FIFO, O_RDWR, TEST_FIFO_LENGTH);
+    CHECK(fifo >= 0);
+    pfds[0].fd = fifo;
+    pfds[0].events = POLLIN;
+    pfds[1].fd = fd;
+    pfds[1].events = POLLIN;
+    start_helper(socket_send_task);
+    CHECK(poll(pfds, 2, TEST_LONG_TIMEOUT) == 1);
+    CHECK(pfds[0].revents == 0);
+    CHECK(pfds[1].revents == POLLIN);
+    CHECK(recv(fd, &c, 1, 0) == 1 && c == 's');
+    close(fifo);
+
+    closesocket(fd);
+}
+
+static int race_device_open_fn(dev_ioctl_t* device)
+{
+    (void)device;
+    race_device_open = true;
+    return 0;
+}
+
+static int race_device_close_fn(dev_ioctl_t* device)
+{
+    (void)device;
+    race_device_open = false;
+    return 0;
+}
+
+/**
+ * dups and closes race_fd until it is closed by check_dup_close_race().
+ * the tick preempts this task at any point in the loop, often between _dup() taking its
+ * reference to the file and entering it in the file table, which is where close() must
+ * not slip in unnoticed.
+ */
+static void race_dup_task(void* parameters)
+{
+    int fd;
+
+    (void)parameters;
+    for(;;)
+    {
+        xSemaphoreTake(race_ready, portMAX_DELAY);
+        while((fd = dup(race_fd)) != -1)
+        {
+            race_dups++;
+            if(!race_device_open)
+                race_dups_closed++;
+            close(fd);
+        }
+        xSemaphoreGive(race_done);
+    }
+}
+
+static void check_dup_close_race(void)
+{
+    int i;
+
+    race_ready = xSemaphoreCreateBinary();
+    race_done = xSemaphoreCreateBinary();
+    CHECK(race_ready && race_done);
+    CHECK(install_device(TEST_RACE_FIFO, NULL, NULL, NULL, race_device_open_fn, race_device_close_fn, NULL) != NULL);
+    // the same priority as this task, so the two are switched on every tick
+    xTaskCreate(race_dup_task, "race", configMINIMAL_STACK_SIZE * 4, NULL, uxTaskPriorityGet(NULL), NULL);
+
+    for(i = 0; i < TEST_RACE_ITERATIONS; i++)
+    {
+        race_fd = open(TEST_RACE_FIFO, O_RDWR, TEST_FIFO_LENGTH);
+        CHECK(race_fd >= 0 && race_device_open);
+        xSemaphoreGive(race_ready);
+        // the dup task runs until the tick wakes this task, wherever it has got to
+        vTaskDelay(1);
+        CHECK(close(race_fd) == 0);
+        xSemaphoreTake(race_done, portMAX_DELAY);
+        CHECK(!race_device_open);
+    }
+
+    printf("dup/close race: %d dups, %d found the device closed\n", race_dups, race_dups_closed);
+    CHECK(race_dups_closed == 0);
+}
+
+static void write_file(const char* path, const char* content)
+{
+    int fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0);
+    if(fd >= 0)
+    {
+        write(fd, content, strlen(content));
+        close(fd);
+    }
+}
+
+/**
+ * brings up LwIP on the host loopback interface, with a static address.
+ */
+static bool net_up(void)
+{
+    static netconf_t netconf;
+
+    write_file(TEST_RESOLV_CONF_PATH, "resolv static\nhostname test\n");
+    write_file(TEST_NETIF_CONF_PATH,
+            "ipaddr " TEST_IPADDR "\n"
+            "netmask 255.255.255.0\n"
+            "gateway 10.0.0.1\n"
+            "macaddr 02:00:00:00:00:01\n");
+
+    net_config(&netconf, TEST_RESOLV_CONF_PATH, TEST_NETIF_CONF_PATH);
+    net_init(&netconf);
+    return wait_for_address(&netconf);
+}
+
+int main(void)
+{
+    sdfs_init();
+    while(!sdfs_ready())
+        vTaskDelay(10);
+
+    mkdir("/test", 0);
+    // the RAM disk starts out empty, see the like-posix bench
+    mkdir("/dev", 0);
+    fifo_device = install_device(TEST_FIFO, NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(fifo_device != NULL);
+    CHECK(net_up());
+
+    check_file();
+    if(fifo_device)
+        check_fifo();
+    check_socket();
+    check_dup_close_race();
+
+    printf("likeposix: %d checks, %d failed\n", checks, failures);
+    exit(failures ? 1 : 0);
+    return 0;
+}
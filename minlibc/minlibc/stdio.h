@@ -46,6 +46,14 @@ extern "C" {
 #define MINLIBC_STDIO_BUFFER_SIZE   128
 #endif
 
+/**
+ * size in bytes of the stack buffer that xxprintf() functions format into,
+ * before writing out to a file or stream
+ */
+#ifndef MINLIBC_PRINTF_CHUNK_SIZE
+#define MINLIBC_PRINTF_CHUNK_SIZE   64
+#endif
+
 /**
  * include floating point string formatting in xxprintf() functions
  */
@@ -87,6 +95,7 @@ extern "C" {
 #define FILE_STREAM_TABLE_START_REGULAR     3
 
 #include <stdio.h>
+#include <sys/types.h>
 
 /**
  * the __Sxxx macros are not there on all libc's
@@ -155,9 +164,9 @@ struct fake__sbuf {
  * extra small FILE type, replaces newlib FILE inside the stdio implementation
  */
 typedef struct {
-//    char *_p;  /* current position in (some) buffer */
-//    int   _r;           /* read space left for getc() */
-//    int   _w;           /* write space left for putc() */
+    char *_p;           /* current read position in the buffer */
+    int   _r;           /* read ahead bytes left in the buffer */
+    int   _w;           /* bytes in the buffer not yet written to the file */
     short _flags;       /* flags, below; this FILE is free if 0 */
     short _file;        /* fileno, if Unix descriptor, else -1 */
     struct fake__sbuf _bf;  /* the buffer (at least 1 byte, if !NULL) */
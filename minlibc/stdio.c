@@ -37,12 +37,20 @@
 
 int vsprintf(char* dst, const char * fmt, va_list argp)
 int sprintf(char* dst, const char* fmt, ...)
+int vsnprintf(char* dst, size_t size, const char * fmt, va_list argp)
+int snprintf(char* dst, size_t size, const char* fmt, ...)
+int vdprintf(int fd, const char * fmt, va_list argp)
+int dprintf(int fd, const char * fmt, ...)
+int vfprintf(FILE* stream, const char * fmt, va_list argp)
 int vprintf(const char * fmt, va_list argp)
 int printf(const char * fmt, ...)
 
+Note: the xxprintf() functions that write to a file or stream format into a MINLIBC_PRINTF_CHUNK_SIZE
+byte buffer on the stack, and write it out in one go each time it fills up.
+
 void init_minlibc() (must be called in crt initialization (init_services under appleseed))
 
-int setvbuf(FILE *stream, char *buf, int mode, size_t size) (not functional)
+int setvbuf(FILE *stream, char *buf, int mode, size_t size)
 FILE* fopen(const char * filename, const char * mode)
 FILE* fdopen(int fd, const char *mode)
 FILE* freopen(const char* filename, const char* mode, FILE* file)
@@ -59,7 +67,7 @@ long int ftell(FILE* stream)
 int fseek(FILE * stream, long int offset, int origin)
 size_t fwrite(const void *data, size_t size, size_t count, FILE *stream)
 size_t fread(void *data, size_t size, size_t count, FILE *stream)
-int fflush(FILE* stream)
+int fflush(FILE* stream) (also commits the file to the device, as fsync())
 int fileno(FILE* stream) (possibly broken)
 int rename(const char *oldname, const char *newname)
 int remove(const char *name)
@@ -74,6 +82,11 @@ MINLIBC_FOPEN_MAX: specified in _stdio.h, my be overidden from the project makef
 FILE_TABLE_LENGTH: specified in like_posix_config.h (per project).
             sets the number of files in the file descriptor table (can be any type of file)
 
+Note: streams on regular files are fully buffered by default, with a buffer of MINLIBC_BUFSIZ bytes
+(512 by default, to match the FatFs sector size) allocated on first use.
+all other streams, including stdin, stdout and stderr, are unbuffered by default.
+setvbuf() may be used to change that.
+
  * @file stdio.c
  * @{
  */
@@ -87,6 +100,7 @@ FILE_TABLE_LENGTH: specified in like_posix_config.h (per project).
 #include <unistd.h> // STDOUT_FILENO etc
 #include <ctype.h> // isdigit() etc
 #include <fcntl.h>
+#include <limits.h>
 
 #include "strutils.h"
 
@@ -94,7 +108,17 @@ FILE_TABLE_LENGTH: specified in like_posix_config.h (per project).
 #include "minlibc/stdlib.h"
 #include "minlibc/string.h"
 
-fake__FILE __fstab[FOPEN_MAX];
+extern int _fstat(int file, struct stat *st);
+
+/**
+ * the standard streams are set up statically, so that printf() and puts() work before init_minlibc().
+ */
+fake__FILE __fstab[FOPEN_MAX] = {
+    [FILE_STREAM_TABLE_INDEX_STDIN] = {._flags = __SRD|__SNBF, ._file = STDIN_FILENO},
+    [FILE_STREAM_TABLE_INDEX_STDOUT] = {._flags = __SWR|__SNBF, ._file = STDOUT_FILENO},
+    [FILE_STREAM_TABLE_INDEX_STDERR] = {._flags = __SWR|__SNBF, ._file = STDERR_FILENO},
+};
+#define __stdout        ((FILE*)&__fstab[FILE_STREAM_TABLE_INDEX_STDOUT])
 static char __tmpnambuf[L_tmpnam];
 fake__FILE* __tmpfs[TMP_MAX];
 
@@ -107,407 +131,559 @@ fake__FILE* __tmpfs[TMP_MAX];
 #define SHORT_FLAG 64
 #define DOT_FLAG 128
 
-typedef char*(*putx_t)(int, char**, const char*);
+/**
+ * formatter output. characters are collected in buf, and handed to flush()
+ * in one go whenever it fills up, and once more at the end.
+ * with no flush function, buf is the final destination and output beyond size is dropped.
+ */
+typedef struct _fmtout_t {
+    char* buf;          ///< the chunk or destination buffer
+    int size;           ///< capacity of buf
+    int len;            ///< number of characters in buf
+    int count;          ///< total number of characters formatted
+    int error;          ///< set when flush() fails
+    int (*flush)(struct _fmtout_t*);   ///< empties buf, or NULL
+    void* ctx;          ///< the stream or file descriptor that flush() writes to
+} fmtout_t;
+
+static int __swrite(fake__FILE* s, const char* data, int count);
+
+static int __fmt_flush_stream(fmtout_t* out)
+{
+    return __swrite((fake__FILE*)out->ctx, out->buf, out->len) == out->len ? 0 : EOF;
+}
 
-static inline char* __minlibc_putc(int fd, char** dst, const char*src)
+static int __fmt_flush_fd(fmtout_t* out)
 {
-    if(*src)
-    {
-        _write(fd, (char*)src, 1);
-        (*dst)++;
-    }
-    return *dst;
+    return _write((int)(intptr_t)out->ctx, out->buf, out->len) == out->len ? 0 : EOF;
 }
 
-static inline char* __minlibc_puts(int fd, char** dst, const char*src)
+static inline void __fmt_drain(fmtout_t* out)
 {
-    int l = strlen(src);
-    if(l > 0)
+    if(out->flush && out->len > 0)
     {
-        _write(fd, (char*)src, l);
-        *dst += l;
+        if(out->flush(out))
+            out->error = 1;
+        out->len = 0;
     }
-    return *dst;
 }
 
-static inline char* memputc(int fd, char** dst, const char*src)
+static inline void __fmt_write(fmtout_t* out, const char* src, int n)
 {
-    (void)fd;
-    **dst = *src;
-    (*dst)++;
-    return *dst;
+    int chunk;
+
+    out->count += n;
+    while(n > 0)
+    {
+        if(out->len == out->size)
+        {
+            if(!out->flush)
+                return;
+            __fmt_drain(out);
+        }
+
+        chunk = out->size - out->len;
+        if(chunk > n)
+            chunk = n;
+        memcpy(out->buf + out->len, src, chunk);
+        out->len += chunk;
+        src += chunk;
+        n -= chunk;
+    }
 }
 
-static inline char* memputs(int fd, char** dst, const char*src)
+static inline void __fmt_putc(fmtout_t* out, char c)
 {
-    (void)fd;
-    while(*src)
+    if(out->len < out->size)
     {
-        **dst = *src;
-        (*dst)++;
-        src++;
+        out->buf[out->len++] = c;
+        out->count++;
     }
-    return *dst;
+    else
+        __fmt_write(out, &c, 1);
 }
 
-static inline void plusflag(int fd, putx_t _put_char, unsigned int flags, char** dst)
+static inline void __fmt_puts(fmtout_t* out, const char* s)
+{
+    __fmt_write(out, s, strlen(s));
+}
+
+/**
+ * pads out to width with padchar, given the length of the field about to be written.
+ */
+static inline void __fmt_pad(fmtout_t* out, char padchar, int width, int length)
+{
+    while(width-- > length)
+        __fmt_putc(out, padchar);
+}
+
+static inline void plusflag(fmtout_t* out, unsigned int flags)
 {
     if(flags&PLUS_FLAG)
-    {
-        char c = '+';
-        _put_char(fd, dst, &c);
-    }
+        __fmt_putc(out, '+');
 }
 
-static inline void hashflag(int fd, putx_t _put_str, unsigned int flags, char** dst)
+static inline void hashflag(fmtout_t* out, unsigned int flags)
 {
     if(flags&HASH_FLAG)
-        _put_str(fd, dst, (const char*)"0x");
+        __fmt_puts(out, "0x");
 }
 
-static inline int strfmt(int fd, putx_t _put_char, putx_t _put_str, char** dst, const char * fmt, va_list argp)
+/**
+ * writes a signed decimal, zero padding goes after the sign.
+ */
+static void __fmt_signed(fmtout_t* out, unsigned int flags, char padchar, int padding, int64_t value)
 {
-    double d;
+    char intbuf[21];
+    uint64_t magnitude = value < 0 ? 0u - (uint64_t)value : (uint64_t)value;
+    int length = duitoa10(magnitude, intbuf);
+
+    if(value < 0)
+        length++;
+    else if(flags&PLUS_FLAG)
+        length++;
+
+    if(flags&SPACE_FLAG)
+        __fmt_pad(out, padchar, padding, length);
+    if(value < 0)
+        __fmt_putc(out, '-');
+    else
+        plusflag(out, flags);
+    if(flags&ZERO_FLAG)
+        __fmt_pad(out, padchar, padding, length);
+    __fmt_puts(out, intbuf);
+}
+
 #if MINLIBC_INCLUDE_FLOAT_SUPPORT
-    int dps = DEFAULT_FTOA_DECIMAL_PLACES;
+/**
+ * writes a double in the style of the %f, %e or %g conversions, given in lower or upper case.
+ * the digits are exact, see dtodecimal(), and are written straight out so that no buffer
+ * is needed for the integer part of large values.
+ */
+static void __fmt_double(fmtout_t* out, unsigned int flags, int padding, int precision, char conversion, double d)
+{
+    decimal_t dec;
+    bool upper = isupper((int)conversion);
+    bool exp = false;
+    bool strip = false;
+    const char* special = NULL;
+    char expbuf[6];
+    int explength = 0;
+    int exponent = 0;
+    int intdigits = 1;
+    int point;
+    int length;
+    int i;
+
+    conversion = (char)tolower((int)conversion);
+    if(precision < 0)
+        precision = DEFAULT_FTOA_DECIMAL_PLACES;
+
+    if(isnan(d))
+    {
+        special = upper ? "NAN" : "nan";
+        dec.negative = false;
+    }
+    else if(isinf(d))
+    {
+        special = upper ? "INF" : "inf";
+        dec.negative = d < 0;
+    }
+    else if(conversion == 'f')
+        dtodecimal(d, &dec, precision, true);
+    else
+    {
+        if(conversion == 'g' && precision == 0)
+            precision = 1;
+        dtodecimal(d, &dec, conversion == 'g' ? precision : precision + 1, false);
+        exponent = dec.ndigits ? dec.decpt - 1 : 0;
+        exp = true;
+        if(conversion == 'g')
+        {
+            // %g is %e for small or large exponents, otherwise %f, with the same significant digits
+            strip = !(flags&HASH_FLAG);
+            if(exponent >= -4 && exponent < precision)
+            {
+                exp = false;
+                precision = precision - 1 - exponent;
+            }
+            else
+                precision--;
+            if(strip && precision > dec.ndigits - (exp ? 1 : dec.decpt))
+                precision = dec.ndigits - (exp ? 1 : dec.decpt);
+            if(precision < 0)
+                precision = 0;
+        }
+    }
+
+    if(special)
+        length = 3;
+    else
+    {
+        if(exp)
+        {
+            expbuf[0] = upper ? 'E' : 'e';
+            expbuf[1] = exponent < 0 ? '-' : '+';
+            explength = 2 + uitoa10(exponent < 0 ? -exponent : exponent, expbuf + 2);
+            if(explength == 3)
+            {
+                expbuf[3] = expbuf[2];
+                expbuf[2] = '0';
+                explength = 4;
+            }
+        }
+        else
+            intdigits = dec.decpt > 0 ? dec.decpt : 1;
+        length = intdigits + explength + precision + ((precision || (flags&HASH_FLAG)) ? 1 : 0);
+    }
+    if(dec.negative || (flags&PLUS_FLAG))
+        length++;
+
+    if((flags&SPACE_FLAG) || (special && (flags&ZERO_FLAG)))
+        __fmt_pad(out, ' ', padding, length);
+    if(dec.negative)
+        __fmt_putc(out, '-');
+    else
+        plusflag(out, flags);
+    if(special)
+    {
+        __fmt_puts(out, special);
+        return;
+    }
+    if(flags&ZERO_FLAG)
+        __fmt_pad(out, '0', padding, length);
+
+    // digits that are not held are zeros
+    point = exp ? 1 : dec.decpt;
+    for(i = point - intdigits; i < point; i++)
+        __fmt_putc(out, (i >= 0 && i < dec.ndigits) ? dec.digits[i] : '0');
+    if(precision || (flags&HASH_FLAG))
+        __fmt_putc(out, '.');
+    for(i = point; i < point + precision; i++)
+        __fmt_putc(out, (i >= 0 && i < dec.ndigits) ? dec.digits[i] : '0');
+    if(exp)
+        __fmt_write(out, expbuf, explength);
+}
 #endif
-    int ret = -1;
-    char* start = *dst;
+
+static int strfmt(fmtout_t* out, const char * fmt, va_list argp)
+{
+    double d;
+    const char* run;
     void* v;
-    unsigned int u;
-    int i;
+    uint64_t u;
+    int64_t i;
     int padding;
+    int precision;
     char padchar;
     const char* s;
     char c;
     char intbuf[28];
     unsigned int flags;
 
-    if(fmt)
+    if(!fmt)
+        return -1;
+
+    while(*fmt)
     {
-        for(;*fmt;fmt++)
+        // copy runs of plain characters in one go
+        run = fmt;
+        while(*fmt && *fmt != '%')
+            fmt++;
+        if(fmt > run)
+            __fmt_write(out, run, fmt - run);
+        if(!*fmt)
+            break;
+
+        flags = 0;
+        fmt++;
+
+        // handle sign and #
+        switch(*fmt)
         {
-            flags = 0;
+            case '-':
+                // ignore left justification for now
+                // flags |= MINUS_FLAG;
+                fmt++;
+            break;
+            case '+':
+                flags |= PLUS_FLAG;
+                fmt++;
+            break;
+            case '#':
+                flags |= HASH_FLAG;
+                fmt++;
+            break;
+            case '.':
+                flags |= DOT_FLAG;
+                fmt++;
+            break;
+        }
 
-            // print fmt chars
-            switch(*fmt)
-            {
-                // print va_args
-                case '%':
-                    fmt++;
-                    // handle sign and #
-                    switch(*fmt)
+        // handle padding
+        padchar = 0;
+        switch(*fmt)
+        {
+            case ' ':
+                padchar = ' ';
+                flags |= SPACE_FLAG;
+                fmt++;
+            break;
+            case '0':
+                padchar = '0';
+                fmt++;
+                flags |= ZERO_FLAG;
+            break;
+            default:
+                if(isdigit((int)*fmt))
+                {
+                    if(flags & DOT_FLAG)
                     {
-                        case '-':
-                            // ignore left justification for now
-                            // flags |= MINUS_FLAG;
-                            fmt++;
-                        break;
-                        case '+':
-                            flags |= PLUS_FLAG;
-                            fmt++;
-                        break;
-                        case '#':
-                            flags |= HASH_FLAG;
-                            fmt++;
-                        break;
-                        case '.':
-                            flags |= DOT_FLAG;
-                            fmt++;
-                        break;
+                        padchar = '0';
+                        flags |= ZERO_FLAG;
                     }
-
-                    // handle padding
-                    padchar = 0;
-                    switch(*fmt)
+                    else
                     {
-                        case ' ':
-                            padchar = ' ';
-                            flags |= SPACE_FLAG;
-                            fmt++;
-                        break;
-                        case '0':
-                            padchar = '0';
-                            fmt++;
-                            flags |= ZERO_FLAG;
-                        break;
-                        default:
-                            if(isdigit((int)*fmt))
-                            {
-                                if(flags & DOT_FLAG)
-                                {
-                                    padchar = '0';
-                                    flags |= ZERO_FLAG;
-                                }
-                                else
-                                {
-                                    padchar = ' ';
-                                    flags |= SPACE_FLAG;
-                                }
-                            }
-                        break;
+                        padchar = ' ';
+                        flags |= SPACE_FLAG;
                     }
+                }
+            break;
+        }
 
-                    // determine overall padded length
-                    // use intbuf as working area
-                    padding = 0;
-                    if(padchar)
-                    {
-                        while(isdigit((int)*fmt))
-                        {
-                            intbuf[padding] = *fmt;
-                            padding++;
-                            fmt++;
-                        }
-                        intbuf[padding] = '\0';
-                        padding = atoi(intbuf);
-                    }
+        // determine overall padded length
+        padding = 0;
+        if(padchar)
+        {
+            while(isdigit((int)*fmt))
+            {
+                padding = padding * 10 + (*fmt - '0');
+                fmt++;
+            }
+        }
 
-                    // handle long/short
-                    switch(*fmt)
-                    {
-                        case 'h':
-                        case 'l':
-                            // flags |= LONG_FLAG;
-                            // flags |= SHORT_FLAG;
-                            // ignore length sub specifiers for now
-                            c = *fmt;
-                            fmt++;
-                            while(*fmt == c)
-                                fmt++;
-                        break;
-                        case 'f':
-#if MINLIBC_INCLUDE_FLOAT_SUPPORT
-                            if(padding)
-                                dps = padding;
-#endif
-                        break;
-                    }
+        // a precision may follow the padded length
+        precision = -1;
+        if(*fmt == '.')
+        {
+            fmt++;
+            precision = 0;
+            while(isdigit((int)*fmt))
+            {
+                precision = precision * 10 + (*fmt - '0');
+                fmt++;
+            }
+        }
 
-                    // handle type
-                    switch(*fmt)
-                    {
-                        case 'c':
-                            c = (char)va_arg(argp, int);
-                            _put_char(fd, dst, &c);
-                        break;
-
-                        case 's':
-                            s = (char*)va_arg(argp, char*);
-                            if(!s)
-                                s = (const char*)"(null)";
-                            if(flags&SPACE_FLAG)
-                            {
-                                padding -= strlen(s);
-                                if(padding > 0)
-                                {
-                                    char padbuf[padding+1];
-                                    padbuf[padding] = '\0';
-                                    while(padding)
-                                    {
-                                        padding--;
-                                        padbuf[padding] = padchar;
-                                    }
-                                    _put_str(fd, dst, padbuf);
-                                }
-                            }
-                            _put_str(fd, dst, s);
-                        break;
-
-                        case 'i':
-                        case 'd':
-                            i = (int)va_arg(argp, int);
-                            if(i >= 0)
-                                plusflag(fd, _put_char, flags, dst);
-
-                            itoa(i, intbuf, 10);
-                            if((flags&ZERO_FLAG) || (flags&SPACE_FLAG))
-                            {
-                                padding -= strlen(intbuf);
-                                if(padding > 0)
-                                {
-                                    char padbuf[padding+1];
-                                    padbuf[padding] = '\0';
-                                    while(padding)
-                                    {
-                                        padding--;
-                                        padbuf[padding] = padchar;
-                                    }
-                                    _put_str(fd, dst, padbuf);
-                                }
-                            }
-                            _put_str(fd, dst, intbuf);
-                        break;
-
-                        case 'u':
-                            u = (unsigned int)va_arg(argp, unsigned int);
-                            plusflag(fd, _put_char, flags, dst);
-
-                            ditoa((int64_t)u, intbuf, 10);
-
-                            if((flags&ZERO_FLAG) || (flags&SPACE_FLAG))
-                            {
-                                padding -= strlen(intbuf);
-                                if(padding > 0)
-                                {
-                                    char padbuf[padding+1];
-                                    padbuf[padding] = '\0';
-                                    while(padding)
-                                    {
-                                        padding--;
-                                        padbuf[padding] = padchar;
-                                    }
-                                    _put_str(fd, dst, padbuf);
-                                }
-                            }
-
-                            _put_str(fd, dst, intbuf);
-                        break;
-
-                        case 'x':
-                            u = (unsigned int)va_arg(argp, unsigned int);
-                            hashflag(fd, _put_str, flags, dst);
-
-                            ditoa((int64_t)u, intbuf, 16);
-
-                            if((flags&ZERO_FLAG) || (flags&SPACE_FLAG))
-                            {
-                                padding -= strlen(intbuf);
-                                if(padding > 0)
-                                {
-                                    char padbuf[padding+1];
-                                    padbuf[padding] = '\0';
-                                    while(padding)
-                                    {
-                                        padding--;
-                                        padbuf[padding] = padchar;
-                                    }
-                                    _put_str(fd, dst, padbuf);
-                                }
-                            }
-
-                            _put_str(fd, dst, intbuf);
-                        break;
-
-                        case 'X':
-                            u = (unsigned int)va_arg(argp, unsigned int);
-                            hashflag(fd, _put_str, flags, dst);
-
-                            ditoa((int64_t)u, intbuf, 16);
-                            // TODO this causes liker error in the test cases!! fix that
-    //                      strtoupper(intbuf);
-
-                            i = 0;
-                            while(intbuf[i])
-                            {
-                                intbuf[i] = toupper((int)intbuf[i]);
-                                i++;
-                            }
-
-                            if((flags&ZERO_FLAG) || (flags&SPACE_FLAG))
-                            {
-                                padding -= strlen(intbuf);
-                                if(padding > 0)
-                                {
-                                    char padbuf[padding+1];
-                                    padbuf[padding] = '\0';
-                                    while(padding)
-                                    {
-                                        padding--;
-                                        padbuf[padding] = padchar;
-                                    }
-                                    _put_str(fd, dst, padbuf);
-                                }
-                            }
-
-                            _put_str(fd, dst, intbuf);
-
-                        break;
-
-                        case 'p':
-                            v = (void*)va_arg(argp, void*);
-                            _put_str(fd, dst, (const char*)"0x");
-
-                            ditoa((intptr_t)v, intbuf, 16);
-                            if((flags&ZERO_FLAG) || (flags&SPACE_FLAG))
-                            {
-                                padding -= strlen(intbuf);
-                                if(padding > 0)
-                                {
-                                    char padbuf[padding+1];
-                                    padbuf[padding] = '\0';
-                                    while(padding)
-                                    {
-                                        padding--;
-                                        padbuf[padding] = padchar;
-                                    }
-                                    _put_str(fd, dst, padbuf);
-                                }
-                            }
-                            _put_str(fd, dst, intbuf);
-                        break;
-
-                        case 'f':
-                            d = va_arg(argp, double);
-                            plusflag(fd, _put_char, flags, dst);
+        // handle long/short
+        switch(*fmt)
+        {
+            case 'h':
+            case 'l':
+                // flags |= SHORT_FLAG;
+                // short lengths are ignored, long lengths are 64 bit when long or long long is
+                c = *fmt;
+                fmt++;
+                i = 1;
+                while(*fmt == c)
+                {
+                    fmt++;
+                    i++;
+                }
+                if(c == 'l' && (i > 1 || sizeof(long) > sizeof(int)))
+                    flags |= LONG_FLAG;
+            break;
+        }
+
+        // handle type
+        switch(*fmt)
+        {
+            case 'c':
+                __fmt_putc(out, (char)va_arg(argp, int));
+            break;
+
+            case 's':
+                s = (char*)va_arg(argp, char*);
+                if(!s)
+                    s = (const char*)"(null)";
+                i = strlen(s);
+                if(flags&SPACE_FLAG)
+                    __fmt_pad(out, padchar, padding, i);
+                __fmt_write(out, s, i);
+            break;
+
+            case 'i':
+            case 'd':
+                if(flags&LONG_FLAG)
+                    i = va_arg(argp, long long);
+                else
+                    i = va_arg(argp, int);
+                __fmt_signed(out, flags, padchar, padding, i);
+            break;
+
+            case 'u':
+                if(flags&LONG_FLAG)
+                    u = va_arg(argp, unsigned long long);
+                else
+                    u = va_arg(argp, unsigned int);
+                plusflag(out, flags);
+
+                i = duitoa10(u, intbuf);
+                if((flags&ZERO_FLAG) || (flags&SPACE_FLAG))
+                    __fmt_pad(out, padchar, padding, i);
+                __fmt_write(out, intbuf, i);
+            break;
+
+            case 'x':
+            case 'X':
+                if(flags&LONG_FLAG)
+                    u = va_arg(argp, unsigned long long);
+                else
+                    u = va_arg(argp, unsigned int);
+                hashflag(out, flags);
+
+                i = duitoa16(u, intbuf, *fmt == 'X');
+                if((flags&ZERO_FLAG) || (flags&SPACE_FLAG))
+                    __fmt_pad(out, padchar, padding, i);
+                __fmt_write(out, intbuf, i);
+            break;
+
+            case 'p':
+                v = (void*)va_arg(argp, void*);
+                __fmt_puts(out, "0x");
+
+                i = duitoa16((uintptr_t)v, intbuf, false);
+                if((flags&ZERO_FLAG) || (flags&SPACE_FLAG))
+                    __fmt_pad(out, padchar, padding, i);
+                __fmt_write(out, intbuf, i);
+            break;
+
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+                d = va_arg(argp, double);
 #if MINLIBC_INCLUDE_FLOAT_SUPPORT
-                            _put_str(fd, dst, dtoascii(intbuf, d, dps));
+                // "%.3f" reads the precision as zero padding, and a bare "%3f" has always meant
+                // 3 decimal places here. the padded length only applies with an explicit precision.
+                // for %e and %g only ".3" is a precision, a bare width is a width.
+                if(precision < 0 && padchar && ((flags & DOT_FLAG) || *fmt == 'f' || *fmt == 'F'))
+                {
+                    precision = padding;
+                    flags &= ~(ZERO_FLAG|SPACE_FLAG);
+                }
+                __fmt_double(out, flags, padding, precision, *fmt, d);
 #else
-                            _put_str(fd, dst, itoa((int)d, intbuf, 10));
+                if(d >= 0)
+                    plusflag(out, flags);
+                __fmt_puts(out, itoa((int)d, intbuf, 10));
 #endif
-                        break;
-
-                        case '%':
-                            c = '%';
-                            _put_char(fd, dst, &c);
-                        break;
-                    }
-                break;
+            break;
 
-                // all other charcters
-                default:
-                    _put_char(fd, dst, fmt);
-                break;
-            }
+            case '%':
+                __fmt_putc(out, '%');
+            break;
         }
 
-        // null terminate
-        c = '\0';
-        _put_char(fd, dst, &c);
-
-        ret = (int)(*dst - start);
+        if(*fmt)
+            fmt++;
     }
 
+    __fmt_drain(out);
+
+    return out->error ? -1 : out->count;
+}
+
+/**
+ * formats into memory, writing at most size characters including the terminating null.
+ */
+static inline int __fmt_mem(char* dst, size_t size, const char * fmt, va_list argp)
+{
+    fmtout_t out = {
+        .buf = dst,
+        .size = size > 0 ? (int)(size - 1) : 0,
+        .flush = NULL,
+    };
+    int ret = strfmt(&out, fmt, argp);
+    if(size > 0)
+        dst[out.len] = '\0';
     return ret;
 }
 
+/**
+ * formats into a stack chunk, handing it to flush() each time it fills.
+ */
+static inline int __fmt_chunked(int (*flush)(fmtout_t*), void* ctx, const char * fmt, va_list argp)
+{
+    char chunk[MINLIBC_PRINTF_CHUNK_SIZE];
+    fmtout_t out = {
+        .buf = chunk,
+        .size = sizeof(chunk),
+        .flush = flush,
+        .ctx = ctx,
+    };
+    return strfmt(&out, fmt, argp);
+}
+
 int vsprintf(char* dst, const char * fmt, va_list argp)
 {
-    return strfmt(-1, memputc, memputs, &dst, fmt, argp) -1;
+    return __fmt_mem(dst, INT_MAX, fmt, argp);
 }
 
 int sprintf(char* dst, const char* fmt, ...)
 {
     va_list argp;
     va_start(argp, fmt);
-    int ret = strfmt(-1, memputc, memputs, &dst, fmt, argp) -1;
+    int ret = __fmt_mem(dst, INT_MAX, fmt, argp);
     va_end(argp);
+    return ret;
+}
+
+int vsnprintf(char* dst, size_t size, const char * fmt, va_list argp)
+{
+    return __fmt_mem(dst, size, fmt, argp);
+}
+
+int snprintf(char* dst, size_t size, const char* fmt, ...)
+{
+    va_list argp;
+    va_start(argp, fmt);
+    int ret = __fmt_mem(dst, size, fmt, argp);
+    va_end(argp);
+    return ret;
+}
+
+int vdprintf(int fd, const char * fmt, va_list argp)
+{
+    return __fmt_chunked(__fmt_flush_fd, (void*)(intptr_t)fd, fmt, argp);
+}
 
+int dprintf(int fd, const char * fmt, ...)
+{
+    va_list argp;
+    va_start(argp, fmt);
+    int ret = __fmt_chunked(__fmt_flush_fd, (void*)(intptr_t)fd, fmt, argp);
+    va_end(argp);
     return ret;
 }
 
+int vfprintf(FILE* stream, const char * fmt, va_list argp)
+{
+    return __fmt_chunked(__fmt_flush_stream, stream, fmt, argp);
+}
+
 int vprintf(const char * fmt, va_list argp)
 {
-    char* dst = NULL;
-    return strfmt(STDOUT_FILENO, __minlibc_putc, __minlibc_puts, &dst, fmt, argp);
+    return __fmt_chunked(__fmt_flush_stream, __stdout, fmt, argp);
 }
 
 int printf(const char * fmt, ...)
 {
-    char* dst = NULL;
     va_list argp;
     va_start(argp, fmt);
-    int ret = strfmt(STDOUT_FILENO, __minlibc_putc, __minlibc_puts, &dst, fmt, argp);
+    int ret = __fmt_chunked(__fmt_flush_stream, __stdout, fmt, argp);
     va_end(argp);
     return ret;
 }
@@ -530,6 +706,9 @@ void init_minlibc()
         __fstab[i]._ub._size = 0;
         __fstab[i]._bf._base = NULL;
         __fstab[i]._bf._size = 0;
+        __fstab[i]._p = NULL;
+        __fstab[i]._r = 0;
+        __fstab[i]._w = 0;
         __fstab[i]._flags = 0;
         __fstab[i]._file = -1;
     }
@@ -549,10 +728,189 @@ void init_minlibc()
 
 #define __eval_err_return(ret, stream) 	if(stream && ret < 0){(((fake__FILE*)stream)->_flags) |= __SERR;}
 
+/**
+ * allocates the stream buffer if there is none yet.
+ * if that fails the stream falls back to being unbuffered.
+ *
+ * @retval  0 if the stream is buffered, EOF if it is not, or if there is no stream.
+ */
+static inline int __salloc(fake__FILE* s)
+{
+    if(!s || (s->_flags & __SNBF))
+        return EOF;
+
+    if(!s->_bf._base)
+    {
+        if(s->_bf._size <= 0)
+            s->_bf._size = __BUFSIZ__;
+
+        s->_bf._base = malloc(s->_bf._size);
+        if(!s->_bf._base)
+        {
+            s->_bf._size = 0;
+            s->_flags |= __SNBF;
+            return EOF;
+        }
+
+        s->_flags |= __SMBF;
+        s->_p = s->_bf._base;
+        s->_r = 0;
+        s->_w = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * writes out any data pending in the stream buffer, and discards any read ahead data,
+ * moving the file position back to where the stream is logically at.
+ *
+ * @retval  0 on success, EOF on error.
+ */
+static int __sflush(fake__FILE* s)
+{
+    int ret = 0;
+    int n;
+    char* p = s->_bf._base;
+
+    while(s->_w > 0)
+    {
+        n = _write(s->_file, p, s->_w);
+        if(n <= 0)
+        {
+            s->_flags |= __SERR;
+            s->_w = 0;
+            ret = EOF;
+        }
+        else
+        {
+            p += n;
+            s->_w -= n;
+        }
+    }
+
+    if(s->_r > 0)
+    {
+        _lseek(s->_file, -s->_r, SEEK_CUR);
+        s->_r = 0;
+    }
+
+    s->_p = s->_bf._base;
+
+    return ret;
+}
+
+/**
+ * refills the stream buffer from the file.
+ *
+ * @retval  the number of bytes now in the buffer, 0 at end of file or on error.
+ */
+static int __srefill(fake__FILE* s)
+{
+    int n;
+
+    if(s->_w > 0 && __sflush(s) == EOF)
+        return 0;
+
+    n = _read(s->_file, s->_bf._base, s->_bf._size);
+    __eval_io_return(n, s);
+
+    s->_p = s->_bf._base;
+    s->_r = n > 0 ? n : 0;
+
+    return s->_r;
+}
+
+/**
+ * puts one character to a stream, buffered according to the stream mode.
+ */
+static int __sputc(int c, fake__FILE* s)
+{
+    char ch = (char)c;
+    int ret;
+
+    if(__salloc(s) == EOF)
+    {
+        ret = _write(s ? s->_file : EOF, &ch, 1);
+        __eval_io_return(ret, s);
+        return ret == 1 ? (unsigned char)ch : EOF;
+    }
+
+    if(s->_r > 0)
+        __sflush(s);
+
+    s->_bf._base[s->_w++] = ch;
+
+    if(s->_w == s->_bf._size || ((s->_flags & __SLBF) && ch == '\n'))
+    {
+        if(__sflush(s) == EOF)
+            return EOF;
+    }
+
+    return (unsigned char)ch;
+}
+
+/**
+ * writes count bytes to a stream, buffered according to the stream mode.
+ * writes at least as large as the buffer bypass it, once it is empty.
+ *
+ * @retval  the number of bytes written or EOF on error.
+ */
+static int __swrite(fake__FILE* s, const char* data, int count)
+{
+    const char* start = data;
+    int total = 0;
+    int n;
+
+    if(__salloc(s) == EOF)
+    {
+        n = _write(s ? s->_file : EOF, (char*)data, count);
+        __eval_err_return(n, s);
+        return n;
+    }
+
+    if(s->_r > 0)
+        __sflush(s);
+
+    while(count > 0)
+    {
+        if(s->_w == 0 && count >= s->_bf._size)
+        {
+            n = _write(s->_file, (char*)data, count);
+            __eval_err_return(n, s);
+            if(n < 0)
+                return total ? total : EOF;
+            return total + n;
+        }
+
+        n = s->_bf._size - s->_w;
+        if(n > count)
+            n = count;
+
+        memcpy(s->_bf._base + s->_w, data, n);
+        s->_w += n;
+        data += n;
+        count -= n;
+        total += n;
+
+        if(s->_w == s->_bf._size && __sflush(s) == EOF)
+            return EOF;
+    }
+
+    if((s->_flags & __SLBF) && memchr(start, '\n', total))
+    {
+        if(__sflush(s) == EOF)
+            return EOF;
+    }
+
+    return total;
+}
 
 static inline FILE* __get_stream_descriptor(int fdes, int flags)
 {
     short i;
+    struct stat st;
+
     if(fdes == EOF)
         return NULL;
     else if(fdes == STDIN_FILENO)
@@ -569,12 +927,16 @@ static inline FILE* __get_stream_descriptor(int fdes, int flags)
     {
         if(__fstab[i]._flags == 0)
         {
-            if(flags & FREAD)
+            if((flags & (FREAD|FWRITE)) == (FREAD|FWRITE))
+                __fstab[i]._flags |= __SRW;
+            else if(flags & FREAD)
                 __fstab[i]._flags |= __SRD;
             else if(flags & FWRITE)
                 __fstab[i]._flags |= __SWR;
-            else if(flags & (FREAD|FWRITE))
-                __fstab[i]._flags |= __SRW;
+
+            // only regular files are buffered by default
+            if(_fstat(fdes, &st) != 0 || !S_ISREG(st.st_mode))
+                __fstab[i]._flags |= __SNBF;
 
             __fstab[i]._file = fdes;
 
@@ -589,8 +951,14 @@ void __release_stream_descriptor(FILE* stream)
     fake__FILE* s = (fake__FILE*)stream;
     if(stream && stream != stdin && stream != stdout && stream != stderr)
     {
+        if(s->_flags & __SMBF)
+            free(s->_bf._base);
+        s->_bf._base = NULL;
         s->_ub._size = 0;
         s->_bf._size = 0;
+        s->_p = NULL;
+        s->_r = 0;
+        s->_w = 0;
         s->_flags = 0;
         s->_file = -1;
     }
@@ -606,7 +974,7 @@ static inline int __stream_mode(const char* mode)
 {
     int flags = 0;
     char m = mode[0];
-    char update = ((mode[1] == '+') || (mode[2] == '+'));
+    char update = mode[1] && ((mode[1] == '+') || (mode[2] == '+'));
 
     if(m == 'r')
         flags = update ? O_RDWR : O_RDONLY;
@@ -630,28 +998,44 @@ static inline int __find_tmpindex()
 }
 
 /**
- * not really implemented, will work OK if the buffer is se to NULL, ie specifying system allocated buffer,
- * and when mode is set to _IOFBF. other modes will simply behave as for _IOFBF.
+ * sets the buffering mode of a stream, one of _IOFBF, _IOLBF or _IONBF.
+ * if buf is NULL, a buffer of size bytes (MINLIBC_BUFSIZ if size is 0) is allocated on first use.
+ * any data pending in the current buffer is flushed first.
  */
 int setvbuf(FILE *stream, char *buf, int mode, size_t size)
 {
     fake__FILE* s = (fake__FILE*)stream;
-    if(buf)
-        return -1;
+
+    if(!s || (mode != _IOFBF && mode != _IOLBF && mode != _IONBF))
+        return EOF;
+
+    if(s->_bf._base)
+        __sflush(s);
+    if(s->_flags & __SMBF)
+        free(s->_bf._base);
+
+    s->_flags &= ~(__SNBF|__SLBF|__SMBF);
+    s->_bf._base = NULL;
+    s->_bf._size = 0;
+    s->_p = NULL;
+    s->_r = 0;
+    s->_w = 0;
 
     switch(mode)
     {
-        case _IOFBF:       /* setvbuf should set fully buffered */
-            s->_bf._base = buf;
-            s->_bf._size = size;
-        break;
-        case _IOLBF:       /* setvbuf should set line buffered */
-            s->_bf._base = buf;
-            s->_bf._size = size;
+        case _IONBF:
+            s->_flags |= __SNBF;
         break;
-        case _IONBF:       /* setvbuf should set unbuffered */
-            s->_bf._base = buf;
+        case _IOLBF:
+            s->_flags |= __SLBF;
+            // fall through
+        case _IOFBF:
             s->_bf._size = size;
+            if(buf && size)
+            {
+                s->_bf._base = buf;
+                s->_p = buf;
+            }
         break;
     }
 
@@ -682,7 +1066,7 @@ FILE* fdopen(int fd, const char *mode)
 
 FILE* freopen(const char* filename, const char* mode, FILE* stream)
 {
-    _fsync(__get_fileno(stream));
+    fflush(stream);
     fclose(stream);
     return fopen(filename, mode);
 }
@@ -693,6 +1077,9 @@ int fclose(FILE* stream)
     int i;
     int res = EOF;
 
+	if(stream && ((fake__FILE*)stream)->_bf._base)
+		__sflush((fake__FILE*)stream);
+
 	if(stream != stdin && stream != stdout && stream != stderr)
 		res = _close(__get_fileno(stream));
     __eval_err_return(res, stream);
@@ -715,10 +1102,9 @@ int fclose(FILE* stream)
 
 int fprintf(FILE* stream, const char * fmt, ...)
 {
-    char* dst = NULL;
     va_list argp;
     va_start(argp, fmt);
-    int ret = strfmt(__get_fileno(stream), __minlibc_putc, __minlibc_puts, &dst, fmt, argp);
+    int ret = vfprintf(stream, fmt, argp);
     __eval_err_return(ret, stream);
     va_end(argp);
     return ret;
@@ -734,17 +1120,22 @@ int fgetc(FILE* stream)
 {
     fake__FILE* s = (fake__FILE*)stream;
     char c;
-    if(s->_ub._size > 0)
+    if(s && s->_ub._size > 0)
     {
         s->_ub._size--;
         c = s->_ub._base[s->_ub._size];
-        return (int)c;
+        return (unsigned char)c;
     }
-    else
+    else if(__salloc(s) == EOF)
     {
     	int ret = _read(__get_fileno(stream), (char*)&c, 1);
     	__eval_io_return(ret, stream);
-    	return ret > 0 ? (int)c : EOF;
+    	return ret > 0 ? (unsigned char)c : EOF;
+    }
+    else if(s->_r > 0 || __srefill(s) > 0)
+    {
+        s->_r--;
+        return (unsigned char)*s->_p++;
     }
     return EOF;
 }
@@ -766,32 +1157,26 @@ int ungetc(int c, FILE* stream)
 
 int fputc(int character, FILE* stream)
 {
-    int ret = _write(__get_fileno(stream), (char*)&character, 1);
-    __eval_io_return(ret, stream);
-    return ret != EOF ? character : EOF;
+    return __sputc(character, (fake__FILE*)stream);
 }
 
 #undef putc
 int putc(int character, FILE* stream)
 {
-	int ret = _write(__get_fileno(stream), (char*)&character, 1);
-	__eval_io_return(ret, stream);
-	return ret != EOF ? character : EOF;
+    return __sputc(character, (fake__FILE*)stream);
 }
 
 int fputs(const char* str, FILE* stream)
 {
-	int ret = _write(__get_fileno(stream), (char*)str, strlen(str));
-	__eval_io_return(ret, stream);
-	return ret;
+	return __swrite((fake__FILE*)stream, str, strlen(str));
 }
 
 int puts(const char * str)
 {
-	int ret = fputs(str, stdout);
+	int ret = fputs(str, __stdout);
 	if(ret >= 0)
 	{
-		if(fputc((int)'\n', stdout) == (int)'\n')
+		if(fputc((int)'\n', __stdout) == (int)'\n')
 			return ret + 1;
 	}
 	return ret;
@@ -799,29 +1184,42 @@ int puts(const char * str)
 
 char* fgets(char* str, int num, FILE* stream)
 {
+    fake__FILE* s = (fake__FILE*)stream;
     char* sptr = str;
-    int i;
-    int len;
-    for(i = 0; i < num-1; )
-    {
-        len = _read(__get_fileno(stream), str, 1);
+    char* nl;
+    int c;
+    int n;
 
-        if(len <= 0)
+    while(num > 1)
+    {
+        if((s && s->_ub._size > 0) || __salloc(s) == EOF)
         {
-        	__eval_io_return(len, stream);
-            break;
+            c = fgetc(stream);
+            if(c == EOF)
+                break;
+            *str++ = (char)c;
+            num--;
+            if(c == '\n')
+                break;
         }
-        else if(len)
+        else if(s->_r > 0 || __srefill(s) > 0)
         {
-            if(*str == '\n')
-            {
-                i++;
-                str++;
+            // copy up to and including the next newline, straight from the buffer
+            n = s->_r < num-1 ? s->_r : num-1;
+            nl = memchr(s->_p, '\n', n);
+            if(nl)
+                n = nl - s->_p + 1;
+
+            memcpy(str, s->_p, n);
+            s->_p += n;
+            s->_r -= n;
+            str += n;
+            num -= n;
+            if(nl)
                 break;
-            }
-            str++;
-            i++;
         }
+        else
+            break;
     }
     *str = 0;
 
@@ -865,15 +1263,23 @@ void perror(const char* message)
 
 long int ftell(FILE* stream)
 {
+    fake__FILE* s = (fake__FILE*)stream;
     int ret = _ftell(__get_fileno(stream));
     __eval_err_return(ret, stream);
+    if(ret >= 0)
+        ret += s->_w - s->_r - s->_ub._size;
     return ret;
 }
 
 int fseek(FILE * stream, long int offset, int origin)
 {
     fake__FILE* s = (fake__FILE*)stream;
+    if(origin == SEEK_CUR)
+        offset -= s->_ub._size;
     s->_ub._size = 0;
+    if(s->_bf._base)
+        __sflush(s);
+    s->_flags &= ~__SEOF;
     int ret = _lseek(__get_fileno(stream), offset, origin);
     __eval_err_return(ret, stream);
     return ret;
@@ -882,21 +1288,94 @@ int fseek(FILE * stream, long int offset, int origin)
 #if !MINLIBC_BUILD_FOR_TEST
 size_t fwrite(const void *data, size_t size, size_t count, FILE *stream)
 {
-	int ret = _write(__get_fileno(stream), (char*)data, size*count);
-    return ret >= 0 ? ret : 0;
+	int ret = __swrite((fake__FILE*)stream, (const char*)data, size*count);
+    return ret > 0 && size ? ret / size : 0;
 }
 
 size_t fread(void *data, size_t size, size_t count, FILE *stream)
 {
-    int ret = _read(__get_fileno(stream), (char*)data, size*count);
-    __eval_io_return(ret, stream);
-    return ret >= 0 ? ret : 0;
+    fake__FILE* s = (fake__FILE*)stream;
+    char* dst = (char*)data;
+    int total = size*count;
+    int got = 0;
+    int n;
+
+    while(got < total && s && s->_ub._size > 0)
+    {
+        s->_ub._size--;
+        dst[got++] = s->_ub._base[s->_ub._size];
+    }
+
+    if(__salloc(s) == EOF)
+    {
+        if(got < total)
+        {
+            n = _read(__get_fileno(stream), dst + got, total - got);
+            __eval_io_return(n, stream);
+            if(n > 0)
+                got += n;
+        }
+    }
+    else
+    {
+        while(got < total)
+        {
+            if(s->_r > 0)
+            {
+                n = s->_r < total - got ? s->_r : total - got;
+                memcpy(dst + got, s->_p, n);
+                s->_p += n;
+                s->_r -= n;
+                got += n;
+            }
+            else if(total - got >= s->_bf._size)
+            {
+                // large reads skip the buffer
+                if(s->_w > 0 && __sflush(s) == EOF)
+                    break;
+                n = _read(__get_fileno(stream), dst + got, total - got);
+                __eval_io_return(n, stream);
+                if(n <= 0)
+                    break;
+                got += n;
+            }
+            else if(__srefill(s) == 0)
+                break;
+        }
+    }
+
+    return size ? got / size : 0;
 }
 #endif
 
-int _fflush(FILE* stream)
+/**
+ * writes out data buffered in the stream, then commits the file to the device.
+ * if stream is NULL, all open streams are flushed.
+ */
+int fflush(FILE* stream)
 {
-    int ret = _fsync(__get_fileno(stream));
+    fake__FILE* s = (fake__FILE*)stream;
+    int ret = 0;
+    short i;
+
+    if(!stream)
+    {
+        for(i = 0; i < FOPEN_MAX; i++)
+        {
+            if(__fstab[i]._flags && fflush((FILE*)&__fstab[i]) == EOF)
+                ret = EOF;
+        }
+        return ret;
+    }
+
+    // not one of ours, eg a stream belonging to the host C library
+    if(s < __fstab || s >= &__fstab[FOPEN_MAX])
+        return EOF;
+
+    if(s->_bf._base)
+        ret = __sflush(s);
+    if(_fsync(__get_fileno(stream)) < 0)
+        ret = EOF;
     __eval_err_return(ret, stream);
     return ret;
 }
@@ -931,7 +1410,12 @@ FILE* tmpfile(void)
     return  NULL;
 }
 
+#ifdef __GLIBC__
+// the host C library declares the parameter as an array
+char* tmpnam(char result[L_tmpnam])
+#else
 char* tmpnam(char *result)
+#endif
 {
     char* buf = result ? result : __tmpnambuf;
     int i = __find_tmpindex();
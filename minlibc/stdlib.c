@@ -41,10 +41,13 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include <math.h>
 #include <ctype.h>
+#include <errno.h>
 #include <minlibc/stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 int atoi(const char* string)
 {
@@ -59,111 +62,759 @@ int atoi(const char* string)
     return result;
 }
 
-double atof(const char* string)
+/**
+ * the significant digits read by the strtod() slow path. halfway points between doubles have
+ * at most 767, so more digits are only needed to break ties, which a sticky flag does.
+ */
+#define STRTOD_MAX_DIGITS           768
+
+/**
+ * the 32 bit limbs of the strtod() slow path numbers. the largest is a halfway point near
+ * the smallest double, times 5^1091, of about 2590 bits.
+ */
+#define STRTOD_LIMBS                84
+
+/**
+ * the error allowed for in the 64 bit mantissa strtod() estimates a value with.
+ */
+#define STRTOD_MARGIN               32
+
+/**
+ * describes a binary floating point format, for the parts of strtod() shared with strtof().
+ */
+typedef struct {
+    int mantissa_bits;      ///< the number of stored mantissa bits.
+    int bias;               ///< the exponent bias.
+    int max_exponent;       ///< the biased exponent of infinity.
+    int sign_bit;           ///< the position of the sign bit.
+    int min_decimal;        ///< decimals below 10^min_decimal round to zero.
+    int max_decimal;        ///< decimals of at least 10^max_decimal round to infinity.
+} float_format_t;
+
+static const float_format_t double_format = {52, 1023, 2047, 63, -324, 309};
+static const float_format_t single_format = {23, 127, 255, 31, -46, 39};
+
+/**
+ * a decimal number as read from a string, the value is digits x 10^exponent.
+ */
+typedef struct {
+    const char* digits;     ///< the first significant digit in the string, may be followed by a '.'
+    int ndigits;            ///< the number of significant digits, including trailing zeros.
+    int exponent;           ///< the decimal exponent of the last significant digit.
+    uint64_t w;             ///< the first 19 significant digits.
+    int w_exponent;         ///< the decimal exponent of the last digit in w.
+    bool w_exact;           ///< set if all the digits after w are zero.
+} decimal_string_t;
+
+typedef struct {
+    uint32_t limbs[STRTOD_LIMBS];
+    int length;
+} bignum_t;
+
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t integer_powers_of_ten[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+    1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+    100000000000000ull, 1000000000000000ull
+};
+
+static const uint64_t powers_of_five[] = {
+    1ull, 5ull, 25ull, 125ull, 625ull, 3125ull, 15625ull, 78125ull, 390625ull, 1953125ull,
+    9765625ull, 48828125ull, 244140625ull, 1220703125ull, 6103515625ull, 30517578125ull,
+    152587890625ull, 762939453125ull, 3814697265625ull, 19073486328125ull, 95367431640625ull,
+    476837158203125ull, 2384185791015625ull, 11920928955078125ull, 59604644775390625ull,
+    298023223876953125ull, 1490116119384765625ull, 7450580596923828125ull
+};
+
+/**
+ * 10^(28k) for k from -13 to 11, as a 64 bit mantissa rounded to nearest, and a binary exponent.
+ */
+static const struct {
+    uint64_t mantissa;
+    int16_t exponent;
+} coarse_powers_of_ten[] = {
+    {0xE1AFA13AFBD14D6Eull, -1273},     // 1e-364
+    {0xE3E27A444D8D98B8ull, -1180},     // 1e-336
+    {0xE61ACF033D1A45DFull, -1087},     // 1e-308
+    {0xE858AD248F5C22CAull, -994},      // 1e-280
+    {0xEA9C227723EE8BCBull, -901},      // 1e-252
+    {0xECE53CEC4A314EBEull, -808},      // 1e-224
+    {0xEF340A98172AACE5ull, -715},      // 1e-196
+    {0xF18899B1BC3F8CA2ull, -622},      // 1e-168
+    {0xF3E2F893DEC3F126ull, -529},      // 1e-140
+    {0xF64335BCF065D37Dull, -436},      // 1e-112
+    {0xF8A95FCF88747D94ull, -343},      // 1e-84
+    {0xFB158592BE068D2Full, -250},      // 1e-56
+    {0xFD87B5F28300CA0Eull, -157},      // 1e-28
+    {0x8000000000000000ull, -63},       // 1e0
+    {0x813F3978F8940984ull, 30},        // 1e28
+    {0x82818F1281ED44A0ull, 123},       // 1e56
+    {0x83C7088E1AAB65DBull, 216},       // 1e84
+    {0x850FADC09923329Eull, 309},       // 1e112
+    {0x865B86925B9BC5C2ull, 402},       // 1e140
+    {0x87AA9AFF79042287ull, 495},       // 1e168
+    {0x88FCF317F22241E2ull, 588},       // 1e196
+    {0x8A5296FFE33CC930ull, 681},       // 1e224
+    {0x8BAB8EEFB6409C1Aull, 774},       // 1e252
+    {0x8D07E33455637EB3ull, 867},       // 1e280
+    {0x8E679C2F5E44FF8Full, 960},       // 1e308
+};
+
+static const float exact_powers_of_ten_f[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+static void bignum_set(bignum_t* n, uint64_t value)
 {
-    double mandiv = 1;
-    const char* mantissa = strchr(string, '.');
+    n->limbs[0] = (uint32_t)value;
+    n->limbs[1] = (uint32_t)(value >> 32);
+    n->length = n->limbs[1] ? 2 : n->limbs[0] ? 1 : 0;
+}
+
+/**
+ * n = (n * mul) + add
+ */
+static void bignum_mul_add(bignum_t* n, uint32_t mul, uint32_t add)
+{
+    uint64_t t = add;
+    int i;
 
-    double result = atoi(string);
-    double manint;
-    if(mantissa)
+    for(i = 0; i < n->length; i++)
     {
-        mantissa++;
-        for(;*mantissa == '0';mantissa++)
-            mandiv *= (double)10;
+        t += (uint64_t)n->limbs[i] * mul;
+        n->limbs[i] = (uint32_t)t;
+        t >>= 32;
+    }
+    if(t && n->length < STRTOD_LIMBS)
+        n->limbs[n->length++] = (uint32_t)t;
+}
 
-        manint = (double)atoi(mantissa);
+static void bignum_mul_pow5(bignum_t* n, int power)
+{
+    while(power >= 13)
+    {
+        bignum_mul_add(n, (uint32_t)powers_of_five[13], 0);
+        power -= 13;
+    }
+    if(power)
+        bignum_mul_add(n, (uint32_t)powers_of_five[power], 0);
+}
 
-        for(;*mantissa; mantissa++)
-            mandiv *= (double)10;
+/**
+ * @retval  limb i of n x 2^shift.
+ */
+static inline uint32_t bignum_shifted_limb(const bignum_t* n, int i, int shift)
+{
+    int word = i - (shift / 32);
+    int bit = shift % 32;
+    uint32_t limb = (word >= 0 && word < n->length) ? n->limbs[word] : 0;
 
-        result += manint / mandiv;
+    if(bit)
+    {
+        limb <<= bit;
+        if(word > 0 && word - 1 < n->length)
+            limb |= n->limbs[word - 1] >> (32 - bit);
     }
-    return result;
+    return limb;
 }
 
-double strtod(const char *string, char **tailptr)
+/**
+ * compares a x 2^a_shift with b x 2^b_shift.
+ *
+ * @retval  less than, equal to, or greater than zero as a is less than, equal to or greater than b.
+ */
+static int bignum_compare(const bignum_t* a, int a_shift, const bignum_t* b, int b_shift)
 {
-    double result = NAN;
-    int mandiv = 1;
-    double manint;
-    const char* mantissa;
+    int common = a_shift < b_shift ? a_shift : b_shift;
+    int i;
+    uint32_t x, y;
 
-    while(isspace((int)*string))
-        string++;
+    a_shift -= common;
+    b_shift -= common;
+    i = (a->length + (a_shift + 31) / 32) > (b->length + (b_shift + 31) / 32) ?
+        a->length + (a_shift + 31) / 32 : b->length + (b_shift + 31) / 32;
 
-    if(*string)
+    for(; i >= 0; i--)
     {
-        mantissa = strchr(string, '.');
-        result = (double)atoi(string);
+        x = bignum_shifted_limb(a, i, a_shift);
+        y = bignum_shifted_limb(b, i, b_shift);
+        if(x != y)
+            return x < y ? -1 : 1;
+    }
+    return 0;
+}
 
-        if(mantissa)
+/**
+ * reads the significant digits of a decimal into a bignum, up to STRTOD_MAX_DIGITS.
+ *
+ * @retval  true if non zero digits were left out.
+ */
+static bool bignum_read_digits(bignum_t* n, const decimal_string_t* dec)
+{
+    const char* s = dec->digits;
+    uint32_t chunk = 0;
+    int chunk_digits = 0;
+    int ndigits = dec->ndigits < STRTOD_MAX_DIGITS ? dec->ndigits : STRTOD_MAX_DIGITS;
+    int i;
+
+    n->length = 0;
+    for(i = 0; i < ndigits; s++)
+    {
+        if(*s == '.')
+            continue;
+        chunk = (chunk * 10) + (*s - '0');
+        i++;
+        if(++chunk_digits == 9)
         {
-            mantissa++;
-            for(;*mantissa == '0';mantissa++)
-                mandiv *= 10;
+            bignum_mul_add(n, 1000000000, chunk);
+            chunk = 0;
+            chunk_digits = 0;
+        }
+    }
+    if(chunk_digits)
+        bignum_mul_add(n, (uint32_t)integer_powers_of_ten[chunk_digits], chunk);
 
-            manint = (double)atoi(mantissa);
+    // the digits left out only matter if they are not all zero
+    for(; i < dec->ndigits; s++)
+    {
+        if(*s == '.')
+            continue;
+        if(*s != '0')
+            return true;
+        i++;
+    }
+    return false;
+}
 
-            for(;*mantissa && !isspace((int)*mantissa); mantissa++)
-                mandiv *= 10;
+/**
+ * finds the correctly rounded value of a decimal, given a close guess.
+ *
+ * the guess is stepped one unit in the last place at a time until the decimal lies between the
+ * halfway points to its neighbours, which are compared with the decimal exactly, in big numbers.
+ * the decimal is digits x 5^exponent x 2^exponent, and a halfway point is an integer h x 2^p, so the
+ * power of five is moved to the side it makes an integer of, and the powers of two are compared as shifts.
+ *
+ * @param   dec is the decimal.
+ * @param   bits is the guess, the bits of a positive value, which may be infinity.
+ * @param   format is the format of the value.
+ * @retval  the bits of the correctly rounded value.
+ */
+static uint64_t __attribute__((noinline)) strtod_slow(const decimal_string_t* dec, uint64_t bits, const float_format_t* format)
+{
+    bignum_t x;
+    bignum_t y;
+    uint64_t infinity = (uint64_t)format->max_exponent << format->mantissa_bits;
+    uint64_t m;
+    uint64_t h;
+    int exponent = dec->exponent + (dec->ndigits > STRTOD_MAX_DIGITS ? dec->ndigits - STRTOD_MAX_DIGITS : 0);
+    int biased;
+    int e;
+    int c;
+    bool sticky;
+
+    // x is the digits, times 5^exponent if that is positive
+    sticky = bignum_read_digits(&x, dec);
+    if(exponent > 0)
+        bignum_mul_pow5(&x, exponent);
+
+    for(;;)
+    {
+        biased = (int)(bits >> format->mantissa_bits);
+        m = bits & ((1ull << format->mantissa_bits) - 1);
+        if(biased == format->max_exponent)
+        {
+            // infinity, when the decimal is at least half way past the largest finite value
+            m = (2ull << format->mantissa_bits) - 1;
+            biased--;
+        }
+        else if(biased)
+            m |= 1ull << format->mantissa_bits;
+        e = (biased ? biased : 1) - format->bias - format->mantissa_bits;
+
+        // compare with the halfway point above, (2m + 1) x 2^(e - 1)
+        h = (2 * m) + 1;
+        bignum_set(&y, h);
+        if(exponent < 0)
+            bignum_mul_pow5(&y, -exponent);
+        c = bignum_compare(&x, exponent, &y, e - 1);
+        if(c == 0 && sticky)
+            c = 1;
+
+        if(bits == infinity)
+        {
+            if(c >= 0)
+                return bits;
+            bits--;
+            continue;
+        }
+        if(c > 0 || (c == 0 && (m & 1)))
+        {
+            bits++;
+            continue;
+        }
+        if(!m)
+            return bits;
 
-            result += manint / mandiv;
+        // compare with the halfway point below, which is closer below a power of two
+        if(m == (1ull << format->mantissa_bits) && biased > 1)
+        {
+            h = (4 * m) - 1;
+            e--;
+        }
+        else
+            h = (2 * m) - 1;
+        bignum_set(&y, h);
+        if(exponent < 0)
+            bignum_mul_pow5(&y, -exponent);
+        c = bignum_compare(&x, exponent, &y, e - 1);
+        if(c == 0 && sticky)
+            c = 1;
+
+        if(c < 0 || (c == 0 && (m & 1)))
+        {
+            bits--;
+            continue;
+        }
+        return bits;
+    }
+}
 
-            string = mantissa;
+/**
+ * multiplies two 64 bit mantissas, keeping the top 64 bits of the product.
+ *
+ * @param   a and b have their top bits set.
+ * @param   exponent is increased by the binary exponent of the result.
+ * @retval  the top 64 bits of the product, with the top bit set, truncated.
+ */
+static uint64_t multiply_mantissas(uint64_t a, uint64_t b, int* exponent)
+{
+    uint64_t lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+    uint64_t hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+    uint64_t lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+    uint64_t hi_hi = (a >> 32) * (b >> 32);
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    uint64_t high = hi_hi + (hi_lo >> 32) + (cross >> 32);
+
+    *exponent += 64;
+    if(!(high >> 63))
+    {
+        high = (high << 1) | ((cross >> 31) & 1);
+        *exponent -= 1;
+    }
+    return high;
+}
 
-            if(tailptr && *string)
-            {
-                while(isspace((int)*string))
-                    string++;
-                *tailptr = (char*)string;
-            }
+/**
+ * rounds a binary number to a floating point format, half to even.
+ *
+ * @param   m is the mantissa.
+ * @param   e is the binary exponent, the value is m x 2^e.
+ * @param   sticky is set if there were non zero bits below m.
+ * @param   format is the format to round to.
+ * @retval  the bits of the positive value, which may be zero or infinity.
+ */
+static uint64_t strtod_round_binary(uint64_t m, int e, bool sticky, const float_format_t* format)
+{
+    int min_e = 1 - format->bias - format->mantissa_bits;
+    int shift;
+    uint64_t half;
+    uint64_t rest;
+    int biased;
+
+    if(!m)
+        return 0;
+    // normalise to the top bit, then find the shift that leaves mantissa_bits + 1 bits
+    while(!(m >> 63))
+    {
+        m <<= 1;
+        e--;
+    }
+    shift = 63 - format->mantissa_bits;
+    if(e + shift < min_e)
+        shift = min_e - e;
+    if(shift > 64)
+        return 0;
+    e += shift;
+
+    if(shift == 64)
+    {
+        rest = m;
+        m = 0;
+    }
+    else
+    {
+        rest = m & ((1ull << shift) - 1);
+        m >>= shift;
+    }
+    half = 1ull << (shift - 1);
+    if(rest > half || (rest == half && (sticky || (m & 1))))
+    {
+        m++;
+        if(m >> (format->mantissa_bits + 1))
+        {
+            m >>= 1;
+            e++;
         }
     }
 
-    return result;
+    if(m >> format->mantissa_bits)
+    {
+        biased = e + format->bias + format->mantissa_bits;
+        if(biased >= format->max_exponent)
+            return (uint64_t)format->max_exponent << format->mantissa_bits;
+        return ((uint64_t)biased << format->mantissa_bits) | (m & ((1ull << format->mantissa_bits) - 1));
+    }
+    // subnormal
+    return m;
 }
 
-float strtof(const char *string, char **tailptr)
+/**
+ * parses an exponent, if there is one. the marker is only taken as the start of an
+ * exponent when digits follow it. exponents are limited to +/-100000.
+ *
+ * @param   string is the string to parse, set to the first character after the exponent.
+ * @param   marker is the lower case character that starts the exponent.
+ * @retval  the exponent, or 0 if there was none.
+ */
+static int strtod_exponent(const char** string, char marker)
 {
-    float result = NAN;
-    int mandiv = 1;
-    float manint;
-    const char* mantissa;
-
-    while(isspace((int)*string))
-        string++;
+    const char* s = *string;
+    int exp = 0;
+    bool negative = false;
+
+    if(tolower((int)*s) != marker)
+        return 0;
+    s++;
+    if(*s == '-' || *s == '+')
+        negative = *s++ == '-';
+    if(!isdigit((int)*s))
+        return 0;
+
+    for(; isdigit((int)*s); s++)
+    {
+        if(exp < 100000)
+            exp = (exp * 10) + (*s - '0');
+    }
+    *string = s;
+    return negative ? -exp : exp;
+}
 
-    if(*string)
+/**
+ * parses a hexadecimal floating point number, after the 0x.
+ *
+ * @param   string is the string to parse, set to the first character after the number.
+ * @param   format is the format to round to.
+ * @param   nonzero is set if the number was not zero.
+ * @retval  the bits of the positive value.
+ */
+static uint64_t strtod_hex(const char** string, const float_format_t* format, bool* nonzero)
+{
+    const char* s = *string;
+    uint64_t m = 0;
+    int e = 0;
+    bool point = false;
+    bool sticky = false;
+    int digit;
+
+    for(;; s++)
     {
-        mantissa = strchr(string, '.');
-        result = (float)atoi(string);
+        if(*s == '.' && !point)
+        {
+            point = true;
+            continue;
+        }
+        if(!isxdigit((int)*s))
+            break;
+        digit = isdigit((int)*s) ? *s - '0' : (tolower((int)*s) - 'a' + 10);
+        if(m >> 60)
+        {
+            // out of bits, these digits only move the point
+            sticky |= digit != 0;
+            if(!point)
+                e += 4;
+        }
+        else
+        {
+            m = (m << 4) | digit;
+            if(point)
+                e -= 4;
+        }
+    }
+    e += strtod_exponent(&s, 'p');
+    *string = s;
+    *nonzero = m != 0;
+    return strtod_round_binary(m, e, sticky, format);
+}
 
-        if(mantissa)
+/**
+ * parses the digits and exponent of a decimal number.
+ *
+ * @retval  false if there were no digits.
+ */
+static bool strtod_decimal(const char** string, decimal_string_t* dec)
+{
+    const char* s = *string;
+    bool point = false;
+    bool any = false;
+    int fraction_digits = 0;
+    int w_digits = 0;
+
+    dec->digits = NULL;
+    dec->ndigits = 0;
+    dec->w = 0;
+    dec->w_exact = true;
+
+    for(;; s++)
+    {
+        if(*s == '.' && !point)
+        {
+            point = true;
+            continue;
+        }
+        if(!isdigit((int)*s))
+            break;
+        any = true;
+        if(point)
+            fraction_digits++;
+        if(!dec->ndigits && *s == '0')
+            continue;
+
+        if(!dec->ndigits)
+            dec->digits = s;
+        dec->ndigits++;
+        if(w_digits < 19)
         {
-            mantissa++;
-            for(;*mantissa == '0';mantissa++)
-                mandiv *= 10;
+            dec->w = (dec->w * 10) + (*s - '0');
+            w_digits++;
+        }
+        else if(*s != '0')
+            dec->w_exact = false;
+    }
+    if(!any)
+        return false;
 
-            manint = (float)atoi(mantissa);
+    dec->exponent = strtod_exponent(&s, 'e') - fraction_digits;
+    *string = s;
+    dec->w_exponent = dec->exponent + (dec->ndigits - w_digits);
+    return true;
+}
 
-            for(;*mantissa && !isspace((int)*mantissa); mantissa++)
-                mandiv *= 10;
+/**
+ * parses inf, infinity, nan or nan(...), not case sensitive.
+ *
+ * @retval  1 for infinity, 2 for nan, 0 if it was neither.
+ */
+static int strtod_special(const char** string)
+{
+    const char* s = *string;
 
-            result += manint / mandiv;
+    if(!strncasecmp(s, "inf", 3))
+    {
+        s += 3;
+        if(!strncasecmp(s, "inity", 5))
+            s += 5;
+        *string = s;
+        return 1;
+    }
+    if(!strncasecmp(s, "nan", 3))
+    {
+        s += 3;
+        if(*s == '(')
+        {
+            const char* t = s + 1;
+            while(isalnum((int)*t) || *t == '_')
+                t++;
+            if(*t == ')')
+                s = t + 1;
+        }
+        *string = s;
+        return 2;
+    }
+    return 0;
+}
 
-            string = mantissa;
+/**
+ * sets errno to ERANGE if a non zero number rounded to zero, a subnormal or infinity.
+ */
+static void strtod_check_range(uint64_t bits, const float_format_t* format)
+{
+    if(!(bits >> format->mantissa_bits) || bits == ((uint64_t)format->max_exponent << format->mantissa_bits))
+        errno = ERANGE;
+}
 
-            if(tailptr && *string)
-            {
-                while(isspace((int)*string))
-                    string++;
-                *tailptr = (char*)string;
-            }
+/**
+ * converts a decimal number to the given format.
+ *
+ * @retval  the bits of the positive value.
+ */
+static uint64_t strtod_convert(const decimal_string_t* dec, const float_format_t* format)
+{
+    int e = dec->w_exponent;
+    int binary_exponent;
+    int shift;
+    int k;
+    int r;
+    double d;
+    float f;
+    uint32_t fbits;
+    uint64_t bits;
+    uint64_t upper;
+    uint64_t m;
+
+    if(!dec->ndigits || dec->ndigits + dec->exponent <= format->min_decimal)
+        return 0;
+    if(dec->ndigits + dec->exponent > format->max_decimal)
+        return (uint64_t)format->max_exponent << format->mantissa_bits;
+
+    if(dec->w_exact && format == &single_format)
+    {
+        // exact operands and a single rounding, so the result is correct
+        if(dec->w <= (1 << 24) && e >= -10 && e <= 10)
+        {
+            f = (float)dec->w;
+            f = e < 0 ? f / exact_powers_of_ten_f[-e] : f * exact_powers_of_ten_f[e];
+            memcpy(&fbits, &f, sizeof(f));
+            return fbits;
+        }
+    }
+    else if(dec->w_exact)
+    {
+        if(dec->w <= (1ull << 53) && e >= -22 && e <= 22)
+        {
+            d = (double)dec->w;
+            d = e < 0 ? d / exact_powers_of_ten[-e] : d * exact_powers_of_ten[e];
+            memcpy(&bits, &d, sizeof(d));
+            return bits;
+        }
+        // 123e30 is 12300000000e22, which is still exact
+        if(e > 22 && e <= 22 + 15 && dec->w <= (1ull << 53) / integer_powers_of_ten[e - 22])
+        {
+            d = (double)(dec->w * integer_powers_of_ten[e - 22]) * exact_powers_of_ten[22];
+            memcpy(&bits, &d, sizeof(d));
+            return bits;
         }
     }
 
-    return result;
+    // w x 10^e to 64 bits, from w x 5^r x 2^r x 10^28k. each step is out by no more than a few units
+    // in the last place, and w by one more if digits were left out of it, which the margin covers.
+    // the result is correctly rounded if both ends of the margin round the same way.
+    shift = __builtin_clzll(dec->w);
+    m = dec->w << shift;
+    binary_exponent = -shift;
+    k = (e >= 0 ? e : e - 27) / 28;
+    r = e - (k * 28);
+    if(r)
+    {
+        shift = __builtin_clzll(powers_of_five[r]);
+        m = multiply_mantissas(m, powers_of_five[r] << shift, &binary_exponent);
+        binary_exponent += r - shift;
+    }
+    if(k)
+    {
+        m = multiply_mantissas(m, coarse_powers_of_ten[k + 13].mantissa, &binary_exponent);
+        binary_exponent += coarse_powers_of_ten[k + 13].exponent;
+    }
+
+    bits = strtod_round_binary(m - STRTOD_MARGIN, binary_exponent, false, format);
+    if(m > UINT64_MAX - STRTOD_MARGIN)
+        upper = strtod_round_binary(1ull << 63, binary_exponent + 1, false, format);
+    else
+        upper = strtod_round_binary(m + STRTOD_MARGIN, binary_exponent, false, format);
+    if(bits == upper)
+        return bits;
+
+    return strtod_slow(dec, bits, format);
+}
+
+/**
+ * parses a floating point number into the given format.
+ *
+ * @retval  the bits of the value, including the sign.
+ */
+static uint64_t strtod_parse(const char* string, char** tailptr, const float_format_t* format)
+{
+    const char* s = string;
+    decimal_string_t dec;
+    uint64_t infinity = (uint64_t)format->max_exponent << format->mantissa_bits;
+    uint64_t bits;
+    bool negative;
+    bool nonzero;
+    int special;
+
+    while(isspace((int)*s))
+        s++;
+    negative = *s == '-';
+    if(*s == '-' || *s == '+')
+        s++;
+
+    if((special = strtod_special(&s)))
+        bits = special == 1 ? infinity : infinity | (1ull << (format->mantissa_bits - 1));
+    else if(s[0] == '0' && (s[1] == 'x' || s[1] == 'X') && (isxdigit((int)s[2]) || (s[2] == '.' && isxdigit((int)s[3]))))
+    {
+        s += 2;
+        bits = strtod_hex(&s, format, &nonzero);
+        if(nonzero)
+            strtod_check_range(bits, format);
+    }
+    else if(strtod_decimal(&s, &dec))
+    {
+        bits = strtod_convert(&dec, format);
+        if(dec.ndigits)
+            strtod_check_range(bits, format);
+    }
+    else
+    {
+        if(tailptr)
+            *tailptr = (char*)string;
+        return 0;
+    }
+
+    if(tailptr)
+        *tailptr = (char*)s;
+    return bits | ((uint64_t)negative << format->sign_bit);
+}
+
+double atof(const char* string)
+{
+    return strtod(string, NULL);
+}
+
+/**
+ * converts a string to a double, correctly rounded.
+ *
+ * accepts leading white space, a sign, then a decimal number with an optional exponent,
+ * a hexadecimal number starting with 0x with an optional binary exponent, inf, infinity, nan or nan(...).
+ * numbers of up to 15 significant digits, and up to 22 in the exponent, are converted with one
+ * rounded multiply or divide. others are estimated with 64 bit mantissas, which decides the rounding
+ * unless the value is very close to half way between two doubles. those are decided by comparing big numbers.
+ *
+ * @param   string is the string to convert.
+ * @param   tailptr, if not NULL, is set to the first character after the number, or to string if
+ *          there was no number.
+ * @retval  the value, or 0 if there was no number. on overflow HUGE_VAL is returned and errno
+ *          is set to ERANGE, on underflow a zero or subnormal value is returned and errno is set to ERANGE.
+ */
+double strtod(const char *string, char **tailptr)
+{
+    uint64_t bits = strtod_parse(string, tailptr, &double_format);
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+/**
+ * converts a string to a float, correctly rounded. see strtod().
+ */
+float strtof(const char *string, char **tailptr)
+{
+    uint32_t bits = (uint32_t)strtod_parse(string, tailptr, &single_format);
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
 }
 
 char* getenv(const char* name)
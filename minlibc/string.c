@@ -41,9 +41,53 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include "strutils.h"
 #include "minlibc/string.h"
 
+/**
+ * the memory and string scanning functions work a machine word at a time where they can,
+ * 32 bits on the Cortex-M targets. word_t may alias any other type.
+ */
+typedef unsigned long __attribute__((__may_alias__)) word_t;
+
+#define WSIZE           sizeof(word_t)
+#define WMASK           (WSIZE - 1)
+#define unaligned(p)    ((uintptr_t)(p) & WMASK)
+/**
+ * 0x01010101 and 0x80808080 for a 32 bit word.
+ */
+#define ONES            ((word_t)-1 / 0xff)
+#define HIGHS           (ONES * 0x80)
+/**
+ * nonzero when any byte in the word x is zero.
+ */
+#define haszero(x)      (((x) - ONES) & ~(x) & HIGHS)
+/**
+ * below this length the byte loops win over setting up a word loop.
+ */
+#define WORD_THRESHOLD  (2 * WSIZE)
+
+/**
+ * merges two aligned source words into the misaligned word that starts
+ * rs bits into the first of them.
+ */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define merge(lo, hi, rs, ls)   (((lo) << (rs)) | ((hi) >> (ls)))
+#else
+#define merge(lo, hi, rs, ls)   (((lo) >> (rs)) | ((hi) << (ls)))
+#endif
+
+/**
+ * stops gcc from turning the copy and fill loops below into calls to memcpy() and memset(),
+ * which would recurse.
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+#define NO_LIBCALLS __attribute__((optimize("no-tree-loop-distribute-patterns")))
+#else
+#define NO_LIBCALLS
+#endif
+
 const char* __errno_strings[] = {
     "UNKNOWN (0)",
     "EPERM (1) Operation not permitted",
@@ -182,15 +226,26 @@ const char* __errno_strings[] = {
 
 
 
-size_t strlen(const char* str)
+/**
+ * note: the word loop may read past the terminator, but never past the aligned word
+ * that holds it, so never off the end of a page or memory region.
+ */
+NO_LIBCALLS size_t strlen(const char* str)
 {
-    size_t len = 0;
-    while(*str)
+    const char* s = str;
+    const word_t* w;
+
+    for(; unaligned(s); s++)
     {
-        len++;
-        str++;
+        if(!*s)
+            return s - str;
     }
-    return len;
+
+    for(w = (const word_t*)s; !haszero(*w); w++);
+
+    for(s = (const char*)w; *s; s++);
+
+    return s - str;
 }
 
 int strcmp(const char* str1, const char* str2)
@@ -253,39 +308,91 @@ char* strerror(int errnum)
     return (char*)__errno_strings[errnum];
 }
 
-char* strchr(const char* src, int character)
+NO_LIBCALLS char* strchr(const char* src, int character)
 {
-    while(*src && ((const char)character) != *src)
-        src++;
-    return ((const char)character) == *src ? (char*)src : (char*)NULL;
+    const unsigned char* s = (const unsigned char*)src;
+    const unsigned char c = (unsigned char)character;
+    const word_t* w;
+    word_t k;
+
+    for(; unaligned(s); s++)
+    {
+        if(*s == c)
+            return (char*)s;
+        if(!*s)
+            return (char*)NULL;
+    }
+
+    k = ONES * c;
+    for(w = (const word_t*)s; !haszero(*w) && !haszero(*w ^ k); w++);
+
+    for(s = (const unsigned char*)w; *s && *s != c; s++);
+
+    return *s == c ? (char*)s : (char*)NULL;
 }
 
+/**
+ * a bit for each byte value, for the span functions.
+ */
+#define BYTESET_WORDS           (256 / (8 * WSIZE))
+#define byteset_add(set, c)     ((set)[(c) / (8 * WSIZE)] |= (word_t)1 << ((c) % (8 * WSIZE)))
+#define byteset_has(set, c)     ((set)[(c) / (8 * WSIZE)] & ((word_t)1 << ((c) % (8 * WSIZE))))
+
+static void __byteset_fill(word_t* set, const unsigned char* chars)
+{
+    int i;
+
+    for(i = 0; i < (int)BYTESET_WORDS; i++)
+        set[i] = 0;
+    for(; *chars; chars++)
+        byteset_add(set, *chars);
+}
+
+/**
+ * the span functions look each byte up in a bitmap of the set, rather than scanning the set for it.
+ * single character sets skip the bitmap.
+ */
 size_t strspn(const char* string, const char* skipset)
 {
-    const char* s;
-    size_t len = 0;
-    while(*string)
+    const unsigned char* s = (const unsigned char*)string;
+    word_t set[BYTESET_WORDS];
+
+    if(!skipset[0])
+        return 0;
+
+    if(!skipset[1])
     {
-        for(s=skipset; *s && *s != *string; s++);
-        if(!*s)
-            break;
-        len++;
-        string++;
+        for(; *s == (unsigned char)skipset[0]; s++);
+        return s - (const unsigned char*)string;
     }
-    return len;
+
+    // the terminator is never in the set, so stops the loop
+    __byteset_fill(set, (const unsigned char*)skipset);
+    for(; byteset_has(set, *s); s++);
+    return s - (const unsigned char*)string;
 }
 
-char* strpbrk(const char*string, const char*stopset)
+size_t strcspn(const char* string, const char* stopset)
 {
-    const char* s;
-    while(*string)
+    const unsigned char* s = (const unsigned char*)string;
+    word_t set[BYTESET_WORDS];
+
+    if(!stopset[0] || !stopset[1])
     {
-        for(s=stopset; *s && *s != *string; s++);
-        if(*s)
-            return (char*)string;
-        string++;
+        s = (const unsigned char*)strchr(string, stopset[0]);
+        return s ? (size_t)(s - (const unsigned char*)string) : strlen(string);
     }
-    return (char*)NULL;
+
+    __byteset_fill(set, (const unsigned char*)stopset);
+    byteset_add(set, 0);
+    for(; !byteset_has(set, *s); s++);
+    return s - (const unsigned char*)string;
+}
+
+char* strpbrk(const char* string, const char* stopset)
+{
+    string += strcspn(string, stopset);
+    return *string ? (char*)string : (char*)NULL;
 }
 
 /*
@@ -296,76 +403,440 @@ int strcoll(const char *s1, const char *s2)
     return strcmp(s1, s2);
 }
 
-char* strstr(const char *haystack, const char *needle)
+/**
+ * the Two-Way search of Crochemore and Perrin, used by strstr() and memmem().
+ * it runs in linear time with constant space, and skips through the haystack by the
+ * Boyer-Moore-Horspool bad character shift of its last byte under the needle, so is
+ * usually sub-linear for longer needles.
+ *
+ * @param   h is the haystack.
+ * @param   z is the end of the haystack.
+ * @param   terminated is true if the haystack ends with a terminator, and z is only how
+ *          far that is known not to be. z is then moved on as the search needs it.
+ * @param   n is the needle, at least 2 bytes.
+ * @param   l is the length of the needle.
+ * @retval  the first match, or NULL if there is none.
+ */
+static void* __two_way(const unsigned char* h, const unsigned char* z, bool terminated, const unsigned char* n, size_t l)
 {
-    const char* s;
-    const char* h;
+    uint8_t shift[256];
+    size_t ip, jp, k, p, ms, p0, mem, mem0;
+    size_t grow;
+    const unsigned char* end;
 
-    if(!*needle)
-        return (char*)haystack;
+    // the distance from the last occurrence of each byte in the needle to its end,
+    // capped to fit a byte, which only makes some shifts shorter than they could be
+    memset(shift, l < 255 ? (int)l : 255, sizeof(shift));
+    for(k = 0; k < l; k++)
+        shift[n[k]] = (l - 1 - k) < 255 ? (uint8_t)(l - 1 - k) : 255;
 
+    // the critical factorisation, from the maximal suffixes in both orderings
+    ip = (size_t)-1;
+    jp = 0;
+    k = p = 1;
+    while(jp + k < l)
+    {
+        if(n[ip + k] == n[jp + k])
+        {
+            if(k == p)
+            {
+                jp += p;
+                k = 1;
+            }
+            else
+                k++;
+        }
+        else if(n[ip + k] > n[jp + k])
+        {
+            jp += k;
+            k = 1;
+            p = jp - ip;
+        }
+        else
+        {
+            ip = jp++;
+            k = p = 1;
+        }
+    }
+    ms = ip;
+    p0 = p;
 
-    while(*haystack)
+    ip = (size_t)-1;
+    jp = 0;
+    k = p = 1;
+    while(jp + k < l)
     {
-        h = haystack;
-        s = needle;
-        while(*s && *h)
+        if(n[ip + k] == n[jp + k])
         {
-            if(!*s)
-                return (char*)haystack;
-            if(*s == *h)
+            if(k == p)
             {
-                s++;
-                h++;
+                jp += p;
+                k = 1;
             }
             else
-                break;
+                k++;
+        }
+        else if(n[ip + k] < n[jp + k])
+        {
+            jp += k;
+            k = 1;
+            p = jp - ip;
         }
-        haystack++;
+        else
+        {
+            ip = jp++;
+            k = p = 1;
+        }
+    }
+    if(ip + 1 > ms + 1)
+        ms = ip;
+    else
+        p = p0;
+
+    // a periodic needle remembers how much of the last match still holds after a shift
+    if(memcmp(n, n + p, ms + 1))
+    {
+        mem0 = 0;
+        p = (ms > l - ms - 1 ? ms : l - ms - 1) + 1;
+    }
+    else
+        mem0 = l - p;
+    mem = 0;
+
+    for(;;)
+    {
+        if((size_t)(z - h) < l)
+        {
+            if(!terminated)
+                return NULL;
+            grow = l | 63;
+            end = (const unsigned char*)memchr(z, 0, grow);
+            if(end)
+            {
+                z = end;
+                terminated = false;
+                if((size_t)(z - h) < l)
+                    return NULL;
+            }
+            else
+                z += grow;
+        }
+
+        k = shift[h[l - 1]];
+        if(k)
+        {
+            h += k < mem ? mem : k;
+            mem = 0;
+            continue;
+        }
+
+        // the right half of the needle, then the left
+        for(k = ms + 1 > mem ? ms + 1 : mem; k < l && n[k] == h[k]; k++);
+        if(k < l)
+        {
+            h += k - ms;
+            mem = 0;
+            continue;
+        }
+        for(k = ms + 1; k > mem && n[k - 1] == h[k - 1]; k--);
+        if(k <= mem)
+            return (void*)h;
+        h += p;
+        mem = mem0;
+    }
+}
+
+/**
+ * finds needles of 2 to 4 bytes by hopping between occurrences of their first byte with strchr(),
+ * which searches a word at a time, and comparing the rest. that is no worse than 4 compares
+ * a byte, which beats setting up the Two-Way search for them.
+ */
+static char* __short_strstr(const char* h, const char* n)
+{
+    for(; h; h = strchr(h + 1, n[0]))
+    {
+        if(h[1] != n[1])
+        {
+            if(!h[1])
+                return NULL;
+            continue;
+        }
+        if(!n[2])
+            return (char*)h;
+        if(h[2] != n[2])
+        {
+            if(!h[2])
+                return NULL;
+            continue;
+        }
+        if(!n[3] || h[3] == n[3])
+            return (char*)h;
+        if(!h[3])
+            return NULL;
     }
     return NULL;
 }
 
-void* memcpy(void* dst, const void* src, size_t len)
+char* strstr(const char* haystack, const char* needle)
+{
+    size_t l;
+
+    if(!needle[0])
+        return (char*)haystack;
+
+    haystack = strchr(haystack, needle[0]);
+    if(!haystack || !needle[1])
+        return (char*)haystack;
+
+    l = strlen(needle);
+    if(l <= 4)
+        return __short_strstr(haystack, needle);
+
+    return (char*)__two_way((const unsigned char*)haystack, (const unsigned char*)haystack, true,
+                            (const unsigned char*)needle, l);
+}
+
+/**
+ * copies len bytes from the lowest address up.
+ * safe for overlapping regions where dst is below src, which memmove() relies on.
+ */
+static NO_LIBCALLS void __copy_forward(unsigned char* d, const unsigned char* s, size_t len)
 {
-    char* d = (char*)dst;
-    char* s = (char*)src;
+    word_t* dw;
+    const word_t* sw;
+
+    if(len >= WORD_THRESHOLD)
+    {
+        for(; unaligned(d); len--)
+            *d++ = *s++;
+
+        dw = (word_t*)d;
+
+        if(!unaligned(s))
+        {
+            sw = (const word_t*)s;
+            for(; len >= 4 * WSIZE; len -= 4 * WSIZE)
+            {
+                dw[0] = sw[0];
+                dw[1] = sw[1];
+                dw[2] = sw[2];
+                dw[3] = sw[3];
+                dw += 4;
+                sw += 4;
+            }
+            for(; len >= WSIZE; len -= WSIZE)
+                *dw++ = *sw++;
+            s = (const unsigned char*)sw;
+        }
+        else
+        {
+            // source is misaligned against the destination, read aligned words
+            // and shift them into place rather than falling back to bytes.
+            const unsigned int rs = unaligned(s) * 8;
+            const unsigned int ls = WSIZE * 8 - rs;
+            word_t lo, hi;
+
+            sw = (const word_t*)(s - unaligned(s));
+            lo = *sw++;
+            for(; len >= WSIZE; len -= WSIZE)
+            {
+                hi = *sw++;
+                *dw++ = merge(lo, hi, rs, ls);
+                lo = hi;
+            }
+            s += (unsigned char*)dw - d;
+        }
+
+        d = (unsigned char*)dw;
+    }
+
     while(len--)
         *d++ = *s++;
-    return dst;
 }
 
-void* memset(void* dst, int num, size_t len)
+/**
+ * copies len bytes from the highest address down.
+ * safe for overlapping regions where dst is above src.
+ */
+static NO_LIBCALLS void __copy_backward(unsigned char* d, const unsigned char* s, size_t len)
 {
-    char* d = (char*)dst;
+    word_t* dw;
+    const word_t* sw;
+
+    d += len;
+    s += len;
+
+    if(len >= WORD_THRESHOLD && unaligned(d) == unaligned(s))
+    {
+        for(; unaligned(d); len--)
+            *--d = *--s;
+
+        dw = (word_t*)d;
+        sw = (const word_t*)s;
+        for(; len >= WSIZE; len -= WSIZE)
+            *--dw = *--sw;
+
+        d = (unsigned char*)dw;
+        s = (const unsigned char*)sw;
+    }
+
     while(len--)
-        *d++ = (char)num;
+        *--d = *--s;
+}
+
+void* memcpy(void* dst, const void* src, size_t len)
+{
+    __copy_forward((unsigned char*)dst, (const unsigned char*)src, len);
+    return dst;
+}
+
+void* memmove(void* dst, const void* src, size_t len)
+{
+    // dst below src, or no overlap at all, copies forward
+    if((uintptr_t)dst - (uintptr_t)src >= len)
+        __copy_forward((unsigned char*)dst, (const unsigned char*)src, len);
+    else
+        __copy_backward((unsigned char*)dst, (const unsigned char*)src, len);
     return dst;
 }
 
-int memcmp(const void* p1, const void* p2, size_t len)
+NO_LIBCALLS void* memset(void* dst, int num, size_t len)
 {
-    const char* tp1 = (const char*)p1;
-    const char* tp2 = (const char*)p2;
+    unsigned char* d = (unsigned char*)dst;
+    const unsigned char c = (unsigned char)num;
+    word_t* dw;
+    word_t w;
+
+    if(len >= WORD_THRESHOLD)
+    {
+        for(; unaligned(d); len--)
+            *d++ = c;
+
+        w = ONES * c;
+        dw = (word_t*)d;
+        for(; len >= 4 * WSIZE; len -= 4 * WSIZE)
+        {
+            dw[0] = w;
+            dw[1] = w;
+            dw[2] = w;
+            dw[3] = w;
+            dw += 4;
+        }
+        for(; len >= WSIZE; len -= WSIZE)
+            *dw++ = w;
+
+        d = (unsigned char*)dw;
+    }
+
     while(len--)
+        *d++ = c;
+
+    return dst;
+}
+
+/**
+ * compares whole words while they match, the bytes of the first mismatching
+ * word are then compared one by one to get the sign right.
+ * bytes compare as unsigned char, as the standard requires.
+ */
+NO_LIBCALLS int memcmp(const void* p1, const void* p2, size_t len)
+{
+    const unsigned char* a = (const unsigned char*)p1;
+    const unsigned char* b = (const unsigned char*)p2;
+    const word_t* aw;
+    const word_t* bw;
+
+    if(len >= WORD_THRESHOLD && unaligned(a) == unaligned(b))
+    {
+        for(; unaligned(a); a++, b++, len--)
+        {
+            if(*a != *b)
+                return (int)*a - (int)*b;
+        }
+
+        aw = (const word_t*)a;
+        bw = (const word_t*)b;
+        for(; len >= WSIZE && *aw == *bw; len -= WSIZE)
+        {
+            aw++;
+            bw++;
+        }
+
+        a = (const unsigned char*)aw;
+        b = (const unsigned char*)bw;
+    }
+
+    for(; len; a++, b++, len--)
     {
-        if(*tp1 != *tp2)
-            return (int)(*tp1 - *tp2);
-        tp1++;
-        tp2++;
+        if(*a != *b)
+            return (int)*a - (int)*b;
     }
+
     return 0;
 }
 
-void* memchr(const void *block, int c, size_t size)
+NO_LIBCALLS void* memchr(const void *block, int c, size_t size)
 {
-    const char* bl = (const char*)block;
-    while(size && ((const char)c) != *bl)
+    const unsigned char* s = (const unsigned char*)block;
+    const unsigned char ch = (unsigned char)c;
+    const word_t* w;
+    word_t k;
+
+    for(; size && unaligned(s); s++, size--)
+    {
+        if(*s == ch)
+            return (void*)s;
+    }
+
+    if(size >= WSIZE)
+    {
+        k = ONES * ch;
+        for(w = (const word_t*)s; size >= WSIZE && !haszero(*w ^ k); w++)
+            size -= WSIZE;
+        s = (const unsigned char*)w;
+    }
+
+    for(; size; s++, size--)
     {
-        bl++;
-        size--;
+        if(*s == ch)
+            return (void*)s;
     }
-    return ((const char)c) == *bl ? (void*)bl : (void*)NULL;
+
+    return NULL;
+}
+
+void* memmem(const void* haystack, size_t haystack_len, const void* needle, size_t needle_len)
+{
+    const unsigned char* h;
+    const unsigned char* last;
+
+    if(!needle_len)
+        return (void*)haystack;
+    if(needle_len > haystack_len)
+        return NULL;
+
+    h = (const unsigned char*)memchr(haystack, *(const unsigned char*)needle, haystack_len - needle_len + 1);
+    if(!h || needle_len == 1)
+        return (void*)h;
+
+    // short needles hop between occurrences of their first byte, like strstr()
+    if(needle_len <= 4)
+    {
+        last = (const unsigned char*)haystack + haystack_len - needle_len;
+        for(;;)
+        {
+            if(!memcmp(h + 1, (const unsigned char*)needle + 1, needle_len - 1))
+                return (void*)h;
+            if(h == last)
+                return NULL;
+            h = (const unsigned char*)memchr(h + 1, *(const unsigned char*)needle, last - h);
+            if(!h)
+                return NULL;
+        }
+    }
+
+    return __two_way(h, (const unsigned char*)haystack + haystack_len, false,
+                     (const unsigned char*)needle, needle_len);
 }
 
 /**
@@ -56,6 +56,7 @@ int recvfrom(int socket, void *buffer, size_t size, int flags, struct sockaddr *
 int send(int socket, const void *buffer, size_t size, int flags);
 int sendto(int socket, const void *buffer, size_t size, int flags, struct sockaddr *addr, socklen_t length);
 int ioctlsocket(int socket, int cmd, void* argp);
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout);
 #else
 
 #define accept(a,b,c)         lwip_accept(a,b,c)
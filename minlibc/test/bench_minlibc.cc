@@ -0,0 +1,409 @@
+/*
+ * bench_minlibc.cc
+ *
+ * timing for the minlibc formatting, string, conversion and time functions,
+ * minlibc against the host C library. built with "make bench", see Makefile.
+ *
+ * the figures are nanoseconds per call on the host, they are only good for comparing
+ * one build of minlibc against another (or against the host C library) on the same machine.
+ *
+ * usage: bench_minlibc [--json]
+ *
+ * --json prints the results as a JSON array instead of a table, one object per benchmark:
+ *  {"name": "memcpy", "variant": "dst+1 src+3", "size": 512, "minlibc_ns": 43.1, "host_ns": 12.7}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+/*
+ * the minlibc functions, built with their symbols renamed
+ * so that they sit alongside the host C library (see Makefile).
+ */
+extern "C" {
+int minlibc_sprintf(char* buf, const char* fmt, ...);
+int minlibc_snprintf(char* buf, size_t size, const char* fmt, ...);
+int minlibc_printf(const char* fmt, ...);
+void* minlibc_memcpy(void* dst, const void* src, size_t len);
+void* minlibc_memset(void* dst, int num, size_t len);
+size_t minlibc_strlen(const char* str);
+char* minlibc_strstr(const char* haystack, const char* needle);
+void* minlibc_memmem(const void* haystack, size_t haystack_len, const void* needle, size_t needle_len);
+size_t minlibc_strspn(const char* string, const char* skipset);
+size_t minlibc_strcspn(const char* string, const char* stopset);
+char* minlibc_strpbrk(const char* string, const char* stopset);
+int minlibc_atoi(const char* string);
+double minlibc_atof(const char* string);
+double minlibc_strtod(const char* string, char** tailptr);
+float minlibc_strtof(const char* string, char** tailptr);
+struct tm* minlibc_gmtime(const time_t* time);
+struct tm* minlibc_gmtime_r(const time_t* time, struct tm* result);
+time_t minlibc_mktime(struct tm* brokentime);
+size_t minlibc_strftime(char* s, size_t size, const char* t, const struct tm* brokentime);
+
+/*
+ * minlibc stdio assigns its streams to these, and writes through the functions below.
+ * output goes nowhere.
+ */
+FILE* minlibc_stdin;
+FILE* minlibc_stdout;
+FILE* minlibc_stderr;
+int _write(int file, char* buf, unsigned int count) { (void)file; (void)buf; return count; }
+int _read(int file, char* buf, unsigned int count) { (void)file; (void)buf; (void)count; return -1; }
+long int _ftell(int file) { (void)file; return 0; }
+int _lseek(int file, int offset, int whence) { (void)file; (void)offset; (void)whence; return 0; }
+int _open(const char* name, int flags, int mode) { (void)name; (void)flags; (void)mode; return -1; }
+int _close(int file) { (void)file; return 0; }
+int _unlink(char* name) { (void)name; return -1; }
+int _rename(const char* oldname, const char* newname) { (void)oldname; (void)newname; return -1; }
+int _fsync(int file) { (void)file; return 0; }
+int _fstat(int file, struct stat* st) { (void)file; memset(st, 0, sizeof(struct stat)); st->st_mode = S_IFCHR; return 0; }
+}
+
+// each measurement repeats the call until at least this much time has passed
+#define BENCH_MIN_NS        (20 * 1000 * 1000)
+#define MAX_RESULTS         256
+#define MAX_ALIGN           16
+#define MAX_SIZE            4096
+
+typedef struct {
+    const char* name;
+    const char* variant;
+    size_t size;
+    double minlibc_ns;
+    double host_ns;
+} result_t;
+
+static result_t results[MAX_RESULTS];
+static int result_count;
+
+// results are stored here so the calls can't be optimised away
+static volatile uintptr_t bench_sink;
+
+static uint64_t now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+static void record(const char* name, const char* variant, size_t size, double minlibc_ns, double host_ns)
+{
+    if(result_count < MAX_RESULTS)
+        results[result_count++] = (result_t){name, variant, size, minlibc_ns, host_ns};
+}
+
+/*
+ * doubles the iteration count until the loop runs for at least BENCH_MIN_NS,
+ * then stores the time per call in ns_per_op.
+ */
+#define TIME_CALL(ns_per_op, call)                                  \
+    do {                                                            \
+        uint64_t start, elapsed;                                    \
+        size_t n, iterations = 16;                                  \
+        for(;;) {                                                   \
+            start = now_ns();                                       \
+            for(n = 0; n < iterations; n++) {                       \
+                bench_sink = (uintptr_t)(call);                     \
+                asm volatile("" ::: "memory");                      \
+            }                                                       \
+            elapsed = now_ns() - start;                             \
+            if(elapsed >= BENCH_MIN_NS)                             \
+                break;                                              \
+            iterations *= 2;                                        \
+        }                                                           \
+        ns_per_op = (double)elapsed / iterations;                   \
+    } while(0)
+
+#define BENCH(name, variant, size, minlibc_call, host_call)         \
+    do {                                                            \
+        double minlibc_ns, host_ns;                                 \
+        TIME_CALL(minlibc_ns, minlibc_call);                        \
+        TIME_CALL(host_ns, host_call);                              \
+        record(name, variant, size, minlibc_ns, host_ns);           \
+    } while(0)
+
+static unsigned char bench_a[MAX_SIZE + MAX_ALIGN] __attribute__((aligned(16)));
+static unsigned char bench_b[MAX_SIZE + MAX_ALIGN] __attribute__((aligned(16)));
+static char text[256];
+
+static const size_t sizes[] = {8, 64, 512, 4096};
+#define SIZE_COUNT          (sizeof(sizes)/sizeof(sizes[0]))
+
+static void bench_formatting()
+{
+    // host printf() output is sent to /dev/null, minlibc printf() output to the _write() above
+    FILE* devnull = fopen("/dev/null", "w");
+
+    BENCH("sprintf", "%d", 0,
+            minlibc_sprintf(text, "%d", -1234567),
+            sprintf(text, "%d", -1234567));
+    BENCH("sprintf", "%s %d %x %c %u", 0,
+            minlibc_sprintf(text, "%s %d %x %c %u", "name", 42, 0xbeef, 'z', 3000000000u),
+            sprintf(text, "%s %d %x %c %u", "name", 42, 0xbeef, 'z', 3000000000u));
+    BENCH("sprintf", "%08d %-10s %5x", 0,
+            minlibc_sprintf(text, "%08d %-10s %5x", 1234, "pad", 0xab),
+            sprintf(text, "%08d %-10s %5x", 1234, "pad", 0xab));
+    BENCH("sprintf", "%u", 0,
+            minlibc_sprintf(text, "%u", 3000000000u),
+            sprintf(text, "%u", 3000000000u));
+    BENCH("sprintf", "%x", 0,
+            minlibc_sprintf(text, "%x", 0xdeadbeefu),
+            sprintf(text, "%x", 0xdeadbeefu));
+    BENCH("sprintf", "%f", 0,
+            minlibc_sprintf(text, "%f", 3.14159265),
+            sprintf(text, "%f", 3.14159265));
+    BENCH("sprintf", "%.3f", 0,
+            minlibc_sprintf(text, "%.3f", -1234.5678),
+            sprintf(text, "%.3f", -1234.5678));
+    BENCH("sprintf", "%f small", 0,
+            minlibc_sprintf(text, "%f", 0.000123456),
+            sprintf(text, "%f", 0.000123456));
+    BENCH("sprintf", "%e", 0,
+            minlibc_sprintf(text, "%e", 6.02214076e23),
+            sprintf(text, "%e", 6.02214076e23));
+    BENCH("sprintf", "%g", 0,
+            minlibc_sprintf(text, "%g", 0.000123456),
+            sprintf(text, "%g", 0.000123456));
+    BENCH("sprintf", "telemetry json", 0,
+            minlibc_sprintf(text, "{\"t\":%u,\"id\":%d,\"v\":%.3f,\"a\":%.2f}", 1700000000u, -42, 3.3014, 101.325),
+            sprintf(text, "{\"t\":%u,\"id\":%d,\"v\":%.3f,\"a\":%.2f}", 1700000000u, -42, 3.3014, 101.325));
+    BENCH("snprintf", "%s=%d;", 0,
+            minlibc_snprintf(text, 16, "%s=%d;%s=%d;", "alpha", 100, "beta", -200),
+            snprintf(text, 16, "%s=%d;%s=%d;", "alpha", 100, "beta", -200));
+    BENCH("printf", "%s %d %x %c %u", 0,
+            minlibc_printf("%s %d %x %c %u\n", "name", 42, 0xbeef, 'z', 3000000000u),
+            fprintf(devnull, "%s %d %x %c %u\n", "name", 42, 0xbeef, 'z', 3000000000u));
+
+    fclose(devnull);
+}
+
+static void bench_string()
+{
+    size_t s;
+
+    for(s = 0; s < SIZE_COUNT; s++)
+    {
+        BENCH("memcpy", "aligned", sizes[s],
+                minlibc_memcpy(bench_b, bench_a, sizes[s]),
+                memcpy(bench_b, bench_a, sizes[s]));
+        BENCH("memcpy", "dst+1 src+3", sizes[s],
+                minlibc_memcpy(bench_b + 1, bench_a + 3, sizes[s]),
+                memcpy(bench_b + 1, bench_a + 3, sizes[s]));
+    }
+
+    for(s = 0; s < SIZE_COUNT; s++)
+    {
+        BENCH("memset", "aligned", sizes[s],
+                minlibc_memset(bench_b, 0x55, sizes[s]),
+                memset(bench_b, 0x55, sizes[s]));
+        BENCH("memset", "dst+1", sizes[s],
+                minlibc_memset(bench_b + 1, 0x55, sizes[s]),
+                memset(bench_b + 1, 0x55, sizes[s]));
+    }
+
+    memset(bench_a, 'x', sizeof(bench_a));
+    for(s = 0; s < SIZE_COUNT; s++)
+    {
+        bench_a[sizes[s]] = '\0';
+        bench_a[sizes[s] + 1] = '\0';
+        BENCH("strlen", "aligned", sizes[s],
+                minlibc_strlen((char*)bench_a),
+                strlen((char*)bench_a));
+        BENCH("strlen", "src+1", sizes[s],
+                minlibc_strlen((char*)bench_a + 1),
+                strlen((char*)bench_a + 1));
+        bench_a[sizes[s]] = 'x';
+        bench_a[sizes[s] + 1] = 'x';
+    }
+
+    // needle at the end of the haystack, in text that often matches its first characters
+    for(s = 0; s < SIZE_COUNT; s++)
+    {
+        size_t i;
+        for(i = 0; i < sizes[s]; i++)
+            bench_a[i] = "the quick brown fox "[i % 20];
+        memcpy(bench_a + sizes[s] - 5, "fox!", 5);
+        BENCH("strstr", "text", sizes[s],
+                minlibc_strstr((char*)bench_a, "fox!"),
+                strstr((char*)bench_a, "fox!"));
+    }
+
+    // many partial matches, a worst case for the naive search
+    for(s = 0; s < SIZE_COUNT; s++)
+    {
+        memset(bench_a, 'a', sizes[s]);
+        memcpy(bench_a + sizes[s] - 5, "aaab", 5);
+        BENCH("strstr", "aaaaaaab", sizes[s],
+                minlibc_strstr((char*)bench_a, "aaaaaaab"),
+                strstr((char*)bench_a, "aaaaaaab"));
+    }
+}
+
+/*
+ * the searches made when parsing an http request and tokenising a shell command line.
+ */
+static void bench_parsing()
+{
+    static const char http_header[] =
+        "POST /api/config HTTP/1.1\r\n"
+        "Host: 192.168.0.20\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:42.0) Gecko/20100101 Firefox/42.0\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+        "Accept-Language: en-US,en;q=0.5\r\n"
+        "Connection: keep-alive\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "Content-Length: 27\r\n"
+        "\r\n"
+        "ssid=appleseed&channel=6";
+    static const char command_line[] = "  ls   -l --color=never /sdcard/logs/2015-10-19.txt";
+    // copied to the writable buffers, so the host calls are not folded into constants
+    char* header = (char*)bench_a;
+    char* command = (char*)bench_b;
+    size_t len = sizeof(http_header) - 1;
+
+    strcpy(header, http_header);
+    strcpy(command, command_line);
+
+    BENCH("strstr", "header end", len,
+            minlibc_strstr(header, "\r\n\r\n"),
+            strstr(header, "\r\n\r\n"));
+    BENCH("strstr", "Content-Length:", len,
+            minlibc_strstr(header, "Content-Length:"),
+            strstr(header, "Content-Length:"));
+    BENCH("strstr", "absent field", len,
+            minlibc_strstr(header, "Transfer-Encoding:"),
+            strstr(header, "Transfer-Encoding:"));
+    BENCH("memmem", "header end", len,
+            minlibc_memmem(header, len, "\r\n\r\n", 4),
+            memmem(header, len, "\r\n\r\n", 4));
+    BENCH("strcspn", "header line", len,
+            minlibc_strcspn(header + 27, "\r\n"),
+            strcspn(header + 27, "\r\n"));
+    BENCH("strpbrk", "header value", len,
+            minlibc_strpbrk(header + 61, ";,\r\n"),
+            strpbrk(header + 61, ";,\r\n"));
+    BENCH("strspn", "command spaces", sizeof(command_line) - 1,
+            minlibc_strspn(command, " \t"),
+            strspn(command, " \t"));
+    BENCH("strcspn", "command token", sizeof(command_line) - 1,
+            minlibc_strcspn(command + 7, " \t\r\n"),
+            strcspn(command + 7, " \t\r\n"));
+}
+
+/*
+ * conversions return their results through bench_sink, the doubles are truncated but still
+ * depend on the call.
+ */
+static void bench_conversion()
+{
+    BENCH("atoi", "-2147483", 0,
+            minlibc_atoi("-2147483"),
+            atoi("-2147483"));
+    BENCH("atof", "1234.5678", 0,
+            minlibc_atof("1234.5678"),
+            atof("1234.5678"));
+    BENCH("strtod", "3.14159", 0,
+            minlibc_strtod("3.14159", NULL),
+            strtod("3.14159", NULL));
+    BENCH("strtod", "-6.02214076e23", 0,
+            minlibc_strtod("-6.02214076e23", NULL),
+            strtod("-6.02214076e23", NULL));
+    BENCH("strtod", "1.7976931348623157e308", 0,
+            minlibc_strtod("1.7976931348623157e308", NULL),
+            strtod("1.7976931348623157e308", NULL));
+    BENCH("strtod", "2.2250738585072014e-308", 0,
+            minlibc_strtod("2.2250738585072014e-308", NULL) * 1e300,
+            strtod("2.2250738585072014e-308", NULL) * 1e300);
+    BENCH("strtod", "0.30000000000000004441", 0,
+            minlibc_strtod("0.30000000000000004441", NULL),
+            strtod("0.30000000000000004441", NULL));
+    BENCH("strtod", "json 51.50722,-0.12750", 0,
+            minlibc_strtod("51.50722,-0.12750", NULL) + minlibc_strtod("-0.12750", NULL),
+            strtod("51.50722,-0.12750", NULL) + strtod("-0.12750", NULL));
+    BENCH("strtof", "3.14159", 0,
+            minlibc_strtof("3.14159", NULL),
+            strtof("3.14159", NULL));
+    BENCH("strtof", "1.00000005960464477539062501", 0,
+            minlibc_strtof("1.00000005960464477539062501", NULL),
+            strtof("1.00000005960464477539062501", NULL));
+}
+
+static void bench_time()
+{
+    time_t t = 1445212800; // 2015-10-19
+    struct tm brokentime = *gmtime(&t);
+    struct tm scratch;
+
+    BENCH("gmtime", "", 0,
+            minlibc_gmtime(&t),
+            gmtime(&t));
+    BENCH("gmtime_r", "", 0,
+            minlibc_gmtime_r(&t, &scratch),
+            gmtime_r(&t, &scratch));
+    BENCH("mktime", "", 0,
+            (scratch = brokentime, minlibc_mktime(&scratch)),
+            (scratch = brokentime, timegm(&scratch)));
+    BENCH("strftime", "%Y-%m-%d %H:%M:%S", 0,
+            minlibc_strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &brokentime),
+            strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &brokentime));
+    BENCH("strftime", "%Y-%m-%d %H:%M", 0,
+            minlibc_strftime(text, sizeof(text), "%Y-%m-%d %H:%M", &brokentime),
+            strftime(text, sizeof(text), "%Y-%m-%d %H:%M", &brokentime));
+    BENCH("strftime", "%a, %d %b %Y %H:%M:%S GMT", 0,
+            minlibc_strftime(text, sizeof(text), "%a, %d %b %Y %H:%M:%S GMT", &brokentime),
+            strftime(text, sizeof(text), "%a, %d %b %Y %H:%M:%S GMT", &brokentime));
+}
+
+static void print_table()
+{
+    int i;
+    printf("%-10s %-28s %6s %14s %14s %8s\n", "function", "variant", "size", "minlibc ns/op", "host ns/op", "ratio");
+    for(i = 0; i < result_count; i++)
+    {
+        printf("%-10s %-28s %6u %14.1f %14.1f %8.2f\n", results[i].name, results[i].variant,
+                (unsigned int)results[i].size, results[i].minlibc_ns, results[i].host_ns,
+                results[i].minlibc_ns / results[i].host_ns);
+    }
+}
+
+static void print_json()
+{
+    int i;
+    printf("[\n");
+    for(i = 0; i < result_count; i++)
+    {
+        printf("  {\"name\": \"%s\", \"variant\": \"%s\", \"size\": %u, \"minlibc_ns\": %.2f, \"host_ns\": %.2f}%s\n",
+                results[i].name, results[i].variant, (unsigned int)results[i].size,
+                results[i].minlibc_ns, results[i].host_ns, i < result_count - 1 ? "," : "");
+    }
+    printf("]\n");
+}
+
+int main(int argc, char** argv)
+{
+    bool json = argc > 1 && strcmp(argv[1], "--json") == 0;
+
+    if(argc > 1 && !json)
+    {
+        fprintf(stderr, "usage: %s [--json]\n", argv[0]);
+        return 1;
+    }
+
+    bench_formatting();
+    bench_string();
+    bench_parsing();
+    bench_conversion();
+    bench_time();
+
+    if(json)
+        print_json();
+    else
+        print_table();
+
+    return 0;
+}
@@ -4,6 +4,8 @@
 
 char buffer[BUFFER_SIZE];
 uint32_t i = 0;
+bool regular = false;
+int writes = 0;
 
 int _open(const char *name, int flags, int mode)
 {
@@ -38,6 +40,21 @@ int _fsync(int file)
     return file == EOF ? EOF : 0;
 }
 
+/**
+ * reports a character device, so that streams stay unbuffered
+ * and writes show up in the fixture buffer straight away.
+ * after set_regular_file(true) it reports a regular file, so that
+ * streams opened from then on are fully buffered.
+ */
+int _fstat(int file, struct stat *st)
+{
+    if(file == EOF)
+        return EOF;
+    memset(st, 0, sizeof(struct stat));
+    st->st_mode = regular ? S_IFREG : S_IFCHR;
+    return 0;
+}
+
 int _write(int file, char *buf, unsigned int count)
 {
     if(file == EOF)
@@ -48,6 +65,8 @@ int _write(int file, char *buf, unsigned int count)
 
     int n = EOF;
 
+    writes++;
+
     for(n = 0; n < (int)count && i < sizeof(buffer); n++, i++) {
         buffer[i] = *buf;
         buf++;
@@ -108,6 +127,17 @@ void reset_fixture()
 {
     memset(buffer, 0, sizeof(buffer));
     i = 0;
+    writes = 0;
+}
+
+void set_regular_file(bool enable)
+{
+    regular = enable;
+}
+
+int get_write_count()
+{
+    return writes;
 }
 
 char* get_buffer()
@@ -6,6 +6,7 @@
  */
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
@@ -26,10 +27,13 @@ extern "C" int _unlink(char *name);
 extern "C" int _rename(const char *oldname, const char *newname);
 //extern "C" int mkdir(const char *pathname, mode_t mode);
 extern "C" int _fsync(int file);
+extern "C" int _fstat(int file, struct stat *st);
 
 
 extern "C" void force_eof();
 extern "C" void reset_fixture();
 extern "C" char* get_buffer();
+extern "C" void set_regular_file(bool enable);
+extern "C" int get_write_count();
 
 #endif /* MINLIBC_TEST_FIXTURE_H_ */
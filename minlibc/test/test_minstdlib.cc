@@ -0,0 +1,194 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <float.h>
+#include <string>
+
+#include "gtest/gtest.h"
+
+/*
+ * the minlibc number conversion functions, built with their symbols renamed
+ * so that they sit alongside the host C library (see Makefile).
+ */
+extern "C" {
+double minlibc_atof(const char* string);
+double minlibc_strtod(const char* string, char** tailptr);
+float minlibc_strtof(const char* string, char** tailptr);
+}
+
+static uint64_t bits_of(double d)
+{
+    uint64_t u;
+    memcpy(&u, &d, sizeof(d));
+    return u;
+}
+
+static uint32_t bits_of(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(f));
+    return u;
+}
+
+/*
+ * checks the value, end pointer and errno against the host C library.
+ */
+static void expect_same_as_host(const char* string)
+{
+    char* host_end;
+    char* end;
+
+    errno = 0;
+    double expected = strtod(string, &host_end);
+    int host_errno = errno;
+    errno = 0;
+    double actual = minlibc_strtod(string, &end);
+
+    if(isnan(expected))
+        EXPECT_TRUE(isnan(actual)) << string;
+    else
+        EXPECT_EQ(bits_of(expected), bits_of(actual)) << string;
+    EXPECT_EQ(host_end, end) << string;
+    // underflow to a subnormal, or rounding up to the smallest normal, may or may not set errno
+    if(expected == 0 || fabs(expected) > DBL_MIN)
+    {
+        EXPECT_EQ(host_errno, errno) << string;
+    }
+
+    float expected_f = strtof(string, &host_end);
+    float actual_f = minlibc_strtof(string, &end);
+    if(isnan(expected_f))
+        EXPECT_TRUE(isnan(actual_f)) << string;
+    else
+        EXPECT_EQ(bits_of(expected_f), bits_of(actual_f)) << string;
+    EXPECT_EQ(host_end, end) << string;
+}
+
+TEST(test_minstdlib, strtod_simple)
+{
+    const char* cases[] = {"0", "-0", "1", "-1", "1.5", "+3.25", ".5", "5.", "0.1", "123456789",
+        "3.14159265358979323846", "1e10", "1E-10", "-2.5e+3", "007", "0.000001", "100000000000000000000000"};
+
+    for(const char* c : cases)
+        expect_same_as_host(c);
+}
+
+TEST(test_minstdlib, strtod_end_pointer)
+{
+    const char* cases[] = {"", " ", "abc", ".", "-", "+.", "e5", "1e", "1e+", "1e-x", "1.5.5", "  \t\n42xyz",
+        "12,5", "0x", "0xg", "0x.", "0x1p", "1..2", "-.e1", "1e5e5"};
+
+    for(const char* c : cases)
+        expect_same_as_host(c);
+
+    char* end;
+    const char* s = "xyz";
+    EXPECT_EQ(0.0, minlibc_strtod(s, &end));
+    EXPECT_EQ(s, end);
+    EXPECT_EQ(0.0, minlibc_strtod(s, NULL));
+}
+
+TEST(test_minstdlib, strtod_special_values)
+{
+    const char* cases[] = {"inf", "-inf", "INF", "Infinity", "-INFINITY", "infinit", "nan", "-NAN",
+        "nan(123)", "nan(abc_1)", "nan(", "nan(1 2)", "in", "na"};
+
+    for(const char* c : cases)
+        expect_same_as_host(c);
+}
+
+TEST(test_minstdlib, strtod_hex)
+{
+    const char* cases[] = {"0x1p3", "0X1.8P-1", "0x.8", "0xA", "-0x1.fffffffffffffp1023", "0x1.fffffffffffff8p1023",
+        "0x1.fffffffffffff7ffp1023", "0x1p-1074", "0x1p-1075", "0x1.0000000000001p-1075", "0x0p0", "0x123456789abcdef123p0",
+        "0x1.000000000000080000000001p0", "0x1.00000000000008p0", "0x1.00000000000018p0", "0x1p1024"};
+
+    for(const char* c : cases)
+        expect_same_as_host(c);
+}
+
+TEST(test_minstdlib, strtod_limits)
+{
+    const char* cases[] = {"1e308", "1e309", "-1e400", "1.7976931348623157e308", "1.7976931348623158e308",
+        "1.797693134862315807937e308", "1.797693134862315808e308", "2.2250738585072014e-308", "2.2250738585072011e-308",
+        "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324", "1e-400", "1e99999999",
+        "1e-99999999", "0e99999999", "3.4028234663852886e38", "3.4028235677973366e38", "1.401298464324817e-45", "7.006e-46"};
+
+    for(const char* c : cases)
+        expect_same_as_host(c);
+
+    errno = 0;
+    EXPECT_EQ(HUGE_VAL, minlibc_strtod("1e999", NULL));
+    EXPECT_EQ(ERANGE, errno);
+    errno = 0;
+    EXPECT_EQ(-HUGE_VALF, minlibc_strtof("-1e39", NULL));
+    EXPECT_EQ(ERANGE, errno);
+    errno = 0;
+    EXPECT_EQ(0.0, minlibc_strtod("1e-999", NULL));
+    EXPECT_EQ(ERANGE, errno);
+    errno = 0;
+    EXPECT_EQ(0.0, minlibc_strtod("0e-999", NULL));
+    EXPECT_EQ(0, errno);
+}
+
+TEST(test_minstdlib, strtod_halfway_cases)
+{
+    const char* cases[] = {
+        // 2^53 + 1, half way between two doubles, then just above it
+        "9007199254740993", "9007199254740993.0000000000000000000000000001", "9007199254740992.9999999999999999999",
+        "9007199254740995",
+        // 1 + 2^-24, half way between two floats
+        "1.000000059604644775390625", "1.00000005960464477539062501", "1.00000005960464477539062499",
+        // hard cases from the literature
+        "8.589973e9", "1e23", "7.038531e-26", "9214843084008499", "30078505129381147446200",
+        "1777820000000000000001", "0.500000000000000166533453693773481063544750213623046875",
+        "3.518437208883201171875e13", "62.5364939768271845828", "8.10109172351e-10",
+        "1.50000000000000011102230246251565404236316680908203125", "9007199254740993.000000000000000000000000000000001",
+        "2.2250738585072012e-308", "123e30", "4.35679e-10"};
+
+    for(const char* c : cases)
+        expect_same_as_host(c);
+}
+
+TEST(test_minstdlib, strtod_long_inputs)
+{
+    // more significant digits than the slow path reads, the rest decide ties
+    std::string half = "9007199254740993." + std::string(1000, '0');
+    expect_same_as_host(half.c_str());
+    expect_same_as_host((half + "1").c_str());
+    expect_same_as_host(("0." + std::string(400, '0') + "1" + std::string(900, '7') + "e400").c_str());
+    expect_same_as_host((std::string(500, '9') + "e-200").c_str());
+    expect_same_as_host(("0." + std::string(5000, '0') + "1e5000").c_str());
+}
+
+TEST(test_minstdlib, strtod_round_trip)
+{
+    uint64_t state = 88172645463325252ull;
+    char buf[64];
+
+    for(int i = 0; i < 100000; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        double d;
+        memcpy(&d, &state, sizeof(d));
+        if(isnan(d) || isinf(d))
+            continue;
+        snprintf(buf, sizeof(buf), "%.17g", d);
+        ASSERT_EQ(bits_of(d), bits_of(minlibc_strtod(buf, NULL))) << buf;
+        snprintf(buf, sizeof(buf), "%.*g", (int)(state % 17) + 1, d);
+        ASSERT_EQ(bits_of(strtod(buf, NULL)), bits_of(minlibc_strtod(buf, NULL))) << buf;
+        ASSERT_EQ(bits_of(strtof(buf, NULL)), bits_of(minlibc_strtof(buf, NULL))) << buf;
+    }
+}
+
+TEST(test_minstdlib, atof)
+{
+    EXPECT_EQ(1.5, minlibc_atof("1.5"));
+    EXPECT_EQ(-2.5e-3, minlibc_atof(" -2.5e-3 volts"));
+    EXPECT_EQ(0.0, minlibc_atof("volts"));
+    EXPECT_EQ(bits_of(0.1), bits_of(minlibc_atof("0.1")));
+}
@@ -1,8 +1,435 @@
-
 #include <stdint.h>
 #include <limits.h>
+#include <string.h>
+#include <time.h>
 
-#include "../_string.h"
-#include "../string.h"
 #include "gtest/gtest.h"
 
+/*
+ * the minlibc string functions, built with their symbols prefixed
+ * so that they sit alongside the host C library (see Makefile).
+ */
+extern "C" {
+void* minlibc_memcpy(void* dst, const void* src, size_t len);
+void* minlibc_memmove(void* dst, const void* src, size_t len);
+void* minlibc_memset(void* dst, int num, size_t len);
+int minlibc_memcmp(const void* p1, const void* p2, size_t len);
+void* minlibc_memchr(const void *block, int c, size_t size);
+size_t minlibc_strlen(const char* str);
+char* minlibc_strchr(const char* src, int character);
+char* minlibc_strstr(const char* haystack, const char* needle);
+void* minlibc_memmem(const void* haystack, size_t haystack_len, const void* needle, size_t needle_len);
+size_t minlibc_strspn(const char* string, const char* skipset);
+size_t minlibc_strcspn(const char* string, const char* stopset);
+char* minlibc_strpbrk(const char* string, const char* stopset);
+}
+
+#define MAX_ALIGN       16
+#define MAX_LEN         300
+#define GUARD           64
+#define AREA_SIZE       (GUARD + MAX_ALIGN + MAX_LEN + GUARD)
+#define GUARD_BYTE      0xA5
+
+static unsigned char area_a[AREA_SIZE] __attribute__((aligned(16)));
+static unsigned char area_b[AREA_SIZE] __attribute__((aligned(16)));
+static unsigned char area_ref[AREA_SIZE] __attribute__((aligned(16)));
+
+static void fill_pattern(unsigned char* buf, size_t len, unsigned int seed)
+{
+    for(size_t i = 0; i < len; i++)
+        buf[i] = (unsigned char)((i * 131 + seed * 7 + 1) & 0xff);
+}
+
+TEST(test_minstring, memcpy_all_alignments_and_lengths)
+{
+    for(int sa = 0; sa < MAX_ALIGN; sa++)
+    {
+        for(int da = 0; da < MAX_ALIGN; da++)
+        {
+            for(int len = 0; len <= MAX_LEN; len++)
+            {
+                fill_pattern(area_a, AREA_SIZE, sa + len);
+                memset(area_b, GUARD_BYTE, AREA_SIZE);
+                memset(area_ref, GUARD_BYTE, AREA_SIZE);
+
+                void* ret = minlibc_memcpy(area_b + GUARD + da, area_a + GUARD + sa, len);
+                memcpy(area_ref + GUARD + da, area_a + GUARD + sa, len);
+
+                ASSERT_EQ(ret, area_b + GUARD + da);
+                ASSERT_EQ(0, memcmp(area_b, area_ref, AREA_SIZE)) << "sa=" << sa << " da=" << da << " len=" << len;
+            }
+        }
+    }
+}
+
+TEST(test_minstring, memset_all_alignments_and_lengths)
+{
+    const int values[] = {0, 0x01, 0x7f, 0x80, 0xff, 0x1234};
+
+    for(size_t v = 0; v < sizeof(values)/sizeof(values[0]); v++)
+    {
+        for(int da = 0; da < MAX_ALIGN; da++)
+        {
+            for(int len = 0; len <= MAX_LEN; len++)
+            {
+                memset(area_b, GUARD_BYTE, AREA_SIZE);
+                memset(area_ref, GUARD_BYTE, AREA_SIZE);
+
+                void* ret = minlibc_memset(area_b + GUARD + da, values[v], len);
+                memset(area_ref + GUARD + da, values[v], len);
+
+                ASSERT_EQ(ret, area_b + GUARD + da);
+                ASSERT_EQ(0, memcmp(area_b, area_ref, AREA_SIZE)) << "v=" << values[v] << " da=" << da << " len=" << len;
+            }
+        }
+    }
+}
+
+TEST(test_minstring, memmove_overlapping_both_directions)
+{
+    for(int sa = 0; sa < MAX_ALIGN; sa++)
+    {
+        for(int shift = -40; shift <= 40; shift++)
+        {
+            for(int len = 0; len <= 200; len++)
+            {
+                unsigned char* src = area_b + GUARD + MAX_ALIGN + sa;
+                fill_pattern(area_b, AREA_SIZE, sa + len);
+                memcpy(area_ref, area_b, AREA_SIZE);
+
+                void* ret = minlibc_memmove(src + shift, src, len);
+                memmove(area_ref + (src - area_b) + shift, area_ref + (src - area_b), len);
+
+                ASSERT_EQ(ret, src + shift);
+                ASSERT_EQ(0, memcmp(area_b, area_ref, AREA_SIZE)) << "sa=" << sa << " shift=" << shift << " len=" << len;
+            }
+        }
+    }
+}
+
+TEST(test_minstring, memmove_disjoint)
+{
+    fill_pattern(area_a, AREA_SIZE, 3);
+    memset(area_b, GUARD_BYTE, AREA_SIZE);
+    memset(area_ref, GUARD_BYTE, AREA_SIZE);
+    minlibc_memmove(area_b + GUARD + 3, area_a + GUARD, MAX_LEN);
+    memmove(area_ref + GUARD + 3, area_a + GUARD, MAX_LEN);
+    ASSERT_EQ(0, memcmp(area_b, area_ref, AREA_SIZE));
+}
+
+static int sign(int v)
+{
+    return v < 0 ? -1 : v > 0 ? 1 : 0;
+}
+
+TEST(test_minstring, memcmp_difference_at_every_position)
+{
+    for(int sa = 0; sa < MAX_ALIGN; sa++)
+    {
+        for(int da = 0; da < MAX_ALIGN; da++)
+        {
+            for(int len = 0; len <= 100; len++)
+            {
+                unsigned char* a = area_a + GUARD + sa;
+                unsigned char* b = area_b + GUARD + da;
+                fill_pattern(a, len, len);
+                fill_pattern(b, len, len);
+
+                ASSERT_EQ(0, minlibc_memcmp(a, b, len));
+
+                for(int pos = 0; pos < len; pos++)
+                {
+                    // bytes above 0x7f must compare as unsigned
+                    unsigned char saved = b[pos];
+                    b[pos] = (unsigned char)(a[pos] ^ 0x80);
+                    ASSERT_EQ(sign(memcmp(a, b, len)), sign(minlibc_memcmp(a, b, len)))
+                        << "sa=" << sa << " da=" << da << " len=" << len << " pos=" << pos;
+                    ASSERT_EQ(0, minlibc_memcmp(a, b, pos));
+                    b[pos] = saved;
+                }
+            }
+        }
+    }
+}
+
+TEST(test_minstring, strlen_all_alignments_and_lengths)
+{
+    for(int sa = 0; sa < MAX_ALIGN; sa++)
+    {
+        for(int len = 0; len <= MAX_LEN; len++)
+        {
+            char* s = (char*)area_a + GUARD + sa;
+            memset(area_a, 0x80, AREA_SIZE);
+            s[len] = '\0';
+            ASSERT_EQ((size_t)len, minlibc_strlen(s)) << "sa=" << sa << " len=" << len;
+        }
+    }
+}
+
+TEST(test_minstring, strchr_finds_first_match_or_terminator)
+{
+    const int chars[] = {'a', 0x01, 0x80, 0xfe, 0xff, 0x100 + 'a'};
+
+    for(size_t c = 0; c < sizeof(chars)/sizeof(chars[0]); c++)
+    {
+        for(int sa = 0; sa < MAX_ALIGN; sa++)
+        {
+            for(int len = 0; len <= 100; len++)
+            {
+                char* s = (char*)area_a + GUARD + sa;
+                memset(area_a, 'z', AREA_SIZE);
+                s[len] = '\0';
+
+                ASSERT_EQ(strchr(s, chars[c]), minlibc_strchr(s, chars[c]));
+                ASSERT_EQ(s + len, minlibc_strchr(s, '\0'));
+
+                for(int pos = 0; pos < len; pos++)
+                {
+                    char saved = s[pos];
+                    s[pos] = (char)chars[c];
+                    ASSERT_EQ(strchr(s, chars[c]), minlibc_strchr(s, chars[c]))
+                        << "c=" << chars[c] << " sa=" << sa << " len=" << len << " pos=" << pos;
+                    s[pos] = saved;
+                }
+            }
+        }
+    }
+}
+
+TEST(test_minstring, memchr_respects_size)
+{
+    for(int sa = 0; sa < MAX_ALIGN; sa++)
+    {
+        for(int len = 0; len <= 100; len++)
+        {
+            unsigned char* s = area_a + GUARD + sa;
+            memset(area_a, 0, AREA_SIZE);
+
+            ASSERT_EQ(NULL, minlibc_memchr(s, 0x80, len));
+            // a match just past the end must not be found
+            s[len] = 0x80;
+            ASSERT_EQ(NULL, minlibc_memchr(s, 0x80, len));
+            ASSERT_EQ(NULL, minlibc_memchr(s, 0x180, len));
+
+            for(int pos = 0; pos < len; pos++)
+            {
+                s[pos] = 0x80;
+                ASSERT_EQ(s + pos, minlibc_memchr(s, 0x80, len)) << "sa=" << sa << " len=" << len << " pos=" << pos;
+                ASSERT_EQ(s + pos, minlibc_memchr(s, 0x180, len));
+                ASSERT_EQ(memchr(s, 0, len), minlibc_memchr(s, 0, len));
+                s[pos] = 0;
+            }
+        }
+    }
+}
+
+/*
+ * fills s with len characters from a small alphabet, so that needles and partial
+ * matches turn up often. a simple LCG keeps the runs repeatable.
+ */
+static unsigned int lcg_state = 1;
+
+static unsigned int lcg()
+{
+    lcg_state = lcg_state * 1103515245 + 12345;
+    return lcg_state >> 16;
+}
+
+static void fill_random(char* s, size_t len, const char* alphabet)
+{
+    size_t n = strlen(alphabet);
+    for(size_t i = 0; i < len; i++)
+        s[i] = alphabet[lcg() % n];
+    s[len] = '\0';
+}
+
+TEST(test_minstring, strstr_matches_host)
+{
+    const char* alphabets[] = {"ab", "abc", "a", "abcdefgh\x80\xff"};
+    char haystack[80];
+    char needle[16];
+
+    for(size_t a = 0; a < sizeof(alphabets)/sizeof(alphabets[0]); a++)
+    {
+        for(int i = 0; i < 100000; i++)
+        {
+            fill_random(haystack, lcg() % 72, alphabets[a]);
+            fill_random(needle, lcg() % 12, alphabets[a]);
+            ASSERT_EQ(strstr(haystack, needle), minlibc_strstr(haystack, needle))
+                << "haystack=" << haystack << " needle=" << needle;
+        }
+    }
+}
+
+TEST(test_minstring, strstr_periodic_and_long_needles)
+{
+    static char haystack[2048];
+    static char needle[600];
+
+    // periodic needles, where the search has to remember what it already matched
+    memset(haystack, 'a', sizeof(haystack) - 1);
+    haystack[sizeof(haystack) - 1] = '\0';
+    for(int len = 2; len < 40; len++)
+    {
+        memset(needle, 'a', len);
+        needle[len - 1] = 'b';
+        needle[len] = '\0';
+        ASSERT_EQ(NULL, minlibc_strstr(haystack, needle));
+        haystack[1500] = 'b';
+        ASSERT_EQ(haystack + 1501 - len, minlibc_strstr(haystack, needle)) << len;
+        haystack[1500] = 'a';
+    }
+    fill_random(needle, 6, "ab");
+    for(int i = 6; i < 24; i++)
+        needle[i] = needle[i - 6];
+    needle[24] = '\0';
+    for(int i = 0; i < 10000; i++)
+    {
+        fill_random(haystack, 200, "ab");
+        ASSERT_EQ(strstr(haystack, needle), minlibc_strstr(haystack, needle));
+    }
+
+    // longer than the bad character shifts can hold
+    fill_random(haystack, sizeof(haystack) - 1, "abcdefghijklmnop");
+    memcpy(needle, haystack + 1200, 500);
+    needle[500] = '\0';
+    ASSERT_EQ(strstr(haystack, needle), minlibc_strstr(haystack, needle));
+    needle[499] = 'z';
+    ASSERT_EQ(NULL, minlibc_strstr(haystack, needle));
+    ASSERT_EQ(haystack, minlibc_strstr(haystack, ""));
+}
+
+TEST(test_minstring, memmem_respects_lengths)
+{
+    char haystack[80];
+    char needle[16];
+
+    for(int i = 0; i < 100000; i++)
+    {
+        size_t hlen = lcg() % 72;
+        size_t nlen = lcg() % 12;
+        fill_random(haystack, hlen, "abc");
+        fill_random(needle, nlen, "abc");
+        // terminators are just bytes to memmem
+        if(hlen && (lcg() & 1))
+            haystack[lcg() % hlen] = '\0';
+        size_t len = lcg() % (hlen + 1);
+        ASSERT_EQ(memmem(haystack, len, needle, nlen), minlibc_memmem(haystack, len, needle, nlen))
+            << "haystack=" << haystack << " len=" << len << " needle=" << needle;
+    }
+
+    // a match that runs past the end must not be found
+    ASSERT_EQ(NULL, minlibc_memmem("abcabd", 5, "abd", 3));
+    ASSERT_EQ(NULL, minlibc_memmem("abcabd", 5, "d", 1));
+    ASSERT_EQ((void*)NULL, minlibc_memmem("ab", 2, "abc", 3));
+}
+
+TEST(test_minstring, span_functions_match_host)
+{
+    const char* alphabet = "abcdefgh \t\r\n:;,\x01\x7f\x80\xff";
+    char string[48];
+    char set[12];
+
+    for(int i = 0; i < 100000; i++)
+    {
+        fill_random(string, lcg() % 40, alphabet);
+        fill_random(set, lcg() % 10, alphabet);
+        ASSERT_EQ(strspn(string, set), minlibc_strspn(string, set)) << "string=" << string << " set=" << set;
+        ASSERT_EQ(strcspn(string, set), minlibc_strcspn(string, set)) << "string=" << string << " set=" << set;
+        ASSERT_EQ(strpbrk(string, set), minlibc_strpbrk(string, set)) << "string=" << string << " set=" << set;
+    }
+}
+
+/*
+ * benchmarks, minlibc against the host C library.
+ * these only report, the host C library is usually vectorised and will win on large copies.
+ */
+
+#define BENCH_BYTES     (64 * 1024 * 1024)
+
+// results are stored here so the calls can't be optimised away
+static volatile uintptr_t bench_sink;
+
+static double elapsed_ms(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static void report(const char* name, size_t len, double minlibc_ms, double host_ms)
+{
+    printf("    %-28s %5u bytes  minlibc %8.1f MB/s  host %8.1f MB/s\n", name, (unsigned int)len,
+           BENCH_BYTES / (minlibc_ms * 1000.0), BENCH_BYTES / (host_ms * 1000.0));
+}
+
+#define BENCH(name, len, minlibc_call, host_call)                   \
+    do {                                                            \
+        struct timespec start;                                      \
+        size_t n, iterations = BENCH_BYTES / (len);                 \
+        double minlibc_ms, host_ms;                                 \
+        clock_gettime(CLOCK_MONOTONIC, &start);                     \
+        for(n = 0; n < iterations; n++) {                           \
+            bench_sink = (uintptr_t)(minlibc_call);                 \
+            asm volatile("" ::: "memory");                          \
+        }                                                           \
+        minlibc_ms = elapsed_ms(&start);                            \
+        clock_gettime(CLOCK_MONOTONIC, &start);                     \
+        for(n = 0; n < iterations; n++) {                           \
+            bench_sink = (uintptr_t)(host_call);                    \
+            asm volatile("" ::: "memory");                          \
+        }                                                           \
+        host_ms = elapsed_ms(&start);                               \
+        report(name, len, minlibc_ms, host_ms);                     \
+    } while(0)
+
+static unsigned char bench_a[4096 + MAX_ALIGN] __attribute__((aligned(16)));
+static unsigned char bench_b[4096 + MAX_ALIGN] __attribute__((aligned(16)));
+
+TEST(bench_minstring, memcpy)
+{
+    const size_t lens[] = {16, 64, 512, 4096};
+    for(size_t i = 0; i < sizeof(lens)/sizeof(lens[0]); i++)
+    {
+        BENCH("memcpy aligned", lens[i], minlibc_memcpy(bench_b, bench_a, lens[i]), memcpy(bench_b, bench_a, lens[i]));
+        BENCH("memcpy misaligned", lens[i], minlibc_memcpy(bench_b + 1, bench_a + 2, lens[i]), memcpy(bench_b + 1, bench_a + 2, lens[i]));
+    }
+}
+
+TEST(bench_minstring, memmove)
+{
+    BENCH("memmove up, overlapping", 4000, minlibc_memmove(bench_a + 8, bench_a, 4000), memmove(bench_a + 8, bench_a, 4000));
+    BENCH("memmove down, overlapping", 4000, minlibc_memmove(bench_a, bench_a + 8, 4000), memmove(bench_a, bench_a + 8, 4000));
+}
+
+TEST(bench_minstring, memset)
+{
+    BENCH("memset", 512, minlibc_memset(bench_b, 0, 512), memset(bench_b, 0, 512));
+    BENCH("memset", 4096, minlibc_memset(bench_b + 1, 0x55, 4096), memset(bench_b + 1, 0x55, 4096));
+}
+
+TEST(bench_minstring, memcmp)
+{
+    memset(bench_a, 'x', sizeof(bench_a));
+    memset(bench_b, 'x', sizeof(bench_b));
+    BENCH("memcmp equal", 4096, minlibc_memcmp(bench_a, bench_b, 4096), memcmp(bench_a, bench_b, 4096));
+}
+
+TEST(bench_minstring, strlen_strchr_memchr)
+{
+    memset(bench_a, 'x', sizeof(bench_a));
+    bench_a[4095] = '\0';
+    BENCH("strlen", 4095, minlibc_strlen((char*)bench_a), strlen((char*)bench_a));
+    BENCH("strchr", 4095, minlibc_strchr((char*)bench_a, 'y'), strchr((char*)bench_a, 'y'));
+    BENCH("memchr", 4096, minlibc_memchr(bench_a, 'y', 4096), memchr(bench_a, 'y', 4096));
+}
+
+TEST(bench_minstring, strstr_strcspn)
+{
+    memset(bench_a, 'x', sizeof(bench_a));
+    bench_a[4095] = '\0';
+    BENCH("strstr 4 byte needle", 4095, minlibc_strstr((char*)bench_a, "xxxy"), strstr((char*)bench_a, "xxxy"));
+    BENCH("strstr 32 byte needle", 4095, minlibc_strstr((char*)bench_a, "abcdefghijklmnopqrstuvwxyz012345"),
+            strstr((char*)bench_a, "abcdefghijklmnopqrstuvwxyz012345"));
+    BENCH("strcspn", 4095, minlibc_strcspn((char*)bench_a, " \t\r\n"), strcspn((char*)bench_a, " \t\r\n"));
+}
@@ -0,0 +1,136 @@
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "gtest/gtest.h"
+
+/*
+ * the minlibc time functions, built with their symbols renamed
+ * so that they sit alongside the host C library (see Makefile).
+ */
+extern "C" {
+struct tm* minlibc_gmtime(const time_t* time);
+struct tm* minlibc_gmtime_r(const time_t* time, struct tm* result);
+time_t minlibc_mktime(struct tm* brokentime);
+size_t minlibc_strftime(char* s, size_t size, const char* t, const struct tm* brokentime);
+}
+
+static void expect_same_tm(const struct tm* expected, const struct tm* actual, time_t t)
+{
+    EXPECT_EQ(expected->tm_year, actual->tm_year) << t;
+    EXPECT_EQ(expected->tm_mon, actual->tm_mon) << t;
+    EXPECT_EQ(expected->tm_mday, actual->tm_mday) << t;
+    EXPECT_EQ(expected->tm_hour, actual->tm_hour) << t;
+    EXPECT_EQ(expected->tm_min, actual->tm_min) << t;
+    EXPECT_EQ(expected->tm_sec, actual->tm_sec) << t;
+    EXPECT_EQ(expected->tm_wday, actual->tm_wday) << t;
+    EXPECT_EQ(expected->tm_yday, actual->tm_yday) << t;
+}
+
+TEST(test_mintime, gmtime_r_matches_host)
+{
+    struct tm expected;
+    struct tm actual;
+
+    // every day from 1901 to 2100, at a different time of day each day
+    for(time_t t = -2177452800LL; t < 4133980800LL; t += 86400 + 3607)
+    {
+        gmtime_r(&t, &expected);
+        ASSERT_EQ(&actual, minlibc_gmtime_r(&t, &actual));
+        expect_same_tm(&expected, &actual, t);
+        if(::testing::Test::HasFailure())
+            return;
+    }
+
+    const time_t edges[] = {0, -1, 86399, 86400, 951782400, 951868800, 1078012800, 4107542399LL, 4107542400LL};
+    for(size_t i = 0; i < sizeof(edges)/sizeof(edges[0]); i++)
+    {
+        gmtime_r(&edges[i], &expected);
+        expect_same_tm(&expected, minlibc_gmtime(&edges[i]), edges[i]);
+    }
+}
+
+TEST(test_mintime, mktime_round_trips_and_normalises)
+{
+    struct tm brokentime;
+
+    for(time_t t = -2177452800LL; t < 4133980800LL; t += 86400 * 3 + 1234)
+    {
+        gmtime_r(&t, &brokentime);
+        ASSERT_EQ(t, minlibc_mktime(&brokentime));
+    }
+
+    // 2015-13-32 25:61:61 is 2016-02-02 02:02:01
+    memset(&brokentime, 0, sizeof(brokentime));
+    brokentime.tm_year = 115;
+    brokentime.tm_mon = 12;
+    brokentime.tm_mday = 32;
+    brokentime.tm_hour = 25;
+    brokentime.tm_min = 61;
+    brokentime.tm_sec = 61;
+    struct tm expected = brokentime;
+    time_t t = timegm(&expected);
+    EXPECT_EQ(t, minlibc_mktime(&brokentime));
+    expect_same_tm(&expected, &brokentime, t);
+
+    brokentime.tm_mon = -1;
+    brokentime.tm_mday = 1;
+    expected = brokentime;
+    EXPECT_EQ(timegm(&expected), minlibc_mktime(&brokentime));
+    expect_same_tm(&expected, &brokentime, t);
+}
+
+TEST(test_mintime, strftime_matches_host)
+{
+    const char* formats[] = {
+        "%Y-%m-%d %H:%M:%S", "%a, %d %b %Y %H:%M:%S GMT", "%A %B %e %j", "%F %T", "%D %R %I %p",
+        "%c", "%x %X", "%C %y %u %w %U %W", "%h %n%t%%", "%r", "[%S]", "%S %S", "plain text"
+    };
+    char expected[128];
+    char actual[128];
+    struct tm brokentime;
+
+    for(time_t t = 946684800 - 86400 * 10; t < 4133980800LL; t += 86400 * 5 + 3601)
+    {
+        gmtime_r(&t, &brokentime);
+        for(size_t f = 0; f < sizeof(formats)/sizeof(formats[0]); f++)
+        {
+            size_t len = strftime(expected, sizeof(expected), formats[f], &brokentime);
+            ASSERT_EQ(len, minlibc_strftime(actual, sizeof(actual), formats[f], &brokentime)) << formats[f];
+            ASSERT_STREQ(expected, actual) << formats[f];
+        }
+    }
+}
+
+TEST(test_mintime, strftime_reuses_the_last_minute)
+{
+    const char* format = "%Y-%m-%d %H:%M:%S";
+    char expected[32];
+    char actual[32];
+    char format_copy[32];
+    struct tm brokentime;
+
+    // each second of an hour, so most calls hit the cache, crossing minutes and the hour
+    for(time_t t = 1445212800 - 1800; t < 1445212800 + 1800; t++)
+    {
+        gmtime_r(&t, &brokentime);
+        strftime(expected, sizeof(expected), format, &brokentime);
+        ASSERT_EQ(19u, minlibc_strftime(actual, sizeof(actual), format, &brokentime));
+        ASSERT_STREQ(expected, actual);
+    }
+
+    // the cache keys on the format text, not where it is
+    time_t t = 1445212800;
+    gmtime_r(&t, &brokentime);
+    strcpy(format_copy, format);
+    minlibc_strftime(actual, sizeof(actual), format_copy, &brokentime);
+    strcpy(format_copy, "%Y/%m/%d %H:%M:%S");
+    minlibc_strftime(actual, sizeof(actual), format_copy, &brokentime);
+    EXPECT_STREQ("2015/10/19 00:00:00", actual);
+
+    // a result that does not fit writes nothing useful and returns 0
+    EXPECT_EQ(0u, minlibc_strftime(actual, 19, format, &brokentime));
+    EXPECT_EQ(19u, minlibc_strftime(actual, 20, format, &brokentime));
+    EXPECT_EQ(0u, minlibc_strftime(actual, 19, format, &brokentime));
+    EXPECT_EQ(0u, minlibc_strftime(actual, 0, format, &brokentime));
+}
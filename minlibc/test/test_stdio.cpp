@@ -165,3 +165,157 @@ TEST(test_ffunc, test_fgetc_ungetc)
 
     fclose(fd);
 }
+
+/**
+ * opens a stream on what the fixture reports as a regular file, so it is fully buffered.
+ */
+static FILE* fopen_regular(const char* mode)
+{
+    set_regular_file(true);
+    FILE* fd = fopen("regular.txt", mode);
+    set_regular_file(false);
+    reset_fixture();
+    return fd;
+}
+
+TEST(test_ffunc, test_buffered_writes_coalesce)
+{
+    int n;
+    FILE* fd = fopen_regular("w");
+    ASSERT_NEQ((intptr_t)fd, (intptr_t)NULL);
+
+    // one write for each full buffer, then one for the rest
+    for(n = 0; n < 600; n++)
+        fputc('x', fd);
+    ASSERT_EQ(get_write_count(), 1);
+    ASSERT_EQ((int)strlen(get_buffer()), __BUFSIZ__);
+
+    ASSERT_EQ(fflush(fd), 0);
+    ASSERT_EQ(get_write_count(), 2);
+    ASSERT_EQ((int)strlen(get_buffer()), 600);
+
+    fclose(fd);
+}
+
+TEST(test_ffunc, test_buffered_fclose_flushes)
+{
+    FILE* fd = fopen_regular("w");
+    ASSERT_NEQ((intptr_t)fd, (intptr_t)NULL);
+
+    fprintf(fd, "hello %d\n", 1);
+    fputs("world", fd);
+    ASSERT_EQ(get_write_count(), 0);
+    ASSERT_STREQ((char*)"", get_buffer());
+
+    fclose(fd);
+    ASSERT_EQ(get_write_count(), 1);
+    ASSERT_STREQ((char*)"hello 1\nworld", get_buffer());
+}
+
+TEST(test_ffunc, test_buffered_line_mode)
+{
+    FILE* fd = fopen_regular("w");
+    ASSERT_NEQ((intptr_t)fd, (intptr_t)NULL);
+    ASSERT_EQ(setvbuf(fd, NULL, _IOLBF, 64), 0);
+
+    fputs("abc", fd);
+    ASSERT_EQ(get_write_count(), 0);
+    fputs("de\nf", fd);
+    ASSERT_EQ(get_write_count(), 1);
+    ASSERT_STREQ((char*)"abcde\nf", get_buffer());
+
+    fputc('g', fd);
+    ASSERT_EQ(get_write_count(), 1);
+    fputc('\n', fd);
+    ASSERT_EQ(get_write_count(), 2);
+    ASSERT_STREQ((char*)"abcde\nfg\n", get_buffer());
+
+    fclose(fd);
+}
+
+TEST(test_ffunc, test_buffered_none_writes_through)
+{
+    FILE* fd = fopen_regular("w");
+    ASSERT_NEQ((intptr_t)fd, (intptr_t)NULL);
+    ASSERT_EQ(setvbuf(fd, NULL, _IONBF, 0), 0);
+
+    fputs("abc", fd);
+    ASSERT_EQ(get_write_count(), 1);
+    ASSERT_STREQ((char*)"abc", get_buffer());
+    fputc('d', fd);
+    ASSERT_EQ(get_write_count(), 2);
+    ASSERT_STREQ((char*)"abcd", get_buffer());
+
+    fclose(fd);
+}
+
+TEST(test_ffunc, test_buffered_full_mode_user_buffer)
+{
+    char buf[8];
+    FILE* fd = fopen_regular("w");
+    ASSERT_NEQ((intptr_t)fd, (intptr_t)NULL);
+    ASSERT_EQ(setvbuf(fd, buf, _IOFBF, sizeof(buf)), 0);
+
+    fputs("1234567", fd);
+    ASSERT_EQ(get_write_count(), 0);
+    fputs("89", fd);
+    ASSERT_EQ(get_write_count(), 1);
+    ASSERT_STREQ((char*)"12345678", get_buffer());
+
+    fclose(fd);
+    ASSERT_STREQ((char*)"123456789", get_buffer());
+}
+
+TEST(test_ffunc, test_buffered_ftell_fseek_pending_write)
+{
+    FILE* fd = fopen_regular("w+");
+    ASSERT_NEQ((intptr_t)fd, (intptr_t)NULL);
+
+    fputs("hello", fd);
+    ASSERT_EQ(get_write_count(), 0);
+    ASSERT_EQ(ftell(fd), 5);
+
+    // the pending data goes out before the seek
+    ASSERT_EQ(fseek(fd, 2, SEEK_SET), 0);
+    ASSERT_EQ(get_write_count(), 1);
+    ASSERT_STREQ((char*)"hello", get_buffer());
+    ASSERT_EQ(ftell(fd), 2);
+
+    fputs("XY", fd);
+    ASSERT_EQ(ftell(fd), 4);
+    ASSERT_EQ(fseek(fd, -1, SEEK_CUR), 0);
+    ASSERT_STREQ((char*)"heXYo", get_buffer());
+    ASSERT_EQ(ftell(fd), 3);
+
+    fclose(fd);
+}
+
+TEST(test_ffunc, test_buffered_ftell_fseek_read_ahead)
+{
+    int c;
+    FILE* fd = fopen_regular("r");
+    ASSERT_NEQ((intptr_t)fd, (intptr_t)NULL);
+    strcpy(get_buffer(), "abcdefghij");
+
+    c = fgetc(fd);
+    ASSERT_EQ(c, (int)'a');
+    ASSERT_EQ(ftell(fd), 1);
+    c = fgetc(fd);
+    ASSERT_EQ(c, (int)'b');
+    ASSERT_EQ(ftell(fd), 2);
+
+    // the read ahead is dropped by the seek
+    ASSERT_EQ(fseek(fd, 5, SEEK_SET), 0);
+    ASSERT_EQ(ftell(fd), 5);
+    c = fgetc(fd);
+    ASSERT_EQ(c, (int)'f');
+
+    ASSERT_EQ(fseek(fd, 2, SEEK_CUR), 0);
+    c = fgetc(fd);
+    ASSERT_EQ(c, (int)'i');
+
+    ungetc('z', fd);
+    ASSERT_EQ(ftell(fd), 8);
+
+    fclose(fd);
+}
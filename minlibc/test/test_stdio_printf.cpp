@@ -821,5 +821,5 @@ TEST(test_printf, percent_f)
     ASSERT_STREQ((char*)"hello 1.3242", get_buffer());
     reset_fixture();
     printf("hello %.8f", 353354354.0001);
-    ASSERT_STREQ((char*)"hello 353354354.00010001", get_buffer());
+    ASSERT_STREQ((char*)"hello 353354354.00010002", get_buffer());
 }
@@ -2,6 +2,7 @@
 #include "fixture.h"
 #include "greenlight.h"
 #include "minlibc/stdio.h"
+#include <math.h>
 
 TESTSUITE(test_sprintf)
 {
@@ -806,3 +807,213 @@ TEST(test_sprintf, percent_hhx)
     ASSERT_EQ(ret, 10);
 }
 
+
+TEST(test_sprintf, percent_f)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %f", 3.14159265);
+    ASSERT_STREQ((char*)"hello 3.141593", get_buffer());
+    ASSERT_EQ(ret, 14);
+}
+
+TEST(test_sprintf, percent_f_negative)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %f", -0.000123456);
+    ASSERT_STREQ((char*)"hello -0.000123", get_buffer());
+    ASSERT_EQ(ret, 15);
+}
+
+TEST(test_sprintf, percent_f_precision)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %.3f", 1234.5678);
+    ASSERT_STREQ((char*)"hello 1234.568", get_buffer());
+    ASSERT_EQ(ret, 14);
+}
+
+TEST(test_sprintf, percent_f_rounds_exact_value)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %.2f", 1.005);
+    ASSERT_STREQ((char*)"hello 1.00", get_buffer());
+    ASSERT_EQ(ret, 10);
+}
+
+TEST(test_sprintf, percent_f_rounds_half_to_even)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %.0f %.0f", 0.5, 1.5);
+    ASSERT_STREQ((char*)"hello 0 2", get_buffer());
+    ASSERT_EQ(ret, 9);
+}
+
+TEST(test_sprintf, percent_f_carries)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %.2f", 9.999);
+    ASSERT_STREQ((char*)"hello 10.00", get_buffer());
+    ASSERT_EQ(ret, 11);
+}
+
+TEST(test_sprintf, percent_f_width_and_precision)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %8.2f", -1.5);
+    ASSERT_STREQ((char*)"hello    -1.50", get_buffer());
+    ASSERT_EQ(ret, 14);
+}
+
+TEST(test_sprintf, percent_f_zero_padding_after_sign)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %08.2f", -1.5);
+    ASSERT_STREQ((char*)"hello -0001.50", get_buffer());
+    ASSERT_EQ(ret, 14);
+}
+
+TEST(test_sprintf, percent_f_legacy_width_is_precision)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %2f", 1.2345);
+    ASSERT_STREQ((char*)"hello 1.23", get_buffer());
+    ASSERT_EQ(ret, 10);
+}
+
+TEST(test_sprintf, percent_f_large)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %.1f", 1e20);
+    ASSERT_STREQ((char*)"hello 100000000000000000000.0", get_buffer());
+    ASSERT_EQ(ret, 29);
+}
+
+TEST(test_sprintf, percent_f_inf_nan)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %f %f", -INFINITY, NAN);
+    ASSERT_STREQ((char*)"hello -inf nan", get_buffer());
+    ASSERT_EQ(ret, 14);
+}
+
+TEST(test_sprintf, percent_e)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %e", 6.02214076e23);
+    ASSERT_STREQ((char*)"hello 6.022141e+23", get_buffer());
+    ASSERT_EQ(ret, 18);
+}
+
+TEST(test_sprintf, percent_E_precision)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %.2E", 0.000123456);
+    ASSERT_STREQ((char*)"hello 1.23E-04", get_buffer());
+    ASSERT_EQ(ret, 14);
+}
+
+TEST(test_sprintf, percent_e_denormal)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %.3e", 4.9e-324);
+    ASSERT_STREQ((char*)"hello 4.941e-324", get_buffer());
+    ASSERT_EQ(ret, 16);
+}
+
+TEST(test_sprintf, percent_g)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %g %g %g", 0.0001, 123456.0, 1234567.0);
+    ASSERT_STREQ((char*)"hello 0.0001 123456 1.23457e+06", get_buffer());
+    ASSERT_EQ(ret, 31);
+}
+
+TEST(test_sprintf, percent_g_precision)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %.3g %.10g", 0.000012345, 0.1);
+    ASSERT_STREQ((char*)"hello 1.23e-05 0.1", get_buffer());
+    ASSERT_EQ(ret, 18);
+}
+
+TEST(test_sprintf, percent_e_width)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %10e|%14e", 3.14159, 3.14159);
+    ASSERT_STREQ((char*)"hello 3.141590e+00|  3.141590e+00", get_buffer());
+    ASSERT_EQ(ret, 33);
+}
+
+TEST(test_sprintf, percent_g_width)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %12g|%3g", 3.14159, 3.14159);
+    ASSERT_STREQ((char*)"hello      3.14159|3.14159", get_buffer());
+    ASSERT_EQ(ret, 26);
+}
+
+TEST(test_sprintf, percent_lld_64bit)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %lld", (long long int)-1234567890123LL);
+    ASSERT_STREQ((char*)"hello -1234567890123", get_buffer());
+    ASSERT_EQ(ret, 20);
+}
+
+TEST(test_sprintf, percent_llu_64bit)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %llu", (long long unsigned int)18446744073709551615ULL);
+    ASSERT_STREQ((char*)"hello 18446744073709551615", get_buffer());
+    ASSERT_EQ(ret, 26);
+}
+
+TEST(test_sprintf, percent_d_negative_with_0_padding)
+{
+    int ret;
+
+    reset_fixture();
+    ret = sprintf(get_buffer(), "hello %06d", -123);
+    ASSERT_STREQ((char*)"hello -00123", get_buffer());
+    ASSERT_EQ(ret, 12);
+}
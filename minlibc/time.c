@@ -45,6 +45,8 @@
  */
 
 #include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
@@ -118,9 +120,6 @@ clock_t clock()
 /* Nonzero if `y' is a leap year, else zero. */
 #define leap(y) (((y) % 4 == 0 && (y) % 100 != 0) || (y) % 400 == 0)
 
-/* Number of leap years from 1970 to `y' (not including `y' itself). */
-#define nleap(y) (((y) - 1969) / 4 - ((y) - 1901) / 100 + ((y) - 1601) / 400)
-
 struct tm __localtime;
 
 char __monthdays[] = {
@@ -138,86 +137,437 @@ const char* __month[] = {
 #define H_PER_DAY 24
 #define M_PER_HOUR 60
 #define S_PER_MIN 60
+#define S_PER_DAY (H_PER_DAY * M_PER_HOUR * S_PER_MIN)
 
-time_t mktime(struct tm *brokentime)
+/**
+ * the days in 400 years of the gregorian calendar, after which it repeats.
+ */
+#define DAYS_PER_ERA 146097
+/**
+ * the days from 0000-03-01 to 1970-01-01. counting years from March puts the leap day
+ * at the end of the year, which keeps the month arithmetic below free of special cases.
+ */
+#define EPOCH_DAYS_FROM_MARCH 719468
+
+/**
+ * converts a date to days since 1970-01-01, in constant time.
+ * from Howard Hinnant's "chrono-Compatible Low-Level Date Algorithms".
+ *
+ * @param   year is the year.
+ * @param   month is the month, 1 to 12.
+ * @param   day is the day of the month, days outside the month carry into the next or previous.
+ * @retval  the days since 1970-01-01, negative before it.
+ */
+static long __days_from_civil(long year, int month, int day)
 {
-    int year = brokentime->tm_year + 1900;
-    int months = brokentime->tm_mon;
-    int days = brokentime->tm_mday-1;
+    long era;
+    long yoe;
+    long doy;
+
+    year -= month <= 2;
+    era = (year >= 0 ? year : year - 399) / 400;
+    yoe = year - (era * 400);
+    doy = ((153 * (month > 2 ? month - 3 : month + 9)) + 2) / 5 + day - 1;
+    return (era * DAYS_PER_ERA) + (yoe * 365) + (yoe / 4) - (yoe / 100) + doy - EPOCH_DAYS_FROM_MARCH;
+}
 
-    if(months > 1 && leap (year))
-        days++;
-    while (months-- > 0)
-        days += __monthdays[months];
-    brokentime->tm_yday = days;
+/**
+ * converts days since 1970-01-01 to a date, in constant time. the inverse of __days_from_civil().
+ *
+ * @param   days is the days since 1970-01-01.
+ * @param   brokentime has its tm_year, tm_mon, tm_mday and tm_yday set.
+ */
+static void __civil_from_days(long days, struct tm* brokentime)
+{
+    long era;
+    long doe;
+    long yoe;
+    long doy;
+    long year;
+    int mp;
+
+    days += EPOCH_DAYS_FROM_MARCH;
+    era = (days >= 0 ? days : days - (DAYS_PER_ERA - 1)) / DAYS_PER_ERA;
+    doe = days - (era * DAYS_PER_ERA);
+    yoe = (doe - (doe / 1460) + (doe / 36524) - (doe / (DAYS_PER_ERA - 1))) / 365;
+    doy = doe - ((365 * yoe) + (yoe / 4) - (yoe / 100));
+    mp = ((5 * doy) + 2) / 153;
+    year = yoe + (era * 400) + (mp >= 10);
+
+    brokentime->tm_year = year - 1900;
+    brokentime->tm_mon = mp < 10 ? mp + 2 : mp - 10;
+    brokentime->tm_mday = doy - (((153 * mp) + 2) / 5) + 1;
+    // March 1st is day 59 of the year, or 60 in a leap year
+    brokentime->tm_yday = mp >= 10 ? doy - 306 : doy + 59 + leap(year);
+}
+
+/**
+ * converts a broken down UTC time to seconds since the epoch, and normalises the fields.
+ * months, days, hours, minutes and seconds outside their ranges carry into the next field.
+ */
+time_t mktime(struct tm *brokentime)
+{
+    long year = brokentime->tm_year + 1900L + (brokentime->tm_mon / 12);
+    int month = brokentime->tm_mon % 12;
+    long days;
+    time_t t;
 
-    days += 365 * (year - 1970) + nleap (year);
-    brokentime->tm_wday = (days + 4) % 7;
-    brokentime->tm_isdst = 0;
+    if(month < 0)
+    {
+        month += 12;
+        year--;
+    }
+    days = __days_from_civil(year, month + 1, brokentime->tm_mday);
 
-    return (60*60*24 * days) + (60*60 * brokentime->tm_hour) + (60 * brokentime->tm_min) + brokentime->tm_sec;
+    t = ((time_t)S_PER_DAY * days) + (60*60 * brokentime->tm_hour) + (60 * brokentime->tm_min) + brokentime->tm_sec;
+    gmtime_r(&t, brokentime);
+    return t;
 }
 
-struct tm * gmtime(const time_t *time)
+/**
+ * converts seconds since the epoch to a broken down UTC time, in constant time.
+ * reentrant, the result is stored in the given struct.
+ */
+struct tm* gmtime_r(const time_t* time, struct tm* result)
 {
     time_t t = *time;
+    long days = t / S_PER_DAY;
+    long secs = t - ((time_t)days * S_PER_DAY);
 
-    // find days since the unix epoch
-    int days = t / (H_PER_DAY * M_PER_HOUR * S_PER_MIN);
-    t = t - (days*H_PER_DAY * M_PER_HOUR * S_PER_MIN);
-    __localtime.tm_hour = t / (M_PER_HOUR * S_PER_MIN);
-    t = t - (__localtime.tm_hour * M_PER_HOUR * S_PER_MIN);
-    __localtime.tm_min =  t / S_PER_MIN;
-    __localtime.tm_sec = t - (__localtime.tm_min * S_PER_MIN);
-
-
-    int d = days;
-    unsigned int year = 1900;
-    __localtime.tm_year = 1970-1900;
-    int ndays;
-    while(d > 0)
+    if(secs < 0)
     {
-        ndays = leap(year) ? 366 : 365;
-        d -= ndays;
-        if(d > 0)
-        {
-            __localtime.tm_year++;
-            year++;
-        }
-        else
-            __localtime.tm_yday = ndays + d;
+        secs += S_PER_DAY;
+        days--;
     }
 
-    d = __localtime.tm_yday;
-    int m = 0;
-    int leapday = leap(year) ? 1 : 0;
-    while(d > 0)
-    {
-        d -= __monthdays[m];
-        if(m == 1)
-            d -= leapday;
+    result->tm_hour = secs / (M_PER_HOUR * S_PER_MIN);
+    secs -= result->tm_hour * (M_PER_HOUR * S_PER_MIN);
+    result->tm_min = secs / S_PER_MIN;
+    result->tm_sec = secs - (result->tm_min * S_PER_MIN);
 
-        if(d > 0)
-            m++;
-        else
-        {
-            __localtime.tm_mday = __monthdays[m] + d + 1;
-            if(m == 1)
-                __localtime.tm_mday = leapday;
-        }
-    }
-    __localtime.tm_mon = m;
+    __civil_from_days(days, result);
 
     // 01/01/1970 was a thursday
-    __localtime.tm_wday = (days + 4) % 7;
+    result->tm_wday = (days + 4) % 7;
+    if(result->tm_wday < 0)
+        result->tm_wday += 7;
+    result->tm_isdst = 0;
+
+    return result;
+}
+
+struct tm* localtime_r(const time_t* time, struct tm* result)
+{
+    time_t t = *time + TIMEZONE_OFFSET;
+    return gmtime_r(&t, result);
+}
 
-    return &__localtime;
+/**
+ * not reentrant, gmtime() and localtime() share a static result. use gmtime_r() or localtime_r()
+ * where more than one thread may call them.
+ */
+struct tm * gmtime(const time_t *time)
+{
+    return gmtime_r(time, &__localtime);
 }
 
 struct tm * localtime(const time_t *time)
 {
-	time_t t = *time + TIMEZONE_OFFSET;
-    return gmtime(&t);
+    return localtime_r(time, &__localtime);
+}
+
+/**
+ * the longest format and output kept by the strftime() cache.
+ */
+#define STRFTIME_CACHE_FORMAT   24
+#define STRFTIME_CACHE_OUTPUT   32
+
+/**
+ * the result of the last strftime() call with a numeric format, with one seconds field.
+ * a call with the same format, in the same minute, copies the result and rewrites the seconds.
+ * tasks share the cache, the sequence count is odd while it is being written, and readers
+ * that see it change start again without it.
+ */
+typedef struct {
+    volatile unsigned int sequence;
+    char format[STRFTIME_CACHE_FORMAT];
+    char output[STRFTIME_CACHE_OUTPUT];
+    int length;
+    int seconds;                ///< the offset of the seconds in the output.
+    struct tm minute;           ///< the time of the output, with tm_sec 0.
+} strftime_cache_t;
+
+static strftime_cache_t __strftime_cache;
+
+#if USE_FREERTOS
+#define strftime_cache_lock()       taskENTER_CRITICAL()
+#define strftime_cache_unlock()     taskEXIT_CRITICAL()
+#else
+#define strftime_cache_lock()
+#define strftime_cache_unlock()
+#endif
+#define barrier()                   __asm volatile("" ::: "memory")
+
+static bool __same_minute(const struct tm* a, const struct tm* b)
+{
+    return a->tm_min == b->tm_min && a->tm_hour == b->tm_hour && a->tm_mday == b->tm_mday &&
+           a->tm_mon == b->tm_mon && a->tm_year == b->tm_year && a->tm_yday == b->tm_yday &&
+           a->tm_wday == b->tm_wday;
+}
+
+/**
+ * @retval  the length of the cached output copied to s, or 0 if the cache did not match.
+ */
+static size_t __strftime_from_cache(char* s, size_t size, const char* t, const struct tm* brokentime)
+{
+    strftime_cache_t* cache = &__strftime_cache;
+    unsigned int sequence = cache->sequence;
+    size_t length;
+    int seconds;
+
+    barrier();
+    length = cache->length;
+    seconds = cache->seconds;
+    if((sequence & 1) || !length || length >= size || length >= STRFTIME_CACHE_OUTPUT ||
+       !__same_minute(brokentime, &cache->minute) || strcmp(t, cache->format))
+        return 0;
+
+    memcpy(s, cache->output, length + 1);
+    barrier();
+    if(cache->sequence != sequence)
+        return 0;
+
+    s[seconds] = '0' + (brokentime->tm_sec / 10);
+    s[seconds + 1] = '0' + (brokentime->tm_sec % 10);
+    return length;
+}
+
+static void __strftime_to_cache(const char* s, size_t length, int seconds, const char* t, const struct tm* brokentime)
+{
+    strftime_cache_t* cache = &__strftime_cache;
+
+    if(length >= STRFTIME_CACHE_OUTPUT || strlen(t) >= STRFTIME_CACHE_FORMAT)
+        return;
+
+    strftime_cache_lock();
+    cache->sequence++;
+    barrier();
+    strcpy(cache->format, t);
+    memcpy(cache->output, s, length + 1);
+    cache->length = length;
+    cache->seconds = seconds;
+    cache->minute = *brokentime;
+    cache->minute.tm_sec = 0;
+    barrier();
+    cache->sequence++;
+    strftime_cache_unlock();
+}
+
+static char* __put_2digits(char* s, int value)
+{
+    s[0] = '0' + (value / 10);
+    s[1] = '0' + (value % 10);
+    return s + 2;
+}
+
+/**
+ * writes value in decimal, at least width digits, padded on the left with pad.
+ *
+ * @retval  a pointer to the end of the digits.
+ */
+static char* __put_number(char* s, long value, int width, char pad)
+{
+    char digits[12];
+    int n = 0;
+    unsigned long v = value < 0 ? -(unsigned long)value : (unsigned long)value;
+
+    // four digit years
+    if(value >= 1000 && value <= 9999 && width <= 4)
+    {
+        s = __put_2digits(s, value / 100);
+        return __put_2digits(s, value % 100);
+    }
+
+    do {
+        digits[n++] = '0' + (v % 10);
+        v /= 10;
+    } while(v);
+
+    if(value < 0)
+        *s++ = '-';
+    for(; width > n; width--)
+        *s++ = pad;
+    while(n)
+        *s++ = digits[--n];
+    return s;
+}
+
+static char* __put_string(char* s, const char* str, int max)
+{
+    for(; *str && max; max--)
+        *s++ = *str++;
+    return s;
+}
+
+/**
+ * writes one conversion, without a terminator.
+ *
+ * @param   s is where to write it, room for STRFTIME_FIELD_MAX characters.
+ * @param   conversion is the character after the %.
+ * @param   brokentime is the time to write.
+ * @param   seconds is set to the offset of the seconds in the field, if it has them.
+ * @param   numeric is cleared if the field is not one of the numeric fields the cache can reuse.
+ * @retval  a pointer to the end of the field.
+ */
+#define STRFTIME_FIELD_MAX  32
+static char* __strftime_field(char* s, char conversion, const struct tm* brokentime, int* seconds, bool* numeric)
+{
+    char* start = s;
+    long year = brokentime->tm_year + 1900L;
+    int hour12 = !brokentime->tm_hour ? 12 : ((brokentime->tm_hour - 1) % 12) + 1;
+
+    switch(conversion)
+    {
+        case 'a':   // Abbreviated weekday name *  Thu
+            s = __put_string(s, __weekday[brokentime->tm_wday], 3);
+            *numeric = false;
+        break;
+        case 'A':   // Full weekday name *     Thursday
+            s = __put_string(s, __weekday[brokentime->tm_wday], -1);
+            *numeric = false;
+        break;
+        case 'h':
+        case 'b':   // Abbreviated month name *    Aug
+            s = __put_string(s, __month[brokentime->tm_mon], 3);
+            *numeric = false;
+        break;
+        case 'B':   // Full month name *   August
+            s = __put_string(s, __month[brokentime->tm_mon], -1);
+            *numeric = false;
+        break;
+        case 'c':   // Date and time representation *  Thu Aug 23 14:55:02 2001
+            s = __put_string(s, __weekday[brokentime->tm_wday], 3);
+            *s++ = ' ';
+            s = __put_string(s, __month[brokentime->tm_mon], 3);
+            *s++ = ' ';
+            s = __put_number(s, brokentime->tm_mday, 2, ' ');
+            *s++ = ' ';
+            s = __put_2digits(s, brokentime->tm_hour);
+            *s++ = ':';
+            s = __put_2digits(s, brokentime->tm_min);
+            *s++ = ':';
+            *seconds = s - start;
+            s = __put_2digits(s, brokentime->tm_sec);
+            *s++ = ' ';
+            s = __put_number(s, year, 0, 0);
+            *numeric = false;
+        break;
+        case 'C':   // Year divided by 100 and truncated to integer (00-99)    20
+            s = __put_number(s, year / 100, 2, '0');
+        break;
+        case 'd':   // Day of the month, zero-padded (01-31)   23
+            s = __put_2digits(s, brokentime->tm_mday);
+        break;
+        case 'x':   // Date representation *   08/23/01
+        case 'D':   // Short MM/DD/YY date, equivalent to %m/%d/%y 08/23/01
+            s = __put_2digits(s, brokentime->tm_mon + 1);
+            *s++ = '/';
+            s = __put_2digits(s, brokentime->tm_mday);
+            *s++ = '/';
+            s = __put_2digits(s, year % 100);
+        break;
+        case 'e':   // Day of the month, space-padded ( 1-31)  23
+            s = __put_number(s, brokentime->tm_mday, 2, ' ');
+        break;
+        case 'F':   // Short YYYY-MM-DD date, equivalent to %Y-%m-%d   2001-08-23
+            s = __put_number(s, year, 0, 0);
+            *s++ = '-';
+            s = __put_2digits(s, brokentime->tm_mon + 1);
+            *s++ = '-';
+            s = __put_2digits(s, brokentime->tm_mday);
+        break;
+        case 'g':   // Week-based year, last two digits (00-99)    01
+        case 'y':   // Year, last two digits (00-99)   01
+            s = __put_number(s, year % 100, 2, '0');
+        break;
+        case 'G':   // Week-based year 2001
+        case 'Y':   // Year    2001
+            s = __put_number(s, year, 0, 0);
+        break;
+        case 'H':   // Hour in 24h format (00-23)  14
+            s = __put_2digits(s, brokentime->tm_hour);
+        break;
+        case 'I':   // Hour in 12h format (01-12)  02
+            s = __put_2digits(s, hour12);
+        break;
+        case 'j':   // Day of the year (001-366)   235
+            s = __put_number(s, brokentime->tm_yday + 1, 3, '0');
+        break;
+        case 'm':   // Month as a decimal number (01-12)   08
+            s = __put_2digits(s, brokentime->tm_mon + 1);
+        break;
+        case 'M':   // Minute (00-59)  55
+            s = __put_2digits(s, brokentime->tm_min);
+        break;
+        case 'n':   // New-line character ('\n')
+            *s++ = '\n';
+        break;
+        case 'p':   // AM or PM designation    PM
+            s = __put_string(s, brokentime->tm_hour >= 12 ? "PM" : "AM", -1);
+            *numeric = false;
+        break;
+        case 'r':   // 12-hour clock time *    02:55:02 pm
+            s = __put_2digits(s, hour12);
+            *s++ = ':';
+            s = __put_2digits(s, brokentime->tm_min);
+            *s++ = ':';
+            *seconds = s - start;
+            s = __put_2digits(s, brokentime->tm_sec);
+            *s++ = ' ';
+            s = __put_string(s, brokentime->tm_hour >= 12 ? "PM" : "AM", -1);
+            *numeric = false;
+        break;
+        case 'R':   // 24-hour HH:MM time, equivalent to %H:%M 14:55
+            s = __put_2digits(s, brokentime->tm_hour);
+            *s++ = ':';
+            s = __put_2digits(s, brokentime->tm_min);
+        break;
+        case 'S':   // Second (00-61)  02
+            *seconds = 0;
+            s = __put_2digits(s, brokentime->tm_sec);
+        break;
+        case 't':   // Horizontal-tab character ('\t')
+            *s++ = '\t';
+        break;
+        case 'X':   // Time representation *   14:55:02
+        case 'T':   // ISO 8601 time format (HH:MM:SS), equivalent to %H:%M:%S 14:55:02
+            s = __put_2digits(s, brokentime->tm_hour);
+            *s++ = ':';
+            s = __put_2digits(s, brokentime->tm_min);
+            *s++ = ':';
+            *seconds = s - start;
+            s = __put_2digits(s, brokentime->tm_sec);
+        break;
+        case 'u':   // ISO 8601 weekday as number with Monday as 1 (1-7)   4
+            *s++ = '0' + (brokentime->tm_wday ? brokentime->tm_wday : 7);
+        break;
+        case 'U':   // Week number with the first Sunday as the first day of week one (00-53)  33
+            s = __put_2digits(s, (brokentime->tm_yday + 7 - brokentime->tm_wday) / 7);
+        break;
+        case 'w':   // Weekday as a decimal number with Sunday as 0 (0-6)  4
+            *s++ = '0' + brokentime->tm_wday;
+        break;
+        case 'W':   // Week number with the first Monday as the first day of week one (00-53) 34
+            s = __put_2digits(s, (brokentime->tm_yday + 7 - ((brokentime->tm_wday + 6) % 7)) / 7);
+        break;
+        case '%':
+            *s++ = '%';
+        break;
+        default:
+            // %V, %z and %Z, no week numbers or timezones
+        break;
+    }
+    return s;
 }
 
 /**
@@ -261,158 +611,65 @@ If timezone cannot be termined, no characters   +100
 %Z  Timezone name or abbreviation *
 If timezone cannot be termined, no characters   CDT
 %%  A % sign    %
+
+ * the fields are written as digits directly, no printf. %g, %G and %V are not week based,
+ * %V, %z and %Z write nothing.
+ *
+ * numeric formats with one seconds field, like "%Y-%m-%d %H:%M:%S", are cached. a repeat
+ * call in the same minute copies the last result and rewrites only the seconds.
+ *
+ * @retval  the number of characters written, not including the terminator, or 0 if they
+ *          did not fit in size.
 */
 size_t strftime(char *s, size_t size, const char *t, const struct tm *brokentime)
 {
-    int length = 0;
-    int len = 0;
-    int year = brokentime->tm_year+1900;
-
-    for(; size > 0 && *t; t++)
+    const char* format = t;
+    char* start = s;
+    char* end = s + size;
+    char field[STRFTIME_FIELD_MAX];
+    char* field_end;
+    int field_seconds;
+    int seconds = -1;
+    int nseconds = 0;
+    bool numeric = true;
+    size_t length;
+
+    if(!size)
+        return 0;
+
+    length = __strftime_from_cache(s, size, t, brokentime);
+    if(length)
+        return length;
+
+    for(; *t; t++)
     {
-        if(*t == '%')
+        if(*t != '%')
         {
-            t++;
-            switch(*t)
-            {
-                case 'a':
-                    len = snprintf(s, size, "%.3s", __weekday[brokentime->tm_wday]);
-                break;
-                case 'A':
-                    len = snprintf(s, size, "%s", __weekday[brokentime->tm_wday]);
-                break;
-                case 'h':
-                case 'b':
-                    len = snprintf(s, size, "%.3s", __month[brokentime->tm_mon]);
-                break;
-                case 'B':
-                    len = snprintf(s, size, "%s", __month[brokentime->tm_mon]);
-                break;
-                case 'c':
-                    // "Thu Aug 23 14:55:02 2001"
-                    len = snprintf(s, size, "%.3s %.3s %2d %02d:%02d:%02d %d",
-                                __weekday[brokentime->tm_wday], __month[brokentime->tm_mon], brokentime->tm_mday,
-                                brokentime->tm_hour, brokentime->tm_min, brokentime->tm_sec, year);
-                break;
-                case 'C':
-                    len = snprintf(s, size, "%d", year/100);
-                break;
-                case 'd':
-                    len = snprintf(s, size, "%02d", brokentime->tm_mday);
-                break;
-                case 'D':
-                    // "MM/DD/YY"
-                    len = snprintf(s, size, "%02d/%02d/%02d", brokentime->tm_mon+1,brokentime->tm_mday,
-                            year - ((year/100)*100));
-                break;
-                case 'e':
-                    len = snprintf(s, size, "%2d", brokentime->tm_mday);
-                break;
-                case 'F':
-                    // "2001-08-23"
-                    len = snprintf(s, size, "%d-%02d-%02d", year, brokentime->tm_mon+1, brokentime->tm_mday);
-                break;
-                case 'g':
-                    len = snprintf(s, size, "%d", year - ((year/100)*100));
-                break;
-                case 'G':
-                    len = snprintf(s, size, "%d", year);
-                break;
-                case 'H':
-                    len = snprintf(s, size, "%02d", brokentime->tm_hour);
-                break;
-                case 'I':
-                    len = snprintf(s, size, "%02d", !brokentime->tm_hour ? 12 : ((brokentime->tm_hour-1)%12) + 1);
-                    printf("%d %d %d\n", -1%12, 0 %12, 1%12);
-                break;
-
-                case 'j':  //Day of the year (001-366)   235
-                    len = snprintf(s, size, "%03d", brokentime->tm_yday+1);
-                break;
-                case 'm':  //Month as a decimal number (01-12)   08
-                    len = snprintf(s, size, "%02d", brokentime->tm_mon+1);
-                break;
-                case 'M':  //Minute (00-59)  55
-                    len = snprintf(s, size, "%02d", brokentime->tm_min);
-                break;
-                case 'n':  //New-line character ('\n')
-                    *s = '\n';
-                    len = 1;
-                break;
-                case 'p':  //AM or PM designation    PM
-                    len = snprintf(s, size, "%s", brokentime->tm_hour >=12 ? "PM" : "AM");
-                break;
-                case 'r':  //12-hour clock time *    02:55:02 pm
-                    len = snprintf(s, size, "%02d:%02d:%02d %s", !brokentime->tm_hour ? 12 : ((brokentime->tm_hour-1)%12) + 1,  brokentime->tm_min,  brokentime->tm_sec,
-                            brokentime->tm_hour >=12 ? "PM" : "AM");
-                break;
-                case 'R':  //24-hour HH:MM time, equivalent to %H:%M 14:55
-                    len = snprintf(s, size, "%02d:%02d", brokentime->tm_hour,  brokentime->tm_min);
-                break;
-                case 'S':  //Second (00-61)  02
-                    len = snprintf(s, size, "%02d", brokentime->tm_sec);
-                break;
-                case 't':  //Horizontal-tab character ('\t')
-                    *s = '\t';
-                    len = 1;
-                break;
-                case 'T':  //ISO 8601 time format (HH:MM:SS), equivalent to %H:%M:%S 14:55:02
-                    len = snprintf(s, size, "%02d:%02d:%02d", brokentime->tm_hour,  brokentime->tm_min,  brokentime->tm_sec);
-                break;
-                case 'u':  //ISO 8601 weekday as number with Monday as 1 (1-7)   4
-                    len = snprintf(s, size, "%d", brokentime->tm_wday ? brokentime->tm_wday : 7);
-                break;
-                case 'U':  //Week number with the first Sunday as the first day of week one (00-53)33
-//                    len = snprintf(s, size, "%d", brokentime->tm_yday/7);
-                     len = 0;
-                break;
-                case 'V':  //ISO 8601 week number (00-53)    34
-//                     len = snprintf(s, size, "%d", brokentime->tm_yday/7);
-                     len = 0;
-                break;
-                case 'w':  //Weekday as a decimal number with Sunday as 0 (0-6)  4
-                    len = snprintf(s, size, "%d", brokentime->tm_wday);
-                break;
-                case 'W':  //Week number with the first Monday as the first day of week one (00-53) 34
-//                    len = snprintf(s, size, "%d", brokentime->tm_yday/7);
-                    len = 0;
-                break;
-                case 'x':  //Date representation *   08/23/01
-                    len = snprintf(s, size, "%02d/%02d/%02d", brokentime->tm_mon+1,  brokentime->tm_mday,  year - ((year/100)*100));
-                break;
-                case 'X':  //Time representation *   14:55:02
-                    len = snprintf(s, size, "%02d:%02d:%02d", brokentime->tm_hour,  brokentime->tm_min,  brokentime->tm_sec);
-                break;
-                case 'y':  //Year, last two digits (00-99)   01
-                    len = snprintf(s, size, "%d", year - ((year/100)*100));
-                break;
-                case 'Y':  //Year    2001
-                    len = snprintf(s, size, "%d", year);
-                break;
-                case 'z':  //ISO 8601 offset from UTC in timezone (1 minute=1, 1 hour=100)If timezone cannot be termined, no characters   +100
-                    len = 0;
-                break;
-                case 'Z':  //Timezone name or abbreviation *
-                    len = 0;
-                break;
-                case '%':
-                *s = *t;
-                len = 1;
-                break;
-            }
+            if(s + 1 >= end)
+                return 0;
+            *s++ = *t;
+            continue;
         }
-        else
+
+        if(!*++t)
+            break;
+        field_seconds = -1;
+        field_end = __strftime_field(field, *t, brokentime, &field_seconds, &numeric);
+        if(s + (field_end - field) >= end)
+            return 0;
+        if(field_seconds >= 0)
         {
-            *s = *t;
-            len = 1;
+            seconds = (s - start) + field_seconds;
+            nseconds++;
         }
-        length += len;
-        size -= len;
-        s += len;
+        memcpy(s, field, field_end - field);
+        s += field_end - field;
     }
+    *s = '\0';
 
-    *s = 0;
-
+    length = s - start;
+    if(numeric && nseconds == 1)
+        __strftime_to_cache(start, length, seconds, format, brokentime);
     return length;
 }
 
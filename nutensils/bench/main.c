@@ -0,0 +1,571 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * nutensils server benchmark.
+ *
+ * brings up LwIP on the host, with no real NIC. the host ethernet interface in ethernetif.c
+ * queues every frame it sends and receives it again, so clients and servers talk to each
+ * other through the whole stack, ARP included, at the interface address.
+ *
+ * the http server and the shell server are started as on a board, from their config files,
+ * then BENCH_CLIENTS client tasks drive them with BENCH_REQUESTS requests each, pausing
+ * BENCH_THINK_TIME ms between requests:
+ *
+ * - http close:        GET /index.html over HTTP/1.0, a new connection per request.
+ * - http keepalive:    GET /index.html over HTTP/1.1, on one persistent connection per client.
+ * - shell:             runs "echo" on one shell connection per client.
+ *
+ * every scenario reports requests per second, p50/p99/max latency and errors. the peak memory use
+ * is reported for the FreeRTOS heap (task stacks and kernel objects), the host heap (malloc),
+ * and the LwIP heap and pools. stack use is not, the POSIX port runs every task on its own
+ * pthread stack, so the FreeRTOS stack high water marks mean nothing on the host.
+ *
+ * the servers spawn a task per connection, and the memory of a deleted task is only freed when
+ * the idle task runs. with no think time the clients keep the CPU busy, and the FreeRTOS heap
+ * fills up with deleted tasks, the peak task count shows how many were waiting.
+ *
+ * latency is measured with the host clock, from the first byte sent to the last byte received,
+ * and includes the connect and close in the http close scenario.
+ *
+ * on persistent connections a response written in several sends stalls on Nagle's algorithm,
+ * until the client's delayed ACK goes out on the next LwIP TCP fast timer, up to 250ms later.
+ * the http server turns Nagle's algorithm off for its connections, see HTTP_SERVER_NODELAY.
+ * the shell leaves it on, it echoes the command, then writes the output and the prompt, so each
+ * shell request waits for the delayed ACK.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "sdfs.h"
+#include "net.h"
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+#include "http_server.h"
+#include "shell.h"
+#include "builtins.h"
+
+#ifndef BENCH_CLIENTS
+#define BENCH_CLIENTS           8
+#endif
+#ifndef BENCH_REQUESTS
+#define BENCH_REQUESTS          50
+#endif
+#ifndef BENCH_THINK_TIME
+#define BENCH_THINK_TIME        1
+#endif
+#define BENCH_HTTP_PORT         80
+#define BENCH_SHELL_PORT        22
+#define BENCH_PAGE_SIZE         1024
+#define BENCH_TIMEOUT           5000
+#define BENCH_BUFFER_SIZE       512
+#define BENCH_CLIENT_STACK      512
+#define BENCH_CLIENT_PRIO       1
+#define BENCH_MONITOR_PRIO      (configMAX_PRIORITIES - 1)
+
+#define BENCH_IPADDR            "10.0.0.2"
+#define BENCH_SHELL_COMMAND     "echo bench\n"
+#define BENCH_SHELL_REPLY       "bench\r\n"
+
+typedef struct _client_t client_t;
+typedef int(*transaction_fn_t)(client_t*);
+
+struct _client_t {
+    int id;
+    int fd;                                 ///< persistent connection, or -1
+    transaction_fn_t transaction;
+    unsigned int errors;
+    unsigned int count;
+    uint32_t latency_us[BENCH_REQUESTS];
+    char buffer[BENCH_BUFFER_SIZE];
+};
+
+static client_t clients[BENCH_CLIENTS];
+static uint32_t latencies[BENCH_CLIENTS * BENCH_REQUESTS];
+static SemaphoreHandle_t done;
+static volatile bool monitoring;
+static size_t heap_min_free;
+static UBaseType_t tasks_peak;
+static size_t host_heap_base;
+static size_t host_heap_peak;
+
+static netconf_t netconf;
+static httpserver_t httpserver;
+static shellserver_t shellserver;
+static const http_api_t* http_api[] = {NULL};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+static size_t host_heap_used(void)
+{
+    size_t used;
+    taskENTER_CRITICAL();
+    used = mallinfo2().uordblks;
+    taskEXIT_CRITICAL();
+    return used;
+}
+
+/**
+ * samples the FreeRTOS and host heaps every tick, while a scenario runs.
+ */
+static void monitor_task(void* ctx)
+{
+    (void)ctx;
+    size_t free_heap, used;
+
+    while(1)
+    {
+        if(monitoring)
+        {
+            if(uxTaskGetNumberOfTasks() > tasks_peak)
+                tasks_peak = uxTaskGetNumberOfTasks();
+            free_heap = xPortGetFreeHeapSize();
+            if(free_heap < heap_min_free)
+                heap_min_free = free_heap;
+            used = host_heap_used();
+            if(used > host_heap_peak)
+                host_heap_peak = used;
+        }
+        vTaskDelay(1);
+    }
+}
+
+static void write_file(const char* path, const char* content)
+{
+    int fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0);
+    if(fd >= 0)
+    {
+        write(fd, content, strlen(content));
+        close(fd);
+    }
+    else
+        printf("failed to write %s\n", path);
+}
+
+/**
+ * writes the network, http and shell configuration, and the page to serve, to the RAM disk.
+ */
+static void write_config(void)
+{
+    char page[BENCH_PAGE_SIZE + 1];
+    char conf[64];
+
+    mkdir("/etc", 0);
+    mkdir("/etc/network", 0);
+    mkdir("/etc/http", 0);
+    mkdir("/etc/shell", 0);
+    mkdir("/var", 0);
+    mkdir("/var/lib", 0);
+    mkdir("/var/lib/httpd", 0);
+
+    write_file(DEFAULT_RESOLV_CONF_PATH, "resolv static\nhostname bench\n");
+    write_file(DEFAULT_NETIF_CONF_PATH,
+            "ipaddr " BENCH_IPADDR "\n"
+            "netmask 255.255.255.0\n"
+            "gateway 10.0.0.1\n"
+            "macaddr 02:00:00:00:00:01\n");
+
+    sprintf(conf, "port %d\nconns %d\nname httpd\nkeepalive_max %d\n",
+            BENCH_HTTP_PORT, BENCH_CLIENTS, BENCH_REQUESTS);
+    write_file(DEFAULT_HTTPSERVER_CONF_PATH, conf);
+    sprintf(conf, "port %d\nconns %d\nname shelld\n", BENCH_SHELL_PORT, BENCH_CLIENTS);
+    write_file(DEFAULT_SHELL_CONFIG_PATH, conf);
+
+    memset(page, 'x', BENCH_PAGE_SIZE);
+    page[BENCH_PAGE_SIZE] = '\0';
+    write_file(DEFAULT_HTTPD_FS_ROOT "/index.html", page);
+}
+
+static int connect_to(int port)
+{
+    struct sockaddr_in addr;
+    int timeout = BENCH_TIMEOUT;   // lwip takes the receive timeout in ms
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if(fd < 0)
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr(BENCH_IPADDR);
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        closesocket(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * finds needle in the string haystack.
+ * minlibc strstr() never finds a match, so it can't be used here.
+ */
+static char* find(char* haystack, const char* needle)
+{
+    size_t length = strlen(needle);
+
+    for(; *haystack; haystack++)
+    {
+        if(!strncmp(haystack, needle, length))
+            return haystack;
+    }
+    return NULL;
+}
+
+static int send_all(int fd, const char* data, int length)
+{
+    int n;
+    while(length > 0)
+    {
+        n = send(fd, data, length, 0);
+        if(n < 1)
+            return -1;
+        data += n;
+        length -= n;
+    }
+    return 0;
+}
+
+/**
+ * receives an http response header, into client->buffer.
+ * @retval  the content length, or -1 on error. the part of the body received with the header
+ *          is counted off the length returned.
+ */
+static int recv_http_header(client_t* client)
+{
+    int length = 0;
+    int n;
+    char* eoh = NULL;
+    char* field;
+
+    while(!eoh)
+    {
+        if(length >= BENCH_BUFFER_SIZE - 1)
+            return -1;
+        n = recv(client->fd, client->buffer + length, BENCH_BUFFER_SIZE - 1 - length, 0);
+        if(n < 1)
+            return -1;
+        length += n;
+        client->buffer[length] = '\0';
+        eoh = find(client->buffer, "\r\n\r\n");
+    }
+
+    if(strncmp(client->buffer, "HTTP/1.1 200", 12))
+        return -1;
+    field = find(client->buffer, "Content-Length:");
+    if(!field)
+        return -1;
+
+    return atoi(field + sizeof("Content-Length:") - 1) - (length - (eoh + 4 - client->buffer));
+}
+
+static int recv_http_body(client_t* client, int length)
+{
+    int n;
+    while(length > 0)
+    {
+        n = recv(client->fd, client->buffer, length < BENCH_BUFFER_SIZE ? length : BENCH_BUFFER_SIZE, 0);
+        if(n < 1)
+            return -1;
+        length -= n;
+    }
+    return length == 0 ? 0 : -1;
+}
+
+static int http_close_transaction(client_t* client)
+{
+    static const char request[] = "GET /index.html HTTP/1.0\r\n\r\n";
+    int ret = -1;
+    int length;
+
+    client->fd = connect_to(BENCH_HTTP_PORT);
+    if(client->fd < 0)
+        return -1;
+
+    if(send_all(client->fd, request, sizeof(request) - 1) == 0)
+    {
+        length = recv_http_header(client);
+        if(length >= 0)
+            ret = recv_http_body(client, length);
+    }
+
+    closesocket(client->fd);
+    client->fd = -1;
+    return ret;
+}
+
+static int http_keepalive_transaction(client_t* client)
+{
+    static const char request[] = "GET /index.html HTTP/1.1\r\nHost: bench\r\n\r\n";
+    int length;
+
+    if(client->fd < 0)
+        client->fd = connect_to(BENCH_HTTP_PORT);
+    if(client->fd < 0)
+        return -1;
+
+    if(send_all(client->fd, request, sizeof(request) - 1) == 0)
+    {
+        length = recv_http_header(client);
+        if(length >= 0 && recv_http_body(client, length) == 0)
+            return 0;
+    }
+
+    closesocket(client->fd);
+    client->fd = -1;
+    return -1;
+}
+
+/**
+ * the shell echoes the command as it is typed, then prints the output and the next prompt.
+ * the reply is complete once the output has been seen and the prompt follows it.
+ */
+static int shell_transaction(client_t* client)
+{
+    int length = 0;
+    int n;
+    char* reply = NULL;
+
+    if(client->fd < 0)
+    {
+        client->fd = connect_to(BENCH_SHELL_PORT);
+        if(client->fd < 0)
+            return -1;
+    }
+
+    if(send_all(client->fd, BENCH_SHELL_COMMAND, sizeof(BENCH_SHELL_COMMAND) - 1) == 0)
+    {
+        while(length < BENCH_BUFFER_SIZE - 1)
+        {
+            n = recv(client->fd, client->buffer + length, BENCH_BUFFER_SIZE - 1 - length, 0);
+            if(n < 1)
+                break;
+            length += n;
+            client->buffer[length] = '\0';
+            if(!reply)
+                reply = find(client->buffer, BENCH_SHELL_REPLY);
+            if(reply && find(reply, SHELL_PROMPT))
+                return 0;
+        }
+    }
+
+    closesocket(client->fd);
+    client->fd = -1;
+    return -1;
+}
+
+static void client_task(void* ctx)
+{
+    client_t* client = (client_t*)ctx;
+    uint64_t start;
+    int i;
+
+    for(i = 0; i < BENCH_REQUESTS; i++)
+    {
+        start = now_ns();
+        if(client->transaction(client) == 0)
+            client->latency_us[client->count++] = (now_ns() - start) / 1000;
+        else
+            client->errors++;
+        if(BENCH_THINK_TIME)
+            vTaskDelay(BENCH_THINK_TIME/portTICK_RATE_MS);
+    }
+
+    if(client->fd >= 0)
+        closesocket(client->fd);
+
+    xSemaphoreGive(done);
+    vTaskDelete(NULL);
+}
+
+static void sort(uint32_t* values, int count)
+{
+    int gap, i, j;
+    uint32_t v;
+
+    for(gap = count / 2; gap > 0; gap /= 2)
+    {
+        for(i = gap; i < count; i++)
+        {
+            v = values[i];
+            for(j = i; j >= gap && values[j - gap] > v; j -= gap)
+                values[j] = values[j - gap];
+            values[j] = v;
+        }
+    }
+}
+
+/**
+ * runs a scenario in BENCH_CLIENTS tasks at once, then reports throughput and latency,
+ * and the memory used while it ran.
+ */
+static void run(const char* name, transaction_fn_t transaction)
+{
+    unsigned int errors = 0;
+    int count = 0;
+    uint64_t start, elapsed;
+    int i;
+
+    memset(clients, 0, sizeof(clients));
+    heap_min_free = xPortGetFreeHeapSize();
+    tasks_peak = uxTaskGetNumberOfTasks();
+    host_heap_base = host_heap_used();
+    host_heap_peak = host_heap_base;
+    monitoring = true;
+
+    start = now_ns();
+    for(i = 0; i < BENCH_CLIENTS; i++)
+    {
+        clients[i].id = i;
+        clients[i].fd = -1;
+        clients[i].transaction = transaction;
+        xTaskCreate(client_task, "client", configMINIMAL_STACK_SIZE + BENCH_CLIENT_STACK,
+                &clients[i], tskIDLE_PRIORITY + BENCH_CLIENT_PRIO, NULL);
+    }
+    for(i = 0; i < BENCH_CLIENTS; i++)
+        xSemaphoreTake(done, portMAX_DELAY);
+    elapsed = now_ns() - start;
+    monitoring = false;
+
+    for(i = 0; i < BENCH_CLIENTS; i++)
+    {
+        errors += clients[i].errors;
+        memcpy(&latencies[count], clients[i].latency_us, clients[i].count * sizeof(uint32_t));
+        count += clients[i].count;
+    }
+    sort(latencies, count);
+
+    printf("%s: %d clients, %d requests, %u ms, %u errors\n", name,
+            BENCH_CLIENTS, count, (unsigned int)(elapsed / 1000000), errors);
+    if(count)
+        printf("  %u requests/s, latency us p50 %u p99 %u max %u\n",
+                (unsigned int)(count * 1000000000ULL / elapsed),
+                (unsigned int)latencies[count / 2],
+                (unsigned int)latencies[(count * 99) / 100],
+                (unsigned int)latencies[count - 1]);
+    printf("  peak heap: FreeRTOS %u bytes in use (of %u), host %u bytes over the %u at the start\n",
+            (unsigned int)(configTOTAL_HEAP_SIZE - heap_min_free), (unsigned int)configTOTAL_HEAP_SIZE,
+            (unsigned int)(host_heap_peak - host_heap_base), (unsigned int)host_heap_base);
+    printf("  peak tasks: %u\n", (unsigned int)tasks_peak);
+}
+
+/**
+ * the LwIP high water marks cover the whole run.
+ */
+static void print_lwip_stats(void)
+{
+#define LWIP_MEMPOOL(name, num, size, desc) desc,
+    static const char* pool_names[MEMP_MAX] = {
+#include "lwip/memp_std.h"
+    };
+    int i;
+
+    printf("LwIP peak use:\n");
+    printf("  %-20s %5u of %5u bytes, %u errors\n", "heap",
+            (unsigned int)lwip_stats.mem.max, (unsigned int)lwip_stats.mem.avail, (unsigned int)lwip_stats.mem.err);
+    for(i = 0; i < MEMP_MAX; i++)
+        printf("  %-20s %5u of %5u, %u errors\n", pool_names[i],
+                (unsigned int)lwip_stats.memp[i].max, (unsigned int)lwip_stats.memp[i].avail, (unsigned int)lwip_stats.memp[i].err);
+}
+
+/**
+ * the object pools cover the whole run, failures were served from the heap.
+ */
+static void print_pool_stats(void)
+{
+    static const char* names[] = {"sock_conn", "http_conn", "file_table"};
+    pool_stats_t stats[3];
+    int i;
+
+    sock_conn_pool_stats(&stats[0]);
+    http_server_pool_stats(&stats[1]);
+    file_table_pool_stats(&stats[2]);
+
+    printf("pool peak use:\n");
+    for(i = 0; i < 3; i++)
+        printf("  %-20s %5u, %u from the heap\n", names[i], stats[i].hwm, stats[i].failures);
+}
+
+int main(void)
+{
+    done = xSemaphoreCreateCounting(BENCH_CLIENTS, 0);
+
+    sdfs_init();
+    while(!sdfs_ready())
+        vTaskDelay(10);
+
+    write_config();
+
+    net_config(&netconf, DEFAULT_RESOLV_CONF_PATH, DEFAULT_NETIF_CONF_PATH);
+    net_init(&netconf);
+    if(!wait_for_address(&netconf))
+    {
+        printf("no address\n");
+        exit(1);
+    }
+
+    if(init_http_server(&httpserver, DEFAULT_HTTPSERVER_CONF_PATH, http_api) == -1 ||
+       start_shell(&shellserver, install_builtin_cmds(&shellserver), DEFAULT_SHELL_CONFIG_PATH, true, true, -1, -1) == -1)
+    {
+        printf("failed to start the servers\n");
+        exit(1);
+    }
+
+    xTaskCreate(monitor_task, "monitor", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + BENCH_MONITOR_PRIO, NULL);
+
+    run("http close", http_close_transaction);
+    run("http keepalive", http_keepalive_transaction);
+    run("shell", shell_transaction);
+    print_lwip_stats();
+    print_pool_stats();
+
+    exit(0);
+    return 0;
+}
@@ -166,9 +166,9 @@ http_response_t* http_request(http_request_t* request, http_response_t* response
 
         	    if(sent == chunklen)
         	    {
-                    // send body
-                    if(request->content_length > 0)
-                        send(fd, request->buffer, request->content_length, 0);
+                	// send body
+                	if(request->content_length > 0)
+                		send(fd, request->buffer, request->content_length, 0);
 
                 	// receive the header and body
                 	// TODO - receive header only, decode nice info like content length, then receive body...
@@ -51,6 +51,7 @@ enum {
 #define HTTP_SERVER             "Server: "
 #define HTTP_CONTENT_LENGTH		"Content-Length: "
 #define HTTP_CONTENT_TYPE		"Content-Type: "
+#define HTTP_CONNECTION			"Connection: "
 
 #define HTTP_HEADER_DECODE \
 { \
@@ -96,6 +97,7 @@ enum {
 #define HTTP_GET				"GET"
 #define HTTP_POST				"POST"
 #define HTTP_VERS				"HTTP/1.0"
+#define HTTP_VERS_1_1			"HTTP/1.1"
 #define HTTP_EOL				"\r\n"
 #define HTTP_EOH				HTTP_EOL HTTP_EOL
 #define HTTP_HEADER				"%s %s " HTTP_VERS HTTP_EOL HTTP_HOST "%s" HTTP_EOL HTTP_CONTENT_LENGTH "%d" HTTP_EOL HTTP_CONTENT_TYPE "%s" HTTP_EOH
@@ -132,8 +134,11 @@ enum {
 #define http_json  ".json"
 #define http_xml  ".xml"
 
-#define http_header1  HTTP_VERS " "
-#define http_header2  HTTP_EOL "Server: nutensils/FreeRTOS" HTTP_EOL "Connection: close" HTTP_EOL HTTP_CONTENT_TYPE
+#define http_connection_close  "close"
+#define http_connection_keepalive  "keep-alive"
+
+#define http_header1  HTTP_VERS_1_1 " "
+#define http_header2  HTTP_EOL "Server: nutensils/FreeRTOS" HTTP_EOL HTTP_CONNECTION
 
 #define http_200_header_title  "200 OK"
 #define http_201_header_title  "201 Created"
@@ -40,9 +40,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/sendfile.h>
 #include "sock_utils.h"
 #include "logger.h"
 #include "http_server.h"
@@ -57,13 +60,23 @@ typedef struct {
 	const char* header;
 	const char* content_type;
 	int content_length;
+	int response_length;
+	bool keepalive;
 	char scratch[HTTP_SCRATCH_LEN];
 	char url[HTTP_URL_LEN];
-	FILE* file;
+	char response[HTTP_HEADER_LEN];
+	FILE* file;             ///< the file a POST request writes to
+	int fd;                 ///< the file a GET request reads from, -1 if none
 	struct stat stat;
 }http_server_conn_t;
 
+/**
+ * request state of open connections, see HTTP_CONN_POOL_LENGTH.
+ */
+static pool_t http_conn_pool;
+
 static void http_server_connection(sock_conn_t* conn);
+static bool http_server_request(httpserver_t* httpserver, http_server_conn_t* httpconn, int fdes, bool last);
 static void message_response(int fdes, const char* message);
 
 /**
@@ -71,6 +84,20 @@ static void message_response(int fdes, const char* message);
  */
 #define compare_string(str, const_comp) (strncmp(const_comp, str, (int)sizeof(const_comp)-1) == 0)
 
+/**
+ * compare string to a constant, lower case string, ignoring the case of str.
+ * good for header field names and tokens, which are letters, digits and punctuation.
+ */
+static bool compare_string_nocase(const char* str, const char* lower)
+{
+	while(*lower)
+	{
+		if((*str++ | 0x20) != *lower++)
+			return false;
+	}
+	return true;
+}
+
 /**
  * @brief   A simple HTTP server with support for GET and POST requests.
  */
@@ -83,12 +110,21 @@ int init_http_server(httpserver_t* httpserver, char* configfile, const http_api_
 
 	log_init(&httpserver->log, "http_server");
 
+	if(pool_init(&http_conn_pool, NULL, sizeof(http_server_conn_t), HTTP_CONN_POOL_LENGTH) == -1)
+		log_error(&httpserver->log, "failed to allocate connection pool");
+
 	if(fsroot == NULL)
 		strncpy(httpserver->fsroot, DEFAULT_HTTPD_FS_ROOT, sizeof(httpserver->fsroot)-1);
 	else
 		strncpy(httpserver->fsroot, fsroot, sizeof(httpserver->fsroot)-1);
 
+	const char* value = (const char*)get_config_value_by_key((uint8_t*)buffer, sizeof(buffer), (const uint8_t*)configfile, (const uint8_t*)HTTP_KEEPALIVE_TIMEOUT_CONFIG_KEY);
+	httpserver->keepalive_timeout = value ? atoi(value) : HTTP_KEEPALIVE_TIMEOUT;
+	value = (const char*)get_config_value_by_key((uint8_t*)buffer, sizeof(buffer), (const uint8_t*)configfile, (const uint8_t*)HTTP_KEEPALIVE_MAX_CONFIG_KEY);
+	httpserver->keepalive_max = value ? atoi(value) : HTTP_KEEPALIVE_MAX_REQUESTS;
+
 	log_debug(&httpserver->log, "fsroot: %s", httpserver->fsroot);
+	log_debug(&httpserver->log, "keepalive: %dms, %d requests", httpserver->keepalive_timeout, httpserver->keepalive_max);
 
 	return start_threaded_server(&httpserver->server, configfile, http_server_connection, httpserver, HTTP_SERVER_STACK_SIZE, HTTP_SERVER_TASK_PRIO);
 }
@@ -104,14 +140,69 @@ void message_response(int fdes, const char* message)
 	send(fdes, text_page_footer, sizeof(text_page_footer)-1, 0);
 }
 
+/**
+ * @brief   receives one line of a request header, up to and including the HTTP_EOL_CHAR.
+ * the line is peeked at first, and only the line itself is taken from the socket,
+ * so the request body and any pipelined requests that follow stay there.
+ * lines longer than the buffer are truncated.
+ * @retval  the length of the line, or -1 if the connection closed or timed out.
+ */
+static int recv_line(int fdes, char* buffer, int size)
+{
+	int length = 0;
+	int pos;
+	int n;
+	char* eol;
+
+	do
+	{
+		// once the buffer is full, the rest of an over long line passes through its last byte
+		pos = length < size - 2 ? length : size - 2;
+		n = recv(fdes, &buffer[pos], size - 1 - pos, MSG_PEEK);
+		if(n < 1)
+			return -1;
+		eol = memchr(&buffer[pos], HTTP_EOL_CHAR, n);
+		if(eol)
+			n = eol - &buffer[pos] + 1;
+		if(recv(fdes, &buffer[pos], n, 0) != n)
+			return -1;
+		length = pos + n;
+	}
+	while(!eol);
+
+	buffer[length] = '\0';
+	return length;
+}
+
+/**
+ * @brief   receives and discards the body of a request that was not used.
+ * @retval  true if the whole body was discarded.
+ */
+static bool discard_body(int fdes, char* buffer, int size, int content_length)
+{
+	int n;
+
+	while(content_length > 0)
+	{
+		n = recv(fdes, buffer, content_length < size ? content_length : size, 0);
+		if(n < 1)
+			return false;
+		content_length -= n;
+	}
+	return true;
+}
+
 /**
  * @brief   the HTTP server thread.
- * Processes requests on a per connection, per request basis.
+ * Serves requests on a connection until the client closes it, asks for it to be closed,
+ * it sits idle for longer than keepalive_timeout, or keepalive_max requests are served.
+ * Requests pipelined by the client are served in turn, from the socket receive buffer.
  */
 void http_server_connection(sock_conn_t* conn)
 {
 	httpserver_t* httpserver = (httpserver_t*)conn->ctx;
-	http_server_conn_t* httpconn = malloc(sizeof(http_server_conn_t));
+	http_server_conn_t* httpconn = pool_alloc(&http_conn_pool);
+	int requests = 0;
 
 	if(!httpconn)
 	{
@@ -120,16 +211,55 @@ void http_server_connection(sock_conn_t* conn)
 	}
 
 	struct timeval tv;
-	tv.tv_sec = 2000; // take care, lwip sets s as ms
+	tv.tv_sec = HTTP_REQUEST_TIMEOUT; // take care, lwip sets s as ms
 	tv.tv_usec = 0;
 	setsockopt(conn->connfd, SOL_SOCKET, SO_RCVTIMEO, (char*)&tv, sizeof(struct timeval));
+#if HTTP_SERVER_NODELAY
+	int nodelay = 1;
+	setsockopt(conn->connfd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+#endif
 
+	while(http_server_request(httpserver, httpconn, conn->connfd, ++requests >= httpserver->keepalive_max))
+	{
+		// the connection is persistent from here, wait for the next request
+		if(requests == 1 && httpserver->keepalive_timeout != HTTP_REQUEST_TIMEOUT)
+		{
+			tv.tv_sec = httpserver->keepalive_timeout;
+			setsockopt(conn->connfd, SOL_SOCKET, SO_RCVTIMEO, (char*)&tv, sizeof(struct timeval));
+		}
+	}
+
+	log_debug(&httpserver->log, "served %d requests", requests);
+
+	pool_free(&http_conn_pool, httpconn);
+}
+
+/**
+ * copies out the connection pool counters.
+ * failures counts the connections that took their state from the heap because the pool was empty.
+ */
+void http_server_pool_stats(pool_stats_t* stats)
+{
+	pool_get_stats(&http_conn_pool, stats);
+}
+
+/**
+ * @brief   serves one request.
+ * @param   last is true if the connection is to be closed after this request, regardless.
+ * @retval  true if the connection may be kept open for another request.
+ */
+bool http_server_request(httpserver_t* httpserver, http_server_conn_t* httpconn, int fdes, bool last)
+{
 	httpconn->req_type = NULL;
 	httpconn->content_length = 0;
 	httpconn->content_type = NULL;
 	httpconn->api_call = NULL;
 	httpconn->url[0] = '\0';
 	httpconn->file = NULL;
+	httpconn->fd = -1;
+	httpconn->response_length = -1;
+	// HTTP/1.1 connections are persistent unless closed, HTTP/1.0 ones only if kept alive
+	httpconn->keepalive = false;
 
 	//*********************************
 	//  receive request
@@ -141,22 +271,15 @@ void http_server_connection(sock_conn_t* conn)
 	 */
 	while(1)
 	{
-		httpconn->length = 0;
-		httpconn->scratch[0] = '\0';
         // receive up to the HTTP_EOL
-        do
-        {
-        	if(recv(conn->connfd, &httpconn->scratch[httpconn->length], 1, 0) < 1)
-        	{
-        	    free(httpconn);
-        	    log_error(&httpserver->log, "aborting");
-        	    return;
-        	}
-            httpconn->length++;
-        }
-        while(httpconn->scratch[httpconn->length-1] != HTTP_EOL_CHAR);
-
-        httpconn->scratch[httpconn->length] = '\0';
+		httpconn->length = recv_line(fdes, httpconn->scratch, sizeof(httpconn->scratch));
+		if(httpconn->length < 0)
+		{
+			// a timeout or close while waiting for the next request is the normal end of a persistent connection
+			if(httpconn->req_type)
+				log_error(&httpserver->log, "aborting");
+			return false;
+		}
 
         // check for end of header
         if(!strcmp(httpconn->scratch, HTTP_EOL))
@@ -184,20 +307,27 @@ void http_server_connection(sock_conn_t* conn)
 				{
 					// change that space to a 0
 					*urlend = '\0';
-					strcpy(httpconn->url, urlstart);
+					strncpy(httpconn->url, urlstart, sizeof(httpconn->url)-1);
+					httpconn->url[sizeof(httpconn->url)-1] = '\0';
+					httpconn->keepalive = compare_string(urlend + 1, HTTP_VERS_1_1);
 				}
 			}
 		}
 		// find content length if it is included in header
-		else if(compare_string(httpconn->scratch, HTTP_CONTENT_LENGTH))
+		else if(compare_string_nocase(httpconn->scratch, "content-length:"))
 		{
-			char* clstart = httpconn->scratch + (sizeof(HTTP_CONTENT_LENGTH)-1);
-			char* clend = strchr(clstart, HTTP_CR_CHAR);
-			if(clend)
-			{
-				*clend = '\0';
-				httpconn->content_length = atoi(clstart);
-			}
+			httpconn->content_length = atoi(httpconn->scratch + sizeof("content-length:")-1);
+		}
+		// look for the client asking to close, or keep alive
+		else if(compare_string_nocase(httpconn->scratch, "connection:"))
+		{
+			char* token = httpconn->scratch + sizeof("connection:")-1;
+			while(*token == HTTP_SPACE_CHAR)
+				token++;
+			if(compare_string_nocase(token, http_connection_close))
+				httpconn->keepalive = false;
+			else if(compare_string_nocase(token, http_connection_keepalive))
+				httpconn->keepalive = true;
 		}
 	}
 
@@ -217,6 +347,8 @@ void http_server_connection(sock_conn_t* conn)
 		log_error(&httpserver->log, http_501_header_title);
 		httpconn->header = http_501_header_title;
 		httpconn->content_type = http_header_content_type_html;
+		// the rest of the request was not read
+		httpconn->keepalive = false;
 	}
 	// POST or GET response
 	else if((httpconn->req_type == (char*)HTTP_POST) || (httpconn->req_type == (char*)HTTP_GET))
@@ -231,6 +363,9 @@ void http_server_connection(sock_conn_t* conn)
 		{
 			httpconn->header = http_202_header_title;
 			httpconn->content_type = http_header_content_type_json;
+			// API calls read the request body and write the response directly,
+			// neither length is known here, so the connection ends with the response
+			httpconn->keepalive = false;
 		}
 		else
 		{
@@ -245,14 +380,29 @@ void http_server_connection(sock_conn_t* conn)
 
 			log_syslog(&httpserver->log, "path: %s", httpconn->scratch);
 
-			httpconn->file = fopen(httpconn->scratch, httpconn->req_type == (char*)HTTP_POST ? "w" : "r");
+			if(httpconn->req_type == (char*)HTTP_POST)
+			{
+				httpconn->file = fopen(httpconn->scratch, "w");
+				httpconn->response_length = 0;
+			}
+			// the length comes from the open file, one path lookup rather than two
+			else if((httpconn->fd = open(httpconn->scratch, O_RDONLY)) != -1)
+			{
+				if(fstat(httpconn->fd, &httpconn->stat) == 0)
+					httpconn->response_length = httpconn->stat.st_size;
+				else
+				{
+					close(httpconn->fd);
+					httpconn->fd = -1;
+				}
+			}
 
-			if(httpconn->file)
+			if(httpconn->file || httpconn->fd != -1)
 			{
-			    if(httpconn->req_type == (char*)HTTP_POST)
-			        httpconn->header = http_201_header_title;
-			    else
-			        httpconn->header = http_200_header_title;
+				if(httpconn->req_type == (char*)HTTP_POST)
+					httpconn->header = http_201_header_title;
+				else
+					httpconn->header = http_200_header_title;
 
 				// find the file extension
 				httpconn->content_type = strrchr(httpconn->scratch, HTTP_DOT_CHAR);
@@ -283,14 +433,35 @@ void http_server_connection(sock_conn_t* conn)
 		}
 	}
 
+	// serve error message
+	if(httpconn->header != (char*)http_200_header_title &&
+	   httpconn->header != (char*)http_201_header_title &&
+       httpconn->header != (char*)http_202_header_title)
+	{
+		log_error(&httpserver->log, (char*)httpconn->header);
+		snprintf(httpconn->scratch, sizeof(httpconn->scratch)-1, "oops...<br>%s: %s", httpconn->header, httpconn->url);
+		httpconn->response_length = sizeof(text_page_header)-1 + strlen(httpconn->scratch) + sizeof(text_page_footer)-1;
+		// an unused request body must be cleared out of the way of the next request
+		if(httpconn->keepalive && !last)
+			httpconn->keepalive = discard_body(fdes, httpconn->response, sizeof(httpconn->response), httpconn->content_length);
+	}
+
+	if(last || httpconn->response_length < 0)
+		httpconn->keepalive = false;
+
 	//*********************************
 	//  send response header
 	//*********************************
-	send(conn->connfd, http_header1, sizeof(http_header1)-1, 0);
-	send(conn->connfd, httpconn->header, strlen(httpconn->header), 0);
-	send(conn->connfd, http_header2, sizeof(http_header2)-1, 0);
-	send(conn->connfd, httpconn->content_type, strlen(httpconn->content_type), 0);
-	send(conn->connfd, HTTP_EOH, sizeof(HTTP_EOH)-1, 0);
+	httpconn->length = snprintf(httpconn->response, sizeof(httpconn->response),
+			http_header1 "%s" http_header2 "%s" HTTP_EOL,
+			httpconn->header,
+			httpconn->keepalive ? http_connection_keepalive : http_connection_close);
+	if(httpconn->response_length >= 0)
+		httpconn->length += snprintf(httpconn->response + httpconn->length, sizeof(httpconn->response) - httpconn->length,
+				HTTP_CONTENT_LENGTH "%d" HTTP_EOL, httpconn->response_length);
+	httpconn->length += snprintf(httpconn->response + httpconn->length, sizeof(httpconn->response) - httpconn->length,
+			HTTP_CONTENT_TYPE "%s" HTTP_EOH, httpconn->content_type);
+	send(fdes, httpconn->response, httpconn->length, 0);
 
     log_debug(&httpserver->log, "sent header");
     log_debug(&httpserver->log, "responding to %s request", httpconn->req_type);
@@ -305,51 +476,53 @@ void http_server_connection(sock_conn_t* conn)
 	   httpconn->header != (char*)http_201_header_title &&
        httpconn->header != (char*)http_202_header_title)
 	{
-		log_error(&httpserver->log, (char*)httpconn->header);
-		snprintf(httpconn->scratch, sizeof(httpconn->scratch)-1, "oops...<br>%s: %s", httpconn->header, httpconn->url);
-		message_response(conn->connfd, httpconn->scratch);
+		message_response(fdes, httpconn->scratch);
 	}
 	// POST or GET, RPC response
 	else if(httpconn->api_call)
 	{
         log_syslog(&httpserver->log, "process API call");
-		http_api_process(httpconn->api_call, conn->connfd, httpconn->content_length, httpconn->scratch, sizeof(httpconn->scratch));
+		http_api_process(httpconn->api_call, fdes, httpconn->content_length, httpconn->scratch, sizeof(httpconn->scratch));
 	}
 	// POST file response
 	else if(httpconn->file && httpconn->req_type == (char*)HTTP_POST)
 	{
 		log_syslog(&httpserver->log, "write %s %ub", httpconn->scratch, httpconn->content_length);
-		while(httpconn->content_length)
+		while(httpconn->content_length > 0)
 		{
-			httpconn->length = recv(conn->connfd, httpconn->scratch, sizeof(httpconn->scratch), 0);
-			if(httpconn->length)
+			// no further than the end of the body, a pipelined request may follow
+			httpconn->length = recv(fdes, httpconn->scratch,
+					httpconn->content_length < (int)sizeof(httpconn->scratch) ? httpconn->content_length : (int)sizeof(httpconn->scratch), 0);
+			if(httpconn->length < 1)
 			{
-				fwrite(httpconn->scratch, 1, httpconn->length, httpconn->file);
-				httpconn->content_length -= httpconn->length;
+				httpconn->keepalive = false;
+				break;
 			}
+			fwrite(httpconn->scratch, 1, httpconn->length, httpconn->file);
+			httpconn->content_length -= httpconn->length;
 		}
 	}
 	// GET file response
-	else if(httpconn->file && httpconn->req_type == (char*)HTTP_GET)
+	else if(httpconn->fd != -1 && httpconn->req_type == (char*)HTTP_GET)
 	{
 		log_syslog(&httpserver->log, "read %s", httpconn->scratch);
-		httpconn->length = sizeof(httpconn->scratch);
-		while(httpconn->length > 0)
-		{
-			httpconn->length = fread(httpconn->scratch, 1, sizeof(httpconn->scratch), httpconn->file);
-			if(httpconn->length > 0)
-				send(conn->connfd, httpconn->scratch, httpconn->length, 0);
-		}
+		// the client cannot tell where a short body ended, the connection must close
+		if(sendfile(fdes, httpconn->fd, NULL, httpconn->response_length) != httpconn->response_length)
+			httpconn->keepalive = false;
 	}
 
 	if(httpconn->file)
 	{
 		fclose(httpconn->file);
 	}
+	if(httpconn->fd != -1)
+	{
+		close(httpconn->fd);
+	}
 
     log_debug(&httpserver->log, "done");
 
-	free(httpconn);
+	return httpconn->keepalive;
 }
 
 /**
@@ -47,23 +47,60 @@
 #define DEFAULT_HTTPSERVER_CONF_PATH		"/etc/http/httpd_config"
 #define DEFAULT_HTTPD_FS_ROOT				"/var/lib/httpd"
 #define HTTP_FS_ROOT_CONFIG_KEY				"fsroot"
+#define HTTP_KEEPALIVE_TIMEOUT_CONFIG_KEY	"keepalive_timeout"
+#define HTTP_KEEPALIVE_MAX_CONFIG_KEY		"keepalive_max"
 
 #define HTTP_FS_ROOT_LENGTH         32
 #define HTTP_URL_LEN                64
 #define HTTP_SCRATCH_LEN            256
+#define HTTP_HEADER_LEN             160
+
+/**
+ * the time in ms to wait for each part of the first request on a connection.
+ */
+#define HTTP_REQUEST_TIMEOUT        2000
+/**
+ * the default time in ms a persistent connection may sit idle waiting for the next request.
+ */
+#define HTTP_KEEPALIVE_TIMEOUT      5000
+/**
+ * the default number of requests served on one connection before it is closed.
+ * set to 1 to close every connection after one request.
+ */
+#define HTTP_KEEPALIVE_MAX_REQUESTS 100
+
+/**
+ * when 1, Nagle's algorithm is disabled on http connections. a response goes out as a
+ * header and a body in separate sends, and on a persistent connection the end of the
+ * body would otherwise wait for the client's delayed ACK.
+ */
+#ifndef HTTP_SERVER_NODELAY
+#define HTTP_SERVER_NODELAY         1
+#endif
 
 #define HTTP_SERVER_STACK_SIZE      325
 #define HTTP_SERVER_TASK_PRIO       1
 
+/**
+ * the number of connections whose request state is kept in a pool, set aside when the
+ * first server starts. connections beyond this take their state from the heap.
+ */
+#ifndef HTTP_CONN_POOL_LENGTH
+#define HTTP_CONN_POOL_LENGTH       4
+#endif
+
 typedef struct {
 	char fsroot[HTTP_FS_ROOT_LENGTH];
 	sock_server_t server;
 	logger_t log;
 	const http_api_t** api;
+	int keepalive_timeout;      ///< idle timeout of a persistent connection, in ms
+	int keepalive_max;          ///< the maximum number of requests served per connection
 }httpserver_t;
 
 
 int init_http_server(httpserver_t* httpserver, char* configfile, const http_api_t** api);
+void http_server_pool_stats(pool_stats_t* stats);
 
 
 #endif /* HTTP_HTTP_SERVER_H_ */
@@ -36,7 +36,9 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/sendfile.h>
 #include <unistd.h>
+#include <limits.h>
 #include <dirent.h>
 #include "strutils.h"
 #include "confparse.h"
@@ -222,19 +224,12 @@ int sh_mkdir(int fdes, const char** args, unsigned char nargs)
 int sh_cat(int fdes, const char** args, unsigned char nargs)
 {
 	(void)nargs;
-	char buffer[64];
-	int len;
 	int ffd = open(args[0], O_RDONLY);
 
 	if(ffd != -1)
 	{
-		len = 1;
-		while(len > 0)
-		{
-			len = read(ffd, buffer, sizeof(buffer));
-			if(len > 0)
-				write(fdes, buffer, len);
-		}
+		// sends up to the end of the file
+		sendfile(fdes, ffd, NULL, INT_MAX);
 		close(ffd);
 	}
     return SHELL_CMD_EXIT;
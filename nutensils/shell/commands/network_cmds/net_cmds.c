@@ -47,6 +47,7 @@
 
 #include "lwip/inet.h"
 #include "net.h"
+#include "eth_mac.h"
 #include "http_client.h"
 
 
@@ -60,7 +60,7 @@ int sh_top(int fdes, const char** args, unsigned char nargs)
     char code;
     int ret = 0;
     int length;
-    unsigned long uptime;
+    uint32_t uptime;
     int i;
     int ntasks = 0;
     int memusage;
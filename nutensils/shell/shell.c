@@ -104,6 +104,7 @@
 #include "shell.h"
 
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -163,6 +164,7 @@ static void open_output_file(shell_instance_t* shell_inst);
 static void close_output_file(shell_instance_t* shell_inst);
 static bool open_input_file(shell_instance_t* shell_inst);
 static char close_input_file(shell_instance_t* shell_inst, char input_char);
+static void shell_instance_task(void* parameters);
 
 /**
  * starts a shell server, or single shell instance.
@@ -179,7 +181,7 @@ static char close_input_file(shell_instance_t* shell_inst, char input_char);
  * @param   rdfd - is a file descriptor for reading. ignored when starting a threaded server.
  * @param   wrfd - is a file descriptor for writing. ignored when starting a threaded server.
  * @retval  returns -1 on error. when running threaded server, returns the server file descriptor.
- * 				when running a threaded instance, returns the task handle.
+ * 				when running a threaded instance, returns 0.
  */
 int start_shell(shellserver_t* shell, shell_cmd_t* commandset, const char* configfile, bool threaded, bool exit_on_eof, int rdfd, int wrfd)
 {
@@ -198,12 +200,10 @@ int start_shell(shellserver_t* shell, shell_cmd_t* commandset, const char* confi
     }
     else if(threaded)
     {
-    	TaskHandle_t th;
-        if(xTaskCreate((TaskFunction_t)shell_instance, "shell", configMINIMAL_STACK_SIZE + SHELL_TASK_STACK_SIZE,
-        				shell, tskIDLE_PRIORITY + SHELL_TASK_PRIORITY, &th) != pdPASS) {
-
-        }
-    	return (int)th;
+        if(xTaskCreate(shell_instance_task, "shell", configMINIMAL_STACK_SIZE + SHELL_TASK_STACK_SIZE,
+        				shell, tskIDLE_PRIORITY + SHELL_TASK_PRIORITY, NULL) != pdPASS)
+            return -1;
+    	return 0;
     }
     else
     {
@@ -278,6 +278,15 @@ shell_cmd_t* register_command(shellserver_t* shell, shell_cmd_t* cmd, shell_cmd_
     return shell->head_cmd;
 }
 
+/**
+ * runs a shell instance in a task of its own, see start_shell().
+ */
+void shell_instance_task(void* parameters)
+{
+	shell_instance((shellserver_t*)parameters, NULL);
+	vTaskDelete(NULL);
+}
+
 #if INCLUDE_REMOTE_SHELL_SUPPORT
 /**
  * this function runs inside a new thread, spawned by the threaded_server
@@ -339,18 +348,18 @@ void prompt(shell_instance_t* shell_inst, const char* inputstr)
 
 	while(!shell_inst->exitflag)
 	{
-	    if(inputstr)
-	    {
-	        if(*inputstr)
-	        {
-	            input_char = *inputstr;
-	            inputstr++;
-	        }
-	        else
-	            ret = -1;
-	    }
-	    else
-	        ret = read(shell_inst->rdfd, &input_char, 1);
+		if(inputstr)
+		{
+			if(*inputstr)
+			{
+				input_char = *inputstr;
+				inputstr++;
+			}
+			else
+				ret = -1;
+		}
+		else
+			ret = read(shell_inst->rdfd, &input_char, 1);
 
 		if(inject == '\0' && ret < 0)
 			shell_inst->exitflag = true;
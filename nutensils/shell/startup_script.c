@@ -33,6 +33,7 @@
 #include "startup_script.h"
 
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <string.h>
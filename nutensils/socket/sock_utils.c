@@ -49,6 +49,11 @@
 #include "FreeRTOS.h"
 #include "task.h"
 
+/**
+ * accepted connections, see SOCK_CONN_POOL_LENGTH.
+ */
+POOL_DEFINE(sock_conn_pool, sizeof(sock_conn_t), SOCK_CONN_POOL_LENGTH);
+
 /**
  * open a socket.
  *
@@ -249,6 +254,23 @@ void sock_server_kill(sock_server_t* servinfo)
     closesocket(servinfo->listenfd);
 }
 
+/**
+ * frees the connection data passed to a sock_handle_incoming_fptr_t, once the connection is closed.
+ */
+void sock_conn_free(sock_conn_t* conn)
+{
+    pool_free(&sock_conn_pool, conn);
+}
+
+/**
+ * copies out the connection pool counters.
+ * failures counts the connections taken from the heap because the pool was empty.
+ */
+void sock_conn_pool_stats(pool_stats_t* stats)
+{
+    pool_get_stats(&sock_conn_pool, stats);
+}
+
 /**
  * this is a thread function - when run, is the the listener.
  */
@@ -259,6 +281,9 @@ void sock_server_thread(void* parameters)
 
     sock_conn_t newconn;
     sock_conn_t* conn;
+#if SOCK_SERVER_NODELAY
+    int nodelay = 1;
+#endif
 
     newconn.ctx = servinfo->ctx;
     newconn.service = servinfo->service;
@@ -274,12 +299,15 @@ void sock_server_thread(void* parameters)
         {
             log_debug(&servinfo->log, "%s accepted conn with %s",
                                     servinfo->name, inet_ntoa(newconn.cliaddr.sin_addr));
+#if SOCK_SERVER_NODELAY
+            setsockopt(newconn.connfd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+#endif
             handled = false;
             conn = NULL;
 
             if(servinfo->handle_incoming)
             {
-                conn = malloc(sizeof(sock_conn_t));
+                conn = pool_alloc(&sock_conn_pool);
 
                 if(conn)
                 {
@@ -301,7 +329,7 @@ void sock_server_thread(void* parameters)
                 log_error(&servinfo->log, "closing unhandled connection");
                 closesocket(newconn.connfd);
                 if(conn)
-                    free(conn);
+                    sock_conn_free(conn);
             }
         }
     }
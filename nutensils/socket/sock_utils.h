@@ -43,6 +43,23 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include "cutensils.h"
+#include "pool.h"
+
+/**
+ * the number of accepted connections whose sock_conn_t is kept in a pool, rather than
+ * taken from the heap. connections beyond this are taken from the heap.
+ */
+#ifndef SOCK_CONN_POOL_LENGTH
+#define SOCK_CONN_POOL_LENGTH   8
+#endif
+
+/**
+ * when 1, Nagle's algorithm is disabled on the connections accepted by every server.
+ * servers that need it turn it off for their own connections, see HTTP_SERVER_NODELAY.
+ */
+#ifndef SOCK_SERVER_NODELAY
+#define SOCK_SERVER_NODELAY     0
+#endif
 
 typedef struct _sock_server_t sock_server_t;
 typedef struct _sock_conn_t sock_conn_t;
@@ -75,6 +92,8 @@ int sock_server(int port, int type, int conns, sock_server_t* servinfo,
 				void* ctx, const char* name, int stacksize, int prio);
 void sock_server_thread(void* parameters);
 void sock_server_kill(sock_server_t* servinfo);
+void sock_conn_free(sock_conn_t* conn);
+void sock_conn_pool_stats(pool_stats_t* stats);
 
 #endif /* SOCKET_SOCK_UTILS_H_ */
 
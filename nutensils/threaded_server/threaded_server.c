@@ -136,7 +136,7 @@ void run_spawned(sock_conn_t* conn)
 		conn->service(conn);
 	    log_debug(NULL, "closing connection with %s", inet_ntoa(conn->cliaddr.sin_addr));
 		closesocket(conn->connfd);
-		free(conn);
+		sock_conn_free(conn);
 	}
 	else
 	    log_error(NULL, "spawned with no connection data");
@@ -37,6 +37,8 @@
 #include "stm32f10x.h"
 #elif FAMILY == STM32F4
 #include "stm32f4xx.h"
+#elif FAMILY == HOST
+#include "host.h"
 #else
 #error "FAMILY setting is invalid, do you want to be compiling this module?"
 #endif
@@ -0,0 +1,6 @@
+BOARD_NAME = host
+BOARDS += $(BOARD_NAME)
+## configure BOARD
+# builds a native executable, see device/HOST
+HSE_VALUE = 0
+DEVICE = host
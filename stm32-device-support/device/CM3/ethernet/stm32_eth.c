@@ -39,8 +39,8 @@
   * @{
   */ 
 /* Global pointers on Tx and Rx descriptor used to track transmit and receive descriptors */
-ETH_DMADESCTypeDef  *DMATxDescToSet;
-ETH_DMADESCTypeDef  *DMARxDescToGet;
+__IO ETH_DMADESCTypeDef  *DMATxDescToSet;
+__IO ETH_DMADESCTypeDef  *DMARxDescToGet;
 ETH_DMADESCTypeDef  *DMAPTPTxDescToSet;
 ETH_DMADESCTypeDef  *DMAPTPRxDescToGet;
 
@@ -661,7 +661,7 @@ uint32_t ETH_GetRxPktSize(void)
      ((DMARxDescToGet->Status & ETH_DMARxDesc_FS) != (uint32_t)RESET))
   {
     /* Get the size of the packet: including 4 bytes of the CRC */
-    frameLength = ETH_GetDMARxDescFrameLength(DMARxDescToGet);
+    frameLength = ETH_GetDMARxDescFrameLength((ETH_DMADESCTypeDef*)DMARxDescToGet);
   }
  
  /* Return Frame Length */ 
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @defgroup host Host Device
+ *
+ * device support for running an appleseed project as a native executable on
+ * a Linux host. the kernel runs on the POSIX FreeRTOS port, and the drivers
+ * that have a host implementation are replaced by it. see host.mk.
+ *
+ * stands in for the chip header (stm32f4xx.h etc) included by board_config.h.
+ *
+ * @file host.h
+ * @{
+ */
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#include <stdint.h>
+#include "system_stm32.h"
+#include "asserts.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#ifndef __IO
+#define __IO volatile
+#endif
+
+/**
+ * the nominal core clock of the host device.
+ */
+#define HOST_CORE_CLOCK     1000000000UL
+
+/**
+ * the value returned by get_device_uid() on the host.
+ */
+#ifndef HOST_DEVICE_UID
+#define HOST_DEVICE_UID     0x00484f5354ULL
+#endif
+
+/**
+ * peripheral definitions referred to by shared driver headers.
+ */
+#define SDIO_FLAG_TXACT     ((uint32_t)0x00001000)
+#define SDIO_FLAG_RXACT     ((uint32_t)0x00002000)
+
+/**
+ * stands in for the sample rate timer of a stream driver, see drivers/stream/sim.
+ * only the auto reload register is modelled.
+ */
+typedef struct {
+    __IO uint32_t ARR;
+} TIM_TypeDef;
+
+void phy_putc(char c);
+char phy_getc();
+void host_exit(int code);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* HOST_H_ */
+
+/**
+ * @}
+ */
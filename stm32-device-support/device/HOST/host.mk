@@ -0,0 +1,25 @@
+## the HOST family builds the project as a native Linux executable.
+# FreeRTOS tasks run as pthreads, see freertos/Source/portable/GCC/POSIX.
+# drivers that have no host implementation may not be enabled.
+# USE_DRIVER_LWIP_NET runs on a loopback ethernet interface, see net_lwip/netif/ethernetif.c.
+
+HOST_DIR = $(DEVICE_SUPPORT_DIR)/device/HOST
+
+SOURCE += $(HOST_DIR)/system_host.c
+SOURCE += $(HOST_DIR)/libc_host.c
+
+CFLAGS += -pthread
+
+# main() is started as a task, from startup_host.c
+LINKER_FLAGS += -Xlinker --wrap=main
+
+HOST_UNSUPPORTED_DRIVERS = USE_DRIVER_LEDS USE_DRIVER_TOUCH_PANEL USE_DRIVER_1WIRE \
+	USE_DRIVER_USART USE_DRIVER_SPI USE_DRIVER_ADC_STREAM USE_DRIVER_DAC_STREAM \
+	USE_DRIVER_I2S_STREAM USE_DRIVER_PWM USE_DRIVER_RTC USE_DRIVER_SDCARD_SPI
+
+# the appleseed pthreads library would replace the host threads the kernel runs on
+ifeq ($(USE_PTHREADS), 1)
+$(error USE_PTHREADS is not supported by the host device)
+endif
+
+$(foreach driver, $(HOST_UNSUPPORTED_DRIVERS), $(if $(filter 1, $($(driver))), $(error $(driver) is not supported by the host device)))
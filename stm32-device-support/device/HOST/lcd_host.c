@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup host
+ *
+ * host implementation of the LCD driver.
+ *
+ * the display is an RGB565 framebuffer of LCD_WIDTH x LCD_HEIGHT pixels, behind an
+ * emulation of the ILI932x register interface that lcd.h drives. only the registers
+ * the graphics library uses are decoded - the GRAM address, the window and the entry mode
+ * ORG bit, which makes the GRAM address relative to the window origin. the address counter is kept in display coordinates, so the rotation set in
+ * lcd_config.h only changes which register holds which axis.
+ *
+ * every bus cycle is counted, so the cost of a drawing primitive can be read back with
+ * lcd_host_get_stats() and compared against the pixels it really changed.
+ * the framebuffer may be saved as a binary PPM image with lcd_host_dump_ppm().
+ *
+ * @file lcd_host.c
+ * @{
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "lcd.h"
+
+#define LCD_HOST_PPM_ROWS       8
+
+typedef struct {
+    uint16_t x1;
+    uint16_t y1;
+    uint16_t x2;
+    uint16_t y2;
+} lcd_host_window_t;
+
+SemaphoreHandle_t xLcdMutex;
+
+static uint16_t framebuffer[LCD_WIDTH * LCD_HEIGHT];
+static lcd_host_window_t window = {0, 0, LCD_WIDTH - 1, LCD_HEIGHT - 1};
+static uint16_t cursor_x;
+static uint16_t cursor_y;
+static uint16_t address_x;
+static uint16_t address_y;
+static uint16_t entry_mode;
+static uint16_t reg_index;
+static bool gram_read_primed;
+static lcd_host_stats_t stats;
+
+void lcd_init(void)
+{
+    memset(framebuffer, 0, sizeof(framebuffer));
+    lcd_host_reset_stats();
+    lcd_set_entry_mode_normal();
+    xLcdMutex = xSemaphoreCreateMutex();
+}
+
+unsigned int lcd_getdeviceid(void)
+{
+    unsigned int id;
+    read_reg(ILI932x_DEVICE_ID, id);
+    return id;
+}
+
+/**
+ * GRAM address set. writing either address register loads the address counter from both,
+ * so the axis not written is back where it was last set, not where the last access left it.
+ * with the ORG bit set the address is relative to the window origin.
+ */
+static void lcd_host_set_address()
+{
+    address_x = cursor_x;
+    address_y = cursor_y;
+    if(entry_mode & ILI932x_EM_ORG)
+    {
+        address_x += window.x1;
+        address_y += window.y1;
+    }
+    stats.cursor_sets++;
+}
+
+/**
+ * steps the address counter along the window, as the controller does after each GRAM access.
+ */
+static void lcd_host_next_address()
+{
+    if(address_x >= window.x2)
+    {
+        address_x = window.x1;
+        address_y = address_y >= window.y2 ? window.y1 : address_y + 1;
+    }
+    else
+        address_x++;
+}
+
+void lcd_host_write_cmd(uint16_t cmd)
+{
+    reg_index = cmd;
+    gram_read_primed = false;
+    stats.cmd_writes++;
+}
+
+void lcd_host_write_data(uint16_t data)
+{
+    uint16_t* pixel;
+
+    switch(reg_index)
+    {
+        case ILI932x_CMD_WRITE_GRAM:
+            stats.pixels++;
+            if(address_x < LCD_WIDTH && address_y < LCD_HEIGHT)
+            {
+                pixel = &framebuffer[address_y * LCD_WIDTH + address_x];
+                if(*pixel != data)
+                {
+                    *pixel = data;
+                    stats.pixels_changed++;
+                }
+            }
+            else
+                stats.pixels_clipped++;
+            lcd_host_next_address();
+            return;
+        case LCD_SET_CURSOR_X:
+            cursor_x = data;
+            lcd_host_set_address();
+        break;
+        case LCD_SET_CURSOR_Y:
+            cursor_y = data;
+            lcd_host_set_address();
+        break;
+        case LCD_SET_WINDOW_X1:
+            window.x1 = data;
+            stats.window_sets++;
+        break;
+        case LCD_SET_WINDOW_Y1:
+            window.y1 = data;
+            stats.window_sets++;
+        break;
+        case LCD_SET_WINDOW_X2:
+            window.x2 = data;
+            stats.window_sets++;
+        break;
+        case LCD_SET_WINDOW_Y2:
+            window.y2 = data;
+            stats.window_sets++;
+        break;
+        case ILI932x_ENTRY_MODE:
+            // setting ORG moves the address counter to the window origin
+            entry_mode = data;
+            if(entry_mode & ILI932x_EM_ORG)
+            {
+                address_x = window.x1;
+                address_y = window.y1;
+            }
+        break;
+        default:
+        break;
+    }
+    stats.reg_writes++;
+}
+
+uint16_t lcd_host_read_data()
+{
+    uint16_t data = 0;
+
+    stats.reads++;
+    switch(reg_index)
+    {
+        case ILI932x_DEVICE_ID:
+            data = LCD_DRIVER_ID;
+        break;
+        case ILI932x_CMD_WRITE_GRAM:
+            // the first GRAM read after the command is a dummy read
+            if(!gram_read_primed)
+                gram_read_primed = true;
+            else
+            {
+                if(address_x < LCD_WIDTH && address_y < LCD_HEIGHT)
+                    data = framebuffer[address_y * LCD_WIDTH + address_x];
+                lcd_host_next_address();
+            }
+        break;
+        case ILI932x_ENTRY_MODE:
+            data = entry_mode;
+        break;
+        default:
+        break;
+    }
+    return data;
+}
+
+/**
+ * copies out the bus counters, accumulated since the last call to lcd_host_reset_stats().
+ */
+void lcd_host_get_stats(lcd_host_stats_t* s)
+{
+    *s = stats;
+}
+
+void lcd_host_reset_stats()
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * @retval  the framebuffer, LCD_WIDTH x LCD_HEIGHT RGB565 pixels in row order.
+ */
+const uint16_t* lcd_host_framebuffer()
+{
+    return framebuffer;
+}
+
+/**
+ * @retval  the FNV-1a hash of the framebuffer, to compare the output of two drawing runs.
+ */
+uint32_t lcd_host_checksum()
+{
+    uint32_t hash = 2166136261u;
+    uint32_t i;
+
+    for(i = 0; i < LCD_WIDTH * LCD_HEIGHT; i++)
+    {
+        hash = (hash ^ (framebuffer[i] & 0xFF)) * 16777619u;
+        hash = (hash ^ (framebuffer[i] >> 8)) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * writes the framebuffer to a binary PPM file on the host filesystem.
+ * the file is written with host system calls, it is not on the like-posix filesystem.
+ *
+ * @param   path is the name of the file to write.
+ * @retval  0 on success, -1 on error.
+ */
+int lcd_host_dump_ppm(const char* path)
+{
+    uint8_t rows[LCD_HOST_PPM_ROWS * LCD_WIDTH * 3];
+    char header[32];
+    uint8_t* rgb;
+    uint16_t pixel;
+    int length;
+    int x, y, fd;
+    int ret = 0;
+
+    fd = syscall(SYS_openat, AT_FDCWD, path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if(fd == -1)
+        return -1;
+
+    length = sprintf(header, "P6\n%d %d\n255\n", LCD_WIDTH, LCD_HEIGHT);
+    if(syscall(SYS_write, fd, header, length) != length)
+        ret = -1;
+
+    for(y = 0; y < LCD_HEIGHT && ret == 0; y += LCD_HOST_PPM_ROWS)
+    {
+        rgb = rows;
+        for(x = 0; x < LCD_HOST_PPM_ROWS * LCD_WIDTH && y + x / LCD_WIDTH < LCD_HEIGHT; x++)
+        {
+            // expand RGB565 to 8 bits per channel, replicating the high bits into the low bits
+            pixel = framebuffer[y * LCD_WIDTH + x];
+            *rgb++ = ((pixel >> 8) & 0xF8) | (pixel >> 13);
+            *rgb++ = ((pixel >> 3) & 0xFC) | ((pixel >> 9) & 0x03);
+            *rgb++ = ((pixel << 3) & 0xF8) | ((pixel >> 2) & 0x07);
+        }
+        length = rgb - rows;
+        if(syscall(SYS_write, fd, rows, length) != length)
+            ret = -1;
+    }
+
+    syscall(SYS_close, fd);
+    return ret;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup host
+ *
+ * @file lcd_host.h
+ * @{
+ */
+
+#ifndef LCD_HOST_H_
+#define LCD_HOST_H_
+
+#include <stdint.h>
+
+/**
+ * bus traffic counted by the host LCD. every write is one FSMC write cycle on the target.
+ */
+typedef struct {
+    uint32_t cmd_writes;        ///< register index writes (LCD_REG).
+    uint32_t reg_writes;        ///< register value writes (LCD_RAM), not counting pixels.
+    uint32_t reads;             ///< register and GRAM reads.
+    uint32_t cursor_sets;       ///< writes to either GRAM address register.
+    uint32_t window_sets;       ///< writes to any window address register.
+    uint32_t pixels;            ///< GRAM writes.
+    uint32_t pixels_changed;    ///< GRAM writes that changed the pixel, the rest were redrawn in the same colour.
+    uint32_t pixels_clipped;    ///< GRAM writes that fell outside of the display.
+} lcd_host_stats_t;
+
+void lcd_host_write_cmd(uint16_t cmd);
+void lcd_host_write_data(uint16_t data);
+uint16_t lcd_host_read_data();
+
+void lcd_host_get_stats(lcd_host_stats_t* stats);
+void lcd_host_reset_stats();
+const uint16_t* lcd_host_framebuffer();
+uint32_t lcd_host_checksum();
+int lcd_host_dump_ppm(const char* path);
+
+#endif /* LCD_HOST_H_ */
+
+/**
+ * @}
+ */
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup host
+ *
+ * connects the host C library to appleseed.
+ *
+ * - on the target the newlib system call stubs (_open, _write, etc) are implemented by
+ *   like-posix. the host C library has no such stubs, so the POSIX entry points are
+ *   defined here instead, and pass through to like-posix.
+ * - malloc and friends are passed through to the host allocator with interrupts masked,
+ *   so that a task can not be preempted while holding the allocator lock.
+ *
+ * @file libc_host.c
+ * @{
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include "board_config.h"
+
+#if USE_FREERTOS
+#include "FreeRTOS.h"
+#define lock_alloc()        uint32_t mask = portSET_INTERRUPT_MASK_FROM_ISR()
+#define unlock_alloc()      portCLEAR_INTERRUPT_MASK_FROM_ISR(mask)
+#else
+#define lock_alloc()
+#define unlock_alloc()
+#endif
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t num, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* ptr);
+
+void* malloc(size_t size)
+{
+    void* ptr;
+    lock_alloc();
+    ptr = __libc_malloc(size);
+    unlock_alloc();
+    return ptr;
+}
+
+void* calloc(size_t num, size_t size)
+{
+    void* ptr;
+    lock_alloc();
+    ptr = __libc_calloc(num, size);
+    unlock_alloc();
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    lock_alloc();
+    ptr = __libc_realloc(ptr, size);
+    unlock_alloc();
+    return ptr;
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    void* ptr;
+    lock_alloc();
+    ptr = __libc_memalign(alignment, size);
+    unlock_alloc();
+    return ptr;
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    *ptr = memalign(alignment, size);
+    return *ptr ? 0 : -1;
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+void free(void* ptr)
+{
+    lock_alloc();
+    __libc_free(ptr);
+    unlock_alloc();
+}
+
+#if USE_LIKEPOSIX
+
+extern int _open(const char *name, int flags, int mode);
+extern int _close(int file);
+extern int _write(int file, char *buffer, unsigned int count);
+extern int _read(int file, char *buffer, int count);
+extern int _lseek(int file, int offset, int whence);
+extern int _isatty(int file);
+extern int _unlink(char *name);
+extern int _rename(const char *oldname, const char *newname);
+
+int open(const char *name, int flags, ...)
+{
+    // like-posix uses mode as the ring buffer length for devices, so it is always taken
+    int mode;
+    va_list args;
+    va_start(args, flags);
+    mode = va_arg(args, int);
+    va_end(args);
+    return _open(name, flags, mode);
+}
+
+int close(int file)
+{
+    return _close(file);
+}
+
+ssize_t write(int file, const void *buffer, size_t count)
+{
+    return _write(file, (char*)buffer, count);
+}
+
+ssize_t read(int file, void *buffer, size_t count)
+{
+    return _read(file, (char*)buffer, count);
+}
+
+off_t lseek(int file, off_t offset, int whence)
+{
+    return _lseek(file, offset, whence);
+}
+
+int isatty(int file)
+{
+    return _isatty(file);
+}
+
+int unlink(const char *name)
+{
+    return _unlink((char*)name);
+}
+
+#if !USE_MINLIBC
+// minlibc provides rename when it is in use
+int rename(const char *oldname, const char *newname)
+{
+    return _rename(oldname, newname);
+}
+#endif
+
+#endif
+
+/**
+ * @}
+ */
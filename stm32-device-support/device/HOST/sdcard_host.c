@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup host
+ *
+ * host implementation of the SD card driver.
+ *
+ * the card is a RAM disk of SDCARD_HOST_SECTORS sectors, which is always present
+ * and starts out blank. the contents persist for the life of the process.
+ *
+ * @file sdcard_host.c
+ * @{
+ */
+
+#include <string.h>
+#include "sdcard.h"
+#include "sdcard_config.h"
+
+#ifndef SDCARD_HOST_SECTORS
+#define SDCARD_HOST_SECTORS     8192
+#endif
+
+static uint8_t sdcard_image[SDCARD_HOST_SECTORS * SD_SECTOR_SIZE];
+static uint8_t disk_status = SD_NOT_PRESENT;
+
+SD_Error SD_PowerON(void)
+{
+    return SD_OK;
+}
+
+SD_Error SD_PowerOFF(void)
+{
+    return SD_OK;
+}
+
+SD_Error SD_Init(SD_CardInfo* sdcardinfo)
+{
+    memset(sdcardinfo, 0, sizeof(SD_CardInfo));
+    sdcardinfo->CardCapacity = SDCARD_HOST_SECTORS;
+    sdcardinfo->CardBlockSize = SD_SECTOR_SIZE;
+    sdcardinfo->CardType = SDIO_HIGH_CAPACITY_SD_CARD;
+    sdcardinfo->SD_csd.EraseGrSize = 1;
+    return SD_OK;
+}
+
+void SD_DeInit(void)
+{
+}
+
+SD_Error SD_WaitIOOperation(sdio_wait_on_io_t io_flag)
+{
+    (void)io_flag;
+    return SD_OK;
+}
+
+SD_Error SD_QueryStatus(SDCardState* cardstatus)
+{
+    *cardstatus = SD_CARD_TRANSFER;
+    return SD_OK;
+}
+
+SD_Error SD_ReadMultiBlocks(uint8_t *readbuff, uint32_t sector, uint32_t NumberOfBlocks)
+{
+    if(sector + NumberOfBlocks > SDCARD_HOST_SECTORS)
+        return SD_ADDR_OUT_OF_RANGE;
+    memcpy(readbuff, sdcard_image + (sector * SD_SECTOR_SIZE), NumberOfBlocks * SD_SECTOR_SIZE);
+    return SD_OK;
+}
+
+SD_Error SD_ReadBlock(uint8_t *readbuff, uint32_t sector)
+{
+    return SD_ReadMultiBlocks(readbuff, sector, 1);
+}
+
+SD_Error SD_WriteMultiBlocks(const uint8_t *writebuff, uint32_t sector, uint32_t NumberOfBlocks)
+{
+    if(sector + NumberOfBlocks > SDCARD_HOST_SECTORS)
+        return SD_ADDR_OUT_OF_RANGE;
+    memcpy(sdcard_image + (sector * SD_SECTOR_SIZE), writebuff, NumberOfBlocks * SD_SECTOR_SIZE);
+    return SD_OK;
+}
+
+SD_Error SD_WriteBlock(const uint8_t *writebuff, uint32_t sector)
+{
+    return SD_WriteMultiBlocks(writebuff, sector, 1);
+}
+
+SD_Error SD_Erase(uint32_t startaddr, uint32_t endaddr)
+{
+    if(endaddr < startaddr || endaddr > sizeof(sdcard_image))
+        return SD_ADDR_OUT_OF_RANGE;
+    memset(sdcard_image + startaddr, 0xff, endaddr - startaddr);
+    return SD_OK;
+}
+
+SDTransferState SD_GetTransferState(void)
+{
+    return SD_TRANSFER_OK;
+}
+
+uint8_t SD_Detect(void)
+{
+    return SD_PRESENT;
+}
+
+uint8_t SD_WPDetect(void)
+{
+    return SD_NOT_WRITE_PROTECTED;
+}
+
+void set_diskstatus(uint8_t state)
+{
+    disk_status = state;
+}
+
+uint8_t get_diskstatus()
+{
+    return disk_status;
+}
+
+/**
+ * @}
+ */
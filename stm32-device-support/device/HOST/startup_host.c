@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup host
+ *
+ * host startup, does the job of Reset_Handler in startup.c.
+ *
+ * the host C runtime calls main(), which is wrapped at link time (see host.mk) so
+ * that the target initialisation sequence runs first, and the application
+ * main() is started as a task - exactly as it is on the target.
+ *
+ * @file startup_host.c
+ * @{
+ */
+
+#include "board_config.h"
+#include "services.h"
+
+#if USE_FREERTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+
+uint32_t SystemCoreClock = HOST_CORE_CLOCK;
+
+extern int __real_main();
+
+#if USE_FREERTOS
+/**
+ * runs the application main() as a task, the process exits with its return value.
+ */
+static void main_task(void* parameters)
+{
+    (void)parameters;
+    host_exit(__real_main());
+}
+#endif
+
+void SystemInit(void)
+{
+}
+
+void SystemCoreClockUpdate(void)
+{
+    SystemCoreClock = HOST_CORE_CLOCK;
+}
+
+int __wrap_main(int argc, char** argv)
+{
+    (void)argc;
+    (void)argv;
+
+    SystemInit();
+
+    // call init_target (in board_config.c)
+    init_target();
+
+    // call init_services (in services.c)
+    init_services();
+
+    /* Call the application's entry point.*/
+#if USE_FREERTOS
+    xTaskCreate(main_task, "main", configMAIN_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL);
+    vTaskStartScheduler();
+#else
+    __real_main();
+#endif
+
+    // only reached if the scheduler is ended
+    host_exit(0);
+
+    return 0;
+}
+
+/**
+ * @}
+ */
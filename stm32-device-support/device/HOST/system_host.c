@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup host
+ *
+ * host implementation of the system.h API, and the console.
+ *
+ * the console is the host process stdin/stdout. it is accessed with raw system calls,
+ * rather than the host C library, which is replaced in part by minlibc and like-posix.
+ *
+ * @file system_host.c
+ * @{
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include "board_config.h"
+#include "system.h"
+#include "strutils.h"
+
+static uint16_t __resetflags = RESETFLAG_PORRST;
+
+void configure_nvic()
+{
+}
+
+void enable_fpu()
+{
+}
+
+void enable_bod()
+{
+}
+
+/**
+ * delays for aproximately count milliseconds.
+ */
+void delay(volatile uint32_t count)
+{
+    struct timespec ts = {
+        .tv_sec = count / 1000,
+        .tv_nsec = (count % 1000) * 1000000
+    };
+    while(syscall(SYS_nanosleep, &ts, &ts) != 0);
+}
+
+/**
+ * there is no reset on the host, the process exits.
+ */
+void soft_reset()
+{
+    __resetflags = RESETFLAG_SFTRST;
+    host_exit(0);
+}
+
+void fake_hardfault()
+{
+    function_pointer_t f = (function_pointer_t)0x12345678;
+    f();
+}
+
+void sys_clear_hardware_reset_flags()
+{
+}
+
+void sys_refresh_reset_flags()
+{
+}
+
+uint16_t sys_get_reset_flags()
+{
+    return __resetflags;
+}
+
+bool sys_get_reset_source_state(uint16_t flag)
+{
+    return (bool)(__resetflags&flag);
+}
+
+const char* sys_get_reset_source_string()
+{
+    if(__resetflags &  RESETFLAG_SFTRST)
+        return "software";
+    else if(__resetflags & RESETFLAG_PORRST)
+        return "poweron";
+    return "unknown";
+}
+
+void run_from(uint32_t address)
+{
+    (void)address;
+    assert_true(0);
+}
+
+uint64_t get_device_uid()
+{
+    return HOST_DEVICE_UID;
+}
+
+void get_device_uid_string(uint8_t* str)
+{
+    ditoa(get_device_uid(), (char*)str, 32);
+}
+
+/**
+ * @brief   writes one character to the host stdout.
+ */
+void phy_putc(char c)
+{
+    syscall(SYS_write, STDOUT_FILENO, &c, 1);
+}
+
+/**
+ * @brief   reads one character from the host stdin, blocks the calling task only.
+ */
+char phy_getc()
+{
+    char c = 0;
+    syscall(SYS_read, STDIN_FILENO, &c, 1);
+    return c;
+}
+
+/**
+ * @brief   ends the host process immediately.
+ */
+void host_exit(int code)
+{
+    syscall(SYS_exit_group, code);
+    while(1);
+}
+
+/**
+ * @}
+ */
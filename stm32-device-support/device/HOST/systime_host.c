@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup host
+ *
+ * host implementation of the system timer driver.
+ *
+ * time is read from the host monotonic clock, and counts from init_systime(),
+ * just as the hardware timer does. set_hw_time() moves it to some other value.
+ *
+ * @file systime_host.c
+ * @{
+ */
+
+#include <time.h>
+#include "board_config.h"
+#include "systime.h"
+
+static volatile unsigned long long system_offset_us;
+
+static unsigned long long host_time_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((unsigned long long)ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000);
+}
+
+void init_systime()
+{
+    system_offset_us = host_time_us();
+}
+
+void set_hw_time(unsigned long secs, unsigned long usecs)
+{
+    system_offset_us = host_time_us() - (((unsigned long long)secs * 1000000ULL) + usecs);
+}
+
+void get_hw_time(unsigned long* secs, unsigned long* usecs)
+{
+    unsigned long long t = host_time_us() - system_offset_us;
+    *secs = (unsigned long)(t / 1000000ULL);
+    *usecs = (unsigned long)(t % 1000000ULL);
+}
+
+unsigned long get_hw_time_ms()
+{
+    return (unsigned long)((host_time_us() - system_offset_us) / 1000ULL);
+}
+
+/**
+ * @}
+ */
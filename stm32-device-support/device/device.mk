@@ -4,11 +4,12 @@ DEVICEDIR = $(DEVICE_SUPPORT_DIR)/device
 ## supported DEVICES
 STM32F1_DEVICES = stm32f103ve stm32f107rc 
 STM32F4_DEVICES = stm32f407ve stm32f407vg stm32f469ni
-DEVICES = $(STM32F1_DEVICES) $(STM32F4_DEVICES)
+HOST_DEVICES = host
+DEVICES = $(STM32F1_DEVICES) $(STM32F4_DEVICES) $(HOST_DEVICES)
 
 ## supported device FAMILIES
-FAMILIES = STM32F1 STM32F4
-FAMILY_FLAGS = -D STM32F1=1 -D STM32F4=4
+FAMILIES = STM32F1 STM32F4 HOST
+FAMILY_FLAGS = -D STM32F1=1 -D STM32F4=4 -D HOST=2
 
 ifeq ($(filter $(DEVICE),$(STM32F1_DEVICES)), $(DEVICE))
 FAMILY = STM32F1
@@ -18,6 +19,10 @@ ifeq ($(filter $(DEVICE),$(STM32F4_DEVICES)), $(DEVICE))
 FAMILY = STM32F4
 endif
 
+ifeq ($(filter $(DEVICE),$(HOST_DEVICES)), $(DEVICE))
+FAMILY = HOST
+endif
+
 ## test FAMILY againt FAMILIES
 ifeq ($(filter $(FAMILY),$(FAMILIES)), )
 $(error FAMILY '$(FAMILY)' not supported. supported FAMILIES: $(FAMILIES))
@@ -56,6 +61,15 @@ STACK_RAM = CCRAM
 CCRAM_BASE_ADDRESS=0x10000000
 endif
 
+## the HOST family builds a native executable, see HOST/host.mk
+ifeq ($(FAMILY), HOST)
+FREERTOS_PORT = GCCPOSIX
+CPU_FLAGS =
+FPU_FLAGS =
+CHIPSUPPORT_MK = host.mk
+CHIPSUPPORTDIR = $(DEVICEDIR)/HOST
+endif
+
 ## test DEVICE against DEVICES
 ifeq ($(filter $(DEVICE),$(DEVICES)), )
 $(error device '$(DEVICE)' not supported. supported devices: $(DEVICES))
@@ -125,11 +139,19 @@ MIN_HEAP_SIZE ?= 0x3000
 MIN_STACK_SIZE ?= 0x10000		# 64kb stack in ccram
 endif
 
+ifeq ($(DEVICE), host)
+# device specification
+DENSITY = HOST_SIMULATION
+endif
+
 ## TODO - this linker script is good for c++ - can it be make simpler for c only projects?
 BASE_LINKER_SCRIPT = atollic_arm_cpp.ld
 LDSCRIPT = stm32.ld
 LINKERSCRIPTPATH = $(DEVICEDIR)
 
+ifeq ($(FAMILY), HOST)
+STARTUP_SOURCE = $(CHIPSUPPORTDIR)/startup_host.c
+else
 #STARTUP_SOURCE = $(DEVICEDIR)/startup.c
 STARTUP_SOURCE += $(CHIPSUPPORTDIR)/$(INTERRUPT_HANDLER_SOURCE)
 
@@ -138,17 +160,25 @@ STARTUP_SOURCE += $(CHIPSUPPORTDIR)/$(INTERRUPT_HANDLER_SOURCE)
 CFLAGS += -T$(LDSCRIPT)
 #linker script paths
 CFLAGS += -L$(LINKERSCRIPTPATH)
+endif
 CFLAGS += $(FAMILY_FLAGS)
 CFLAGS += $(CPU_FLAGS) $(FPU_FLAGS)
 CFLAGS += -D $(FREERTOS_PORT)
 CFLAGS += -D $(DENSITY)
+ifneq ($(FAMILY), HOST)
 CFLAGS += -I $(CHIPSUPPORTDIR)/std_periph_drivers/inc
 CFLAGS += -I $(CHIPSUPPORTDIR)/ethernet
+endif
 CFLAGS += -I $(DEVICEDIR)
 CFLAGS += -I $(CHIPSUPPORTDIR)
 
 include $(CHIPSUPPORTDIR)/$(CHIPSUPPORT_MK)
 
+ifeq ($(FAMILY), HOST)
+buildlinkerscript:
+	@echo 
+	@echo "no linker script for a host build"
+else
 buildlinkerscript:
 	@echo 
 	@echo "building linker script"
@@ -165,3 +195,4 @@ buildlinkerscript:
 	@sed -i 's/!STACK_RAM!/$(STACK_RAM)/g' $(LINKERSCRIPTPATH)/$(LDSCRIPT)
 	@sed -i 's/!BASE_LINKER_SCRIPT!/$(BASE_LINKER_SCRIPT)/g' $(LINKERSCRIPTPATH)/$(LDSCRIPT)
 	
+endif
@@ -211,13 +211,21 @@
 
 /**
  * lcd IO macros.
+ * on the host device the bus is emulated by a framebuffer, see device/HOST/lcd_host.c.
  */
+#if FAMILY == HOST
+#include "lcd_host.h"
+#define write_cmd(cmd)                      lcd_host_write_cmd(cmd)
+#define write_data(data)                    lcd_host_write_data(data)
+#define read_data()                         lcd_host_read_data()
+#else
 #define LCD_REG                             (*((volatile unsigned short *) LCD_REG_IO_ADDRESS))
 #define LCD_RAM                             (*((volatile unsigned short *) LCD_RAM_IO_ADDRESS))
 #define write_cmd(cmd)                      LCD_REG = cmd
 #define write_data(data)                    LCD_RAM = data
-#define write_reg(reg, value)               write_cmd(reg);write_data(value)
 #define read_data()                         LCD_RAM
+#endif
+#define write_reg(reg, value)               write_cmd(reg);write_data(value)
 #define read_reg(reg, result)               write_cmd(reg);result = read_data()
 
 
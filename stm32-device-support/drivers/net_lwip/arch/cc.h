@@ -35,6 +35,17 @@
 #include "cpu.h"
 #include <sys/time.h>
 
+#if FAMILY == HOST
+// long and pointers are 64 bit on the host
+#include <stdint.h>
+typedef uint8_t     u8_t;
+typedef int8_t      s8_t;
+typedef uint16_t    u16_t;
+typedef int16_t     s16_t;
+typedef uint32_t    u32_t;
+typedef int32_t     s32_t;
+typedef uintptr_t   mem_ptr_t;
+#else
 typedef unsigned   char    u8_t;
 typedef signed     char    s8_t;
 typedef unsigned   short   u16_t;
@@ -42,6 +53,7 @@ typedef signed     short   s16_t;
 typedef unsigned   long    u32_t;
 typedef signed     long    s32_t;
 typedef u32_t mem_ptr_t;
+#endif
 typedef int sys_prot_t;
 
 
@@ -87,6 +99,11 @@ typedef int sys_prot_t;
 
 #define LWIP_PLATFORM_ASSERT(x) assert_true(x)//do { if(!(x)) while(1); } while(0)
 
+#if FAMILY == HOST
+// errno and its values come from the host C library
+#include <errno.h>
+#else
 #define LWIP_PROVIDE_ERRNO              0
+#endif
 
 #endif /* __CC_H__ */
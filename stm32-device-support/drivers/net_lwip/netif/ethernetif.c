@@ -43,6 +43,8 @@
 #include "net.h"
 #include "lwip/mem.h"
 #include "lwip/debug.h"
+#include "lwip/sys.h"
+#include "lwip/tcpip.h"
 #include "etharp.h"
 #include "eth_mac.h"
 
@@ -55,15 +57,314 @@
 
 u8_t copy_buffer[ETH_MAX_PACKET_SIZE];
 
+#if USE_ETH_ZERO_COPY || FAMILY == STM32F4
+/* Global pointers to track current transmit and receive descriptors */
+// defined in stm32_eth.c
+extern __IO ETH_DMADESCTypeDef  *DMATxDescToSet;
+extern __IO ETH_DMADESCTypeDef  *DMARxDescToGet;
+#endif
+
+#if USE_ETH_ZERO_COPY
+
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error "USE_ETH_ZERO_COPY requires custom pbuf support, see LWIP_SUPPORT_CUSTOM_PBUF in lwip/pbuf.h"
+#endif
+
+/**
+ * the number of spare receive buffers. a received frame is handed to LwIP in its DMA buffer,
+ * and a spare takes its place in the descriptor. when no spare is free, frames are copied.
+ * the spares cost ETH_RX_ZERO_COPY_BUFNB * ETH_RX_BUF_SIZE bytes of RAM on top of the
+ * ETH_RXBUFNB descriptor buffers, about 3kB at the default of 2.
+ * may be set in net_config.h.
+ */
+#ifndef ETH_RX_ZERO_COPY_BUFNB
+#define ETH_RX_ZERO_COPY_BUFNB      2
+#endif
+
+/**
+ * true if the ethernet DMA may read the memory at addr, that is, it lies in SRAM.
+ * frames with payloads elsewhere (eg const data in flash) are copied.
+ */
+#define eth_dma_can_read(addr)      (((u32_t)(addr) & 0xF0000000) == 0x20000000)
+
+/**
+ * a receive buffer wrapped in a pbuf. buffer is the spare while the wrapper is free,
+ * or the received frame while it is held by LwIP.
+ */
+typedef struct {
+    struct pbuf_custom pc;
+    u8_t* buffer;
+} rx_pbuf_t;
+
+static u8_t rx_spare_buffers[ETH_RX_ZERO_COPY_BUFNB][ETH_RX_BUF_SIZE] __attribute__ ((aligned (4)));
+static rx_pbuf_t rx_pbufs[ETH_RX_ZERO_COPY_BUFNB];
+static rx_pbuf_t* rx_free[ETH_RX_ZERO_COPY_BUFNB];
+static int rx_free_count;
+
+/**
+ * the transmit descriptor ring. tx_pbuf holds a reference to the frame whose last
+ * segment sits in that descriptor, until the DMA is done with it.
+ */
+static __IO ETH_DMADESCTypeDef* tx_desc[ETH_TXBUFNB];
+static u32_t tx_buffer[ETH_TXBUFNB];
+static struct pbuf* tx_pbuf[ETH_TXBUFNB];
+static int tx_next;
+static int tx_reclaim;
+static int tx_used;
+
+/**
+ * called by pbuf_free() when LwIP is done with a received frame.
+ */
+static void rx_pbuf_free(struct pbuf* p)
+{
+    SYS_ARCH_DECL_PROTECT(old_level);
+    SYS_ARCH_PROTECT(old_level);
+    rx_free[rx_free_count++] = (rx_pbuf_t*)p;
+    SYS_ARCH_UNPROTECT(old_level);
+}
+
+/**
+ * records the transmit descriptor ring set up by ETH_Configuration(),
+ * and fills the spare receive buffer list.
+ */
+static void zero_copy_init()
+{
+    __IO ETH_DMADESCTypeDef* desc = DMATxDescToSet;
+    int i;
+
+    for(i = 0; i < ETH_TXBUFNB; i++)
+    {
+        tx_desc[i] = desc;
+        tx_buffer[i] = desc->Buffer1Addr;
+        tx_pbuf[i] = NULL;
+        desc = (ETH_DMADESCTypeDef*)desc->Buffer2NextDescAddr;
+    }
+    tx_next = 0;
+    tx_reclaim = 0;
+    tx_used = 0;
+
+    for(i = 0; i < ETH_RX_ZERO_COPY_BUFNB; i++)
+    {
+        rx_pbufs[i].pc.custom_free_function = rx_pbuf_free;
+        rx_pbufs[i].buffer = rx_spare_buffers[i];
+        rx_free[i] = &rx_pbufs[i];
+    }
+    rx_free_count = ETH_RX_ZERO_COPY_BUFNB;
+}
+#endif
+
 /**
  * performs MAC/PHY level initialization
  */
 static void low_level_init(void* macaddr)
 {
     ETH_Configuration((const uint8_t*)macaddr);
+#if USE_ETH_ZERO_COPY
+    zero_copy_init();
+#endif
+}
+
+#if USE_ETH_ZERO_COPY
+
+/**
+ * releases the frames the DMA has finished sending.
+ * called with the LwIP core locked, from low_level_output() and from the RX task,
+ * see ethernetif_incoming().
+ */
+static void tx_reclaim_descriptors()
+{
+    while(tx_used > 0 && !(tx_desc[tx_reclaim]->Status & ETH_DMATxDesc_OWN))
+    {
+        if(tx_pbuf[tx_reclaim])
+        {
+            pbuf_free(tx_pbuf[tx_reclaim]);
+            tx_pbuf[tx_reclaim] = NULL;
+        }
+        tx_reclaim = (tx_reclaim + 1) % ETH_TXBUFNB;
+        tx_used--;
+    }
+}
+
+/**
+ * sends a frame with one transmit descriptor per pbuf in the chain, pointing at the
+ * pbuf payloads. the chain is referenced until the DMA has sent it.
+ * frames that need more descriptors than are free, or that hold payloads the DMA
+ * cannot reach, are copied into the driver buffer of a single descriptor instead.
+ *
+ * @param netif the lwip network interface structure for this ethernetif
+ * @param p the MAC packet to send (e.g. IP packet including MAC addresses and type)
+ * @return ERR_OK if the packet could be sent, ERR_MEM if all descriptors are in use
+ */
+static err_t low_level_output(struct netif *netif, struct pbuf *p)
+{
+    (void)netif;
+    __IO ETH_DMADESCTypeDef* desc;
+    __IO ETH_DMADESCTypeDef* first;
+    struct pbuf *q;
+    int segments = 0;
+    bool copy = false;
+    int i;
+
+    tx_reclaim_descriptors();
+
+    for(q = p; q != NULL; q = q->next)
+    {
+        if(q->len)
+        {
+            segments++;
+            copy |= !eth_dma_can_read(q->payload);
+        }
+    }
+
+    if(segments > ETH_TXBUFNB - tx_used)
+        copy = true;
+
+    if(tx_used == ETH_TXBUFNB)
+        return ERR_MEM;
+
+    i = tx_next;
+    first = tx_desc[i];
+
+    if(copy)
+    {
+        // fall back to the driver buffer belonging to the descriptor
+        assert_true(p->tot_len <= ETH_TX_BUF_SIZE);
+        first->Buffer1Addr = tx_buffer[i];
+        pbuf_copy_partial(p, (void*)tx_buffer[i], p->tot_len, 0);
+        first->ControlBufferSize = p->tot_len & ETH_DMATxDesc_TBS1;
+        first->Status = (first->Status & ~ETH_DMATxDesc_OWN) | ETH_DMATxDesc_FS | ETH_DMATxDesc_LS;
+        i = (i + 1) % ETH_TXBUFNB;
+        tx_used++;
+    }
+    else
+    {
+        for(q = p; q != NULL; q = q->next)
+        {
+            if(!q->len)
+                continue;
+
+            desc = tx_desc[i];
+            desc->Buffer1Addr = (u32_t)q->payload;
+            desc->ControlBufferSize = q->len & ETH_DMATxDesc_TBS1;
+            desc->Status &= ~(ETH_DMATxDesc_FS | ETH_DMATxDesc_LS);
+            if(desc == first)
+                desc->Status |= ETH_DMATxDesc_FS;
+            if(--segments == 0)
+            {
+                desc->Status |= ETH_DMATxDesc_LS;
+                pbuf_ref(p);
+                tx_pbuf[i] = p;
+            }
+            // the first descriptor is handed over last, so the DMA never sees part of a frame
+            if(desc != first)
+                desc->Status |= ETH_DMATxDesc_OWN;
+
+            i = (i + 1) % ETH_TXBUFNB;
+            tx_used++;
+        }
+    }
+
+    __DSB();
+    first->Status |= ETH_DMATxDesc_OWN;
+    tx_next = i;
+    DMATxDescToSet = tx_desc[i];
+
+    /* When Tx Buffer unavailable flag is set: clear it and resume transmission */
+    if((ETH->DMASR & ETH_DMASR_TBUS) != (u32_t)RESET)
+    {
+        ETH->DMASR = ETH_DMASR_TBUS;
+        ETH->DMATPDR = 0;
+    }
+
+    return ERR_OK;
+}
+
+/**
+ * hands a received frame to LwIP in the DMA buffer it was received into,
+ * and gives the descriptor a spare buffer in its place.
+ * when no spare is free the frame is copied into a pool pbuf.
+ * frames spread over more than one descriptor are dropped.
+ *
+ * @param netif the lwip network interface structure for this ethernetif
+ * @return a pbuf holding the received packet (including MAC header)
+ *         NULL on memory error
+ */
+static struct pbuf * low_level_input(struct netif *netif)
+{
+    (void)netif;
+    __IO ETH_DMADESCTypeDef* desc = DMARxDescToGet;
+    struct pbuf *p = NULL;
+    rx_pbuf_t* rxp = NULL;
+    u8_t* buffer;
+    u16_t len;
+    SYS_ARCH_DECL_PROTECT(old_level);
+
+    if(desc->Status & ETH_DMARxDesc_OWN)
+        return NULL;
+
+    if(!(desc->Status & ETH_DMARxDesc_ES) &&
+        (desc->Status & ETH_DMARxDesc_FS) &&
+        (desc->Status & ETH_DMARxDesc_LS))
+    {
+        /* frame length less the CRC */
+        len = ETH_GetDMARxDescFrameLength((ETH_DMADESCTypeDef*)desc) - 4;
+        buffer = (u8_t*)desc->Buffer1Addr;
+
+        SYS_ARCH_PROTECT(old_level);
+        if(rx_free_count > 0)
+            rxp = rx_free[--rx_free_count];
+        SYS_ARCH_UNPROTECT(old_level);
+
+        if(rxp)
+        {
+            desc->Buffer1Addr = (u32_t)rxp->buffer;
+            rxp->buffer = buffer;
+            p = pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &rxp->pc, buffer, ETH_RX_BUF_SIZE);
+        }
+        else
+        {
+            p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+            if(p)
+                pbuf_take(p, buffer, len);
+        }
+    }
+
+    /* Set Own bit of the Rx descriptor Status: gives the buffer back to DMA */
+    desc->Status = ETH_DMARxDesc_OWN;
+    DMARxDescToGet = (ETH_DMADESCTypeDef*)desc->Buffer2NextDescAddr;
+
+    /* When Rx Buffer unavailable flag is set: clear it and resume reception */
+    if((ETH->DMASR & ETH_DMASR_RBUS) != (u32_t)RESET)
+    {
+        ETH->DMASR = ETH_DMASR_RBUS;
+        ETH->DMARPDR = 0;
+    }
+
+    return p;
 }
 
-#if FAMILY == STM32F1
+/**
+ * polled by the RX task (see net_task()). also releases the frames the DMA has finished
+ * sending, so that they are not held until the next frame goes out.
+ * tx_used is only changed with the core locked, a stale read delays the release by one poll.
+ */
+err_t ethernetif_incoming()
+{
+    if(tx_used > 0)
+    {
+#if !NO_SYS
+        LOCK_TCPIP_CORE();
+#endif
+        tx_reclaim_descriptors();
+#if !NO_SYS
+        UNLOCK_TCPIP_CORE();
+#endif
+    }
+
+    return (DMARxDescToGet->Status & ETH_DMARxDesc_OWN) ? ERR_MEM : ERR_OK;
+}
+
+#elif FAMILY == STM32F1
 
 /**
  * This function should do the actual transmission of the packet. The packet is
@@ -151,11 +452,6 @@ err_t ethernetif_incoming()
 }
 
 #elif FAMILY == STM32F4
-/* Global pointers to track current transmit and receive descriptors */
-// defined in stm32_eth.c
-extern ETH_DMADESCTypeDef  *DMATxDescToSet;
-extern ETH_DMADESCTypeDef  *DMARxDescToGet;
-
 /* Global pointer for last received frame infos */
 // defined in stm32_eth.c, only valid for stm32f4
 extern ETH_DMA_Rx_Frame_infos *DMA_RX_FRAME_infos;
@@ -340,6 +636,81 @@ err_t ethernetif_incoming()
     return enc28j60_check_incoming() ? ERR_OK : ERR_MEM;
 }
 
+#elif FAMILY == HOST && USE_DRIVER_LWIP_NET
+
+/**
+ * host builds have no MAC or PHY. frames sent are queued on a "wire" and received again,
+ * so the interface only ever talks to its own address, through the whole stack.
+ */
+
+#ifndef ETH_HOST_WIRE_LENGTH
+#define ETH_HOST_WIRE_LENGTH    64
+#endif
+
+static QueueHandle_t wire;
+
+static void low_level_init(void* macaddr)
+{
+    (void)macaddr;
+    wire = xQueueCreate(ETH_HOST_WIRE_LENGTH, sizeof(struct pbuf*));
+    LWIP_ASSERT("wire != NULL", (wire != NULL));
+}
+
+/**
+ * copies the frame, as a MAC would, the stack may reuse p once this returns.
+ * frames are dropped when the wire is full.
+ */
+static err_t low_level_output(struct netif *netif, struct pbuf *p)
+{
+    (void)netif;
+    struct pbuf* frame = pbuf_alloc(PBUF_RAW, p->tot_len, PBUF_POOL);
+
+    if(frame == NULL)
+        return ERR_MEM;
+
+    pbuf_copy(frame, p);
+    if(xQueueSend(wire, &frame, 0) != pdTRUE)
+    {
+        pbuf_free(frame);
+        return ERR_MEM;
+    }
+
+    return ERR_OK;
+}
+
+static struct pbuf * low_level_input(struct netif *netif)
+{
+    (void)netif;
+    struct pbuf* frame = NULL;
+    xQueueReceive(wire, &frame, 0);
+    return frame;
+}
+
+/**
+ * waits up to a tick for a frame, so the net task wakes as soon as one is sent.
+ */
+err_t ethernetif_incoming()
+{
+    struct pbuf* frame;
+    return xQueuePeek(wire, &frame, 1) == pdTRUE ? ERR_OK : ERR_MEM;
+}
+
+// the link on the wire is always up
+bool eth_link_status()
+{
+    return true;
+}
+
+uint16_t eth_link_speed()
+{
+    return 100;
+}
+
+bool eth_link_full_duplex()
+{
+    return true;
+}
+
 #else
 #error "invalid ethernet device configuration"
 #endif
@@ -54,7 +54,9 @@ inline void spi_rx_isr(SPI_TypeDef* spi, void* spi_dev)
 	{
 #if USE_LIKEPOSIX
 		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-		xQueueSendFromISR(((dev_ioctl_t*)spi_dev)->pipe.read, (char*)&(spi->DR), &xHigherPriorityTaskWoken);
+		uint8_t c = (uint8_t)spi->DR;
+		if(((dev_ioctl_t*)spi_dev)->pipe.read)
+			ringbuf_put_from_isr(((dev_ioctl_t*)spi_dev)->pipe.read, &c, 1, &xHigherPriorityTaskWoken);
 		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 #else
         (void)spi_dev;
@@ -74,7 +76,10 @@ inline void spi_tx_isr(SPI_TypeDef* spi, void* spi_dev)
 	{
 #if USE_LIKEPOSIX
 		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-		if(xQueueReceiveFromISR(((dev_ioctl_t*)spi_dev)->pipe.write, (char*)&(spi->DR), &xHigherPriorityTaskWoken) == pdFALSE)
+		uint8_t c;
+		if(((dev_ioctl_t*)spi_dev)->pipe.write && ringbuf_get_from_isr(((dev_ioctl_t*)spi_dev)->pipe.write, &c, 1, &xHigherPriorityTaskWoken))
+			spi->DR = c;
+		else
 			SPI_I2S_ITConfig(spi, SPI_I2S_IT_TXE, DISABLE);
 		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 #else
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * stream processing benchmark.
+ *
+ * every channel of the simulated stream has two connections, a source that writes a sawtooth
+ * into the buffer and a filter that runs an FIR over it in place. the filter length, channel
+ * count and sample rate are swept, and each configuration is run for BENCH_RUN_TIME ms.
+ *
+ * the load is the longest time taken to process one half buffer, as a percentage of the half
+ * buffer period. at 100% or more the chain can not keep up, which shows as overruns (half buffers
+ * that took too long) and missed half buffers (those that had not been processed when the next
+ * one was ready). results where the host held up the simulated DMA are marked, they may be repeated
+ * with a longer BENCH_RUN_TIME. the last section breaks one configuration down by connection.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sim_stream.h"
+
+#ifndef BENCH_RUN_TIME
+#define BENCH_RUN_TIME      200
+#endif
+
+#define MAX_TAPS            1024
+
+typedef struct {
+    int16_t history[MAX_TAPS];
+    uint16_t pos;
+} fir_t;
+
+static const uint16_t tap_counts[] = {16, 128, 1024};
+static const uint8_t channel_counts[] = {1, 2, 4, 8};
+static const uint32_t samplerates[] = {8000, 16000, 32000, 48000, 96000};
+
+static stream_connection_t sources[SIM_STREAM_MAX_CHANNEL_COUNT];
+static stream_connection_t filters[SIM_STREAM_MAX_CHANNEL_COUNT];
+static uint32_t phases[SIM_STREAM_MAX_CHANNEL_COUNT];
+static fir_t firs[SIM_STREAM_MAX_CHANNEL_COUNT];
+static int16_t coeffs[MAX_TAPS];
+static uint16_t taps;
+
+static void source_process(unsigned_stream_type_t* buffer, uint16_t length, uint8_t channels, stream_connection_t* conn)
+{
+    uint32_t* phase = conn->ctx;
+    uint16_t i;
+
+    for(i = 0; i < length; i++)
+    {
+        *phase += 0x01000000 + (conn->stream_channel << 20);
+        *buffer = *phase >> 16;
+        buffer += channels;
+    }
+}
+
+static void fir_process(unsigned_stream_type_t* buffer, uint16_t length, uint8_t channels, stream_connection_t* conn)
+{
+    fir_t* fir = conn->ctx;
+    uint16_t i, t, h;
+    int32_t acc;
+
+    for(i = 0; i < length; i++)
+    {
+        fir->history[fir->pos] = (int16_t)*buffer;
+        acc = 0;
+        h = fir->pos;
+        for(t = 0; t < taps; t++)
+        {
+            acc += coeffs[t] * fir->history[h];
+            h = h ? h - 1 : taps - 1;
+        }
+        fir->pos = fir->pos + 1 < taps ? fir->pos + 1 : 0;
+        *buffer = (unsigned_stream_type_t)(acc >> 15);
+        buffer += channels;
+    }
+}
+
+/**
+ * a windowed low pass filter would do as well, the coefficients only need to be stable.
+ */
+static void set_taps(uint16_t count)
+{
+    uint16_t t;
+
+    taps = count;
+    for(t = 0; t < taps; t++)
+        coeffs[t] = 32767 / taps;
+    memset(firs, 0, sizeof(firs));
+}
+
+static void run(uint8_t channels, uint32_t samplerate)
+{
+    uint8_t c;
+
+    sim_stream_stop();
+    sim_stream_set_channel_count(channels);
+    sim_stream_set_samplerate(samplerate);
+
+    for(c = 0; c < SIM_STREAM_MAX_CHANNEL_COUNT; c++)
+    {
+        stream_connection_enable(&sources[c], c < channels);
+        stream_connection_enable(&filters[c], c < channels);
+    }
+
+    // let the first half buffers, which may be late while the stream task wakes, pass before measuring
+    sim_stream_start();
+    vTaskDelay(20);
+    stream_reset_stats(get_sim_stream());
+    vTaskDelay(BENCH_RUN_TIME);
+    sim_stream_stop();
+}
+
+static uint32_t load_percent(stream_t* stream)
+{
+    return (stream->stats.max_us * 100) / stream_get_period_us(stream);
+}
+
+static void bench_sweep(void)
+{
+    stream_t* stream = get_sim_stream();
+    uint32_t t, c, r, best;
+
+    for(t = 0; t < sizeof(tap_counts)/sizeof(tap_counts[0]); t++)
+    {
+        set_taps(tap_counts[t]);
+        printf("FIR %d taps, worst case load %% of the %d sample half buffer period ('!' overrun or missed, '?' simulation late)\n",
+                tap_counts[t], SIM_STREAM_BUFFER_LENGTH / 2);
+        printf("  channels");
+        for(r = 0; r < sizeof(samplerates)/sizeof(samplerates[0]); r++)
+            printf(" %8dHz", (int)samplerates[r]);
+        printf("  max sustained\n");
+
+        for(c = 0; c < sizeof(channel_counts)/sizeof(channel_counts[0]); c++)
+        {
+            best = 0;
+            printf("  %8d", channel_counts[c]);
+            for(r = 0; r < sizeof(samplerates)/sizeof(samplerates[0]); r++)
+            {
+                run(channel_counts[c], samplerates[r]);
+                if(stream->overruns || sim_stream_get_missed())
+                    printf(" %9d!", (int)load_percent(stream));
+                else
+                {
+                    printf(" %9d%c", (int)load_percent(stream), sim_stream_get_late() ? '?' : '%');
+                    best = samplerates[r];
+                }
+            }
+            if(best)
+                printf("  %dHz\n", (int)best);
+            else
+                printf("  none\n");
+        }
+    }
+}
+
+static void bench_breakdown(uint16_t tap_count, uint8_t channels, uint32_t samplerate)
+{
+    stream_t* stream = get_sim_stream();
+    stream_connection_t* conn;
+    uint32_t i;
+
+    set_taps(tap_count);
+    run(channels, samplerate);
+
+    printf("breakdown, FIR %d taps, %d channels at %dHz, half buffer period %dus\n",
+            tap_count, channels, (int)samplerate, (int)stream_get_period_us(stream));
+    printf("  %-12s %8s %8s %8s %8s\n", "connection", "calls", "mean us", "max us", "max %");
+    for(i = 0; i < stream->maxconns; i++)
+    {
+        conn = stream->connections[i];
+        if(conn && conn->enabled)
+            printf("  %-12s %8d %8d %8d %8d\n", conn->name, (int)conn->stats.calls,
+                    (int)(conn->stats.calls ? conn->stats.total_us / conn->stats.calls : 0),
+                    (int)conn->stats.max_us, (int)((conn->stats.max_us * 100) / stream_get_period_us(stream)));
+    }
+    printf("  %-12s %8d %8d %8d %8d\n", "all", (int)stream->stats.calls,
+            (int)(stream->stats.calls ? stream->stats.total_us / stream->stats.calls : 0),
+            (int)stream->stats.max_us, (int)load_percent(stream));
+    printf("  overruns %d, missed %d, simulation late %d\n", (int)stream->overruns,
+            (int)sim_stream_get_missed(), (int)sim_stream_get_late());
+}
+
+int main(void)
+{
+    static char names[SIM_STREAM_MAX_CHANNEL_COUNT * 2][12];
+    uint8_t c;
+
+    sim_stream_init();
+
+    for(c = 0; c < SIM_STREAM_MAX_CHANNEL_COUNT; c++)
+    {
+        sprintf(names[c * 2], "source %d", c);
+        sprintf(names[(c * 2) + 1], "fir %d", c);
+        stream_connection_init(&sources[c], source_process, names[c * 2], &phases[c]);
+        stream_connection_init(&filters[c], fir_process, names[(c * 2) + 1], &firs[c]);
+        sim_stream_connect_service(&sources[c], c);
+        sim_stream_connect_service(&filters[c], c);
+    }
+
+    bench_sweep();
+    bench_breakdown(1024, 4, 48000);
+
+    exit(0);
+    return 0;
+}
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @defgroup sim
+ *
+ * simulated streaming driver, for host builds.
+ *
+ * runs stream connections exactly as the ADC, DAC and I2S stream drivers do, without the hardware.
+ * a host thread stands in for the DMA controller. it raises the half transfer and transfer complete
+ * interrupts in turn, once every half buffer at the sample rate, and the interrupt handler hands the
+ * finished half of the buffer to the stream processing task (see stream_common.c).
+ *
+ * the buffer contents are left alone, connections may fill it (like a DAC stream) or read it (like
+ * an ADC stream) or both.
+ *
+ * a half buffer that is still unprocessed when the next interrupt is raised has been missed - on real
+ * hardware the DMA would have played or overwritten it. these are counted, see sim_stream_get_missed().
+ * the host may hold up the DMA thread too, most of all on a single core, that is counted separately
+ * by sim_stream_get_late().
+ * with USE_STREAM_STATS set to 1 the processing time of each connection is also recorded, and may be
+ * compared against stream_get_period_us().
+ *
+ * example usage:
+ *
+\code
+
+#include "sim_stream.h"
+
+void sim_stream_callback(uint16_t* buffer, uint16_t length, uint8_t channels, stream_connection_t* conn)
+{
+    printf("%s: %x %d %d %d\n", conn->name, buffer, length, channels, conn->stream_channel);
+}
+
+stream_connection_t sim_stream_conn;
+
+void start()
+{
+    sim_stream_init();
+    sim_stream_set_samplerate(2000);
+    sim_stream_start();
+
+    stream_connection_init(&sim_stream_conn, sim_stream_callback, "sim process", NULL);
+    sim_stream_connect_service(&sim_stream_conn, 0);
+    stream_connection_enable(&sim_stream_conn, true);
+}
+
+\endcode
+ *
+ * @file sim_stream.c
+ * @{
+ */
+
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "asserts.h"
+#include "sim_stream.h"
+#include "stream_common.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+
+#if(SIM_STREAM_BUFFER_LENGTH%2)
+#error "buffer SIM_STREAM_BUFFER_LENGTH must be a multiple of 2"
+#endif
+
+#if(SIM_STREAM_CHANNEL_COUNT > SIM_STREAM_MAX_CHANNEL_COUNT)
+#error "SIM_STREAM_CHANNEL_COUNT must not be more than SIM_STREAM_MAX_CHANNEL_COUNT"
+#endif
+
+
+static uint16_t sim_stream_buffer[SIM_STREAM_MAX_CHANNEL_COUNT * SIM_STREAM_BUFFER_LENGTH];
+static stream_connection_t* sim_stream_connections[SIM_STREAM_MAX_CONNECTIONS];
+static TIM_TypeDef sim_stream_timer;
+static pthread_t sim_stream_dma;
+static volatile bool sim_stream_running;
+static volatile bool sim_stream_second_half;
+static volatile uint32_t sim_stream_missed;
+static volatile uint32_t sim_stream_late;
+
+stream_t sim_stream;
+
+static void* sim_stream_dma_thread(void* arg);
+static BaseType_t sim_stream_interrupt_handler(void* ctx);
+static void sim_stream_add_ns(struct timespec* t, uint64_t ns);
+
+void sim_stream_init()
+{
+    init_stream(&sim_stream, "sim_stream", SIM_STREAM_DEFAULT_SAMPLERATE,
+            SIM_STREAM_MAX_CONNECTIONS, sim_stream_buffer, sim_stream_connections,
+            SIM_STREAM_BUFFER_LENGTH, SIM_STREAM_CHANNEL_COUNT, SIM_STREAM_THREAD_PRIO,
+            SIM_STREAM_THREAD_STACK_SIZE, SIM_STREAM_FULL_SCALE_AMPLITUDE_MV, SIM_STREAM_RESOLUTION);
+
+    sim_stream_set_samplerate(SIM_STREAM_DEFAULT_SAMPLERATE);
+
+    assert_true(xPortCreateSimulatedInterruptThread(&sim_stream_dma, sim_stream_dma_thread, NULL) == pdPASS);
+}
+
+stream_t* get_sim_stream()
+{
+    return &sim_stream;
+}
+
+/**
+ * stands in for the DMA half transfer and transfer complete interrupts.
+ */
+static BaseType_t sim_stream_interrupt_handler(void* ctx)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    (void)ctx;
+
+    if(!sim_stream_running)
+        return pdFALSE;
+
+    if(sim_stream.buffer)
+        sim_stream_missed++;
+
+    if(sim_stream_second_half)
+        sim_stream.buffer = sim_stream._buffer + ((SIM_STREAM_BUFFER_LENGTH / 2) * sim_stream.channels);
+    else
+        sim_stream.buffer = sim_stream._buffer;
+    sim_stream_second_half = !sim_stream_second_half;
+
+    xSemaphoreGiveFromISR(sim_stream.ready, &xHigherPriorityTaskWoken);
+
+    return xHigherPriorityTaskWoken;
+}
+
+static void sim_stream_add_ns(struct timespec* t, uint64_t ns)
+{
+    t->tv_nsec += ns % 1000000000ULL;
+    t->tv_sec += (ns / 1000000000ULL) + (t->tv_nsec / 1000000000L);
+    t->tv_nsec %= 1000000000L;
+}
+
+/**
+ * stands in for the DMA controller, raises an interrupt every half buffer.
+ * the period is taken from the sample rate timer, so that stream_set_samplerate() works as it does on hardware.
+ * the interrupts are scheduled against absolute times, so that a late one does not delay those that follow.
+ */
+static void* sim_stream_dma_thread(void* arg)
+{
+    struct timespec next;
+    struct timespec now;
+    uint64_t period_ns;
+    (void)arg;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while(1)
+    {
+        if(!sim_stream_running)
+        {
+            next.tv_sec = 0;
+            next.tv_nsec = 1000000;
+            nanosleep(&next, NULL);
+            clock_gettime(CLOCK_MONOTONIC, &next);
+            continue;
+        }
+
+        period_ns = ((uint64_t)(SIM_STREAM_BUFFER_LENGTH / 2) * (sim_stream_timer.ARR + 1) * 1000000000ULL) / SIM_SR_TIMER_CLOCK_RATE;
+        sim_stream_add_ns(&next, period_ns);
+
+        // if the host ran this thread a whole period late, carry on from now rather than raising interrupts
+        // back to back. that would be a fault of the simulation, not of the stream connections.
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if((now.tv_sec > next.tv_sec) || ((now.tv_sec == next.tv_sec) && (now.tv_nsec > next.tv_nsec)))
+        {
+            next = now;
+            sim_stream_add_ns(&next, period_ns);
+            sim_stream_late++;
+        }
+
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        if(sim_stream_running && xPortGenerateSimulatedInterrupt(sim_stream_interrupt_handler, NULL) != pdPASS)
+            sim_stream_missed++;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief   start the stream sim_stream.
+ */
+void sim_stream_start()
+{
+    sim_stream.buffer = NULL;
+    //clear the buffer
+    memset(sim_stream._buffer, SIM_STREAM_BUFFER_CLEAR_VALUE, sizeof(sim_stream_buffer));
+
+    sim_stream_missed = 0;
+    sim_stream_late = 0;
+    sim_stream_second_half = false;
+    sim_stream_running = true;
+
+    log_debug(&sim_stream.log, "started");
+}
+
+/**
+ * @brief   stop the stream sim_stream.
+ */
+void sim_stream_stop()
+{
+    sim_stream_running = false;
+    sim_stream.buffer = NULL;
+
+    log_debug(&sim_stream.log, "sim_stream stopped");
+}
+
+/**
+ * @brief   wraps stream_set_samplerate, see stream_common.c for info.
+ */
+void sim_stream_set_samplerate(uint32_t samplerate)
+{
+    stream_set_samplerate(&sim_stream, &sim_stream_timer, SIM_SR_TIMER_CLOCK_RATE, samplerate);
+}
+
+/**
+ * @brief   wraps stream_get_samplerate, see stream_common.c for info.
+ */
+uint32_t sim_stream_get_samplerate()
+{
+    return stream_get_samplerate(&sim_stream);
+}
+
+/**
+ * @brief   sets the number of interleaved channels in the stream buffer.
+ *          may only be changed while the stream is stopped.
+ * @param   channels is the new channel count, from 1 to SIM_STREAM_MAX_CHANNEL_COUNT.
+ */
+void sim_stream_set_channel_count(uint8_t channels)
+{
+    if(sim_stream_running || (channels < 1) || (channels > SIM_STREAM_MAX_CHANNEL_COUNT))
+    {
+        log_error(&sim_stream.log, "cannot set channel count to %d", channels);
+    }
+    else
+    {
+        sim_stream.channels = channels;
+        log_debug(&sim_stream.log, "channel count set to %d", channels);
+    }
+}
+
+/**
+ * @brief   wraps stream_connect_service, see stream_common.c for info.
+ */
+void sim_stream_connect_service(stream_connection_t* interface, uint8_t stream_channel)
+{
+    stream_connect_service(interface, &sim_stream, stream_channel);
+}
+
+/**
+ * @brief   gets the number of half buffers that were not processed before the next was ready,
+ *          since the stream was started.
+ */
+uint32_t sim_stream_get_missed()
+{
+    return sim_stream_missed;
+}
+
+/**
+ * @brief   gets the number of times the simulated DMA was itself held up by the host for a whole half
+ *          buffer period or more, since the stream was started. results are only meaningful when this is 0.
+ */
+uint32_t sim_stream_get_late()
+{
+    return sim_stream_late;
+}
+
+/**
+ * @}
+ */
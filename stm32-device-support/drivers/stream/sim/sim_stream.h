@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2015 Michael Stuart.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the Appleseed project, <https://github.com/drmetal/app-l-seed>
+ *
+ * Author: Michael Stuart <spaceorbot@gmail.com>
+ *
+ */
+
+/**
+ * @addtogroup sim
+ *
+ * @file sim_stream.h
+ * @{
+ */
+
+#ifndef SIM_STREAM_H
+#define SIM_STREAM_H
+
+#include <stdint.h>
+#include "board_config.h"
+#include "cutensils.h"
+#include "sim_stream_config.h"
+#include "stream_common.h"
+
+/**
+ * the rate at which the simulated sample rate timer counts.
+ */
+#define SIM_SR_TIMER_CLOCK_RATE             HOST_CORE_CLOCK
+
+stream_t* get_sim_stream();
+void sim_stream_init();
+void sim_stream_start();
+void sim_stream_stop();
+void sim_stream_set_samplerate(uint32_t samplerate);
+uint32_t sim_stream_get_samplerate();
+void sim_stream_set_channel_count(uint8_t channels);
+void sim_stream_connect_service(stream_connection_t* interface, uint8_t stream_channel);
+uint32_t sim_stream_get_missed();
+uint32_t sim_stream_get_late();
+
+#endif // SIM_STREAM_H
+
+/**
+ * @}
+ */
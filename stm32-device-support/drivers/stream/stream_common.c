@@ -41,6 +41,12 @@
 static void stream_processing_task(stream_t* stream);
 #endif
 
+#if USE_STREAM_STATS
+#include "systime.h"
+static uint32_t stream_time_us();
+static void stream_stats_update(stream_stats_t* stats, uint32_t us);
+#endif
+
 
 /**
  * this file contains common stream control code, the funtions are
@@ -121,6 +127,51 @@ uint32_t stream_get_samplerate(stream_t* stream)
     return stream->samplerate;
 }
 
+/**
+ * @brief   gets the time between half buffer events, which is the time available to process one half buffer.
+ * @retval  returns the half buffer period in us.
+ */
+uint32_t stream_get_period_us(stream_t* stream)
+{
+    return (uint32_t)(((uint64_t)(stream->length / 2) * 1000000) / stream->samplerate);
+}
+
+#if USE_STREAM_STATS
+/**
+ * @brief   clears the processing time statistics of the stream and all of its connections.
+ */
+void stream_reset_stats(stream_t* stream)
+{
+    uint8_t i;
+
+    memset(&stream->stats, 0, sizeof(stream->stats));
+    stream->overruns = 0;
+
+    for(i = 0; i < stream->maxconns; i++)
+    {
+        if(stream->connections[i])
+            memset(&stream->connections[i]->stats, 0, sizeof(stream->connections[i]->stats));
+    }
+}
+
+static uint32_t stream_time_us()
+{
+    unsigned long secs;
+    unsigned long usecs;
+    get_hw_time(&secs, &usecs);
+    return (secs * 1000000) + usecs;
+}
+
+static void stream_stats_update(stream_stats_t* stats, uint32_t us)
+{
+    stats->calls++;
+    stats->last_us = us;
+    stats->total_us += us;
+    if(us > stats->max_us)
+        stats->max_us = us;
+}
+#endif
+
 /**
  * @brief   initializes a connection structure.
  *
@@ -135,6 +186,9 @@ void stream_connection_init(stream_connection_t* interface, stream_callback_t pr
     interface->process = process;
     interface->name = name;
     interface->ctx = ctx;
+#if USE_STREAM_STATS
+    memset(&interface->stats, 0, sizeof(interface->stats));
+#endif
 }
 
 /**
@@ -217,26 +271,56 @@ void stream_processing_task(stream_t* stream)
 {
     uint8_t connection;
     uint8_t channel;
+    uint8_t channels;
+    unsigned_stream_type_t* buffer;
     stream_connection_t* interface;
+#if USE_STREAM_STATS
+    uint32_t start;
+    uint32_t pass_start;
+    uint32_t elapsed;
+#endif
 
     while(1)
     {
         stream->buffer = NULL;
         xSemaphoreTake(stream->ready, 10000/portTICK_RATE_MS);
 
-        if(!stream->buffer)
+        // the stream may be stopped or reconfigured while the connections run
+        buffer = stream->buffer;
+        channels = stream->channels;
+        if(!buffer)
             continue;
 
+#if USE_STREAM_STATS
+        pass_start = stream_time_us();
+#endif
+
         // call all registered + enabled service channel buffer read functions
-        for(channel = 0; channel < stream->channels; channel++)
+        for(channel = 0; channel < channels; channel++)
         {
             for(connection = 0; connection < stream->maxconns; connection++)
             {
                 interface = stream->connections[connection];
                 if(interface && interface->enabled && (interface->stream_channel == channel))
-                    interface->process(stream->buffer + channel, stream->length/2, stream->channels, interface);
+                {
+#if USE_STREAM_STATS
+                    start = stream_time_us();
+                    interface->process(buffer + channel, stream->length/2, channels, interface);
+                    stream_stats_update(&interface->stats, stream_time_us() - start);
+#else
+                    interface->process(buffer + channel, stream->length/2, channels, interface);
+#endif
+                }
             }
         }
+
+#if USE_STREAM_STATS
+        // the DMA is already filling/emptying the other half, this one has to be done before it comes back around
+        elapsed = stream_time_us() - pass_start;
+        stream_stats_update(&stream->stats, elapsed);
+        if(elapsed > stream_get_period_us(stream))
+            stream->overruns++;
+#endif
     }
 }
 #endif
@@ -39,6 +39,10 @@ void init_stream(stream_t* stream, const char* name, uint32_t samplerate,
                 uint16_t buffer_length, uint8_t channel_count, uint8_t task_prio, uint16_t task_stack, uint16_t full_scale_amplitude, uint32_t resolution);
 void stream_set_samplerate(stream_t* stream, TIM_TypeDef* samplerate_timer, uint32_t timer_clockrate, uint32_t samplerate);
 uint32_t stream_get_samplerate(stream_t* stream);
+uint32_t stream_get_period_us(stream_t* stream);
+#if USE_STREAM_STATS
+void stream_reset_stats(stream_t* stream);
+#endif
 
 void stream_connection_init(stream_connection_t* interface, stream_callback_t process, const char* name, void* ctx);
 
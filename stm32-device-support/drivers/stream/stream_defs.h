@@ -57,6 +57,17 @@ typedef uint16_t unsigned_stream_type_t;
 
 typedef struct _stream_connection_t stream_connection_t;
 
+/**
+ * processing time statistics, kept when USE_STREAM_STATS is set to 1.
+ * times are in microseconds, read from the system timer.
+ */
+typedef struct {
+    uint32_t calls;                         ///< the number of times processing was run.
+    uint32_t last_us;                       ///< the duration of the most recent run.
+    uint32_t max_us;                        ///< the longest run.
+    uint64_t total_us;                      ///< the sum of all runs, divide by calls for the mean.
+} stream_stats_t;
+
 typedef void(*stream_callback_t)(unsigned_stream_type_t* buffer, uint16_t length, uint8_t channels, stream_connection_t* conn);
 
 typedef struct {
@@ -73,6 +84,10 @@ typedef struct {
     uint16_t length;                        ///< stream buffer length, in samples
     uint16_t full_scale_amplitude;          ///< a number that may be used to scale the input/output of a stream.
     uint32_t resolution;                    ///< stream resolution, eg 65536 for a 16 bit device. used to scale the input/output of a stream.
+#if USE_STREAM_STATS
+    stream_stats_t stats;                   ///< time taken to run all connections on one half buffer.
+    uint32_t overruns;                      ///< the number of half buffers that took longer than the half buffer period to process.
+#endif
 } stream_t;
 
 typedef struct _stream_connection_t{
@@ -82,6 +97,9 @@ typedef struct _stream_connection_t{
     void* ctx;                              ///< application context data, set by the application.
     stream_t* stream;                       ///< stream this connection is associated with.
     uint8_t stream_channel;                ///< stream channel this connection is associated with.
+#if USE_STREAM_STATS
+    stream_stats_t stats;                   ///< time taken by the process callback.
+#endif
 }stream_connection_t;
 
 #endif // STREAM_DEFS_H
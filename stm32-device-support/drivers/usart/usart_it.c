@@ -59,7 +59,9 @@ inline void usart_rx_isr(USART_TypeDef* usart, void* usart_dev)
 	{
 #if USE_LIKEPOSIX
 		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-		xQueueSendFromISR(((dev_ioctl_t*)usart_dev)->pipe.read, (char*)&(usart->DR), &xHigherPriorityTaskWoken);
+		uint8_t c = (uint8_t)usart->DR;
+		if(((dev_ioctl_t*)usart_dev)->pipe.read)
+			ringbuf_put_from_isr(((dev_ioctl_t*)usart_dev)->pipe.read, &c, 1, &xHigherPriorityTaskWoken);
 		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 #else
         (void)usart_dev;
@@ -79,7 +81,10 @@ inline void usart_tx_isr(USART_TypeDef* usart, void* usart_dev)
 	{
 #if USE_LIKEPOSIX
 		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-		if(xQueueReceiveFromISR(((dev_ioctl_t*)usart_dev)->pipe.write, (char*)&(usart->DR), &xHigherPriorityTaskWoken) == pdFALSE)
+		uint8_t c;
+		if(((dev_ioctl_t*)usart_dev)->pipe.write && ringbuf_get_from_isr(((dev_ioctl_t*)usart_dev)->pipe.write, &c, 1, &xHigherPriorityTaskWoken))
+			usart->DR = c;
+		else
 			USART_ITConfig(usart, USART_IT_TXE, DISABLE);
 		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 #else